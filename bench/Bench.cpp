@@ -0,0 +1,138 @@
+/***********************************************************************************************//**
+ *  Micro-benchmark harness.
+ *  @class      Bench
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#include "Bench.hpp"
+
+CREATE_LOGGER(Bench)
+
+Bench::Bench(double min_time, unsigned int samples)
+    : m_current(nullptr)
+    , m_min_time(min_time)
+    , m_samples(std::max(1u, samples))
+{ }
+
+void Bench::add(std::string name, std::function<Body(void)> setup, double items)
+{
+    m_cases.push_back({name, setup, items});
+}
+
+void Bench::setMetric(std::string key, double value)
+{
+    if(m_current != nullptr) {
+        m_current->metrics[key] = value;
+    }
+}
+
+unsigned int Bench::run(std::string filter)
+{
+    unsigned int count = 0;
+    for(auto& c : m_cases) {
+        if(!filter.empty() && c.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        Result r;
+        r.name = c.name;
+        r.items = c.items;
+        m_current = &r;
+        Body body = c.setup();
+
+        /*  Calibration (also warms up caches and lazily initialized structures): the number of
+         *  operations grows until one sample takes at least `min_time / samples`.
+         **/
+        double t_sample = m_min_time / m_samples;
+        unsigned long n = 1;
+        double t = time(body, n);
+        while(t < t_sample) {
+            double f = (t > 0.0 ? 1.2 * t_sample / t : 10.0);
+            n = std::max(n + 1, (unsigned long)(n * std::min(f, 10.0)));
+            t = time(body, n);
+        }
+
+        std::vector<double> ns(m_samples);
+        for(auto& s : ns) {
+            s = time(body, n) * 1e9 / n;
+        }
+        std::sort(ns.begin(), ns.end());
+        r.ops = n;
+        r.samples = m_samples;
+        r.ns_min = ns.front();
+        r.ns_median = (m_samples % 2 == 1 ? ns[m_samples / 2] : (ns[m_samples / 2 - 1] + ns[m_samples / 2]) / 2.0);
+        r.ns_mean = std::accumulate(ns.begin(), ns.end(), 0.0) / m_samples;
+        m_current = nullptr;
+        m_results.push_back(r);
+        Log::dbg << "Completed \'" << r.name << "\' (" << m_samples << " x " << n << " ops).\n";
+        count++;
+    }
+    return count;
+}
+
+double Bench::time(Body& body, unsigned long n)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    body(n);
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+void Bench::list(std::ostream& os) const
+{
+    for(auto& c : m_cases) {
+        os << c.name << "\n";
+    }
+}
+
+void Bench::print(std::ostream& os) const
+{
+    os << std::left << std::setw(48) << "Case" << std::right
+        << std::setw(14) << "ns/op (min)" << std::setw(14) << "ns/op (med)" << std::setw(14) << "ns/op (mean)"
+        << std::setw(14) << "ns/item" << std::setw(12) << "ops" << "\n";
+    for(auto& r : m_results) {
+        os << std::left << std::setw(48) << r.name << std::right << std::fixed << std::setprecision(1)
+            << std::setw(14) << r.ns_min << std::setw(14) << r.ns_median << std::setw(14) << r.ns_mean
+            << std::setw(14) << r.ns_median / r.items << std::setw(12) << r.ops << "\n";
+        for(auto& m : r.metrics) {
+            os << "    " << m.first << " = " << std::setprecision(3) << m.second << "\n";
+        }
+    }
+    os.unsetf(std::ios::floatfield);
+}
+
+bool Bench::writeJSON(std::string path) const
+{
+    std::ofstream f(path, std::ios::out | std::ios::trunc);
+    if(!f.is_open()) {
+        Log::err << "Unable to write benchmark results to \'" << path << "\'.\n";
+        return false;
+    }
+    f << std::setprecision(6) << std::fixed;
+    f << "{\n";
+    f << "  \"min_time\": " << m_min_time << ",\n";
+    f << "  \"samples\": " << m_samples << ",\n";
+    f << "  \"threads\": " << omp_get_max_threads() << ",\n";
+    f << "  \"results\": [\n";
+    for(auto r = m_results.begin(); r != m_results.end(); r++) {
+        f << "    {\n";
+        f << "      \"name\": \"" << r->name << "\",\n";
+        f << "      \"ops\": " << r->ops << ",\n";
+        f << "      \"items\": " << r->items << ",\n";
+        f << "      \"ns_per_op\": {\"min\": " << r->ns_min << ", \"median\": " << r->ns_median
+            << ", \"mean\": " << r->ns_mean << "},\n";
+        f << "      \"ns_per_item\": " << r->ns_median / r->items << ",\n";
+        f << "      \"metrics\": {";
+        for(auto m = r->metrics.begin(); m != r->metrics.end(); m++) {
+            f << (m == r->metrics.begin() ? "" : ", ") << "\"" << m->first << "\": " << m->second;
+        }
+        f << "}\n";
+        f << "    }" << (std::next(r) != m_results.end() ? "," : "") << "\n";
+    }
+    f << "  ]\n";
+    f << "}\n";
+    return true;
+}
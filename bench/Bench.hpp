@@ -0,0 +1,88 @@
+/***********************************************************************************************//**
+ *  Micro-benchmark harness.
+ *  @class      Bench
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include "prot.hpp"
+
+/***********************************************************************************************//**
+ *  Runs a set of named cases and measures the wall time of each operation. Every case is made of
+ *  a setup function, which is only called if the case is selected, that returns the body of the
+ *  case: a function that runs the measured operation `n` times. The number of operations of a
+ *  sample is calibrated so that a sample lasts at least `min_time / samples` seconds. Results are
+ *  given in nanoseconds per operation (minimum, median and mean of the samples) and can be written
+ *  as JSON to be compared between builds.
+ **************************************************************************************************/
+class Bench
+{
+public:
+    typedef std::function<void(unsigned long)> Body;
+
+    struct Result {
+        std::string name;
+        unsigned long ops;          /**< Operations per sample. */
+        unsigned int samples;
+        double items;               /**< Items processed in each operation (e.g. cells, agents). */
+        double ns_min;
+        double ns_median;
+        double ns_mean;
+        std::map<std::string, double> metrics;  /**< Additional values reported by the case. */
+    };
+
+    Bench(double min_time = 0.5, unsigned int samples = 7);
+
+    /*******************************************************************************************//**
+     *  Registers a case.
+     *  @param  name    Name of the case (usually the name of the benchmarked function).
+     *  @param  setup   Prepares the inputs of the case and returns its body.
+     *  @param  items   Items processed in each operation, used to report the time per item.
+     **********************************************************************************************/
+    void add(std::string name, std::function<Body(void)> setup, double items = 1.0);
+
+    /*******************************************************************************************//**
+     *  Sets an additional value in the result of the case that is running.
+     **********************************************************************************************/
+    void setMetric(std::string key, double value);
+
+    /*******************************************************************************************//**
+     *  Runs the cases whose name contains `filter` (all of them if it is empty).
+     *  @return The number of cases that have been run.
+     **********************************************************************************************/
+    unsigned int run(std::string filter = "");
+
+    void list(std::ostream& os) const;
+    void print(std::ostream& os) const;
+    bool writeJSON(std::string path) const;
+
+    const std::vector<Result>& getResults(void) const { return m_results; }
+
+    /*******************************************************************************************//**
+     *  Prevents the compiler from optimizing away the computation of `v`.
+     **********************************************************************************************/
+    template <class T>
+    static void keep(const T& v) { asm volatile("" : : "g"(&v) : "memory"); }
+
+private:
+    struct Case {
+        std::string name;
+        std::function<Body(void)> setup;
+        double items;
+    };
+    std::vector<Case> m_cases;
+    std::vector<Result> m_results;
+    Result* m_current;
+    double m_min_time;
+    unsigned int m_samples;
+
+    static double time(Body& body, unsigned long n);
+};
+
+#endif /* BENCH_HPP */
@@ -0,0 +1,443 @@
+/***********************************************************************************************//**
+ *  Micro-benchmarks of the hot kernels of the simulator.
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#include "prot.hpp"
+
+#include "Bench.hpp"
+#include "Agent.hpp"
+#include "AgentBuilder.hpp"
+#include "Activity.hpp"
+#include "EnvCell.hpp"
+#include "PayoffFunctions.hpp"
+#include "BasicInstrument.hpp"
+#include "CoordinateSystemUtils.hpp"
+#include "GASChromosome.hpp"
+#include "GAScheduler.hpp"
+#include "ReportGenerator.hpp"
+#include "TaskPool.hpp"
+#include "GridView.hpp"
+#include "WorldPyramid.hpp"
+
+CREATE_LOGGER(bench_kernels)
+
+/*  Creates `n` agents (always the same) and connects their links. The virtual time is restarted. **/
+std::vector<std::shared_ptr<Agent> > makeAgents(unsigned int n)
+{
+    Random::getUniformEngine().seed(1234);
+    VirtualTime::doInit(Config::start_epoch);
+    std::vector<std::shared_ptr<Agent> > agents;
+    for(unsigned int i = 0; i < n; i++) {
+        AgentBuilder ab;
+        ab.generateAndStore("A" + std::to_string(i));
+        agents.push_back(std::make_shared<Agent>(&ab));
+    }
+    for(auto& a : agents) {
+        a->getLink()->setAgents(agents);
+        a->getLink()->enable();
+    }
+    return agents;
+}
+
+/*  Activity of another agent with one interval in cell (x, y). **/
+std::shared_ptr<Activity> makeActivity(std::string aid, int id, unsigned int x, unsigned int y, double t0, double t1)
+{
+    ActivityCell c;
+    c.x = x;
+    c.y = y;
+    c.nts = 1;
+    c.t0s = new double[1];
+    c.t1s = new double[1];
+    c.t0s[0] = t0;
+    c.t1s[0] = t1;
+    c.ready = true;
+    c.aux = 0;
+    Trajectory traj(t0, (t1 - t0) / 4.0);
+    for(int i = 0; i < 5; i++) {
+        traj.addPosition(sf::Vector3f(i, 0.f, 0.f));
+    }
+    auto act = std::make_shared<Activity>(aid, id);
+    act->setTrajectory(traj, {c});
+    return act;
+}
+
+void addPayoffCases(Bench& b)
+{
+    const unsigned int n = 1024;
+    b.add("PayoffFunctions::payoff", [n]() {
+        PayoffFunctions::bindPayoffFunctions();
+        auto rts = std::make_shared<std::vector<double> >(n);
+        for(unsigned int i = 0; i < n; i++) {
+            (*rts)[i] = Config::time_step * i;
+        }
+        return [rts](unsigned long ops) {
+            for(unsigned long k = 0; k < ops; k++) {
+                float acc = 0.f;
+                for(auto rt : *rts) {
+                    acc += PayoffFunctions::payoff(rt);
+                }
+                Bench::keep(acc);
+            }
+        };
+    }, n);
+
+    const int nts = 64;
+    const unsigned int n_acts = 32;
+    b.add("EnvCell::computeCellPayoff", [nts, n_acts]() {
+        PayoffFunctions::bindPayoffFunctions();
+        auto agents = makeAgents(1);
+        auto cell = std::make_shared<EnvCell>(agents[0].get(), 3, 4);
+        cell->pushPayoffFunc(PayoffFunctions::f_revisit_time_backwards);
+        cell->pushPayoffFunc(PayoffFunctions::f_revisit_time_forwards);
+
+        /* Activities of other agents spread over the window, and the intervals to evaluate: */
+        double t = VirtualTime::now();
+        double span = Config::agent_planning_window * Config::time_step;
+        auto acts = std::make_shared<std::vector<std::shared_ptr<Activity> > >();
+        for(unsigned int k = 0; k < n_acts; k++) {
+            double t0 = t + span * k / n_acts;
+            acts->push_back(makeActivity("B" + std::to_string(k % 7), k, 3, 4, t0, t0 + Config::time_step));
+            if(k % 3 == 0) {
+                acts->back()->setConfirmed();
+            } else {
+                acts->back()->setConfidenceBaseline(0.5f);
+            }
+            cell->addCellActivity(acts->back());
+        }
+        auto t0s = std::make_shared<std::vector<double> >(nts);
+        auto t1s = std::make_shared<std::vector<double> >(nts);
+        for(int i = 0; i < nts; i++) {
+            (*t0s)[i] = t + span * i / nts;
+            (*t1s)[i] = (*t0s)[i] + Config::time_step;
+        }
+        return [agents, cell, acts, t0s, t1s, nts](unsigned long ops) {
+            for(unsigned long k = 0; k < ops; k++) {
+                cell->setDirty();   /* Forces a full evaluation. */
+                Bench::keep(cell->computeCellPayoff(t0s->data(), t1s->data(), nts));
+            }
+        };
+    }, nts);
+}
+
+void addGeometryCases(Bench& b)
+{
+    b.add("CoordinateSystemUtils::fromECIToECEF", []() {
+        auto agents = makeAgents(1);
+        AgentMotion m(agents[0]->getMotion());
+        auto ps = std::make_shared<std::vector<sf::Vector3f> >(m.propagate(Config::agent_planning_window));
+        double t = VirtualTime::now();
+        return [ps, t](unsigned long ops) {
+            for(unsigned long k = 0; k < ops; k++) {
+                for(auto& p : *ps) {
+                    Bench::keep(CoordinateSystemUtils::fromECIToECEF(p, t));
+                }
+            }
+        };
+    }, Config::agent_planning_window);
+
+    b.add("CoordinateSystemUtils::fromECIToECEF[batch]", []() {
+        auto agents = makeAgents(1);
+        AgentMotion m(agents[0]->getMotion());
+        auto ps = std::make_shared<std::vector<sf::Vector3f> >(m.propagate(Config::agent_planning_window));
+        auto ecef = std::make_shared<Vec3Array<double> >();
+        double t = VirtualTime::now();
+        return [ps, ecef, t](unsigned long ops) {
+            for(unsigned long k = 0; k < ops; k++) {
+                CoordinateSystemUtils::fromECIToECEF(ps->data(), ps->size(), t, *ecef);
+                Bench::keep(ecef->x.back());
+            }
+        };
+    }, Config::agent_planning_window);
+
+    /*  BasicInstrument::applyToDistance3D is private: it is measured through getVisibleCells, which
+     *  only adds the projection of the origin and the collection of the visible cells.
+     **/
+    for(bool cached : {false, true}) {
+        std::string name = std::string("BasicInstrument::getVisibleCells") + (cached ? "[cached]" : "");
+        b.add(name, [&b, cached]() {
+            Config::instrument_footprint_cache = cached;
+            auto agents = makeAgents(1);
+            auto env = agents[0]->getEnvironment();
+            const AgentMotion& m = agents[0]->getMotion();
+            auto ins = std::make_shared<BasicInstrument>(Config::agent_aperture_max, m.getMaxAltitude());
+            ins->setDimensions(env->getEnvModelInfo());
+            sf::Vector3f p = m.getPosition();
+            double t = VirtualTime::now();
+            double r = ins->getSwath(p, ins->getAperture()) / 2.f;
+            return [&b, agents, env, ins, p, t, r](unsigned long ops) {
+                std::size_t cells = 0;
+                for(unsigned long k = 0; k < ops; k++) {
+                    cells += ins->getVisibleCells(env->getPositionLUT(), r, p, false, t).size();
+                }
+                b.setMetric("cells_per_op", (double)cells / ops);
+            };
+        });
+    }
+
+    b.add("AgentMotion::propagate", []() {
+        auto agents = makeAgents(1);
+        AgentMotion m0(agents[0]->getMotion());
+        return [agents, m0](unsigned long ops) {
+            for(unsigned long k = 0; k < ops; k++) {
+                AgentMotion m(m0);  /* Only positions that have not been propagated are computed. */
+                Bench::keep(m.propagate(Config::agent_planning_window));
+            }
+        };
+    }, Config::agent_planning_window);
+}
+
+void addSchedulerCases(Bench& b)
+{
+    const unsigned int len = 64;
+    b.add("GASChromosome::crossover", [len]() {
+        Random::getUniformEngine().seed(1234);
+        auto p = std::make_shared<std::vector<GASChromosome> >();
+        p->push_back(GASChromosome(len));
+        p->push_back(GASChromosome(len));
+        p->push_back(GASChromosome(len, false));
+        p->push_back(GASChromosome(len, false));
+        return [p](unsigned long ops) {
+            for(unsigned long k = 0; k < ops; k++) {
+                GASChromosome::crossover((*p)[0], (*p)[1], (*p)[2], (*p)[3]);
+                Bench::keep((*p)[2]);
+            }
+        };
+    });
+
+    b.add("GASChromosome::mutate", [len]() {
+        Random::getUniformEngine().seed(1234);
+        auto c = std::make_shared<GASChromosome>(len);
+        return [c](unsigned long ops) {
+            for(unsigned long k = 0; k < ops; k++) {
+                c->mutate();
+                Bench::keep(*c);
+            }
+        };
+    });
+
+    /*  GAScheduler::computeFitness is private: the whole scheduler is run and the time spent in
+     *  fitness evaluations is taken from the "ga_fitness" counter of the task pool.
+     **/
+    b.add("GAScheduler::schedule", [&b]() {
+        Config::ga_generations = 20;
+        auto agents = makeAgents(1);
+        std::map<std::string, std::shared_ptr<const Resource> > res;
+        res["energy"] = agents[0]->getResource("energy");
+        double t = VirtualTime::now();
+        return [&b, agents, res, t](unsigned long ops) {
+            const unsigned int n = 24;
+            TaskPool::resetCounters();
+            Random::getUniformEngine().seed(1234);
+            for(unsigned long k = 0; k < ops; k++) {
+                std::vector<double> t0s, t1s;
+                for(unsigned int i = 0; i < n; i++) {
+                    t0s.push_back(t + 4 * i * Config::time_step);
+                    t1s.push_back(t + (4 * i + 3) * Config::time_step);
+                }
+                GAScheduler gas(t0s.front(), t1s.back(), res);
+                gas.setChromosomeInfo(t0s, t1s, {{"energy", 5.0}});
+                for(unsigned int i = 0; i < n; i++) {
+                    std::vector<sf::Vector2i> cells {{(int)i, 0}, {(int)i, 1}, {(int)i, 2}};
+                    std::vector<float> payoffs {0.1f * (i % 10), 0.5f, 0.05f * (i % 20)};
+                    gas.setAggregatedPayoff(i, cells, payoffs, 0.5f);
+                }
+                std::vector<std::shared_ptr<Activity> > adis;
+                GAScheduler::Solution result;
+                Bench::keep(gas.schedule(adis, result));
+            }
+            auto c = TaskPool::getCounters()["ga_fitness"];
+            if(c.items > 0) {
+                b.setMetric("computeFitness_ns", c.total_time * 1e9 / c.items);
+                b.setMetric("computeFitness_per_op", (double)c.items / ops);
+            }
+        };
+    });
+}
+
+void addAgentCases(Bench& b)
+{
+    const unsigned int n_agents = 32;
+    b.add("AgentLink::update", [n_agents]() {
+        auto agents = makeAgents(n_agents);
+        return [agents](unsigned long ops) {
+            for(unsigned long k = 0; k < ops; k++) {
+                for(auto& a : agents) {
+                    a->getLink()->update();
+                }
+            }
+        };
+    }, n_agents);
+
+    for(bool flush : {false, true}) {
+        std::string name = std::string("ReportGenerator::outputReport") + (flush ? "[flush]" : "");
+        b.add(name, [flush]() {
+            VirtualTime::doInit(Config::start_epoch);
+            auto rg = std::make_shared<ReportGenerator>("bench/", std::string("report.csv"), false);
+            for(int c = 0; c < 8; c++) {
+                rg->addReportColumn("column_" + std::to_string(c));
+            }
+            rg->enableReport();
+            return [rg, flush](unsigned long ops) {
+                for(unsigned long k = 0; k < ops; k++) {
+                    for(int c = 0; c < 8; c++) {
+                        rg->setReportColumnValue(c, 0.125 * c + k);
+                    }
+                    rg->outputReport(flush, Config::start_epoch + k);
+                }
+            };
+        });
+    }
+}
+
+void addViewCases(Bench& b)
+{
+    /*  World-sized grid recolored as in World::display, with values that stay the same between
+     *  frames (only the quantized LUT entry is compared) or that change in every frame.
+     **/
+    const int w = Config::world_width;
+    const int h = Config::world_height;
+    for(bool texture : {false, true}) {
+        for(bool changing : {false, true}) {
+            std::string name = std::string("GridView::setValue[") + (texture ? "texture" : "vertices")
+                + (changing ? ",changing]" : ",static]");
+            b.add(name, [w, h, texture, changing]() {
+                auto view = std::make_shared<GridView>(w, h, 1.f, 1.f, sf::Color(127, 127, 127), texture);
+                auto values = std::make_shared<std::vector<float> >(2 * w * h);
+                for(int i = 0; i < w * h; i++) {
+                    (*values)[i] = (float)(i % (w + h)) / (w + h);
+                    (*values)[w * h + i] = (changing ? 1.f - (*values)[i] : (*values)[i]);
+                }
+                return [view, values, w, h](unsigned long ops) {
+                    for(unsigned long k = 0; k < ops; k++) {
+                        const float* v = values->data() + (k % 2) * w * h;
+                        for(int x = 0; x < w; x++) {
+                            for(int y = 0; y < h; y++) {
+                                view->setValue(x, y, v[x * h + y]);
+                            }
+                        }
+                    }
+                };
+            }, (double)w * h);
+        }
+    }
+}
+
+/*  World-sized pyramid visited by swaths that sweep the world (like ground tracks). **/
+void visitSwaths(WorldPyramid& p, unsigned int steps)
+{
+    const unsigned int w = p.getWidth(0);
+    const unsigned int h = p.getHeight(0);
+    for(unsigned int s = 0; s < steps; s++) {
+        p.step();
+        for(unsigned int a = 0; a < 40; a++) {
+            unsigned int x0 = (a * 97 + s * 7) % w;
+            unsigned int y0 = (a * 53 + s * 3) % h;
+            for(unsigned int x = x0; x < std::min(x0 + 20, w); x++) {
+                for(unsigned int y = y0; y < std::min(y0 + 20, h); y++) {
+                    p.visit(x, y, (a + s / 50) % 3 != 0);
+                }
+            }
+        }
+    }
+}
+
+void addWorldCases(Bench& b)
+{
+    /* Region queries as in World::computeMetrics (14 regions and the whole world), and refreshes: */
+    const unsigned int w = Config::world_width;
+    const unsigned int h = Config::world_height;
+    b.add("WorldPyramid::getRegionStats[metrics]", [w, h]() {
+        auto p = std::make_shared<WorldPyramid>(w, h);
+        visitSwaths(*p, 2000);
+        p->refresh();
+        return [p, w, h](unsigned long ops) {
+            unsigned int wg = w / 4;
+            unsigned int hg = h / 6;
+            for(unsigned long k = 0; k < ops; k++) {
+                for(unsigned int q = 0; q < 14; q++) {
+                    unsigned int x = (q % 4) * wg;
+                    unsigned int y = (q / 4) * hg;
+                    p->getRegionStats(x, x + wg, y, y + hg, 300);
+                }
+                p->getRegionStats(0, w, 0, h, 300);
+            }
+        };
+    }, 2.0 * w * h);
+    b.add("WorldPyramid::refresh[10 steps]", [w, h]() {
+        auto p = std::make_shared<WorldPyramid>(w, h);
+        visitSwaths(*p, 1000);
+        p->refresh();
+        return [p](unsigned long ops) {
+            for(unsigned long k = 0; k < ops; k++) {
+                visitSwaths(*p, 10);
+                p->refresh();
+            }
+        };
+    });
+}
+
+int main(int argc, char** argv)
+{
+    std::string filter, json;
+    double min_time = 0.5;
+    unsigned int samples = 7;
+    bool list = false;
+    LogStream::Level level = LogStream::Level::ERROR;
+    Config::data_path = "/tmp/prot-3-bench/";
+    for(int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        bool has_value = (i + 1 < argc);
+        if(arg == "--filter" && has_value) {
+            filter = argv[++i];
+        } else if(arg == "--min-time" && has_value) {
+            min_time = std::stod(argv[++i]);
+        } else if(arg == "--samples" && has_value) {
+            samples = std::stoi(argv[++i]);
+        } else if(arg == "--json" && has_value) {
+            json = argv[++i];
+        } else if(arg == "--data-path" && has_value) {
+            Config::data_path = std::string(argv[++i]) + "/";
+        } else if(arg == "--list") {
+            list = true;
+        } else if(arg == "--verbose") {
+            level = LogStream::Level::DEBUG;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--filter <substring>] [--min-time <seconds>] "
+                << "[--samples <n>] [--json <file>] [--data-path <dir>] [--list] [--verbose]\n";
+            return 1;
+        }
+    }
+    LogStream::setLogLevel(level);
+    Config::motion_model = AgentMotionType::ORBITAL;
+    std::string cmd = "mkdir -p " + Config::data_path;
+    if(std::system(cmd.c_str()) != 0) {
+        Log::err << "Unable to create data directory: " << Config::data_path << ". Check permissions.\n";
+        return 1;
+    }
+
+    Bench b(min_time, samples);
+    addPayoffCases(b);
+    addGeometryCases(b);
+    addSchedulerCases(b);
+    addAgentCases(b);
+    addViewCases(b);
+    addWorldCases(b);
+    if(list) {
+        b.list(std::cout);
+        return 0;
+    }
+    if(b.run(filter) == 0) {
+        std::cerr << "No benchmark matches \'" << filter << "\'.\n";
+        return 1;
+    }
+    b.print(std::cout);
+    if(!json.empty() && !b.writeJSON(json)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,380 @@
+/***********************************************************************************************//**
+ *  End-to-end benchmark of canned headless scenarios.
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#include "prot.hpp"
+
+#include <atomic>
+#include <sys/resource.h>
+
+#include "Agent.hpp"
+#include "AgentBuilder.hpp"
+#include "Init.hpp"
+#include "ReportSet.hpp"
+#include "TaskPool.hpp"
+
+CREATE_LOGGER(bench_scenarios)
+
+/*  Allocations done through operator new (i.e. by C++ containers and objects). **/
+static std::atomic<unsigned long> alloc_count(0);
+static std::atomic<unsigned long> alloc_bytes(0);
+
+void* operator new(std::size_t sz)
+{
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    alloc_bytes.fetch_add(sz, std::memory_order_relaxed);
+    void* p = std::malloc(sz == 0 ? 1 : sz);
+    if(p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+enum Phase { PROPAGATE, PLAN, STEP, WORLD, METRICS, REPORTS, N_PHASES };
+static const char* phase_names[N_PHASES] = { "propagate", "plan", "step", "world", "metrics", "reports" };
+
+struct Scenario {
+    std::string name;
+    std::string conf;           /**< Configuration file (relative to conf/). */
+    unsigned int n_agents;      /**< Agents to generate (ignored if `system_yml` is set). */
+    std::string system_yml;     /**< Agent set (relative to the root path), all of its agents are loaded. */
+};
+
+/*  Results of a scenario, sent by the child process that runs it (hence, plain data only). **/
+struct ScenarioResult {
+    unsigned int agents;
+    unsigned int steps;
+    double setup_time;
+    double run_time;
+    double phase_time[N_PHASES];
+    unsigned long allocs;       /**< Allocations during the run (setup excluded). */
+    unsigned long alloc_bytes;
+    long peak_rss;              /**< Peak resident set size of the process (KiB). Set by the parent. */
+};
+
+struct Options {
+    unsigned int steps = 120;
+    unsigned int seed = 1234;
+    std::string root;
+    std::string out = "bench_data";
+    bool verbose = false;
+};
+
+static const std::vector<Scenario> scenarios = {
+    {"debug-10",        "debug.yml", 10,  ""},
+    {"synthetic-100",   "debug.yml", 100, ""},
+    {"flock",           "debug.yml", 0,   "batch/set/largescale/flock-2018-operational.yml"},
+};
+
+double elapsed(std::chrono::steady_clock::time_point& t0)
+{
+    auto t1 = std::chrono::steady_clock::now();
+    double dt = std::chrono::duration<double>(t1 - t0).count();
+    t0 = t1;
+    return dt;
+}
+
+/*  Runs one scenario in the calling process. Configuration is loaded as in prot-3 (i.e. with the
+ *  same command line arguments) and then overridden to make runs headless and reproducible. The
+ *  step loop is that of `control_loop` in main.cpp, without idle step skipping.
+ **/
+ScenarioResult runScenario(const Scenario& sc, const Options& opts)
+{
+    ScenarioResult r = {};
+    auto t0 = std::chrono::steady_clock::now();
+    Init::doInit();
+    LogStream::setLogLevel(opts.verbose ? LogStream::Level::DEBUG : LogStream::Level::ERROR);
+    std::vector<std::string> args = {"prot-3-bench"};
+    if(!opts.root.empty()) {
+        args.insert(args.end(), {"--dbg-rootdir", opts.root + "/"});
+    }
+    args.insert(args.end(), {"-f", sc.conf, "-d", opts.out + "/" + sc.name, "-g0", "--simple-log"});
+    std::vector<char*> argv;
+    for(auto& a : args) {
+        argv.push_back(&a[0]);
+    }
+    Config::loadCmdArgs(argv.size(), argv.data());
+    Init::createOutputDirectories();
+    Config::enable_graphics = false;
+    Config::event_driven = false;
+    Config::duration = std::max(Config::duration, (opts.steps + 1) * Config::time_step);
+    Random::getUniformEngine().seed(opts.seed);
+
+    std::vector<std::shared_ptr<Agent> > agents;
+    if(!sc.system_yml.empty()) {
+        AgentBuilder agent_builder;
+        auto abset = agent_builder.load(Config::root_path + sc.system_yml);
+        Config::n_agents = abset.size();
+        for(auto ab : abset) {
+            agents.push_back(std::make_shared<Agent>(&ab));
+        }
+    } else {
+        Config::n_agents = sc.n_agents;
+        for(unsigned int i = 0; i < sc.n_agents; i++) {
+            AgentBuilder ab;
+            ab.generateAndStore("A" + std::to_string(i));
+            agents.push_back(std::make_shared<Agent>(&ab));
+        }
+    }
+    for(auto& a : agents) {
+        a->getLink()->setAgents(agents);
+    }
+    auto world = std::make_shared<World>();
+    world->addAgent(agents);
+    ReportSet::getInstance().outputAllHeaders();
+    r.agents = agents.size();
+    r.setup_time = elapsed(t0);
+
+    unsigned long allocs0 = alloc_count.load();
+    unsigned long bytes0 = alloc_bytes.load();
+    auto t_run = t0;
+    for(unsigned int s = 0; s < opts.steps && !VirtualTime::finished(); s++) {
+        VirtualTime::step();
+        for(auto& a : agents) {
+            a->updatePosition();
+        }
+        r.phase_time[PROPAGATE] += elapsed(t0);
+        TaskPool::parallelFor(agents.size(), 1, [&agents](std::size_t i) {
+            agents[i]->plan();
+        }, "planner", Config::parallel_planners);
+        r.phase_time[PLAN] += elapsed(t0);
+        if(Config::parallel_agent_step) {
+            Agent::stepTwoPhase(agents, true);
+        } else {
+            for(auto& a : agents) {
+                a->step();
+            }
+        }
+        r.phase_time[STEP] += elapsed(t0);
+        world->step();
+        r.phase_time[WORLD] += elapsed(t0);
+        if(s % 10 == 0) {
+            world->computeMetrics();
+            r.phase_time[METRICS] += elapsed(t0);
+            ReportSet::getInstance().outputAll();
+            r.phase_time[REPORTS] += elapsed(t0);
+        }
+        r.steps++;
+    }
+    world->computeMetrics(true);
+    r.phase_time[METRICS] += elapsed(t0);
+    ReportSet::getInstance().outputAll();
+    r.phase_time[REPORTS] += elapsed(t0);
+    r.run_time = std::chrono::duration<double>(t0 - t_run).count();
+    r.allocs = alloc_count.load() - allocs0;
+    r.alloc_bytes = alloc_bytes.load() - bytes0;
+    return r;
+}
+
+/*  Runs a scenario in a child process, so that every scenario starts from the same (static)
+ *  configuration and state, and its peak RSS can be measured separately.
+ **/
+bool forkScenario(const Scenario& sc, const Options& opts, ScenarioResult& r)
+{
+    int fds[2];
+    if(pipe(fds) != 0) {
+        Log::err << "Unable to create a pipe for scenario \'" << sc.name << "\'.\n";
+        return false;
+    }
+    pid_t cpid = fork();
+    if(cpid == 0) {
+        close(fds[0]);
+        ScenarioResult cr = runScenario(sc, opts);
+        bool ok = (write(fds[1], &cr, sizeof(cr)) == sizeof(cr));
+        close(fds[1]);
+        std::_Exit(ok ? 0 : 1);     /* Skips the destruction of the simulation state. */
+    } else if(cpid < 0) {
+        Log::err << "Unable to fork for scenario \'" << sc.name << "\'.\n";
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    close(fds[1]);
+    bool ok = (read(fds[0], &r, sizeof(r)) == sizeof(r));
+    close(fds[0]);
+    int status;
+    struct rusage ru;
+    wait4(cpid, &status, 0, &ru);
+    if(!ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        Log::err << "Scenario \'" << sc.name << "\' failed (status " << status << ").\n";
+        return false;
+    }
+    r.peak_rss = ru.ru_maxrss;
+    return true;
+}
+
+void print(std::ostream& os, const std::vector<std::pair<std::string, ScenarioResult> >& results)
+{
+    os << std::left << std::setw(16) << "Scenario" << std::right << std::setw(8) << "agents" << std::setw(8) << "steps"
+        << std::setw(10) << "steps/s" << std::setw(10) << "setup" << std::setw(10) << "run";
+    for(int p = 0; p < N_PHASES; p++) {
+        os << std::setw(11) << phase_names[p];
+    }
+    os << std::setw(12) << "RSS (MiB)" << std::setw(12) << "allocs/step" << "\n";
+    for(auto& res : results) {
+        const ScenarioResult& r = res.second;
+        os << std::left << std::setw(16) << res.first << std::right << std::fixed << std::setprecision(2)
+            << std::setw(8) << r.agents << std::setw(8) << r.steps << std::setw(10) << r.steps / r.run_time
+            << std::setw(10) << r.setup_time << std::setw(10) << r.run_time;
+        for(int p = 0; p < N_PHASES; p++) {
+            os << std::setw(11) << r.phase_time[p];
+        }
+        os << std::setw(12) << r.peak_rss / 1024.0 << std::setw(12) << std::setprecision(0)
+            << (double)r.allocs / r.steps << "\n";
+    }
+    os.unsetf(std::ios::floatfield);
+}
+
+bool writeJSON(std::string path, const Options& opts, const std::vector<std::pair<std::string, ScenarioResult> >& results)
+{
+    std::ofstream f(path, std::ios::out | std::ios::trunc);
+    if(!f.is_open()) {
+        Log::err << "Unable to write benchmark results to \'" << path << "\'.\n";
+        return false;
+    }
+    f << std::setprecision(6) << std::fixed;
+    f << "{\n";
+    f << "  \"steps\": " << opts.steps << ",\n";
+    f << "  \"seed\": " << opts.seed << ",\n";
+    f << "  \"threads\": " << omp_get_max_threads() << ",\n";
+    f << "  \"scenarios\": [\n";
+    for(auto res = results.begin(); res != results.end(); res++) {
+        const ScenarioResult& r = res->second;
+        f << "    {\n";
+        f << "      \"name\": \"" << res->first << "\",\n";
+        f << "      \"agents\": " << r.agents << ",\n";
+        f << "      \"steps\": " << r.steps << ",\n";
+        f << "      \"steps_per_s\": " << r.steps / r.run_time << ",\n";
+        f << "      \"setup_s\": " << r.setup_time << ",\n";
+        f << "      \"run_s\": " << r.run_time << ",\n";
+        f << "      \"phases_s\": {";
+        for(int p = 0; p < N_PHASES; p++) {
+            f << (p > 0 ? ", " : "") << "\"" << phase_names[p] << "\": " << r.phase_time[p];
+        }
+        f << "},\n";
+        f << "      \"peak_rss_kib\": " << r.peak_rss << ",\n";
+        f << "      \"allocs\": " << r.allocs << ",\n";
+        f << "      \"alloc_bytes\": " << r.alloc_bytes << "\n";
+        f << "    }" << (std::next(res) != results.end() ? "," : "") << "\n";
+    }
+    f << "  ]\n";
+    f << "}\n";
+    return true;
+}
+
+/*  Compares the results with a baseline (a JSON file written by this program). Throughput can
+ *  not decrease, and peak RSS and allocations can not increase, by more than `tol` (relative).
+ *  Returns the number of regressions.
+ **/
+unsigned int compare(std::string path, double tol, const std::vector<std::pair<std::string, ScenarioResult> >& results)
+{
+    YAML::Node baseline = YAML::LoadFile(path);    /* JSON is parsed as YAML. */
+    unsigned int regressions = 0;
+    auto check = [&](std::string sc, std::string metric, double b, double v, bool higher_is_better) {
+        double delta = (b != 0.0 ? (v - b) / b : 0.0);
+        bool regressed = (higher_is_better ? delta < -tol : delta > tol);
+        regressions += regressed;
+        std::cout << std::left << std::setw(16) << sc << std::setw(14) << metric << std::right << std::fixed
+            << std::setprecision(2) << std::setw(14) << b << std::setw(14) << v << std::setw(9) << delta * 100.0 << " %"
+            << (regressed ? "  REGRESSION" : "") << "\n";
+    };
+    std::cout << "Comparison with \'" << path << "\' (tolerance: " << tol * 100.0 << " %):\n";
+    for(auto& res : results) {
+        bool found = false;
+        for(auto bs : baseline["scenarios"]) {
+            if(bs["name"].as<std::string>() != res.first) {
+                continue;
+            }
+            const ScenarioResult& r = res.second;
+            check(res.first, "steps_per_s", bs["steps_per_s"].as<double>(), r.steps / r.run_time, true);
+            check(res.first, "peak_rss_kib", bs["peak_rss_kib"].as<double>(), r.peak_rss, false);
+            check(res.first, "allocs", bs["allocs"].as<double>(), r.allocs, false);
+            found = true;
+        }
+        if(!found) {
+            Log::warn << "Scenario \'" << res.first << "\' is not in the baseline.\n";
+        }
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    return regressions;
+}
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    std::string filter, json, baseline;
+    double tolerance = 0.1;
+    for(int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        bool has_value = (i + 1 < argc);
+        if(arg == "--scenario" && has_value) {
+            filter = argv[++i];
+        } else if(arg == "--steps" && has_value) {
+            opts.steps = std::stoi(argv[++i]);
+        } else if(arg == "--seed" && has_value) {
+            opts.seed = std::stoi(argv[++i]);
+        } else if(arg == "--root" && has_value) {
+            opts.root = argv[++i];
+        } else if(arg == "--out" && has_value) {
+            opts.out = argv[++i];
+        } else if(arg == "--json" && has_value) {
+            json = argv[++i];
+        } else if(arg == "--baseline" && has_value) {
+            baseline = argv[++i];
+        } else if(arg == "--tolerance" && has_value) {
+            tolerance = std::stod(argv[++i]);
+        } else if(arg == "--list") {
+            for(auto& sc : scenarios) {
+                std::cout << sc.name << "\n";
+            }
+            return 0;
+        } else if(arg == "--verbose") {
+            opts.verbose = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--scenario <name>] [--steps <n>] [--seed <n>] [--root <dir>] "
+                << "[--out <dir>] [--json <file>] [--baseline <file>] [--tolerance <fraction>] [--list] [--verbose]\n";
+            return 1;
+        }
+    }
+
+    std::vector<std::pair<std::string, ScenarioResult> > results;
+    bool failed = false;
+    for(auto& sc : scenarios) {
+        if(!filter.empty() && sc.name != filter) {
+            continue;
+        }
+        ScenarioResult r;
+        if(forkScenario(sc, opts, r)) {
+            results.push_back(std::make_pair(sc.name, r));
+        } else {
+            failed = true;
+        }
+    }
+    if(results.empty()) {
+        std::cerr << "No scenario has been run.\n";
+        return 1;
+    }
+    print(std::cout, results);
+    if(!json.empty() && !writeJSON(json, opts, results)) {
+        return 1;
+    }
+    if(!baseline.empty() && compare(baseline, tolerance, results) > 0) {
+        return 2;
+    }
+    return (failed ? 1 : 0);
+}
@@ -11,9 +11,16 @@
 
 #include "Agent.hpp"
 #include "AgentBuilder.hpp"
+#include "TLECatalogue.hpp"
 #include "MultiView.hpp"
 #include "MessageBox.hpp"
 #include "Init.hpp"
+#include "TaskPool.hpp"
+#include "Profiler.hpp"
+#include "MemoryReport.hpp"
+#include "RenderSnapshot.hpp"
+#include "TripleBuffer.hpp"
+#include <future>
 
 CREATE_LOGGER(main)
 
@@ -24,11 +31,11 @@ struct ControlInfo {
     std::string agent_id;
 };
 
-std::timed_mutex mutex_draw;
 std::timed_mutex mutex_control;
 std::vector<std::shared_ptr<Agent> > agents;
 std::vector<ControlInfo> control_info;
 std::shared_ptr<World> world;
+TripleBuffer<RenderSnapshot> render_snapshots;
 bool exit_draw_loop;
 bool exit_control_loop;
 
@@ -36,10 +43,13 @@ bool exit_control_loop;
 void handleEvents(sf::RenderWindow& w);
 void testModePayoff(void);
 void parseTLEFile(void);
-void draw_loop(void);
+void draw_loop(std::promise<void>& setup_done);
 void control_loop(void);
+void skip_idle_steps(int& update_world_metrics);
+void report_memory(MemoryReport& mr);
+void publish_snapshot(bool update_grids);
 
-void draw_loop(void)
+void draw_loop(std::promise<void>& setup_done)
 {
     Log::dbg << "Draw thread started.\n";
     sf::ContextSettings settings;
@@ -47,29 +57,33 @@ void draw_loop(void)
     sf::RenderWindow window(sf::VideoMode(Config::win_width, Config::win_height), "Autonomous DSS Simulation Tool", sf::Style::Titlebar | sf::Style::Close, settings);
     window.setFramerateLimit(5);
 
-    /* Configure Agent Views: */
-    for(auto a : agents) {
-        a->showResources(true);
+    /*  Copy the views (the control thread waits until they are copied). From now on, they are only
+     *  updated with the snapshots published by the control thread:
+     **/
+    std::vector<std::shared_ptr<SnapshotView<AgentView> > > agent_views;
+    std::vector<std::shared_ptr<SnapshotView<AgentLinkView> > > link_views;
+    for(auto& a : agents) {
+        agent_views.push_back(std::make_shared<SnapshotView<AgentView> >(a->getView()));
+        link_views.push_back(std::make_shared<SnapshotView<AgentLinkView> >(a->getLink()->getView()));
     }
-    agents[0]->displayActivities(ActivityDisplayType::ALL);
-    agents[0]->showResources(true);
-    agents[0]->getEnvironment()->buildView();
+    auto activities_view = std::make_shared<SnapshotView<ActivityHandlerView> >(ActivityHandlerView());
+    auto payoff_view = std::make_shared<SnapshotView<GridView> >(agents[0]->getEnvironment()->getView());
+    auto actual_view = std::make_shared<SnapshotView<GridView> >(world->getView());
+    auto utopia_view = std::make_shared<SnapshotView<GridView> >(world->getView());
+    setup_done.set_value();
 
     /* Create multi-views: ---------------------------------------------------------------------- */
-    std::vector<std::shared_ptr<const HasView> > avs(agents.begin(), agents.end());   /* Casts. */
     MultiView mv1, mv2, mv3, mv4;
-    // mv1.setViews(avs);
-    mv2.addViewToBack(agents[0]->getEnvironment());
-    mv2.addViewToBack(std::static_pointer_cast<const HasView>(agents[0]->getActivityHandler()));
-    mv2.addViewToBack(avs[0]);
-    mv3.addViewToBack(world);
-    mv4.addViewToBack(world);
+    mv2.addViewToBack(payoff_view);
+    mv2.addViewToBack(activities_view);
+    mv2.addViewToBack(agent_views[0]);
+    mv3.addViewToBack(actual_view);
+    mv4.addViewToBack(utopia_view);
     for(unsigned int i = 0; i < agents.size(); i++) {
-        mv1.addViewToBack(std::static_pointer_cast<const HasView>(agents[i]->getLink()));
-        mv1.addViewToBack(avs[i]);
-        // mv1.addViewToBack(std::static_pointer_cast<const HasView>(agents[i]->getActivityHandler()));
-        mv3.addViewToBack(avs[i]);
-        mv4.addViewToBack(avs[i]);
+        mv1.addViewToBack(link_views[i]);
+        mv1.addViewToBack(agent_views[i]);
+        mv3.addViewToBack(agent_views[i]);
+        mv4.addViewToBack(agent_views[i]);
     }
 
     mv1.setScale(0.5f, 0.5f);
@@ -115,58 +129,70 @@ void draw_loop(void)
     msg.setPosition((Config::win_width - msg.getWidth()) / 2.f, (Config::win_height - msg.getHeight()) / 2.f);
     Log::dbg << "Draw loop will start now...\n";
 
-    int draw_world = 5;
+    unsigned int shown_grids_version = 0;
+    double shown_time = Config::start_epoch;
     while(window.isOpen() && !exit_draw_loop) {
-        draw_world++;
-        if(mutex_draw.try_lock_for(std::chrono::milliseconds(100))) {
-            /* Message box: --------------------------------------------------------------------- */
-            msg.setMessage(VirtualTime::toString(VirtualTime::now(), true, true));
-            if(!msg_show_time) {
-                msg.setMargin(5.f);
-                msg.setPosition(
-                    std::round((Config::win_width - msg.getWidth()) / 2.f),
-                    std::round((Config::win_height - msg.getHeight()) / 2.f)
-                );
-                msg_show_time = true;
+        if(render_snapshots.acquire()) {
+            /* Update views with the latest snapshot: ------------------------------------------- */
+            const RenderSnapshot& rs = render_snapshots.front();
+            for(unsigned int i = 0; i < rs.agents.size(); i++) {
+                const AgentSnapshot& as = rs.agents[i];
+                AgentView& av = agent_views[i]->get();
+                av.setText(as.text);
+                av.setLocation(as.location);
+                av.setDirection(as.direction);
+                av.setFootprint(as.footprint);
+                link_views[i]->get().setLinks(as.link_position, as.links);
+            }
+            activities_view->get().setSegments(rs.activities);
+            if(rs.grids_version != shown_grids_version) {
+                /* Only the cells that have changed are recolored: */
+                actual_view->get().setEntries(*rs.world_actual);
+                utopia_view->get().setEntries(*rs.world_utopia);
+                payoff_view->get().setEntries(*rs.payoff);
+                shown_grids_version = rs.grids_version;
             }
             /* Pre-draw loop: ------------------------------------------------------------------- */
             mv1.drawViews();
             mv2.drawViews();
-            if(draw_world >= 5) {
-                draw_world = 0;
-                world->display(World::Layer::REVISIT_TIME_ACTUAL);
-                mv3.drawViews();
-                world->display(World::Layer::REVISIT_TIME_UTOPIA);
-                mv4.drawViews();
+            mv3.drawViews();
+            mv4.drawViews();
+            shown_time = rs.time;
+            if(msg_show_time) {
+                msg.setMessage(VirtualTime::toString(shown_time, true, true));
             }
-            /* The rest is not dependent on objects managed by the control loop: */
-            mutex_draw.unlock();
-
-        } else {
-            /* Message box: --------------------------------------------------------------------- */
-            if(mutex_control.try_lock_for(std::chrono::milliseconds(10))) {
-                bool waiting = false;
-                std::string agent_list = "";
-                for(auto ci : control_info) {
-                    if(ci.planning) {
-                        waiting = true;
-                        if(agent_list.length() < 50) {
-                            agent_list += " " + ci.agent_id;
-                        } else {
-                            break;
-                        }
+        }
+        /* Message box: ------------------------------------------------------------------------- */
+        if(mutex_control.try_lock_for(std::chrono::milliseconds(10))) {
+            bool waiting = false;
+            std::string agent_list = "";
+            for(auto ci : control_info) {
+                if(ci.planning) {
+                    waiting = true;
+                    if(agent_list.length() < 50) {
+                        agent_list += " " + ci.agent_id;
+                    } else {
+                        break;
                     }
                 }
-                if(waiting) {
-                    msg.setMessage("WAITING FOR..." + agent_list);
-                    msg.setMargin(10.f);
-                    msg.setPosition(
-                        std::round((Config::win_width - msg.getWidth()) / 2.f),
-                        std::round((Config::win_height - msg.getHeight()) / 2.f)
-                    );
-                    msg_show_time = false;
-                }
-                mutex_control.unlock();
+            }
+            mutex_control.unlock();
+            if(waiting) {
+                msg.setMessage("WAITING FOR..." + agent_list);
+                msg.setMargin(10.f);
+                msg.setPosition(
+                    std::round((Config::win_width - msg.getWidth()) / 2.f),
+                    std::round((Config::win_height - msg.getHeight()) / 2.f)
+                );
+                msg_show_time = false;
+            } else if(!msg_show_time) {
+                msg.setMessage(VirtualTime::toString(shown_time, true, true));
+                msg.setMargin(5.f);
+                msg.setPosition(
+                    std::round((Config::win_width - msg.getWidth()) / 2.f),
+                    std::round((Config::win_height - msg.getHeight()) / 2.f)
+                );
+                msg_show_time = true;
             }
         }
         /* Draw loop: --------------------------------------------------------------------------- */
@@ -190,9 +216,111 @@ void draw_loop(void)
     Log::dbg << "Exiting draw thread.\n";
 }
 
+void skip_idle_steps(int& update_world_metrics)
+{
+    PROFILE_ZONE("skip_idle_steps");
+    /*  Looks for the earliest event among all agents (activity start/end or confirmation, link
+     *  connections and disconnections, transfers, replanning) and steps over the idle steps before it.
+     *  Metric ticks (every 10 steps) and the end of the simulation are also events. Skipped steps
+     *  only move agents, integrate their resources and age the world cells.
+     **/
+    double t = VirtualTime::now();
+    double t_end = Config::start_epoch + Config::duration;
+    unsigned int k_max = (10 - update_world_metrics % 10) % 10;
+    double steps_left = std::ceil((t_end - t) / Config::time_step - 1e-3);
+    if(steps_left <= 1.0) {
+        return;
+    }
+    k_max = std::min(k_max, (unsigned int)steps_left - 1);
+    if(k_max == 0) {
+        return;
+    }
+    std::priority_queue<double, std::vector<double>, std::greater<double> > events;
+    events.push(t + (k_max + 1) * Config::time_step);
+    for(auto& a : agents) {
+        a->propagatePosition(k_max + 2);
+    }
+    for(auto& a : agents) {
+        events.push(a->getNextEventTime(k_max));
+    }
+    /*  Number of steps to skip (i.e. the event will be processed in the following full step). Event
+     *  times are rounded down to the time grid so that events are never missed:
+     **/
+    double steps = std::ceil((events.top() - t) / Config::time_step - 1e-3);
+    unsigned int k = (steps <= 1.0 ? 0 : std::min((unsigned int)steps - 1, k_max));
+    if(k > 0) {
+        world->beginSkip();
+        for(unsigned int i = 0; i < k; i++) {
+            VirtualTime::step();
+            for(auto& a : agents) {
+                a->skipStep();
+            }
+            world->skipStep();
+        }
+        world->endSkip();
+        update_world_metrics += k;
+    }
+}
+
+void report_memory(MemoryReport& mr)
+{
+    PROFILE_ZONE("report_memory");
+    for(auto& a : agents) {
+        MemoryUsage mu;
+        a->getMemoryUsage(mu);
+        mr.add(a->getId(), mu);
+    }
+    MemoryUsage mu;
+    world->getMemoryUsage(mu);
+    mr.add("world", mu);
+    mr.commit();
+}
+
+void publish_snapshot(bool update_grids)
+{
+    PROFILE_ZONE("publish_snapshot");
+    /*  Grids are shared by the snapshots until they are recomputed (the draw thread may still be
+     *  reading the previous ones, so new ones are allocated):
+     **/
+    static unsigned int grids_version = 0;
+    static std::shared_ptr<const std::vector<std::uint16_t> > world_actual, world_utopia, payoff;
+    if(update_grids || grids_version == 0) {
+        auto actual = std::make_shared<std::vector<std::uint16_t> >();
+        auto utopia = std::make_shared<std::vector<std::uint16_t> >();
+        world->getDisplayEntries(World::Layer::REVISIT_TIME_ACTUAL, *actual);
+        world->getDisplayEntries(World::Layer::REVISIT_TIME_UTOPIA, *utopia);
+        world_actual = actual;
+        world_utopia = utopia;
+        payoff = std::make_shared<std::vector<std::uint16_t> >(agents[0]->getEnvironment()->getView().getEntries());
+        grids_version++;
+    }
+    RenderSnapshot& rs = render_snapshots.back();
+    rs.time = VirtualTime::now();
+    rs.agents.resize(agents.size());
+    for(unsigned int i = 0; i < agents.size(); i++) {
+        const AgentView& av = agents[i]->getView();
+        const AgentLinkView& lv = agents[i]->getLink()->getView();
+        AgentSnapshot& as = rs.agents[i];
+        as.text = av.getText();
+        as.location = av.getLocation();
+        as.direction = av.getDirection();
+        as.footprint = av.getFootprint();
+        as.link_position = lv.getPosition();
+        as.links = lv.getLinks();
+    }
+    rs.activities.clear();
+    for(auto& seg : agents[0]->getActivityHandler()->getView().getSegments()) {
+        rs.activities.push_back(std::make_shared<SegmentView>(*seg));
+    }
+    rs.grids_version = grids_version;
+    rs.world_actual = world_actual;
+    rs.world_utopia = world_utopia;
+    rs.payoff = payoff;
+    render_snapshots.publish();
+}
+
 void control_loop(void)
 {
-    mutex_draw.lock();
     mutex_control.lock();
     Log::dbg << "Control loop started...\n";
 
@@ -236,24 +364,44 @@ void control_loop(void)
 
     std::thread thread_draw;
     if(Config::enable_graphics) {
+        world->setDisplaySize(Config::world_width / 2, Config::world_height / 2);   /* World views are scaled by 0.5 in draw_loop. */
+
+        /* Configure Agent Views: */
+        for(auto a : agents) {
+            a->showResources(true);
+        }
+        agents[0]->displayActivities(ActivityDisplayType::ALL);
+        agents[0]->showResources(true);
+        agents[0]->getEnvironment()->buildView();
+        publish_snapshot(true);
+
         Log::dbg << "Starting draw thread.\n";
         exit_draw_loop = false;
-        thread_draw = std::thread(draw_loop);
+        std::promise<void> draw_setup;
+        thread_draw = std::thread(draw_loop, std::ref(draw_setup));
+        draw_setup.get_future().wait();     /* Views are copied by the draw thread. */
     }
-    mutex_draw.unlock();
     mutex_control.unlock();
     std::this_thread::sleep_for(std::chrono::milliseconds(500));
 
     Log::dbg << "Starting control loop.\n";
     ReportSet::getInstance().outputAllHeaders();
     int update_world_metrics = 0;
+    std::unique_ptr<MemoryReport> memory_report;
+    int memory_report_step = 0;
+    int render_step = 0;
+    int render_grids_step = 0;
+    if(Config::memory_report_period > 0) {
+        memory_report.reset(new MemoryReport());
+        report_memory(*memory_report);
+    }
 
     while(!VirtualTime::finished() && !exit_control_loop) {
         /* Update loop: ------------------------------------------------------------------------- */
         mutex_control.lock();
         if(run_sandbox) {
+            PROFILE_ZONE("control_loop");
             mutex_control.unlock();
-            mutex_draw.lock();     /* Synchronise with draw loop. */
 
             /* Define a lambda for the plan function (as a wrapper): */
             auto agent_plan = [] (const std::shared_ptr<Agent>& a, int i) {
@@ -267,29 +415,32 @@ void control_loop(void)
                 control_info[i].planning = false;
                 mutex_control.unlock();
             };
+            /* Jump over idle steps: */
+            if(Config::event_driven) {
+                skip_idle_steps(update_world_metrics);
+            }
+
             /* Step time: */
             VirtualTime::step();
 
             /* Step agents: */
-            std::for_each(agents.begin(), agents.end(), [](const std::shared_ptr<Agent>& a) { a->updatePosition(); });
-            if(Config::parallel_planners >= 2) {
-                #pragma omp parallel for num_threads(Config::parallel_planners)
-                for(unsigned int i = 0; i < agents.size(); i++) {
-                    agent_plan(agents.at(i), i);
-                }
-            } else {
-                for(unsigned int i = 0; i < agents.size(); i++) {
+            {
+                PROFILE_ZONE("control_loop::propagate");
+                std::for_each(agents.begin(), agents.end(), [](const std::shared_ptr<Agent>& a) { a->updatePosition(); });
+            }
+            {
+                PROFILE_ZONE("control_loop::plan");
+                TaskPool::parallelFor(agents.size(), 1, [&](std::size_t i) {
                     agent_plan(agents.at(i), i);
-                }
+                }, "planner", Config::parallel_planners);
             }
-            if(Config::parallel_agent_step) {
-                std::for_each(agents.begin(), agents.end(), [](const std::shared_ptr<Agent>& a) { a->stepSequential(); });
-                #pragma omp parallel for
-                for(unsigned int i = 0; i < agents.size(); i++) {
-                    agents[i]->stepParallel();
+            {
+                PROFILE_ZONE("control_loop::step");
+                if(Config::parallel_agent_step) {
+                    Agent::stepTwoPhase(agents, true);
+                } else {
+                    std::for_each(agents.begin(), agents.end(), [](const std::shared_ptr<Agent>& a) { a->step(); });
                 }
-            } else {
-                std::for_each(agents.begin(), agents.end(), [](const std::shared_ptr<Agent>& a) { a->step(); });
             }
 
             /*  Step world:
@@ -297,19 +448,26 @@ void control_loop(void)
              *  graphical objects).
              **/
             world->step();
-            mutex_draw.unlock();   /* System can be drawn now. */
+
+            /* Publish the system to the draw thread (steps may have been skipped): */
+            if(Config::enable_graphics && update_world_metrics - render_step >= (int)Config::render_period) {
+                bool update_grids = (update_world_metrics - render_grids_step >= (int)Config::render_world_period);
+                publish_snapshot(update_grids);
+                render_step = update_world_metrics;
+                if(update_grids) {
+                    render_grids_step = update_world_metrics;
+                }
+            }
 
             /* Report world values: */
             if(update_world_metrics % 10 == 0) {
-                if(Config::enable_graphics) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
                 world->computeMetrics();    /* This only reports to file. */
                 ReportSet::getInstance().outputAll();
-            } else {
-                if(Config::enable_graphics) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
-                }
+            }
+            /* Report memory usage (steps may have been skipped): */
+            if(memory_report && update_world_metrics - memory_report_step >= (int)Config::memory_report_period) {
+                report_memory(*memory_report);
+                memory_report_step = update_world_metrics;
             }
             update_world_metrics++;
         } else {
@@ -322,6 +480,15 @@ void control_loop(void)
     }
     world->computeMetrics(true);    /* Make the last measurements. */
     ReportSet::getInstance().outputAll();
+    TaskPool::logCounters();
+    if(memory_report) {
+        report_memory(*memory_report);
+        memory_report->writeSummary(Config::data_path + "memory_summary.csv");
+    }
+    if(Profiler::isEnabled()) {
+        Profiler::writeChromeTrace(Config::data_path + "profile_trace.json");
+        Profiler::writeCSV(Config::data_path + "profile.csv");
+    }
     if(Config::enable_graphics) {
         exit_draw_loop = true;
         thread_draw.join();
@@ -338,6 +505,9 @@ int main(int argc, char** argv)
     Init::doInit();
     Config::loadCmdArgs(argc, argv);
     Init::createOutputDirectories();
+    if(Config::profiler_enable) {
+        Profiler::enable(Config::profiler_buffer_size);
+    }
 
     if(Config::mode != SandboxMode::SIMULATE) {
         switch(Config::mode) {
@@ -401,43 +571,18 @@ void parseTLEFile(void)
 {
     Log::dbg << "**************************************************\n";
     Log::dbg << "-- Entering TLE file parse mode for: \'" << Config::tle_file << "\'...\n";
-    std::ifstream tle_file(Config::tle_file, std::ios::in);
-    if(tle_file.is_open()) {
-        bool valid = true;
-        int line_count = 0;
-        std::vector<TLE> tle_collection;
-        std::string tle0, tle1, tle2;
-        char line[100];
-        while(tle_file.getline(line, 100)) {
-            if(line_count == 0) {
-                tle0 = Utils::trim(std::string(line));
-            } else if(line_count == 1) {
-                tle1 = Utils::trim(std::string(line));
-            } else if(line_count == 2) {
-                tle2 = Utils::trim(std::string(line));
-                TLE tle_obj;
-                try {
-                    tle_obj.setTLE(tle0, tle1, tle2);
-                    Utils::removeWhitespace(tle_obj.sat_name);
-                    tle_collection.push_back(tle_obj);
-                    Log::dbg << "-- Parsing " << tle_collection.back().sat_name << " done.\n";
-                } catch(const std::exception& e) {
-                    Log::err << "-- Unable to parse TLE. Aborting...\n";
-                    Log::err << "-- LINE0: \'" << tle0 << "\'\n";
-                    Log::err << "-- LINE1: \'" << tle1 << "\'\n";
-                    Log::err << "-- LINE2: \'" << tle2 << "\'\n";
-                    valid = false;
-                    break;
-                }
-            }
-            line_count++;
-            line_count %= 3;
-        }
-        if(tle_collection.size() == 0) {
+    try {
+        Utils::tic();
+        TLECatalogue catalogue;
+        bool valid = (catalogue.load(Config::tle_file) == 0);
+        if(catalogue.empty()) {
             Log::warn << "-- Parsing the file returned 0 TLE objects.\n";
         } else {
-            Log::dbg << "-- Parsing the file returned " << tle_collection.size() << " TLE objects.\n";
-            for(auto& tle_obj : tle_collection) {
+            Log::dbg << "-- Parsing the file returned " << catalogue.size() << " TLE objects ("
+                << std::fixed << std::setprecision(3) << Utils::toc() * 1e3 << " ms).\n";
+            for(auto& r : catalogue) {
+                TLE tle_obj = r.toTLE();
+                Utils::removeWhitespace(tle_obj.sat_name);
                 AgentBuilder ab(tle_obj);
             }
         }
@@ -447,8 +592,8 @@ void parseTLEFile(void)
             Log::warn << "-- Some TLE lines could not be parsed.\n";
             Log::warn << "-- Results in \'" << Config::data_path << "system.yml\' may be incomplete.\n";
         }
-    } else {
-        Log::err << "-- Unable to open TLE collection file: \'" << Config::tle_file << "\'. Check permissions and path.\n";
+    } catch(const std::exception& e) {
+        Log::err << "-- " << e.what() << " Check permissions and path.\n";
     }
     Log::dbg << "**************************************************\n";
 }
@@ -20,6 +20,7 @@
 #include <cmath>
 #include <complex>
 #include <set>
+#include <queue>
 #include <functional>
 #include <cmath>
 #include <chrono>
@@ -34,6 +34,7 @@ unsigned int    Config::win_width  = 1800;
 unsigned int    Config::win_height =  900;
 unsigned int    Config::world_width  = 1800;
 unsigned int    Config::world_height =  900;
+bool            Config::world_lod_metrics = true;
 unsigned int    Config::model_unity_size = 10;
 unsigned int    Config::agent_size = 14;
 unsigned int    Config::n_agents = 1;
@@ -41,11 +42,23 @@ double          Config::start_epoch = 2451545.0;
 double          Config::duration = 30.0;
 double          Config::time_step = 10.0 / 86400.0;
 bool            Config::enable_graphics = true;
+bool            Config::grid_textures = true;
+int             Config::world_lod = -1;
+Aggregate       Config::world_lod_aggregate = Aggregate::MEAN_VALUE;
+unsigned int    Config::render_period = 1;
+unsigned int    Config::render_world_period = 10;
+bool            Config::event_driven = false;
 
 /* Concurrency settings: */
 bool            Config::parallel_nested = true;
 bool            Config::parallel_agent_step = false;
 unsigned int    Config::parallel_planners = 1;
+bool            Config::parallel_payoff = true;
+
+/* Profiling settings: */
+bool            Config::profiler_enable = false;
+unsigned int    Config::profiler_buffer_size = 65536;
+unsigned int    Config::memory_report_period = 0;
 
 /* System goals and payoff model: */
 double          Config::goal_target = 0.5;      /* 12 hours.   */
@@ -55,6 +68,7 @@ PayoffModel     Config::payoff_model = PayoffModel::SIGMOID;
 float           Config::payoff_mid = 0.5f;
 float           Config::payoff_steepness = 20.f;
 float           Config::payoff_slope = 1.f;
+bool            Config::payoff_incremental = true;
 
 /* Earth WGS84 parameters: */
 const long double    Config::earth_radius  = 6371000.0L;
@@ -66,6 +80,8 @@ const long double    Config::earth_mu = 3.986004419e14L;
 /* Agent parametrization: */
 float           Config::agent_aperture_min = 60.f;
 float           Config::agent_aperture_max = 120.f;
+bool            Config::instrument_footprint_cache = true;
+GeometryPrecision Config::instrument_precision = GeometryPrecision::DOUBLE;
 float           Config::agent_range_min = 50.f;
 float           Config::agent_range_max = 90.f;
 float           Config::agent_datarate_min = 100.f;
@@ -75,6 +91,7 @@ float           Config::agent_speed =  4.f;
 unsigned int    Config::agent_planning_window = 1080;   /* Steps (540 ~= 1 orbit). */
 unsigned int    Config::agent_replanning_window = 100;  /* Steps (540 ~= 1 orbit). */
 float           Config::activity_size = 1000.f;
+bool            Config::compact_trajectories = false;
 AgentMotionType Config::motion_model = AgentMotionType::ORBITAL;
 TimeValueType   Config::time_type;
 
@@ -156,6 +173,7 @@ float           Config::ga_confidence_th = 0.5f;
 bool        Config::create_data_dirname = true;
 bool        Config::load_agents_from_yaml = false;
 std::string Config::system_yml;
+AgentCacheMode Config::agent_cache = AgentCacheMode::AUTO;
 std::string Config::simulation_name;
 std::string Config::root_path;
 std::string Config::data_path;
@@ -174,6 +192,7 @@ void Config::loadCmdArgs(int argc, char** argv)
     std::string opt, opt_val;
     bool force_graphics = false;
     bool override_graphics_value = false;
+    bool force_profiler = false;
     for(int cmd_idx = 1; cmd_idx < argc; cmd_idx++) {
         opt = argv[cmd_idx];
         if(opt == "-h" || opt == "--help" || opt == "-help") {
@@ -182,16 +201,19 @@ void Config::loadCmdArgs(int argc, char** argv)
             Log::dbg << "                  -tp  Enters TEST_PAYOFF mode. Generates revisit time values and prints the resulting payoffs.\n";
             Log::dbg << "             --random  Enters RANDOM mode. Simulates with random agent behaviour.\n";
             Log::dbg << "   --parse-tle <file>  Enters PARSE_TLE_FILE mode. Generates a system.yml from a TLE collection file. Does not simulate.\n";
-            Log::dbg << "            -f <file>  Reads configuration file. Output is stored in an auto-generated folder inside \'data\'.\n";
+            Log::dbg << "            -f <file>  Reads configuration file (relative to \'conf\' unless absolute). Output is stored in an auto-generated folder inside \'data\'.\n";
             Log::dbg << "                       The autogenerated results folder is postfixed to the simulation \'name\' (if given).\n";
             Log::dbg << "             -d <dir>  Defines an output directory (relative to bash execution, not binary). \n";
             Log::dbg << "                       This overrides the option \'name\' in the config file.\n";
             Log::dbg << "            -l <path>  Loads \'n_agents\' from the file indicated in <path>. \n";
             Log::dbg << "                       The path must be the location of a YAML file that has the structure of \'system.yml\'. \n";
             Log::dbg << "                       If the `-l` option is not set, the program generates one \'system.yml\' in the results folder.\n";
+            Log::dbg << " --agent-cache <mode>  How agents are loaded with `-l`: \'auto\' (default) uses a binary copy of the file (<path>.bin)\n";
+            Log::dbg << "                       while it is up to date; \'bin\' always uses it; \'yaml\' always parses the YAML file.\n";
             Log::dbg << "              -g[0|1]  Overrides `graphics.enable` value: -g0 = graphics disabled.\n";
             Log::dbg << "  --dbg-rootdir <dir>  Overrides the root path with the given one (for debug purposes only).\n";
             Log::dbg << "         --simple-log  Does not print logs with colors.\n";
+            Log::dbg << "            --profile  Records phase timings (profile.csv and profile_trace.json).\n";
 
         } else if(opt == "-tp") {
             /* Will enter in 'test payoff' mode. */
@@ -228,6 +250,10 @@ void Config::loadCmdArgs(int argc, char** argv)
             // parallel_agent_step = true;
             Log::dbg << " -- Config. parameter \'parallel.agent_step\' is set to: true\n";
 
+        } else if(opt == "--profile") {
+            force_profiler = true;
+            Log::dbg << "Phase profiler enabled.\n";
+
         } else if(opt == "--simple-log") {
             /* Will enter in 'test payoff' mode. */
             simple_log = true;
@@ -271,12 +297,26 @@ void Config::loadCmdArgs(int argc, char** argv)
             load_agents_from_yaml = true;
             Log::dbg << "Agent configuration will be loaded from: " << system_yml << "\n";
 
+        } else if(opt == "--agent-cache" && (cmd_idx + 1) < argc) {
+            opt_val = argv[cmd_idx + 1];
+            if(opt_val == "auto") {
+                agent_cache = AgentCacheMode::AUTO;
+            } else if(opt_val == "bin") {
+                agent_cache = AgentCacheMode::BINARY;
+            } else if(opt_val == "yaml") {
+                agent_cache = AgentCacheMode::YAML;
+            } else {
+                Log::err << "Unknown agent cache mode \'" << opt_val << "\'. Valid modes are: auto, bin, yaml.\n";
+                std::exit(-1);
+            }
+            Log::dbg << "Agent cache mode set to: " << opt_val << "\n";
+
         } else if(opt == "-f" && (cmd_idx + 1) < argc) {
             opt_val = argv[cmd_idx + 1];
             try {
-                YAML::Node conf = YAML::LoadFile(root_path + "conf/" + opt_val);
-                conf_file = root_path + "conf/" + opt_val;
-                Log::dbg << "Loading configuration from \'" << root_path << ("conf/" + opt_val) << "\'.\n";
+                conf_file = (opt_val[0] == '/' ? opt_val : root_path + "conf/" + opt_val);
+                YAML::Node conf = YAML::LoadFile(conf_file);
+                Log::dbg << "Loading configuration from \'" << conf_file << "\'.\n";
                 if(conf["version"].IsDefined()) {
                     unsigned int conf_ver = conf["version"].as<unsigned int>();
                     if(conf_ver < CONF_VERSION) {
@@ -301,6 +341,7 @@ void Config::loadCmdArgs(int argc, char** argv)
                         getConfigParam("n_agents", node_it.second, n_agents);
                         getConfigParam("verbosity", node_it.second, verbosity);
                         getConfigParam("interpos", node_it.second, interpos);
+                        getConfigParam("event_driven", node_it.second, event_driven);
                         YAML::Node time_node = node_it.second["time"];
                         if(time_node.IsDefined()) {
                             getConfigParam("duration", time_node, duration);
@@ -336,10 +377,20 @@ void Config::loadCmdArgs(int argc, char** argv)
                             getConfigParam("agent_step", parallel_node, parallel_agent_step);
                             getConfigParam("nested", parallel_node, parallel_nested);
                             getConfigParam("planners", parallel_node, parallel_planners);
+                            getConfigParam("payoff", parallel_node, parallel_payoff);
                             if(parallel_planners == 0) {
                                 parallel_planners = 1;
                             }
                         }
+                        YAML::Node profiler_node = node_it.second["profiler"];
+                        if(profiler_node.IsDefined()) {
+                            getConfigParam("enable", profiler_node, profiler_enable);
+                            getConfigParam("buffer_size", profiler_node, profiler_buffer_size);
+                        }
+                        YAML::Node memory_node = node_it.second["memory_report"];
+                        if(memory_node.IsDefined()) {
+                            getConfigParam("period", memory_node, memory_report_period);
+                        }
 
                     } else if(node_it.first.as<std::string>() == "graphics") {
                         Log::dbg << "=== Loading graphics configuration...\n";
@@ -352,6 +403,24 @@ void Config::loadCmdArgs(int argc, char** argv)
                             getConfigParam("win_height", node_it.second, win_height);
                             getConfigParam("agent_size", node_it.second, agent_size);
                             getConfigParam("font_size", node_it.second, fnt_size);
+                            getConfigParam("grid_textures", node_it.second, grid_textures);
+                            getConfigParam("world_lod", node_it.second, world_lod);
+                            if(node_it.second["world_lod_aggregate"].IsDefined()) {
+                                if(node_it.second["world_lod_aggregate"].as<std::string>() == "min") {
+                                    world_lod_aggregate = Aggregate::MIN_VALUE;
+                                } else if(node_it.second["world_lod_aggregate"].as<std::string>() == "max") {
+                                    world_lod_aggregate = Aggregate::MAX_VALUE;
+                                } else if(node_it.second["world_lod_aggregate"].as<std::string>() == "avg") {
+                                    world_lod_aggregate = Aggregate::MEAN_VALUE;
+                                } else {
+                                    world_lod_aggregate = Aggregate::MEAN_VALUE;
+                                    Log::warn << " -- Config. parameter \'world_lod_aggregate\' is wrong. Default value: MEAN.\n";
+                                }
+                            }
+                            getConfigParam("render_period", node_it.second, render_period);
+                            getConfigParam("render_world_period", node_it.second, render_world_period);
+                            render_period = std::max(render_period, 1u);
+                            render_world_period = std::max(render_world_period, render_period);
                         } else {
                             Log::dbg << "Graphics are disabled\n";
                         }
@@ -359,6 +428,7 @@ void Config::loadCmdArgs(int argc, char** argv)
                     } else if(node_it.first.as<std::string>() == "agent") {
                         Log::dbg << "=== Loading agent configuration...\n";
                         getConfigParam("activity_size", node_it.second, activity_size);
+                        getConfigParam("compact_trajectories", node_it.second, compact_trajectories);
                         getConfigParam("energy_generation", node_it.second, agent_energy_generation_rate);
                         getConfigParam("planning_window", node_it.second, agent_planning_window);
                         getConfigParam("replanning_window", node_it.second, agent_replanning_window);
@@ -386,6 +456,19 @@ void Config::loadCmdArgs(int argc, char** argv)
                             getConfigParam("aperture", instrument_node, agent_aperture_min, agent_aperture_max);
                             getConfigParam("energy", instrument_node, instrument_energy_min, instrument_energy_max);
                             getConfigParam("storage", instrument_node, instrument_storage_min, instrument_storage_max);
+                            getConfigParam("footprint_cache", instrument_node, instrument_footprint_cache);
+                            if(instrument_node["precision"].IsDefined()) {
+                                if(instrument_node["precision"].as<std::string>() == "long_double") {
+                                    instrument_precision = GeometryPrecision::LONG_DOUBLE;
+                                } else if(instrument_node["precision"].as<std::string>() == "double") {
+                                    instrument_precision = GeometryPrecision::DOUBLE;
+                                } else if(instrument_node["precision"].as<std::string>() == "float") {
+                                    instrument_precision = GeometryPrecision::FLOAT;
+                                } else {
+                                    instrument_precision = GeometryPrecision::DOUBLE;
+                                    Log::warn << " -- Config. parameter \'instrument.precision\' is not valid. Default value: double.\n";
+                                }
+                            }
                         } else {
                             throw std::runtime_error("Agent instrument model parameters have not been provided.");
                         }
@@ -572,10 +655,12 @@ void Config::loadCmdArgs(int argc, char** argv)
                         getConfigParam("model_unity_size", node_it.second, model_unity_size);
                         getConfigParam("world_width", node_it.second, world_width);
                         getConfigParam("world_height", node_it.second, world_height);
+                        getConfigParam("lod_metrics", node_it.second, world_lod_metrics);
                         if(node_it.second["payoff"].IsDefined()) {
                             YAML::Node payoff_node = node_it.second["payoff"];
                             getConfigParam("goal_target", payoff_node, goal_target);
                             Log::dbg << "The system target revisit time is: " << VirtualTime::toString(goal_target, false, true) << ".\n";
+                            getConfigParam("incremental", payoff_node, payoff_incremental);
                             if(payoff_node["type"].IsDefined()) {
                                 if(payoff_node["type"].as<std::string>() == "sigmoid") {
                                     payoff_model = PayoffModel::SIGMOID;
@@ -636,6 +721,9 @@ void Config::loadCmdArgs(int argc, char** argv)
     if(force_graphics) {
         enable_graphics = override_graphics_value;
     }
+    if(force_profiler) {
+        profiler_enable = true;
+    }
 
     VirtualTime::doInit(start_epoch);
     if(Config::motion_model == AgentMotionType::ORBITAL) {
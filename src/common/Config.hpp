@@ -30,6 +30,7 @@ public:
     static unsigned int win_height;             /**< Default window height. */
     static unsigned int world_width;            /**< Default window width. */
     static unsigned int world_height;           /**< Default window height. */
+    static bool world_lod_metrics;              /**< Whether world metrics are computed from the WorldPyramid. */
     static unsigned int model_unity_size;       /**< Size of the model unity. */
     static unsigned int agent_size;             /**< Size of an agent view. */
     static unsigned int n_agents;               /**< Total number of agents. */
@@ -37,11 +38,23 @@ public:
     static double duration;                     /**< Units of time. */
     static double time_step;                    /**< Units of time per step. */
     static bool enable_graphics;                /**< Whether to launch the graphical views. */
+    static bool grid_textures;                  /**< Whether grid views are drawn as textures (see GridView). */
+    static int world_lod;                       /**< Level of the world views (see WorldPyramid), -1 to fit the display. */
+    static Aggregate world_lod_aggregate;       /**< Reduction of the world cells in levels above 0 (min, max or mean). */
+    static unsigned int render_period;          /**< Steps between render snapshots (agents, links and activities). */
+    static unsigned int render_world_period;    /**< Steps between updates of the grids (world and payoff) in render snapshots. */
+    static bool event_driven;                   /**< Whether to skip steps where no event occurs. */
 
     /* Concurrency settings: */
-    static bool parallel_nested;                /**< Whether to use OMP nested loops or not. */
+    static bool parallel_nested;                /**< Whether nested loops spawn tasks (see TaskPool). */
     static bool parallel_agent_step;            /**< Whether agent steps will be partially run in parallel. */
     static unsigned int parallel_planners;      /**< Max number of parallel GAs planners. */
+    static bool parallel_payoff;                /**< Whether cell payoffs are computed in parallel. */
+
+    /* Profiling settings: */
+    static bool profiler_enable;                /**< Whether to record phase timings (see Profiler). */
+    static unsigned int profiler_buffer_size;   /**< Zones kept by each thread for the trace. */
+    static unsigned int memory_report_period;   /**< Steps between memory reports (0 = disabled, see MemoryReport). */
 
     /* System goals and payoff model: */
     static double goal_target;                  /**< Units of time. */
@@ -51,6 +64,7 @@ public:
     static float payoff_mid;                    /**< Unit-less (payoff RT = target) */
     static float payoff_steepness;              /**< Steepness of logistic curve. */
     static float payoff_slope;                  /**< Slope of linear payoff. */
+    static bool payoff_incremental;             /**< Whether to reuse the payoff of unchanged cells. */
 
     /* Earth WGS84 parameters: */
     static const long double earth_radius;      /**< Standard radius of the Earth (in meters). */
@@ -62,6 +76,8 @@ public:
     /* Agent parametrization: */
     static float agent_aperture_min;            /**< Min. aperture for instruments. */
     static float agent_aperture_max;            /**< Max. aperture for instruments. */
+    static bool instrument_footprint_cache;     /**< Whether to reuse footprints of the same latitude. */
+    static GeometryPrecision instrument_precision;  /**< Floating-point type of instrument geometry. */
     static float agent_range_min;               /**< Minimum range for links. */
     static float agent_range_max;               /**< Maximum range for links. */
     static float agent_datarate_min;            /**< Minimum range for links. */
@@ -71,6 +87,7 @@ public:
     static unsigned int agent_planning_window;  /**< Steps. 540 ~= 1 orbit. */
     static unsigned int agent_replanning_window;/**< Steps. 540 ~= 1 orbit. */
     static float activity_size;                 /**< Size of a single agent msg. */
+    static bool compact_trajectories;           /**< Whether trajectories are sent in their encoded form. */
     static AgentMotionType motion_model;        /**< Type of trajectory and motion model. */
     static TimeValueType time_type;             /**< Type of units in time magnitudes. */
 
@@ -151,6 +168,7 @@ public:
     static bool create_data_dirname;    /**< Create a directory (true) or use the name provided in command arguments. */
     static bool load_agents_from_yaml;  /**< Whether to configure agents from a pre-generated YAML file. */
     static std::string system_yml;      /**< Path to the YAML file that has `n_agents` agent configurations. */
+    static AgentCacheMode agent_cache;  /**< How agents are loaded from `system_yml` (see AgentBuilder::load). */
     static std::string simulation_name; /**< Simulation name. */
     static std::string root_path;       /**< Root path of the project. */
     static std::string data_path;       /**< Path were simulation results will be saved to.*/
@@ -0,0 +1,44 @@
+/***********************************************************************************************//**
+ *  Registry of interned agent identifiers.
+ *  @class      IdRegistry
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-26
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#include "IdRegistry.hpp"
+
+CREATE_LOGGER(IdRegistry)
+
+std::unordered_map<std::string, AgentHandle> IdRegistry::m_handles;
+std::deque<std::string> IdRegistry::m_names;
+std::mutex IdRegistry::m_mtx;
+
+AgentHandle IdRegistry::getAgentHandle(const std::string& aid)
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    auto it = m_handles.find(aid);
+    if(it != m_handles.end()) {
+        return it->second;
+    }
+    AgentHandle h = (AgentHandle)m_names.size();
+    m_names.push_back(aid);
+    m_handles[aid] = h;
+    return h;
+}
+
+const std::string& IdRegistry::getAgentName(AgentHandle h)
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if(h >= m_names.size()) {
+        throw std::runtime_error("Unknown agent handle " + std::to_string(h) + ".");
+    }
+    return m_names[h];
+}
+
+std::string IdRegistry::toString(ActivityHandle h)
+{
+    return getAgentName(getAgent(h)) + ":" + std::to_string(getSequence(h));
+}
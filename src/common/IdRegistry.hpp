@@ -0,0 +1,61 @@
+/***********************************************************************************************//**
+ *  Registry of interned agent identifiers.
+ *  @class      IdRegistry
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-26
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef ID_REGISTRY_HPP
+#define ID_REGISTRY_HPP
+
+#include "prot.hpp"
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+
+typedef std::uint32_t AgentHandle;      /**< Interned agent identifier. */
+typedef std::uint64_t ActivityHandle;   /**< Agent handle (32 MSB) and activity sequence (32 LSB). */
+
+/***********************************************************************************************//**
+ *  Maps agent identifiers (i.e. display names) to dense integer handles, which are assigned in
+ *  order of registration and never released. Handles let the model key its maps and compare
+ *  owners without hashing, comparing or copying strings. Activities are identified by the handle
+ *  of their owner and their sequence number, packed in a single 64-bit integer.
+ *  Interning is thread-safe. Names are stored in a deque, so the references returned by
+ *  getAgentName remain valid while other agents are registered.
+ **************************************************************************************************/
+class IdRegistry
+{
+public:
+    /*******************************************************************************************//**
+     *  Returns the handle of agent `aid`, registering it the first time it is seen.
+     **********************************************************************************************/
+    static AgentHandle getAgentHandle(const std::string& aid);
+
+    /*******************************************************************************************//**
+     *  Returns the identifier of the agent with handle `h`. Throws if `h` is not registered.
+     **********************************************************************************************/
+    static const std::string& getAgentName(AgentHandle h);
+
+    static ActivityHandle getActivityHandle(AgentHandle a, unsigned int seq)
+    {
+        return ((ActivityHandle)a << 32) | (ActivityHandle)seq;
+    }
+    static AgentHandle getAgent(ActivityHandle h) { return (AgentHandle)(h >> 32); }
+    static unsigned int getSequence(ActivityHandle h) { return (unsigned int)(h & 0xFFFFFFFFu); }
+
+    /*******************************************************************************************//**
+     *  Display name of an activity handle (e.g. "SAT-1:23").
+     **********************************************************************************************/
+    static std::string toString(ActivityHandle h);
+
+private:
+    static std::unordered_map<std::string, AgentHandle> m_handles;
+    static std::deque<std::string> m_names;
+    static std::mutex m_mtx;
+};
+
+#endif /* ID_REGISTRY_HPP */
@@ -65,8 +65,6 @@ void Init::doInit(void)
     Log::dbg << "Process root path: " << Config::root_path << "\n";
 
     PayoffFunctions::bindPayoffFunctions();
-
-    omp_set_nested(Config::parallel_nested);
 }
 
 void Init::createOutputDirectories(void)
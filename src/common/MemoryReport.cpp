@@ -0,0 +1,190 @@
+/***********************************************************************************************//**
+ *  Memory accounting of the model structures.
+ *  @class      MemoryReport
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#include "MemoryReport.hpp"
+#include <sys/resource.h>
+#include <unistd.h>
+
+CREATE_LOGGER(MemoryReport)
+
+const char* const MemoryUsage::subsystem_names[MemoryUsage::n_subsystems] = {
+    "env_cells", "env_activities", "env_payoff", "knowledge_base", "trajectories",
+    "ga_population", "motion", "world_layers", "heatmaps", "views"
+};
+
+std::size_t MemoryUsage::get(unsigned int i) const
+{
+    switch(i) {
+        case 0: return env_cells;
+        case 1: return env_activities;
+        case 2: return env_payoff;
+        case 3: return knowledge_base;
+        case 4: return trajectories;
+        case 5: return ga_population;
+        case 6: return motion;
+        case 7: return world_layers;
+        case 8: return heatmaps;
+        case 9: return views;
+        default: throw std::runtime_error("Wrong memory subsystem index");
+    }
+}
+
+std::size_t MemoryUsage::total(void) const
+{
+    std::size_t retval = 0;
+    for(unsigned int i = 0; i < n_subsystems; i++) {
+        retval += get(i);
+    }
+    return retval;
+}
+
+MemoryUsage& MemoryUsage::operator+=(const MemoryUsage& other)
+{
+    env_cells += other.env_cells;
+    env_activities += other.env_activities;
+    env_payoff += other.env_payoff;
+    knowledge_base += other.knowledge_base;
+    trajectories += other.trajectories;
+    ga_population += other.ga_population;
+    motion += other.motion;
+    world_layers += other.world_layers;
+    heatmaps += other.heatmaps;
+    views += other.views;
+    return *this;
+}
+
+void MemoryUsage::keepMax(const MemoryUsage& other)
+{
+    env_cells = std::max(env_cells, other.env_cells);
+    env_activities = std::max(env_activities, other.env_activities);
+    env_payoff = std::max(env_payoff, other.env_payoff);
+    knowledge_base = std::max(knowledge_base, other.knowledge_base);
+    trajectories = std::max(trajectories, other.trajectories);
+    ga_population = std::max(ga_population, other.ga_population);
+    motion = std::max(motion, other.motion);
+    world_layers = std::max(world_layers, other.world_layers);
+    heatmaps = std::max(heatmaps, other.heatmaps);
+    views = std::max(views, other.views);
+}
+
+MemoryReport::MemoryReport(void)
+    : ReportGenerator(std::string("memory.csv"), false)
+    , m_peak_total(0)
+    , m_peak_total_time(0.0)
+    , m_peak_owner_total(0)
+    , m_peak_rss(0)
+    , m_commits(0)
+{
+    addReportColumn("owner");
+    for(unsigned int i = 0; i < MemoryUsage::n_subsystems; i++) {
+        addReportColumn(MemoryUsage::subsystem_names[i]);
+    }
+    addReportColumn("total");
+    addReportColumn("rss");
+    enableReport();
+    outputReportHeader();
+}
+
+void MemoryReport::setRow(std::string owner, const MemoryUsage& mu, std::size_t rss)
+{
+    unsigned int col = 0;
+    setReportColumnValue(col++, owner);
+    for(unsigned int i = 0; i < MemoryUsage::n_subsystems; i++) {
+        setReportColumnValue(col++, std::to_string(mu.get(i)));
+    }
+    setReportColumnValue(col++, std::to_string(mu.total()));
+    setReportColumnValue(col++, (rss > 0 ? std::to_string(rss) : std::string("")));
+}
+
+void MemoryReport::add(std::string owner, const MemoryUsage& mu, double t_now)
+{
+    setRow(owner, mu, 0);
+    outputReport(false, t_now);
+    m_current += mu;
+    if(mu.total() > m_peak_owner_total) {
+        m_peak_owner_total = mu.total();
+        m_peak_owner = owner;
+    }
+}
+
+void MemoryReport::commit(double t_now)
+{
+    if(t_now < 0.0) {
+        t_now = VirtualTime::now();
+    }
+    std::size_t rss = getResidentSize();
+    setRow("all", m_current, rss);
+    outputReport(true, t_now);
+
+    m_peak.keepMax(m_current);
+    if(m_current.total() > m_peak_total) {
+        m_peak_total = m_current.total();
+        m_peak_total_time = t_now;
+    }
+    m_peak_rss = std::max(m_peak_rss, rss);
+    m_current = MemoryUsage();
+    m_commits++;
+}
+
+bool MemoryReport::writeSummary(std::string path)
+{
+    if(m_commits == 0) {
+        return false;
+    }
+    std::ofstream f(path, std::ios::out | std::ios::trunc);
+    if(!f.is_open()) {
+        Log::err << "Unable to write the memory summary to \'" << path << "\'.\n";
+        return false;
+    }
+    std::size_t peak_rss = std::max(m_peak_rss, getPeakResidentSize());
+    f << "item,bytes,mib\n";
+    f << std::fixed << std::setprecision(3);
+    for(unsigned int i = 0; i < MemoryUsage::n_subsystems; i++) {
+        f << MemoryUsage::subsystem_names[i] << "," << m_peak.get(i) << "," << m_peak.get(i) / 1048576.0 << "\n";
+    }
+    f << "total," << m_peak_total << "," << m_peak_total / 1048576.0 << "\n";
+    f << "owner:" << m_peak_owner << "," << m_peak_owner_total << "," << m_peak_owner_total / 1048576.0 << "\n";
+    f << "rss," << peak_rss << "," << peak_rss / 1048576.0 << "\n";
+
+    /* Largest subsystems first: */
+    std::vector<unsigned int> idxs(MemoryUsage::n_subsystems);
+    std::iota(idxs.begin(), idxs.end(), 0);
+    std::sort(idxs.begin(), idxs.end(), [this](unsigned int a, unsigned int b) { return m_peak.get(a) > m_peak.get(b); });
+    Log::dbg << "Memory high-water marks (estimated " << std::fixed << std::setprecision(1)
+        << m_peak_total / 1048576.0 << " MiB at " << VirtualTime::toString(m_peak_total_time)
+        << ", process peak " << peak_rss / 1048576.0 << " MiB):\n";
+    for(auto i : idxs) {
+        if(m_peak.get(i) > 0) {
+            Log::dbg << "  " << std::left << std::setw(16) << MemoryUsage::subsystem_names[i] << std::right
+                << std::setw(10) << m_peak.get(i) / 1048576.0 << " MiB\n";
+        }
+    }
+    Log::dbg << "  Largest owner: " << m_peak_owner << " (" << m_peak_owner_total / 1048576.0 << " MiB).\n";
+    return true;
+}
+
+std::size_t MemoryReport::getResidentSize(void)
+{
+    std::ifstream f("/proc/self/statm");
+    std::size_t pages_total = 0, pages_resident = 0;
+    if(f >> pages_total >> pages_resident) {
+        return pages_resident * (std::size_t)sysconf(_SC_PAGESIZE);
+    }
+    return getPeakResidentSize();   /* Not available (e.g. not Linux). */
+}
+
+std::size_t MemoryReport::getPeakResidentSize(void)
+{
+    struct rusage ru;
+    if(getrusage(RUSAGE_SELF, &ru) == 0) {
+        return (std::size_t)ru.ru_maxrss * 1024;
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+/***********************************************************************************************//**
+ *  Memory accounting of the model structures.
+ *  @class      MemoryReport
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef MEMORY_REPORT_HPP
+#define MEMORY_REPORT_HPP
+
+#include "prot.hpp"
+#include <map>
+#include <unordered_map>
+#include "ReportGenerator.hpp"
+
+/***********************************************************************************************//**
+ *  Estimated footprint (in bytes) of a set of model structures, broken down by subsystem. Sizes
+ *  are computed from container capacities and element sizes; allocator overheads are approximated
+ *  with the node layout of libstdc++ containers. Buffers that are shared among several owners
+ *  (e.g. the active cells of copied activities) are split evenly among them.
+ **************************************************************************************************/
+struct MemoryUsage
+{
+    std::size_t env_cells = 0;          /**< EnvModel cell grids, position LUTs and clean queues. */
+    std::size_t env_activities = 0;     /**< EnvCell activity maps (including cell times). */
+    std::size_t env_payoff = 0;         /**< EnvCell payoff series. */
+    std::size_t knowledge_base = 0;     /**< ActivityHandler activities and indices. */
+    std::size_t trajectories = 0;       /**< Activity trajectories and active cells. */
+    std::size_t ga_population = 0;      /**< GAScheduler populations (last planning of each agent). */
+    std::size_t motion = 0;             /**< AgentMotion propagation buffers. */
+    std::size_t world_layers = 0;       /**< World layers and heatmap update flags. */
+    std::size_t heatmaps = 0;           /**< HeatMap matrices. */
+    std::size_t views = 0;              /**< GridView vertex arrays and pixel buffers. */
+
+    static const unsigned int n_subsystems = 10;
+    static const char* const subsystem_names[n_subsystems];
+
+    std::size_t get(unsigned int i) const;
+    std::size_t total(void) const;
+    MemoryUsage& operator+=(const MemoryUsage& other);
+    void keepMax(const MemoryUsage& other);     /**< Keeps the largest value of each subsystem. */
+
+    template <class T>
+    static std::size_t bytes(const std::vector<T>& v) { return v.capacity() * sizeof(T); }
+    static std::size_t bytes(const std::vector<bool>& v) { return v.capacity() / 8; }
+    static std::size_t bytes(const std::string& s) { return (s.capacity() > 15 ? s.capacity() + 1 : 0); }
+    template <class K, class V, class C>
+    static std::size_t bytes(const std::map<K, V, C>& m) { return m.size() * (sizeof(std::pair<const K, V>) + map_node_overhead); }
+    template <class K, class C>
+    static std::size_t bytes(const std::set<K, C>& s) { return s.size() * (sizeof(K) + map_node_overhead); }
+    template <class K, class V, class H>
+    static std::size_t bytes(const std::unordered_map<K, V, H>& m)
+    {
+        return m.size() * (sizeof(std::pair<const K, V>) + 2 * sizeof(void*)) + m.bucket_count() * sizeof(void*);
+    }
+
+    /*  Heap chunk used by an array allocated with new[] (glibc: size header, 16-byte alignment and
+     *  32-byte minimum chunk).
+     **/
+    static std::size_t chunk(std::size_t n) { return std::max<std::size_t>(32, (n + sizeof(std::size_t) + 15) & ~(std::size_t)15); }
+
+    static const std::size_t map_node_overhead = 4 * sizeof(void*);    /**< Colour and links of a tree node. */
+};
+
+/***********************************************************************************************//**
+ *  Periodic memory report (memory.csv): one row per owner (agents and the world) with its
+ *  footprint per subsystem, and one row (`all`) with the sum of all owners and the process resident
+ *  set size. High-water marks are kept for every subsystem, for the largest owner and for the
+ *  process, and written as a summary (memory_summary.csv) when the simulation finishes.
+ **************************************************************************************************/
+class MemoryReport : public ReportGenerator
+{
+public:
+    MemoryReport(void);
+
+    /*******************************************************************************************//**
+     *  Writes the row of an owner and adds its usage to the current report.
+     **********************************************************************************************/
+    void add(std::string owner, const MemoryUsage& mu, double t_now = -1.0);
+
+    /*******************************************************************************************//**
+     *  Writes the `all` row with the usage added since the last commit and updates the marks.
+     **********************************************************************************************/
+    void commit(double t_now = -1.0);
+
+    /*******************************************************************************************//**
+     *  Writes and logs the high-water marks.
+     **********************************************************************************************/
+    bool writeSummary(std::string path);
+
+    /*******************************************************************************************//**
+     *  Current and peak resident set size of the process (bytes).
+     **********************************************************************************************/
+    static std::size_t getResidentSize(void);
+    static std::size_t getPeakResidentSize(void);
+
+private:
+    MemoryUsage m_current;                      /**< Sum of the owners added since the last commit. */
+    MemoryUsage m_peak;                         /**< Largest value of each subsystem in `all`. */
+    std::size_t m_peak_total;                   /**< Largest total in `all`. */
+    double m_peak_total_time;                   /**< Time of m_peak_total. */
+    std::string m_peak_owner;                   /**< Owner with the largest total. */
+    std::size_t m_peak_owner_total;             /**< Total of m_peak_owner. */
+    std::size_t m_peak_rss;                     /**< Largest resident set size seen in a commit. */
+    unsigned int m_commits;                     /**< Number of `all` rows written. */
+
+    void setRow(std::string owner, const MemoryUsage& mu, std::size_t rss);
+};
+
+#endif /* MEMORY_REPORT_HPP */
@@ -0,0 +1,167 @@
+/***********************************************************************************************//**
+ *  Scoped phase profiler with Chrome trace export.
+ *  @class      Profiler
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#include "Profiler.hpp"
+
+CREATE_LOGGER(Profiler)
+
+bool Profiler::m_enabled = false;
+std::size_t Profiler::m_buffer_size = 65536;
+std::chrono::steady_clock::time_point Profiler::m_origin = std::chrono::steady_clock::now();
+std::vector<std::unique_ptr<Profiler::ThreadBuffer> > Profiler::m_buffers;
+std::mutex Profiler::m_buffers_mtx;
+
+void Profiler::enable(std::size_t buffer_size)
+{
+    std::lock_guard<std::mutex> lock(m_buffers_mtx);
+    if(m_buffers.empty()) {
+        m_origin = std::chrono::steady_clock::now();
+        m_buffer_size = std::max<std::size_t>(1, buffer_size);
+    }
+    m_enabled = true;
+}
+
+std::int64_t Profiler::now(void)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_origin).count();
+}
+
+Profiler::ThreadBuffer& Profiler::getThreadBuffer(void)
+{
+    static thread_local ThreadBuffer* tb = nullptr;
+    if(tb == nullptr) {
+        std::lock_guard<std::mutex> lock(m_buffers_mtx);
+        m_buffers.emplace_back(new ThreadBuffer());
+        tb = m_buffers.back().get();
+        tb->tid = m_buffers.size() - 1;
+        tb->ring.resize(m_buffer_size);
+        tb->stack.resize(max_depth);
+    }
+    return *tb;
+}
+
+void Profiler::begin(const char* name)
+{
+    ThreadBuffer& tb = getThreadBuffer();
+    if(tb.depth < max_depth) {
+        tb.stack[tb.depth] = {name, now(), 0};
+    }
+    tb.depth++;     /* Deeper zones are not recorded, but still have to be balanced. */
+}
+
+void Profiler::end(void)
+{
+    ThreadBuffer& tb = getThreadBuffer();
+    if(tb.depth == 0) {
+        return;     /* Zone started before a reset. */
+    }
+    tb.depth--;
+    if(tb.depth >= max_depth) {
+        return;
+    }
+    const Frame& f = tb.stack[tb.depth];
+    std::int64_t t1 = now();
+    std::int64_t dt = t1 - f.t0;
+    if(tb.depth > 0) {
+        tb.stack[tb.depth - 1].t_children += dt;
+    }
+    tb.ring[tb.written % tb.ring.size()] = {f.name, f.t0, t1};
+    tb.written++;
+
+    ProfilerStats& s = tb.stats[f.name];
+    s.count++;
+    s.total_time += dt * 1e-9;
+    s.self_time += (dt - f.t_children) * 1e-9;
+    s.max_time = std::max(s.max_time, dt * 1e-9);
+}
+
+std::map<std::string, ProfilerStats> Profiler::getStats(void)
+{
+    /* Literals with the same text can have different addresses (e.g. in different units): */
+    std::lock_guard<std::mutex> lock(m_buffers_mtx);
+    std::map<std::string, ProfilerStats> retval;
+    for(auto& tb : m_buffers) {
+        for(auto& s : tb->stats) {
+            ProfilerStats& r = retval[s.first];
+            r.count += s.second.count;
+            r.total_time += s.second.total_time;
+            r.self_time += s.second.self_time;
+            r.max_time = std::max(r.max_time, s.second.max_time);
+        }
+    }
+    return retval;
+}
+
+void Profiler::reset(void)
+{
+    /* Buffers are cleared but not released: threads keep a pointer to theirs. */
+    std::lock_guard<std::mutex> lock(m_buffers_mtx);
+    for(auto& tb : m_buffers) {
+        tb->written = 0;
+        tb->depth = 0;
+        tb->stats.clear();
+    }
+}
+
+bool Profiler::writeChromeTrace(std::string path)
+{
+    std::ofstream f(path, std::ios::out | std::ios::trunc);
+    if(!f.is_open()) {
+        Log::err << "Unable to write the profiler trace to \'" << path << "\'.\n";
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_buffers_mtx);
+    std::size_t dropped = 0;
+    bool first = true;
+    f << std::fixed << std::setprecision(3);
+    f << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    for(auto& tb : m_buffers) {
+        f << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << tb->tid
+            << ", \"args\": {\"name\": \"thread " << tb->tid << "\"}}";
+        first = false;
+        std::size_t n = std::min(tb->written, tb->ring.size());
+        dropped += tb->written - n;
+        for(std::size_t i = tb->written - n; i < tb->written; i++) {
+            const Event& e = tb->ring[i % tb->ring.size()];
+            f << ",\n{\"name\": \"" << e.name << "\", \"cat\": \"prot-3\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << tb->tid
+                << ", \"ts\": " << e.t0 * 1e-3 << ", \"dur\": " << (e.t1 - e.t0) * 1e-3 << "}";
+        }
+    }
+    f << "\n]}\n";
+    if(dropped > 0) {
+        Log::warn << "The profiler trace is missing the " << dropped << " oldest zones (see the profiler buffer size).\n";
+    }
+    Log::dbg << "Profiler trace written to \'" << path << "\'.\n";
+    return true;
+}
+
+bool Profiler::writeCSV(std::string path)
+{
+    std::ofstream f(path, std::ios::out | std::ios::trunc);
+    if(!f.is_open()) {
+        Log::err << "Unable to write the profiler stats to \'" << path << "\'.\n";
+        return false;
+    }
+    auto stats = getStats();
+    std::vector<std::pair<std::string, ProfilerStats> > sorted(stats.begin(), stats.end());
+    std::sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, ProfilerStats>& a, const std::pair<std::string, ProfilerStats>& b) {
+        return a.second.total_time > b.second.total_time;
+    });
+    double wall = now() * 1e-9;
+    f << "zone,count,total_s,self_s,mean_ms,max_ms,wall_pct\n";
+    f << std::fixed << std::setprecision(6);
+    for(auto& s : sorted) {
+        const ProfilerStats& p = s.second;
+        f << s.first << "," << p.count << "," << p.total_time << "," << p.self_time << ","
+            << p.total_time / p.count * 1e3 << "," << p.max_time * 1e3 << "," << p.total_time / wall * 100.0 << "\n";
+    }
+    Log::dbg << "Profiler stats written to \'" << path << "\'.\n";
+    return true;
+}
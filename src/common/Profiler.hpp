@@ -0,0 +1,128 @@
+/***********************************************************************************************//**
+ *  Scoped phase profiler with Chrome trace export.
+ *  @class      Profiler
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include "prot.hpp"
+#include <map>
+#include <unordered_map>
+
+/***********************************************************************************************//**
+ *  Accumulated timing of the zones with the same name.
+ **************************************************************************************************/
+struct ProfilerStats
+{
+    unsigned long count = 0;        /**< Number of times the zone has been run. */
+    double total_time = 0.0;        /**< Sum of zone wall times (s). */
+    double self_time = 0.0;         /**< Total time minus the time spent in nested zones (s). */
+    double max_time = 0.0;          /**< Longest zone wall time (s). */
+};
+
+/***********************************************************************************************//**
+ *  Records the start and end times of named zones (see ProfilerZone). Every thread records its
+ *  zones in its own buffer, so that no lock is taken while profiling: the last zones are kept in a
+ *  ring buffer of fixed size (older ones are overwritten) and every zone is accumulated in the
+ *  ProfilerStats of its name. Zones nested in the same thread form a hierarchy, which is used to
+ *  compute self times.
+ *  Results are exported as Chrome trace events (chrome://tracing, Perfetto), with the zones kept in
+ *  the ring buffers, and as a CSV table with the stats of all the zones.
+ *  NOTE: Zone names are not copied, they must be string literals (or live as long as the profiler).
+ *  Buffers must not be exported or reset while zones are being recorded.
+ **************************************************************************************************/
+class Profiler
+{
+public:
+    /*******************************************************************************************//**
+     *  Starts recording zones.
+     *  @param  buffer_size     Number of zones kept by each thread for the trace.
+     **********************************************************************************************/
+    static void enable(std::size_t buffer_size = 65536);
+    static void disable(void) { m_enabled = false; }
+    static bool isEnabled(void) { return m_enabled; }
+
+    static void begin(const char* name);
+    static void end(void);
+
+    static std::map<std::string, ProfilerStats> getStats(void);
+    static void reset(void);
+
+    /*******************************************************************************************//**
+     *  Writes the recorded zones in Chrome's trace event format (JSON).
+     **********************************************************************************************/
+    static bool writeChromeTrace(std::string path);
+
+    /*******************************************************************************************//**
+     *  Writes the stats of every zone (CSV), sorted by total time.
+     **********************************************************************************************/
+    static bool writeCSV(std::string path);
+
+private:
+    struct Event {
+        const char* name;
+        std::int64_t t0;                /**< Start time (ns since Profiler::enable). */
+        std::int64_t t1;                /**< End time (ns since Profiler::enable). */
+    };
+    struct Frame {
+        const char* name;
+        std::int64_t t0;
+        std::int64_t t_children;        /**< Time spent in nested zones (ns). */
+    };
+    struct ThreadBuffer {
+        unsigned int tid;
+        std::vector<Event> ring;
+        std::size_t written = 0;        /**< Zones written to the ring (including overwritten ones). */
+        std::vector<Frame> stack;
+        unsigned int depth = 0;
+        std::unordered_map<const char*, ProfilerStats> stats;
+    };
+    static const unsigned int max_depth = 64;
+
+    static bool m_enabled;
+    static std::size_t m_buffer_size;
+    static std::chrono::steady_clock::time_point m_origin;
+    static std::vector<std::unique_ptr<ThreadBuffer> > m_buffers;
+    static std::mutex m_buffers_mtx;
+
+    static ThreadBuffer& getThreadBuffer(void);
+    static std::int64_t now(void);
+};
+
+/***********************************************************************************************//**
+ *  Records a zone from its construction to the end of its scope, if the profiler is enabled.
+ **************************************************************************************************/
+class ProfilerZone
+{
+public:
+    ProfilerZone(const char* name)
+        : m_active(Profiler::isEnabled())
+    {
+        if(m_active) {
+            Profiler::begin(name);
+        }
+    }
+    ~ProfilerZone(void)
+    {
+        if(m_active) {
+            Profiler::end();
+        }
+    }
+    ProfilerZone(const ProfilerZone&) = delete;
+    ProfilerZone& operator=(const ProfilerZone&) = delete;
+
+private:
+    bool m_active;
+};
+
+#define PROFILE_ZONE_NAME_(line) profiler_zone_##line
+#define PROFILE_ZONE_NAME(line) PROFILE_ZONE_NAME_(line)
+#define PROFILE_ZONE(name) ProfilerZone PROFILE_ZONE_NAME(__LINE__)(name)
+
+#endif /* PROFILER_HPP */
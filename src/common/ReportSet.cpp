@@ -10,6 +10,7 @@
 
 #include "ReportSet.hpp"
 #include "ReportGenerator.hpp"
+#include "Profiler.hpp"
 
 ReportSet& ReportSet::getInstance(void)
 {
@@ -19,6 +20,7 @@ ReportSet& ReportSet::getInstance(void)
 
 void ReportSet::outputAll(void)
 {
+    PROFILE_ZONE("ReportSet::outputAll");
     for(auto& rg : m_publish_list) {
         rg->outputReport();
     }
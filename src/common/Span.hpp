@@ -0,0 +1,55 @@
+/***********************************************************************************************//**
+ *  Non-owning view of a contiguous sequence of objects.
+ *  @class      Span
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-12
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef SPAN_HPP
+#define SPAN_HPP
+
+#include <cstddef>
+#include <vector>
+
+/*  NOTE: a Span does not own its elements and is only valid as long as the underlying container is
+ *  not modified (or destroyed).
+ **/
+template <class T>
+class Span
+{
+public:
+    Span(void) : m_data(nullptr), m_size(0) { }
+    Span(T* d, std::size_t n) : m_data(d), m_size(n) { }
+    template <class U>
+    Span(const std::vector<U>& v) : m_data(v.data()), m_size(v.size()) { }
+    template <class U>
+    Span(std::vector<U>& v) : m_data(v.data()), m_size(v.size()) { }
+
+    T* begin(void) const { return m_data; }
+    T* end(void) const { return m_data + m_size; }
+    T* data(void) const { return m_data; }
+    std::size_t size(void) const { return m_size; }
+    bool empty(void) const { return m_size == 0; }
+    T& operator[](std::size_t i) const { return m_data[i]; }
+    T& front(void) const { return m_data[0]; }
+    T& back(void) const { return m_data[m_size - 1]; }
+
+    /*******************************************************************************************//**
+     *  Returns a view of `n` elements starting at `offset`. The result is clamped to this span.
+     **********************************************************************************************/
+    Span<T> subspan(std::size_t offset, std::size_t n) const {
+        if(offset >= m_size) {
+            return Span<T>(m_data + m_size, 0);
+        }
+        return Span<T>(m_data + offset, (n > m_size - offset ? m_size - offset : n));
+    }
+
+private:
+    T* m_data;
+    std::size_t m_size;
+};
+
+#endif /* SPAN_HPP */
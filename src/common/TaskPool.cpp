@@ -0,0 +1,100 @@
+/***********************************************************************************************//**
+ *  Shared task pool for the parallel loops of the simulator.
+ *  @class      TaskPool
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-24
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#include "TaskPool.hpp"
+
+CREATE_LOGGER(TaskPool)
+
+std::map<std::string, TaskCounter> TaskPool::m_counters;
+std::mutex TaskPool::m_counters_mtx;
+
+void TaskPool::parallelFor(std::size_t n, std::size_t grain, const std::function<void(std::size_t)>& f,
+    const std::string& counter, unsigned int max_threads)
+{
+    if(n == 0) {
+        return;
+    }
+    bool nested = omp_in_parallel();
+    unsigned int nt = (nested ? omp_get_num_threads() : (max_threads == 0 ? omp_get_max_threads() : max_threads));
+    if(grain == 0) {
+        grain = std::max<std::size_t>(1, n / (4 * nt));     /* A few chunks per thread to balance load. */
+    }
+    if(max_threads == 1 || nt <= 1 || n <= grain || (nested && !Config::parallel_nested)) {
+        runChunk(0, n, f, counter);
+        return;
+    }
+
+    /*  Chunks are spawned by a single thread and run by any thread of the team. Nested loops spawn
+     *  their chunks as child tasks of the calling one: the calling thread waits in `taskwait`, where
+     *  it can also run pending tasks (its own or those of other loops).
+     **/
+    const std::function<void(std::size_t)>* fp = &f;
+    const std::string* cp = &counter;
+    if(nested) {
+        for(std::size_t i0 = 0; i0 < n; i0 += grain) {
+            std::size_t i1 = std::min(n, i0 + grain);
+            #pragma omp task firstprivate(i0, i1, fp, cp)
+            runChunk(i0, i1, *fp, *cp);
+        }
+        #pragma omp taskwait
+    } else {
+        #pragma omp parallel num_threads(nt)
+        #pragma omp single
+        {
+            for(std::size_t i0 = 0; i0 < n; i0 += grain) {
+                std::size_t i1 = std::min(n, i0 + grain);
+                #pragma omp task firstprivate(i0, i1, fp, cp)
+                runChunk(i0, i1, *fp, *cp);
+            }
+        }   /* Implicit barrier: all tasks (and their descendants) have completed. */
+    }
+}
+
+void TaskPool::runChunk(std::size_t i0, std::size_t i1, const std::function<void(std::size_t)>& f,
+    const std::string& counter)
+{
+    double t0 = omp_get_wtime();
+    for(std::size_t i = i0; i < i1; i++) {
+        f(i);
+    }
+    if(!counter.empty()) {
+        double dt = omp_get_wtime() - t0;
+        std::lock_guard<std::mutex> lock(m_counters_mtx);
+        TaskCounter& tc = m_counters[counter];
+        tc.count++;
+        tc.items += i1 - i0;
+        tc.total_time += dt;
+        tc.max_time = std::max(tc.max_time, dt);
+    }
+}
+
+std::map<std::string, TaskCounter> TaskPool::getCounters(void)
+{
+    std::lock_guard<std::mutex> lock(m_counters_mtx);
+    return m_counters;
+}
+
+void TaskPool::resetCounters(void)
+{
+    std::lock_guard<std::mutex> lock(m_counters_mtx);
+    m_counters.clear();
+}
+
+void TaskPool::logCounters(void)
+{
+    for(auto& c : getCounters()) {
+        const TaskCounter& tc = c.second;
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(3);
+        ss << tc.count << " tasks, " << tc.items << " items, " << tc.total_time << " s total, ";
+        ss << (tc.total_time / tc.count) * 1e3 << " ms/task mean, " << tc.max_time * 1e3 << " ms/task max";
+        Log::dbg << "Task pool [" << c.first << "]: " << ss.str() << ".\n";
+    }
+}
@@ -0,0 +1,61 @@
+/***********************************************************************************************//**
+ *  Shared task pool for the parallel loops of the simulator.
+ *  @class      TaskPool
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-24
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef TASK_POOL_HPP
+#define TASK_POOL_HPP
+
+#include "prot.hpp"
+#include <map>
+
+/***********************************************************************************************//**
+ *  Accumulated timing of the tasks run under the same counter name.
+ **************************************************************************************************/
+struct TaskCounter
+{
+    unsigned long count = 0;        /**< Number of tasks (i.e. chunks) run. */
+    unsigned long items = 0;        /**< Number of loop iterations run. */
+    double total_time = 0.0;        /**< Sum of task wall times (s). */
+    double max_time = 0.0;          /**< Longest task wall time (s). */
+};
+
+/***********************************************************************************************//**
+ *  Runs loops as chunks of OpenMP tasks over the (persistent) OpenMP thread team. Idle threads take
+ *  pending tasks from the rest of the team, which balances loops with uneven iteration costs (e.g.
+ *  GA planners of different agents).
+ *  A loop started from the outside of any parallel region opens the team. Loops started from inside
+ *  a task (e.g. payoff computed by a planner) spawn their chunks as child tasks in the same team and
+ *  wait for them, instead of opening nested teams. Nested loops run inline when
+ *  Config::parallel_nested is not set.
+ **************************************************************************************************/
+class TaskPool
+{
+public:
+    /*******************************************************************************************//**
+     *  Runs f(i) for every i in [0, n), in chunks of `grain` consecutive iterations (0 = automatic).
+     *  @param  counter     Name under which the timing of each chunk is accumulated (none if empty).
+     *  @param  max_threads Threads of the team opened by this loop (0 = OpenMP default, 1 = run
+     *                      inline). Ignored for nested loops, which share the team of the outer one.
+     **********************************************************************************************/
+    static void parallelFor(std::size_t n, std::size_t grain, const std::function<void(std::size_t)>& f,
+        const std::string& counter = "", unsigned int max_threads = 0);
+
+    static std::map<std::string, TaskCounter> getCounters(void);
+    static void resetCounters(void);
+    static void logCounters(void);
+
+private:
+    static void runChunk(std::size_t i0, std::size_t i1, const std::function<void(std::size_t)>& f,
+        const std::string& counter);
+
+    static std::map<std::string, TaskCounter> m_counters;
+    static std::mutex m_counters_mtx;
+};
+
+#endif /* TASK_POOL_HPP */
@@ -40,6 +40,12 @@ enum class PayoffModel {
     QUADRATIC           /* Quadratic function with slope and 0 at goal_min. */
 };
 
+enum class GeometryPrecision {
+    LONG_DOUBLE,        /* Reference path (extended precision). */
+    DOUBLE,             /* Double-precision kernels. */
+    FLOAT               /* Single-precision kernels (fastest, ~meters of error in swaths). */
+};
+
 enum class SandboxMode {
     SIMULATE,           /* Runs a simulation with the configured parameters. */
     RANDOM,             /* Simulates with most of the configured parameters but disables all reasoning and communications. */
@@ -47,4 +53,10 @@ enum class SandboxMode {
     PARSE_TLE_FILE      /* Parses a TLE file and generates a system.yml file. Does not simulate. */
 };
 
+enum class AgentCacheMode {
+    AUTO,               /* Loads the binary agent set if it matches the YAML source, regenerates it otherwise. */
+    BINARY,             /* Loads the binary agent set even if its source has changed. */
+    YAML                /* Always parses the YAML source (and regenerates the binary agent set). */
+};
+
 #endif /* COMMON_ENUM_TYPES_HPP */
@@ -102,9 +102,10 @@ void ActivityHandlerView::update(void)
                     }
                 } else {
                     /* Look if this agent is in the map: */
-                    if(m_act_others_ptr->find(f_elem.first) != m_act_others_ptr->end()) {
+                    auto it = m_act_others_ptr->find(IdRegistry::getAgentHandle(f_elem.first));
+                    if(it != m_act_others_ptr->end()) {
                         /* if it is, add all its segments: */
-                        for(auto& act : m_act_others_ptr->at(f_elem.first)) {
+                        for(auto& act : it->second) {
                             segv_ptr = act.second->getView(m_agent_id);
                             if(segv_ptr != nullptr) {
                                 segs.push_back(segv_ptr);
@@ -125,7 +126,7 @@ void ActivityHandlerView::update(void)
             }
             for(auto& actmap : *m_act_others_ptr) {
                 for(auto& act : actmap.second) {
-                    if(std::find(m_filter.begin(), m_filter.end(), std::make_pair(actmap.first, act.first)) != m_filter.end()) {
+                    if(std::find(m_filter.begin(), m_filter.end(), std::make_pair(act.second->getAgentId(), act.first)) != m_filter.end()) {
                         segv_ptr = act.second->getView(m_agent_id);
                         if(segv_ptr != nullptr) {
                             segs.push_back(segv_ptr);
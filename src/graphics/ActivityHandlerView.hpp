@@ -30,11 +30,15 @@ class ActivityHandlerView : public sf::Drawable
 public:
     ActivityHandlerView(std::string aid = "unknown");
     void setOwnActivityList(std::vector<std::shared_ptr<Activity> >* alist_ptr) { m_act_own_ptr = alist_ptr; }
-    void setOthersActivityList(std::map<std::string, std::map<unsigned int, std::shared_ptr<Activity> > > const * alist_ptr) { m_act_others_ptr = alist_ptr; }
+    void setOthersActivityList(std::map<AgentHandle, std::map<unsigned int, std::shared_ptr<Activity> > > const * alist_ptr) { m_act_others_ptr = alist_ptr; }
     void display(ActivityDisplayType adt, std::vector<std::pair<std::string, unsigned int> > filter = { });
     void update(void);
     void setAgentId(std::string aid) { m_agent_id = aid; }
 
+    /* Segments shown since the last update (e.g. to display copies of them in another view): */
+    const std::vector<std::shared_ptr<SegmentView> >& getSegments(void) const { return m_segments; }
+    void setSegments(std::vector<std::shared_ptr<SegmentView> > segs) { m_segments.swap(segs); }
+
 
 private:
     std::string m_agent_id;
@@ -43,7 +47,7 @@ private:
 
     std::vector<std::shared_ptr<SegmentView> > m_segments;
     std::vector<std::shared_ptr<Activity> > const * m_act_own_ptr;
-    std::map<std::string, std::map<unsigned int, std::shared_ptr<Activity> > > const * m_act_others_ptr;
+    std::map<AgentHandle, std::map<unsigned int, std::shared_ptr<Activity> > > const * m_act_others_ptr;
 
     void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
 };
@@ -79,6 +79,30 @@ void AgentLinkView::removeAll(void)
     m_link_lines.clear();
 }
 
+std::vector<AgentLinkView::Link> AgentLinkView::getLinks(void) const
+{
+    std::vector<Link> links;
+    for(auto& l : m_link_lines) {
+        State s = m_link_states.at(l.first);
+        if(s != State::DISCONNECTED) {
+            links.push_back({l.first, s, m_link_targets.at(l.first)});
+        }
+    }
+    return links;
+}
+
+void AgentLinkView::setLinks(sf::Vector2f position, const std::vector<Link>& links)
+{
+    m_position = position;
+    m_link_targets.clear();
+    m_link_states.clear();
+    m_link_lines.clear();
+    for(auto& l : links) {
+        m_link_targets[l.aid] = l.target;
+        m_link_states[l.aid] = l.state;
+        updateLine(l.aid);
+    }
+}
 
 void AgentLinkView::draw(sf::RenderTarget& target, sf::RenderStates states) const {
     for(auto& l : m_link_lines) {
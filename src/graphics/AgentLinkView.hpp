@@ -25,6 +25,15 @@ public:
         SENDING         /**< Connected and trasfering packets. */
     };
 
+    /*******************************************************************************************//**
+     *  Link as displayed (target positions are already wrapped around the world, if needed).
+     **********************************************************************************************/
+    struct Link {
+        std::string aid;
+        State state;
+        sf::Vector2f target;
+    };
+
     /*******************************************************************************************//**
      *  Create a new link view.
      **********************************************************************************************/
@@ -63,6 +72,17 @@ public:
      **********************************************************************************************/
     void removeAll(void);
 
+    /*******************************************************************************************//**
+     *  Position and links that are currently displayed (i.e. not disconnected).
+     **********************************************************************************************/
+    sf::Vector2f getPosition(void) const { return m_position; }
+    std::vector<Link> getLinks(void) const;
+
+    /*******************************************************************************************//**
+     *  Replaces all the links, e.g. with the ones of another view (see AgentLinkView::getLinks).
+     **********************************************************************************************/
+    void setLinks(sf::Vector2f position, const std::vector<Link>& links);
+
 private:
     sf::Vector2f m_position;
     std::map<std::string, sf::Vector2f> m_link_targets;
@@ -46,6 +46,7 @@ AgentView::AgentView(std::string str, float comms_range)
 
 void AgentView::setFootprint(std::vector<sf::Vector2f> footprint)
 {
+    m_footprint_points = footprint;
     m_footprint.clear();
     for(int i = 1; i < (int)footprint.size(); i++) {
         ThickLine tl(footprint[i - 1], footprint[i]);
@@ -81,6 +82,7 @@ void AgentView::displayId(bool d)
 
 void AgentView::setDirection(sf::Vector2f vel)
 {
+    m_direction = vel;
     float dir = 0.f;
     switch(quadrant(vel)) {
         case 1:
@@ -130,6 +132,7 @@ void AgentView::setText(std::string str)
 
 void AgentView::setLocation(sf::Vector2f l)
 {
+    m_location = l;
     m_txt.setPosition(l.x + Config::agent_size, l.y + Config::agent_size);
     m_range.setPosition(l);
     m_triangle.setPosition(l);
@@ -35,6 +35,10 @@ public:
     bool isFootprintHidden(void) const { return m_display_footprint; }
     bool isRangeHidden(void) const { return m_display_range; }
     bool isIdHidden(void) const { return m_display_id; }
+    std::string getText(void) const { return m_txt.getString(); }
+    sf::Vector2f getLocation(void) const { return m_location; }
+    sf::Vector2f getDirection(void) const { return m_direction; }
+    const std::vector<sf::Vector2f>& getFootprint(void) const { return m_footprint_points; }
 
 private:
     float m_comms_range;
@@ -42,6 +46,8 @@ private:
     bool m_display_range;
     bool m_display_id;
     sf::Vector2f m_location;
+    sf::Vector2f m_direction;
+    std::vector<sf::Vector2f> m_footprint_points;
     sf::ConvexShape m_triangle;
     std::vector<ThickLine> m_footprint;
     sf::CircleShape m_range;
@@ -65,3 +65,12 @@ sf::Color ColorGradient::getColorAt(float v)
     }
     return sf::Color::Black;
 }
+
+std::vector<sf::Color> ColorGradient::getLUT(unsigned int n)
+{
+    std::vector<sf::Color> lut(n);
+    for(unsigned int i = 0; i < n; i++) {
+        lut[i] = getColorAt(n > 1 ? (float)i / (n - 1) : 0.f);
+    }
+    return lut;
+}
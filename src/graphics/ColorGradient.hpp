@@ -19,6 +19,7 @@ public:
     ColorGradient(void);
     ColorGradient(std::map<float, sf::Color> colors);
     sf::Color getColorAt(float v);
+    std::vector<sf::Color> getLUT(unsigned int n = 256);   /* Colors at n evenly spaced values in [0, 1]. */
     void setGradient(std::map<float, sf::Color> cg) { m_color_steps = cg; }
 
 private:
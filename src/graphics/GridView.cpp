@@ -3,56 +3,143 @@
  *  @class      GridView
  *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
  *  @date       2018-sep-19
- *  @version    0.2
+ *  @version    0.3
  *  @copyright  This file is part of a project developed at Nano-Satellite and Payload Laboratory
  *              (NanoSat Lab), Technical University of Catalonia - UPC BarcelonaTech.
  **************************************************************************************************/
 
 #include "GridView.hpp"
 
-GridView::GridView(int w, int h, float cw, float ch, sf::Color init_color)
+const unsigned int GridView::lut_size;
+const std::uint16_t GridView::lut_below;
+const std::uint16_t GridView::lut_nan;
+const std::uint16_t GridView::lut_none;
+
+GridView::GridView(int w, int h, float cw, float ch, sf::Color init_color, bool use_texture)
     : m_width(w)
     , m_height(h)
-    , m_grid(sf::Triangles, w * h * 6)
+    , m_cell_width(cw)
+    , m_cell_height(ch)
+    , m_use_texture(use_texture)
+    , m_grid(sf::Triangles, use_texture ? 0 : w * h * 6)
     , m_color_gradient(Config::color_gradient_rainbow)
+    , m_texture_created(false)
 {
-    int v = 0;
-    m_grid_idxs.reserve(m_width);
-    for(int x = 0; x < m_width; x++) {
-        std::vector<GridUnit> col;
-        col.reserve(m_height);
-        for(int y = 0; y < m_height; y++) {
-            GridUnit cell_idx;
-            /* Triangle 1: */
-            m_grid[v + 0] = sf::Vertex(sf::Vector2f(cw * (x + 0), ch * (y + 0)), init_color);
-            m_grid[v + 1] = sf::Vertex(sf::Vector2f(cw * (x + 1), ch * (y + 0)), init_color);
-            m_grid[v + 2] = sf::Vertex(sf::Vector2f(cw * (x + 0), ch * (y + 1)), init_color);
-            cell_idx.ca0 = v + 0;
-            cell_idx.ca1 = v + 1;
-            cell_idx.ca3 = v + 2;
-            /* Triangle 2: */
-            m_grid[v + 3] = sf::Vertex(sf::Vector2f(cw * (x + 1), ch * (y + 0)), init_color);
-            m_grid[v + 4] = sf::Vertex(sf::Vector2f(cw * (x + 1), ch * (y + 1)), init_color);
-            m_grid[v + 5] = sf::Vertex(sf::Vector2f(cw * (x + 0), ch * (y + 1)), init_color);
-            cell_idx.cb1 = v + 3;
-            cell_idx.cb2 = v + 4;
-            cell_idx.cb3 = v + 5;
-
-            col.push_back(cell_idx);
-            v += 6;
+    if(m_use_texture) {
+        m_pixels.resize((std::size_t)w * h * 4);
+        for(std::size_t i = 0; i < m_pixels.size(); i += 4) {
+            m_pixels[i + 0] = init_color.r;
+            m_pixels[i + 1] = init_color.g;
+            m_pixels[i + 2] = init_color.b;
+            m_pixels[i + 3] = init_color.a;
+        }
+        m_dirty_columns.assign(w, 1);
+    } else {
+        int v = 0;
+        m_grid_idxs.reserve(m_width);
+        for(int x = 0; x < m_width; x++) {
+            std::vector<GridUnit> col;
+            col.reserve(m_height);
+            for(int y = 0; y < m_height; y++) {
+                GridUnit cell_idx;
+                /* Triangle 1: */
+                m_grid[v + 0] = sf::Vertex(sf::Vector2f(cw * (x + 0), ch * (y + 0)), init_color);
+                m_grid[v + 1] = sf::Vertex(sf::Vector2f(cw * (x + 1), ch * (y + 0)), init_color);
+                m_grid[v + 2] = sf::Vertex(sf::Vector2f(cw * (x + 0), ch * (y + 1)), init_color);
+                cell_idx.ca0 = v + 0;
+                cell_idx.ca1 = v + 1;
+                cell_idx.ca3 = v + 2;
+                /* Triangle 2: */
+                m_grid[v + 3] = sf::Vertex(sf::Vector2f(cw * (x + 1), ch * (y + 0)), init_color);
+                m_grid[v + 4] = sf::Vertex(sf::Vector2f(cw * (x + 1), ch * (y + 1)), init_color);
+                m_grid[v + 5] = sf::Vertex(sf::Vector2f(cw * (x + 0), ch * (y + 1)), init_color);
+                cell_idx.cb1 = v + 3;
+                cell_idx.cb2 = v + 4;
+                cell_idx.cb3 = v + 5;
+
+                col.push_back(cell_idx);
+                v += 6;
+            }
+            m_grid_idxs.push_back(col);
+        }
+    }
+    setColorGradient(m_color_gradient);
+}
+
+void GridView::setColorGradient(const ColorGradient& cg)
+{
+    m_color_gradient = cg;
+    m_lut = m_color_gradient.getLUT(lut_size);
+    m_lut.push_back(sf::Color(127, 127, 127));  /* lut_below (see ColorGradient::getColorAt). */
+    m_lut.push_back(sf::Color::Black);          /* lut_nan. */
+    m_cell_entries.assign((std::size_t)m_width * m_height, lut_none);
+}
+
+std::size_t GridView::getMemoryFootprint(void) const
+{
+    std::size_t b = sizeof(GridView) + m_grid.getVertexCount() * sizeof(sf::Vertex);
+    b += m_grid_idxs.capacity() * sizeof(std::vector<GridUnit>);
+    for(auto& col : m_grid_idxs) {
+        b += col.capacity() * sizeof(GridUnit);
+    }
+    b += m_lut.capacity() * sizeof(sf::Color) + m_cell_entries.capacity() * sizeof(std::uint16_t);
+    b += m_pixels.capacity() + m_dirty_columns.capacity() + m_upload_buffer.capacity();
+    return b;
+}
+
+std::uint16_t GridView::getEntry(float v)
+{
+    if(v >= 0.f && v <= 1.f) {
+        return (std::uint16_t)(v * (lut_size - 1) + 0.5f);
+    } else if(v > 1.f) {
+        return lut_size - 1;
+    } else if(v < 0.f) {
+        return lut_below;
+    }
+    return lut_nan;
+}
+
+void GridView::setEntry(int x, int y, std::uint16_t e)
+{
+    std::uint16_t& current = m_cell_entries[(std::size_t)x * m_height + y];
+    if(current != e) {
+        current = e;
+        setColor(x, y, m_lut[e]);
+    }
+}
+
+void GridView::setEntries(const std::vector<std::uint16_t>& entries)
+{
+    if(entries.size() != m_cell_entries.size()) {
+        throw std::runtime_error("Wrong number of entries for the grid view.");
+    }
+    for(int xx = 0; xx < m_width; xx++) {
+        for(int yy = 0; yy < m_height; yy++) {
+            std::uint16_t e = entries[(std::size_t)xx * m_height + yy];
+            if(e != lut_none) {
+                setEntry(xx, yy, e);
+            }
         }
-        m_grid_idxs.push_back(col);
     }
 }
 
 void GridView::setColor(int x, int y, sf::Color c)
 {
-    m_grid[m_grid_idxs[x][y].ca0 + 0].color = c;
-    m_grid[m_grid_idxs[x][y].ca0 + 1].color = c;
-    m_grid[m_grid_idxs[x][y].ca0 + 2].color = c;
-    m_grid[m_grid_idxs[x][y].ca0 + 3].color = c;
-    m_grid[m_grid_idxs[x][y].ca0 + 4].color = c;
-    m_grid[m_grid_idxs[x][y].ca0 + 5].color = c;
+    if(m_use_texture) {
+        sf::Uint8* p = &m_pixels[((std::size_t)y * m_width + x) * 4];
+        p[0] = c.r;
+        p[1] = c.g;
+        p[2] = c.b;
+        p[3] = c.a;
+        m_dirty_columns[x] = 1;
+    } else {
+        m_grid[m_grid_idxs[x][y].ca0 + 0].color = c;
+        m_grid[m_grid_idxs[x][y].ca0 + 1].color = c;
+        m_grid[m_grid_idxs[x][y].ca0 + 2].color = c;
+        m_grid[m_grid_idxs[x][y].ca0 + 3].color = c;
+        m_grid[m_grid_idxs[x][y].ca0 + 4].color = c;
+        m_grid[m_grid_idxs[x][y].ca0 + 5].color = c;
+    }
 }
 
 void GridView::setColor(std::vector<sf::Vector2i> units, sf::Color c)
@@ -62,23 +149,67 @@ void GridView::setColor(std::vector<sf::Vector2i> units, sf::Color c)
     }
 }
 
+void GridView::uploadTexture(void) const
+{
+    if(!m_texture_created) {
+        if(!m_texture.create(m_width, m_height)) {
+            return;
+        }
+        m_texture.setSmooth(false);
+        m_sprite.setTexture(m_texture, true);
+        m_sprite.setScale(m_cell_width, m_cell_height);
+        m_texture.update(m_pixels.data());
+        std::fill(m_dirty_columns.begin(), m_dirty_columns.end(), 0);
+        m_texture_created = true;
+        return;
+    }
+
+    /* Upload the span of columns that have changed: */
+    auto first = std::find(m_dirty_columns.begin(), m_dirty_columns.end(), 1);
+    if(first == m_dirty_columns.end()) {
+        return;
+    }
+    int x0 = first - m_dirty_columns.begin();
+    int x1 = m_width - 1;
+    while(m_dirty_columns[x1] == 0) {
+        x1--;
+    }
+    int n = x1 - x0 + 1;
+    if(n == m_width) {
+        m_texture.update(m_pixels.data());
+    } else {
+        m_upload_buffer.resize((std::size_t)n * m_height * 4);
+        for(int y = 0; y < m_height; y++) {
+            std::memcpy(&m_upload_buffer[(std::size_t)y * n * 4], &m_pixels[((std::size_t)y * m_width + x0) * 4], n * 4);
+        }
+        m_texture.update(m_upload_buffer.data(), n, m_height, x0, 0);
+    }
+    std::fill(m_dirty_columns.begin() + x0, m_dirty_columns.begin() + x1 + 1, 0);
+}
+
 void GridView::draw(sf::RenderTarget& target, sf::RenderStates states) const
 {
     if(m_show) {
-        target.draw(m_grid, states);
+        if(m_use_texture) {
+            uploadTexture();
+            target.draw(m_sprite, states);
+        } else {
+            target.draw(m_grid, states);
+        }
     }
 }
 
 void GridView::setValue(int x, int y, float v)
 {
-    setColor(x, y, m_color_gradient.getColorAt(v));
+    setEntry(x, y, getEntry(v));
 }
 
 void GridView::setValue(float v)
 {
+    std::uint16_t e = getEntry(v);
     for(int xx = 0; xx < m_width; xx++) {
         for(int yy = 0; yy < m_height; yy++) {
-            setColor(xx, yy, m_color_gradient.getColorAt(v));
+            setEntry(xx, yy, e);
         }
     }
 }
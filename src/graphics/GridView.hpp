@@ -3,7 +3,7 @@
  *  @class      GridView
  *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
  *  @date       2018-sep-19
- *  @version    0.2
+ *  @version    0.3
  *  @copyright  This file is part of a project developed at Nano-Satellite and Payload Laboratory
  *              (NanoSat Lab), Technical University of Catalonia - UPC BarcelonaTech.
  **************************************************************************************************/
@@ -15,14 +15,35 @@
 #include "ColorGradient.hpp"
 #include "HideGraphics.hpp"
 
+/***********************************************************************************************//**
+ *  Grid of w x h cells colored after a value in [0, 1] (negative values are shown in grey). Values
+ *  are quantized to the entries of a color look-up table (the color gradient sampled at
+ *  GridView::lut_size points) and cells are only recolored when their entry changes.
+ *  Cells are drawn either as a vertex array (two triangles per cell) or as a texture with one pixel
+ *  per cell (scaled to the cell size). Textures use far less memory and only the columns that have
+ *  changed since the last draw are uploaded.
+ *  NOTE: setValue can be called concurrently for cells in different columns.
+ **************************************************************************************************/
 class GridView : public HideGraphics, public sf::Drawable
 {
 public:
-    GridView(int w, int h, float cw, float ch, sf::Color init_color = sf::Color::Black);
+    GridView(int w, int h, float cw, float ch, sf::Color init_color = sf::Color::Black,
+        bool use_texture = Config::grid_textures);
 
-    void setColorGradient(const ColorGradient& cg) { m_color_gradient = cg; }
+    void setColorGradient(const ColorGradient& cg);
     void setValue(int x, int y, float v);
     void setValue(float v);
+    std::size_t getMemoryFootprint(void) const;
+
+    /*******************************************************************************************//**
+     *  Look-up table entry of a value. Entries of all the cells (column-major) can be read and set
+     *  at once, e.g. to fill a view in another thread (only the cells that change are recolored).
+     **********************************************************************************************/
+    static std::uint16_t getEntry(float v);
+    const std::vector<std::uint16_t>& getEntries(void) const { return m_cell_entries; }
+    void setEntries(const std::vector<std::uint16_t>& entries);
+
+    static const unsigned int lut_size = 256;
 
 private:
     struct GridUnit {
@@ -37,15 +58,33 @@ private:
         int ca3;
         int cb3;
     };
+    static const std::uint16_t lut_below = lut_size;        /**< LUT entry of negative values. */
+    static const std::uint16_t lut_nan = lut_size + 1;      /**< LUT entry of NaN values. */
+    static const std::uint16_t lut_none = 0xFFFF;           /**< Cell not set since the last LUT change. */
 
     int m_width;
     int m_height;
+    float m_cell_width;
+    float m_cell_height;
+    bool m_use_texture;
     sf::VertexArray m_grid;
     std::vector<std::vector<GridUnit> > m_grid_idxs;
     ColorGradient m_color_gradient;
+    std::vector<sf::Color> m_lut;                   /**< Gradient colors, then lut_below and lut_nan. */
+    std::vector<std::uint16_t> m_cell_entries;      /**< LUT entry of each cell (column-major). */
+
+    /* Texture mode: */
+    std::vector<sf::Uint8> m_pixels;                /**< RGBA of each cell (row-major). */
+    mutable std::vector<unsigned char> m_dirty_columns;
+    mutable std::vector<sf::Uint8> m_upload_buffer;
+    mutable sf::Texture m_texture;
+    mutable sf::Sprite m_sprite;
+    mutable bool m_texture_created;
 
+    void setEntry(int x, int y, std::uint16_t e);
     void setColor(int x, int y, sf::Color c);
     void setColor(std::vector<sf::Vector2i> units, sf::Color c);
+    void uploadTexture(void) const;
     virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const;
 };
 
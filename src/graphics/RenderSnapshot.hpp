@@ -0,0 +1,64 @@
+/***********************************************************************************************//**
+ *  State of the simulation to be drawn, decoupled from the model.
+ *  @class      RenderSnapshot
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef RENDER_SNAPSHOT_HPP
+#define RENDER_SNAPSHOT_HPP
+
+#include "prot.hpp"
+#include "HasView.hpp"
+#include "AgentLinkView.hpp"
+#include "SegmentView.hpp"
+
+/***********************************************************************************************//**
+ *  Dynamic part of the views of an agent (see AgentView and AgentLinkView).
+ **************************************************************************************************/
+struct AgentSnapshot {
+    std::string text;
+    sf::Vector2f location;
+    sf::Vector2f direction;
+    std::vector<sf::Vector2f> footprint;
+    sf::Vector2f link_position;
+    std::vector<AgentLinkView::Link> links;         /**< Links that are not disconnected. */
+};
+
+/***********************************************************************************************//**
+ *  Everything the draw thread needs from one step of the simulation. Snapshots are filled by the
+ *  control thread and exchanged through a TripleBuffer, hence the draw thread never reads the model.
+ *  Grids are kept as look-up table entries (see GridView::getEntries) and are only recomputed every
+ *  few snapshots: they are shared (read-only) by the snapshots in between and views recolor the
+ *  cells that differ from the last grid they were set to.
+ **************************************************************************************************/
+struct RenderSnapshot {
+    double time;
+    std::vector<AgentSnapshot> agents;
+    std::vector<std::shared_ptr<SegmentView> > activities;          /**< Copies of the segments of the first agent. */
+    unsigned int grids_version;                                     /**< Incremented every time grids are recomputed. */
+    std::shared_ptr<const std::vector<std::uint16_t> > world_actual;
+    std::shared_ptr<const std::vector<std::uint16_t> > world_utopia;
+    std::shared_ptr<const std::vector<std::uint16_t> > payoff;      /**< Payoff grid of the first agent. */
+};
+
+/***********************************************************************************************//**
+ *  View owned by the draw thread, e.g. a copy of a model view that is then updated from snapshots.
+ *  Implements HasView to be added to MultiView objects.
+ **************************************************************************************************/
+template <class V>
+class SnapshotView : public HasView
+{
+public:
+    SnapshotView(const V& v) : m_view(v) { }
+    V& get(void) { return m_view; }
+    const sf::Drawable& getView(void) const override { return m_view; }
+
+private:
+    V m_view;
+};
+
+#endif /* RENDER_SNAPSHOT_HPP */
@@ -16,6 +16,7 @@ CREATE_LOGGER(Activity)
 
 Activity::Activity(std::string agent_id, int id)
     : m_agent_id(agent_id)
+    , m_agent_handle(IdRegistry::getAgentHandle(agent_id))
     , m_id(id)
     , m_confirmed(false)
     , m_discarded(false)
@@ -44,6 +45,7 @@ Activity::~Activity(void)
 
 Activity::Activity(const Activity& other)
     : m_agent_id(other.m_agent_id)
+    , m_agent_handle(other.m_agent_handle)
     , m_id(other.m_id)
     , m_confirmed(other.m_confirmed)
     , m_discarded(other.m_discarded)
@@ -69,6 +71,7 @@ Activity::Activity(const Activity& other)
 Activity& Activity::operator=(const Activity& other)
 {
     m_agent_id = other.m_agent_id;
+    m_agent_handle = other.m_agent_handle;
     m_id = other.m_id;
     m_confirmed = other.m_confirmed;
     m_discarded = other.m_discarded;
@@ -205,14 +208,14 @@ int Activity::getCellTimes(unsigned int x, unsigned int y, double** t0s, double*
     return 0;
 }
 
-void Activity::setTrajectory(const std::map<double, sf::Vector3f>& pts, const std::vector<ActivityCell>& acs)
+void Activity::setTrajectory(const Trajectory& pts, const std::vector<ActivityCell>& acs)
 {
     if(m_cell_lut == nullptr) {
         m_cell_lut = std::make_shared<std::map<unsigned int, std::map<unsigned int, int> > >();
     } else {
         m_cell_lut->clear();
     }
-    m_trajectory = std::make_shared<std::map<double, sf::Vector3f> >(pts.begin(), pts.end());   /* Copies trajectory.   */
+    m_trajectory = std::make_shared<Trajectory>(pts);                                           /* Copies trajectory.   */
     m_active_cells = std::make_shared<std::vector<ActivityCell> >(acs.begin(), acs.end());      /* Copies active cells. */
     unsigned int it = 0;
     for(auto& ac : *m_active_cells) {
@@ -252,7 +255,7 @@ void Activity::setActiveCells(const std::vector<ActivityCell>& acs)
             m_cell_lut->emplace(ac.x, inner_map);
         }
     }
-    m_ready = m_trajectory->size() > 0;
+    m_ready = m_trajectory != nullptr && m_trajectory->size() > 0;
 }
 
 void Activity::setId(int id)
@@ -368,11 +371,7 @@ float Activity::utility(float c, float fl)
 std::shared_ptr<SegmentView> Activity::getView(std::string owner)
 {
     if(m_self_view == nullptr && m_ready) {
-        std::vector<sf::Vector2f> vec_pos;
-        vec_pos.reserve(m_trajectory->size());
-        for(auto& p : *m_trajectory) {
-            vec_pos.push_back(AgentMotion::getProjection2D(p.second, p.first));
-        }
+        std::vector<sf::Vector2f> vec_pos = AgentMotion::getProjection2D(*m_trajectory);
         m_self_view = std::make_shared<SegmentView>(vec_pos, m_agent_id + ":" + std::to_string(m_id));
         m_self_view->setOwnership(m_agent_id == owner);
         m_self_view->setActive(m_active);
@@ -386,7 +385,7 @@ std::shared_ptr<SegmentView> Activity::getView(std::string owner)
 double Activity::getStartTime(void) const
 {
     if(m_trajectory->size() > 0 && m_ready) {
-        return m_trajectory->cbegin()->first;
+        return m_trajectory->getStartTime();
     } else {
         Log::warn << "Trying to retrieve start time of activity "
             << m_agent_id << ":" << m_id << ", but its trajectory has yet not been defined.\n";
@@ -397,7 +396,7 @@ double Activity::getStartTime(void) const
 double Activity::getEndTime(void) const
 {
     if(m_trajectory->size() > 0 && m_ready) {
-        return m_trajectory->crbegin()->first;
+        return m_trajectory->getEndTime();
     } else {
         Log::warn << "Trying to retrieve end time of activity "
             << m_agent_id << ":" << m_id << ", but its trajectory has yet not been defined.\n";
@@ -408,15 +407,11 @@ double Activity::getEndTime(void) const
 void Activity::setStartTime(double t)
 {
     if(m_trajectory->size() > 1 && m_ready) {
-        auto i = m_trajectory->cbegin();
-        auto j = std::next(i);
-        if(t < j->first) {
-            if(std::abs(t - i->first) > Config::time_step) {
+        if(t < m_trajectory->getTime(1)) {
+            if(std::abs(t - m_trajectory->getStartTime()) > Config::time_step) {
                 Log::warn << "Changing start time of an activity will result in a change of more than one time step.\n";
             }
-            auto p = i->second;
-            m_trajectory->erase(i);         /* Remove the previous start point. */
-            m_trajectory->emplace(t, p);    /* Add it again with the new time. */
+            m_trajectory->setStartTime(t);  /* Keeps the start point, only its time changes. */
         } else {
             Log::err << "Can't change the start time of an activity for a value that is past the second trajectory point.\n";
         }
@@ -429,15 +424,11 @@ void Activity::setStartTime(double t)
 void Activity::setEndTime(double t)
 {
     if(m_trajectory->size() > 1 && m_ready) {
-        auto i = m_trajectory->crbegin();
-        auto j = std::prev(i);
-        if(t > j->first) {
-            if(std::abs(t - i->first) > Config::time_step) {
+        if(t > m_trajectory->getTime(m_trajectory->size() - 2)) {
+            if(std::abs(t - m_trajectory->getEndTime()) > Config::time_step) {
                 Log::warn << "Changing end time of an activity will result in a change of more than one time step.\n";
             }
-            auto p = i->second;
-            m_trajectory->erase(std::prev(m_trajectory->end()));    /* Remove the previous end point. */
-            m_trajectory->emplace(t, p);    /* Add it again with the new time. */
+            m_trajectory->setEndTime(t);    /* Keeps the end point, only its time changes. */
         } else {
             Log::err << "Can't change the end time of an activity for a value that is before the previous-to-last trajectory point.\n";
         }
@@ -447,6 +438,28 @@ void Activity::setEndTime(double t)
     }
 }
 
+void Activity::getMemoryUsage(MemoryUsage& mu) const
+{
+    mu.knowledge_base += sizeof(Activity) + MemoryUsage::bytes(m_agent_id);
+    if(m_trajectory != nullptr) {
+        mu.trajectories += m_trajectory->getMemoryFootprint() / m_trajectory.use_count();
+    }
+    if(m_active_cells != nullptr) {
+        std::size_t b = MemoryUsage::bytes(*m_active_cells);
+        for(auto& ac : *m_active_cells) {
+            b += 2 * MemoryUsage::chunk(ac.nts * sizeof(double));
+        }
+        mu.trajectories += b / m_active_cells.use_count();
+    }
+    if(m_cell_lut != nullptr) {
+        std::size_t b = MemoryUsage::bytes(*m_cell_lut);
+        for(auto& col : *m_cell_lut) {
+            b += MemoryUsage::bytes(col.second);
+        }
+        mu.trajectories += b / m_cell_lut.use_count();
+    }
+}
+
 bool Activity::operator<(const Activity& a) const
 {
     if(a.m_ready && m_ready) {
@@ -462,7 +475,7 @@ bool Activity::operator==(const Activity& a) const
     if(a.m_id <= -1 || m_id <= -1) {
         Log::warn << "Trying to compare (==) activities may be unreliable because their ID's are not set.\n";
     }
-    return (m_id == a.m_id) && (m_agent_id == a.m_agent_id) && (m_last_update == a.m_last_update);
+    return (m_id == a.m_id) && (m_agent_handle == a.m_agent_handle) && (m_last_update == a.m_last_update);
 }
 
 std::ostream& operator<<(std::ostream& os, const Activity& act)
@@ -12,7 +12,9 @@
 #define ACTIVITY_HPP
 
 #include "prot.hpp"
+#include "IdRegistry.hpp"
 #include "EnvModel.hpp"
+#include "Trajectory.hpp"
 
 class SegmentView;
 
@@ -107,7 +109,8 @@ public:
      *  Returns true if agent identified with `aid` is the owner of this task. False is returned
      *  otherwise.
      **********************************************************************************************/
-    bool isOwner(std::string aid) const { return aid == m_agent_id; }
+    bool isOwner(const std::string& aid) const { return aid == m_agent_id; }
+    bool isOwner(AgentHandle ah) const { return ah == m_agent_handle; }
 
     /*******************************************************************************************//**
      *  Retrieves the start and end times for the cell with model coordinates x and y.
@@ -157,20 +160,25 @@ public:
     /*******************************************************************************************//**
      *  Getter for the trajectory of this activity, as set by its creating agent.
      **********************************************************************************************/
-    std::shared_ptr<std::map<double, sf::Vector3f> > getTrajectory(void) const { return m_trajectory; }
-    // const std::map<double, sf::Vector3f>& getTrajectory(void) const { return m_trajectory; }
+    std::shared_ptr<const Trajectory> getTrajectory(void) const { return m_trajectory; }
 
     /*******************************************************************************************//**
      *  Returns the number of points in the trajectory of this activity.
      **********************************************************************************************/
     std::size_t getPositionCount(void) const { return m_trajectory->size(); }
 
+    /*******************************************************************************************//**
+     *  Returns the size (in bytes) of the trajectory of this activity in its compact (encoded)
+     *  representation. See Trajectory::encode.
+     **********************************************************************************************/
+    std::size_t getEncodedTrajectorySize(void) const { return m_trajectory->getEncodedSize(); }
+
     /*******************************************************************************************//**
      *  Sets the trajectory and the active cells for this activity. This function is meant to be
      *  called once an activity is created (i.e. both its trajectory and active cells are known and
      *  have been computed by the creating agent).
      **********************************************************************************************/
-    void setTrajectory(const std::map<double, sf::Vector3f>& pts, const std::vector<ActivityCell>& acs);
+    void setTrajectory(const Trajectory& pts, const std::vector<ActivityCell>& acs);
 
     /*******************************************************************************************//**
      *  Sets the active cells of this activity. This is meant to be called by an agent that has
@@ -240,7 +248,17 @@ public:
     /*******************************************************************************************//**
      *  Getter for the identifier of the creating agent.
      **********************************************************************************************/
-    std::string getAgentId(void) const { return m_agent_id; }
+    const std::string& getAgentId(void) const { return m_agent_id; }
+
+    /*******************************************************************************************//**
+     *  Getter for the interned identifier of the creating agent (see IdRegistry).
+     **********************************************************************************************/
+    AgentHandle getAgentHandle(void) const { return m_agent_handle; }
+
+    /*******************************************************************************************//**
+     *  Getter for the (agent, activity) handle. Only meaningful once the identifier has been set.
+     **********************************************************************************************/
+    ActivityHandle getHandle(void) const { return IdRegistry::getActivityHandle(m_agent_handle, (unsigned int)m_id); }
 
     /*******************************************************************************************//**
      *  Getter for the activity identifier.
@@ -329,6 +347,12 @@ public:
      *  Compares the start times of activities, iff both activities are ready.
      *  @throws     std::runtime_error if either of the two activities are not ready.
      **********************************************************************************************/
+    /*******************************************************************************************//**
+     *  Adds the estimated footprint of this activity (knowledge base), its trajectory and active
+     *  cells (trajectories). Buffers shared with copies of this activity are split among them.
+     **********************************************************************************************/
+    void getMemoryUsage(MemoryUsage& mu) const;
+
     bool operator<(const Activity& a) const;
 
     /*******************************************************************************************//**
@@ -344,6 +368,7 @@ public:
 
 private:
     std::string m_agent_id;         /* 1 bytes. */
+    AgentHandle m_agent_handle;     /* 4 bytes. */
     int m_id;                       /* 4 bytes. */
     bool m_confirmed;               /* 1 bytes. */
     bool m_discarded;               /* 0 bytes. */
@@ -359,7 +384,7 @@ private:
 
     /* Spatio-temporal information: */
     std::shared_ptr<SegmentView> m_self_view;
-    std::shared_ptr<std::map<double, sf::Vector3f> > m_trajectory;
+    std::shared_ptr<Trajectory> m_trajectory;
     std::shared_ptr<std::vector<ActivityCell> > m_active_cells;
     std::shared_ptr<std::map<unsigned int, std::map<unsigned int, int> > > m_cell_lut;
 };
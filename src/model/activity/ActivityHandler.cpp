@@ -19,6 +19,7 @@ ActivityHandler::ActivityHandler(Agent* aptr)
     , m_activity_count(0)
     , m_update_view(false)
     , m_aperture(0.f)
+    , m_agent_handle(0)
 {
     m_self_view.setOwnActivityList(&m_activities_own);
     m_self_view.setOthersActivityList(&m_activities_others);
@@ -28,6 +29,7 @@ ActivityHandler::ActivityHandler(Agent* aptr)
 void ActivityHandler::setAgentId(std::string aid)
 {
     m_agent_id = aid;
+    m_agent_handle = IdRegistry::getAgentHandle(aid);
     m_self_view.setAgentId(aid);
     initReport("agents/" + aid + "/", "knowledgebase.csv");
     addReportColumn("known_facts_own");     /* 0 */
@@ -106,6 +108,9 @@ void ActivityHandler::discard(std::shared_ptr<Activity> pa)
     auto it = std::find(m_activities_own.begin(), m_activities_own.end(), pa);
     if(it != m_activities_own.end()) {
         pa->setDiscarded(true);
+        if(m_env_model_ptr != nullptr) {
+            m_env_model_ptr->touchActivity(pa);
+        }
         buildActivityLUT();
     }
     report();
@@ -174,38 +179,52 @@ void ActivityHandler::purge(bool remove_unsent, std::set<int> skip_list)
      *  longer meaningful to anyone.
      **/
     if(m_env_model_ptr != nullptr) {
-        /* Build crosscheck set: */
-        std::set<std::pair<std::string, unsigned int> > xcset_ah;
+        /* Build crosscheck list (sorted, as the one from the environment model): */
+        std::vector<ActivityHandle> xclist_ah;
+        xclist_ah.reserve(m_activities_own.size());
         for(auto& acown : m_activities_own) {
-            xcset_ah.insert(std::make_pair(acown->getAgentId(), acown->getId()));
+            xclist_ah.push_back(acown->getHandle());
         }
         for(auto& acothers : m_activities_others) {
             for(auto& act : acothers.second) {
-                xcset_ah.insert(std::make_pair(act.second->getAgentId(), act.second->getId()));
+                xclist_ah.push_back(act.second->getHandle());
             }
         }
-        auto xcset_env = m_env_model_ptr->getCrosscheckList();
-        /* Remove coincident: */
-        for(auto& pair : xcset_env) {
-            if(xcset_ah.count(pair)) {
-                xcset_ah.erase(pair);
-            } else {
+        std::sort(xclist_ah.begin(), xclist_ah.end());
+        xclist_ah.erase(std::unique(xclist_ah.begin(), xclist_ah.end()), xclist_ah.end());
+        const auto& xclist_env = m_env_model_ptr->getCrosscheckList();
+        /* Remove coincident (linear merge of both sorted lists): */
+        std::vector<ActivityHandle> xcset_ah;
+        auto it_ah = xclist_ah.begin();
+        auto it_env = xclist_env.begin();
+        while(it_env != xclist_env.end()) {
+            if(it_ah == xclist_ah.end() || *it_env < *it_ah) {
                 Log::err << "[" << m_agent_id << "] Environment model retained an activity that is not in the knowledge base ";
-                Log::err << "[" << pair.first << ":" << pair.second << "].\n";
+                Log::err << "[" << IdRegistry::toString(*it_env) << "].\n";
+                it_env++;
+            } else if(*it_ah < *it_env) {
+                xcset_ah.push_back(*it_ah);
+                it_ah++;
+            } else {
+                it_ah++;
+                it_env++;
             }
         }
+        xcset_ah.insert(xcset_ah.end(), it_ah, xclist_ah.end());
         if(xcset_ah.size() > 0) {
             count = 0;
-            for(auto& pair : xcset_ah) {
-                if(pair.first == m_agent_id) {
-                    if(skip_list.find(pair.second) == skip_list.end()) {
+            for(auto& xch : xcset_ah) {
+                AgentHandle xc_agent = IdRegistry::getAgent(xch);
+                unsigned int xc_id = IdRegistry::getSequence(xch);
+                if(xc_agent == m_agent_handle) {
+                    if(skip_list.find(xc_id) == skip_list.end()) {
                         /* It's not in the skip list. We shall remove it: */
                         for(auto it = m_activities_own.begin(); it != m_activities_own.end(); ) {
-                            if((*it)->getId() == (int)pair.second && !(*it)->isDiscarded()) {
+                            if((*it)->getId() == (int)xc_id && !(*it)->isDiscarded()) {
                                 m_activities_own.erase(it);
                                 count++;
                                 break;
-                            } else if((*it)->getId() == (int)pair.second && (*it)->isDiscarded()) {
+                            } else if((*it)->getId() == (int)xc_id && (*it)->isDiscarded()) {
                                 break;
                             } else {
                                 it++;
@@ -214,8 +233,8 @@ void ActivityHandler::purge(bool remove_unsent, std::set<int> skip_list)
                     }
                 } else {
                     /* We can safely use the subscript operator[] because we have just built `xcset_ah`: */
-                    if(!m_activities_others[pair.first][pair.second]->isDiscarded()) {
-                        m_activities_others[pair.first].erase(pair.second);
+                    if(!m_activities_others[xc_agent][xc_id]->isDiscarded()) {
+                        m_activities_others[xc_agent].erase(xc_id);
                         count++;
                     }
                 }
@@ -249,6 +268,9 @@ void ActivityHandler::update(void)
             if(aptr->getStartTime() - t <= (Config::activity_confirm_window * Config::time_step)) {
                 /* Can be confirmed now: */
                 aptr->setConfirmed(true);
+                if(m_env_model_ptr != nullptr) {
+                    m_env_model_ptr->touchActivity(aptr);
+                }
                 report_flag = true;
             }
         }
@@ -264,10 +286,13 @@ void ActivityHandler::update(void)
                     std::string idb = std::to_string(m_activities_own[j]->getId());
                     Log::err << "Two non-discarded activities overlap in [" << m_agent_id << "]: " << ida << " and " << idb << "\n";
                     Log::err << "Will discard the older and continue, but this is unexpected\n";
+                    auto dptr = m_activities_own[it->second];
                     if(m_activities_own[it->second]->getLastUpdateTime() >= m_activities_own[j]->getLastUpdateTime()) {
-                        m_activities_own[j]->setDiscarded(true);
-                    } else {
-                        m_activities_own[it->second]->setDiscarded(true);
+                        dptr = m_activities_own[j];
+                    }
+                    dptr->setDiscarded(true);
+                    if(m_env_model_ptr != nullptr) {
+                        m_env_model_ptr->touchActivity(dptr);
                     }
                 }
                 j = it->second;
@@ -328,6 +353,21 @@ void ActivityHandler::markAsSent(int aid)
     }
 }
 
+void ActivityHandler::getMemoryUsage(MemoryUsage& mu) const
+{
+    mu.knowledge_base += MemoryUsage::bytes(m_act_own_lut) + MemoryUsage::bytes(m_activities_own);
+    mu.knowledge_base += MemoryUsage::bytes(m_activities_others) + MemoryUsage::bytes(m_agent_id);
+    for(auto& a : m_activities_own) {
+        a->getMemoryUsage(mu);
+    }
+    for(auto& ao : m_activities_others) {
+        mu.knowledge_base += MemoryUsage::bytes(ao.second);
+        for(auto& a : ao.second) {
+            a.second->getMemoryUsage(mu);
+        }
+    }
+}
+
 bool ActivityHandler::isCapturing(void)
 {
     double t = VirtualTime::now();
@@ -342,6 +382,27 @@ bool ActivityHandler::isCapturing(void)
     return false;
 }
 
+double ActivityHandler::getNextEventTime(void) const
+{
+    double t = VirtualTime::now();
+    double t_next = std::numeric_limits<double>::infinity();
+    for(auto& aptr : m_activities_own) {
+        if(aptr->isDiscarded()) {
+            continue;
+        }
+        if(aptr->getStartTime() > t) {
+            t_next = std::min(t_next, aptr->getStartTime());
+        } else if(aptr->getEndTime() > t) {
+            t_next = std::min(t_next, aptr->getEndTime());
+        }
+        if(!aptr->isFact()) {
+            /* Same condition as in ActivityHandler::update: */
+            t_next = std::min(t_next, aptr->getStartTime() - (Config::activity_confirm_window * Config::time_step));
+        }
+    }
+    return t_next;
+}
+
 std::shared_ptr<Activity> ActivityHandler::getNextActivity(double t) // const
 {
     if(t <= -1.0) {
@@ -411,14 +472,14 @@ std::shared_ptr<Activity> ActivityHandler::getLastActivity(void) // const
     }
 }
 
-unsigned int ActivityHandler::count(std::string aid) const
+unsigned int ActivityHandler::count(const std::string& aid) const
 {
     if(aid == m_agent_id) {
         return m_activities_own.size();
     } else {
-        auto it = m_activities_others.find(aid);
+        auto it = m_activities_others.find(IdRegistry::getAgentHandle(aid));
         if(it != m_activities_others.end()) {
-            return m_activities_others.at(aid).size();
+            return it->second.size();
         } else {
             return 0;
         }
@@ -440,7 +501,7 @@ unsigned int ActivityHandler::pending(void) const
 
 std::shared_ptr<Activity> ActivityHandler::createOwnedActivity(
     double /* t0 */, double /* t1 */,
-    const std::map<double, sf::Vector3f>& a_pos,
+    const Trajectory& a_pos,
     const std::vector<ActivityCell>& a_cells)
 {
     auto a = std::make_shared<Activity>(m_agent_id);
@@ -466,6 +527,9 @@ void ActivityHandler::add(std::shared_ptr<Activity> a, std::map<unsigned int, st
                  *  been cleaned).
                  **/
                 m_env_model_ptr->updateActivity(a); /* Will also be cloned in EnvModel::updateActivity. */
+            } else if(m_env_model_ptr != nullptr) {
+                /* ... but if they are, the cells hold the object that has just been cloned: */
+                m_env_model_ptr->touchActivity(a);
             }
             Log::dbg << "Agent " << m_agent_id << " updated an activity from " << a->getAgentId() << ": " << *a << "\n";
         }
@@ -497,6 +561,9 @@ void ActivityHandler::add(std::shared_ptr<Activity> a, std::map<unsigned int, st
             }
             for(auto& oa : overlap_vec) {
                 oa->setDiscarded(true);
+                if(m_env_model_ptr != nullptr) {
+                    m_env_model_ptr->touchActivity(oa);
+                }
             }
             // if(Config::verbosity) {
             //     Log::dbg << "Agent " << m_agent_id << " added an new activity from " << a->getAgentId() << ": " << *a << "\n";
@@ -519,7 +586,7 @@ void ActivityHandler::add(std::shared_ptr<Activity> pa)
         Log::err << "[" << m_agent_id << "] Trying to add an activity that had 0 active cells: " << pa << ". Ignoring.\n";
         return;
     }
-    if(pa->isOwner(m_agent_id)) {
+    if(pa->isOwner(m_agent_handle)) {
         /* It's owned: */
         pa->setId(m_activity_count++);
         auto overlap_vec = checkOverlaps(pa, m_activities_own);
@@ -542,12 +609,12 @@ void ActivityHandler::add(std::shared_ptr<Activity> pa)
             count_activities += kbi.second.size();
         }
         if(count_activities < Config::knowledge_base_size) {
-            add(pa, m_activities_others[pa->getAgentId()]);
+            add(pa, m_activities_others[pa->getAgentHandle()]);
         } else {
 #if 0
             /* Will remove the lower priority one, and add the new one: */
             std::map<float, unsigned int> list; /* table <priority, ID>. */
-            for(auto& act_old : m_activities_others[pa->getAgentId()]) {
+            for(auto& act_old : m_activities_others[pa->getAgentHandle()]) {
                 list[act_old.second->getPriority(ActivityPriorityModel::BASIC)] = act_old.first;
             }
             /* Maps are sorted, so the first element is the one with lower priority: */
@@ -555,8 +622,8 @@ void ActivityHandler::add(std::shared_ptr<Activity> pa)
                 Log::err << "========================= Will replace ["
                     << pa->getAgentId() << ":" << list.begin()->second << " == " << list.begin()->first << "] by ["
                     << pa->getAgentId() << ":" << pa->getId() << " == " << pa->getPriority(ActivityPriorityModel::BASIC) << "]\n";
-                m_activities_others[pa->getAgentId()].erase(list.begin()->second);
-                add(pa, m_activities_others[pa->getAgentId()]);
+                m_activities_others[pa->getAgentHandle()].erase(list.begin()->second);
+                add(pa, m_activities_others[pa->getAgentHandle()]);
             } /*... else: the new activity has lower priority than the worst (this is very unlikely). We do nothing. */
 #endif
         }
@@ -567,7 +634,7 @@ void ActivityHandler::add(std::shared_ptr<Activity> pa)
     report();
 }
 
-const sf::Drawable& ActivityHandler::getView(void) const
+const ActivityHandlerView& ActivityHandler::getView(void) const
 {
     return m_self_view;
 }
@@ -582,10 +649,10 @@ void ActivityHandler::displayInView(ActivityDisplayType adt, std::vector<std::pa
     m_self_view.display(adt, filter);
 }
 
-std::vector<std::shared_ptr<Activity> > ActivityHandler::getActivitiesToExchange(std::string aid)
+std::vector<std::shared_ptr<Activity> > ActivityHandler::getActivitiesToExchange(AgentHandle ah)
 {
     std::vector<std::shared_ptr<Activity> > retvec;
-    if(aid == m_agent_id) {
+    if(ah == m_agent_handle) {
         return retvec;
     }
 
@@ -594,12 +661,15 @@ std::vector<std::shared_ptr<Activity> > ActivityHandler::getActivitiesToExchange
     for(auto aptr : m_activities_own) {
         if(aptr->getEndTime() >= time_th) {
             aptr->setConfidence();  /* Updates the confidence that will be reported if undecided. */
+            /*  NOTE: EnvModel::touchActivity is not needed: undecided owned activities are in the
+             *  future and are not considered when this agent computes payoff.
+             **/
             retvec.push_back(aptr);
         }
     }
-    /* Add all activities from others (except those from aid itself): */
+    /* Add all activities from others (except those from ah itself): */
     for(auto& as_others : m_activities_others) {
-        if(as_others.first != aid) {
+        if(as_others.first != ah) {
             for(auto& apair : as_others.second) {
                 if(apair.second->getEndTime() >= time_th) {
                     retvec.push_back(apair.second);
@@ -613,7 +683,7 @@ std::vector<std::shared_ptr<Activity> > ActivityHandler::getActivitiesToExchange
     });
 
     /* Debug:
-    Log::warn << "==== Agent " << m_agent_id << " is going to transfer the following activities to " << aid << ": =====================\n";
+    Log::warn << "==== Agent " << m_agent_id << " is going to transfer the following activities to " << IdRegistry::getAgentName(ah) << ": =====================\n";
     int count = 0;
     for(auto& a : retvec) {
         if(count++ <= 20) {
@@ -35,6 +35,13 @@ public:
      **********************************************************************************************/
     bool isCapturing(void);
 
+    /*******************************************************************************************//**
+     *  Computes the next time at which the state of owned activities will change on its own (i.e.
+     *  the start or end of a non-discarded activity, or the time from which an undecided activity
+     *  will be confirmed in ActivityHandler::update). Returns infinity if there are no such events.
+     **********************************************************************************************/
+    double getNextEventTime(void) const;
+
     /*******************************************************************************************//**
      *  Determines whether two activities have overlapping intervals.
      **********************************************************************************************/
@@ -90,7 +97,7 @@ public:
      *  Counts the number of known activities for an agent identified with `aid`.
      *  @param  aid     Agent identifier.
      **********************************************************************************************/
-    unsigned int count(std::string aid) const;
+    unsigned int count(const std::string& aid) const;
 
     /*******************************************************************************************//**
      *  Gives the number of activities for the owning agent such that they end in the future and
@@ -108,20 +115,19 @@ public:
     /*******************************************************************************************//**
      *  Creates an activity that is onwed by this agent. This function does not add the new activity
      *  to the internal list, but only generates the object and assigns its trajectory.
-     *  @param  a_pos   A table with the trajectory for this activity where the index (double) is
-     *                  the virtual time and the item (sf::Vector3f) is the propagated position of
-     *                  the agent.
+     *  @param  a_pos   The trajectory for this activity: propagated positions of the agent sampled
+     *                  every time step from the activity start time.
      **********************************************************************************************/
     std::shared_ptr<Activity> createOwnedActivity(
         double t0, double t1,
-        const std::map<double, sf::Vector3f>& a_pos,
+        const Trajectory& a_pos,
         const std::vector<ActivityCell>& a_cells
     );
 
     /*******************************************************************************************//**
-     *  Finds a list of activities that could be worth sharing with agent `aid`.
+     *  Finds a list of activities that could be worth sharing with agent `ah` (see IdRegistry).
      **********************************************************************************************/
-    std::vector<std::shared_ptr<Activity> > getActivitiesToExchange(std::string aid);
+    std::vector<std::shared_ptr<Activity> > getActivitiesToExchange(AgentHandle ah);
 
     /*******************************************************************************************//**
      *  Setter for the instrument aperture of the owner agent.
@@ -136,7 +142,7 @@ public:
     /*******************************************************************************************//**
      *  Implements the HasView interface.
      **********************************************************************************************/
-    const sf::Drawable& getView(void) const override;
+    const ActivityHandlerView& getView(void) const override;
 
     /*******************************************************************************************//**
      *  Configure whether the view should automatically be updated as new activities are added.
@@ -167,11 +173,17 @@ public:
      **********************************************************************************************/
     void markAsSent(int aid);
 
+    /*******************************************************************************************//**
+     *  Adds the estimated footprint of the known activities (own and from other agents).
+     **********************************************************************************************/
+    void getMemoryUsage(MemoryUsage& mu) const;
+
 private:
     std::map<double, unsigned int> m_act_own_lut;               /* Activity LUT (own) indexed by start time. */
     std::vector<std::shared_ptr<Activity> > m_activities_own;   /* Unsorted. */
-    std::map<std::string, std::map<unsigned int, std::shared_ptr<Activity> > > m_activities_others;
+    std::map<AgentHandle, std::map<unsigned int, std::shared_ptr<Activity> > > m_activities_others;
     std::string m_agent_id;
+    AgentHandle m_agent_handle;
     Agent* m_agent;
     bool m_update_view;
     ActivityHandlerView m_self_view;
@@ -0,0 +1,206 @@
+/***********************************************************************************************//**
+ *  Uniformly sampled trajectory of an activity.
+ *  @class      Trajectory
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-10
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#include "Trajectory.hpp"
+#include <cstring>
+
+CREATE_LOGGER(Trajectory)
+
+/*  Header: number of positions (uint32), t0, step, first and last times (double), quantisation
+ *  scale (float) and the first position (3 x float).
+ **/
+const std::size_t Trajectory::enc_header_size = sizeof(std::uint32_t) + 4 * sizeof(double) + 4 * sizeof(float);
+const float Trajectory::enc_delta_max = 32000.f;    /* Leaves some margin below INT16_MAX. */
+
+Trajectory::Trajectory(double t0, double step)
+    : m_t0(t0)
+    , m_step(step)
+    , m_t_first(t0)
+    , m_t_last(t0)
+{ }
+
+void Trajectory::addPosition(const sf::Vector3f& p)
+{
+    m_positions.push_back(p);
+    m_t_last = m_t0 + (m_positions.size() - 1) * m_step;
+    if(m_positions.size() == 1) {
+        m_t_first = m_t_last;
+    }
+}
+
+double Trajectory::getTime(std::size_t i) const
+{
+    if(i == 0) {
+        return m_t_first;
+    } else if(i + 1 >= m_positions.size()) {
+        return m_t_last;
+    } else {
+        return m_t0 + i * m_step;
+    }
+}
+
+std::size_t Trajectory::indexAt(double t) const
+{
+    if(m_positions.empty()) {
+        Log::err << "Trying to find a position in an empty trajectory.\n";
+        throw std::runtime_error("Empty trajectory.");
+    }
+    std::size_t n = m_positions.size();
+    if(t <= m_t_first || n == 1) {
+        return 0;
+    } else if(t >= m_t_last) {
+        return n - 1;
+    }
+    long int i = std::floor((t - m_t0) / m_step);
+    std::size_t idx = (std::size_t)std::max(0L, std::min(i, (long int)n - 1));
+    /* Correct for first/last times that are not on the grid and for rounding errors: */
+    while(idx > 0 && getTime(idx) > t) {
+        idx--;
+    }
+    while(idx + 1 < n && getTime(idx + 1) <= t) {
+        idx++;
+    }
+    return idx;
+}
+
+sf::Vector3f Trajectory::getPosition(double t, bool interpolate) const
+{
+    std::size_t i = indexAt(t);
+    if(!interpolate || i + 1 >= m_positions.size()) {
+        return m_positions[i];
+    }
+    double ti = getTime(i);
+    double tj = getTime(i + 1);
+    float k = (tj > ti) ? std::min(std::max((t - ti) / (tj - ti), 0.0), 1.0) : 0.f;
+    return m_positions[i] + (m_positions[i + 1] - m_positions[i]) * k;
+}
+
+void Trajectory::setStartTime(double t)
+{
+    m_t_first = t;
+    if(m_positions.size() <= 1) {
+        m_t_last = t;
+    }
+}
+
+void Trajectory::setEndTime(double t)
+{
+    m_t_last = t;
+    if(m_positions.size() <= 1) {
+        m_t_first = t;
+    }
+}
+
+std::size_t Trajectory::getEncodedSize(void) const
+{
+    if(m_positions.empty()) {
+        return enc_header_size;
+    }
+    return enc_header_size + (m_positions.size() - 1) * 3 * sizeof(std::int16_t);
+}
+
+std::vector<std::uint8_t> Trajectory::encode(void) const
+{
+    std::vector<std::uint8_t> buf(getEncodedSize());
+    std::uint8_t* ptr = buf.data();
+    auto write = [&ptr](const void* v, std::size_t s) {
+        std::memcpy(ptr, v, s);
+        ptr += s;
+    };
+
+    /* Find the quantisation scale from the largest delta in any of the three axes: */
+    float max_delta = 0.f;
+    for(std::size_t i = 1; i < m_positions.size(); i++) {
+        sf::Vector3f d = m_positions[i] - m_positions[i - 1];
+        max_delta = std::max(max_delta, std::max(std::abs(d.x), std::max(std::abs(d.y), std::abs(d.z))));
+    }
+    float scale = (max_delta > 0.f ? max_delta / enc_delta_max : 1.f);
+
+    std::uint32_t n = m_positions.size();
+    sf::Vector3f p0 = (n > 0 ? m_positions[0] : sf::Vector3f(0.f, 0.f, 0.f));
+    write(&n, sizeof(n));
+    write(&m_t0, sizeof(m_t0));
+    write(&m_step, sizeof(m_step));
+    write(&m_t_first, sizeof(m_t_first));
+    write(&m_t_last, sizeof(m_t_last));
+    write(&scale, sizeof(scale));
+    write(&p0.x, sizeof(float));
+    write(&p0.y, sizeof(float));
+    write(&p0.z, sizeof(float));
+
+    /* Deltas are computed from the reconstructed position (closed loop): */
+    sf::Vector3f rec = p0;
+    auto quantise = [scale](float v) -> std::int16_t {
+        float q = std::round(v / scale);
+        q = std::min(std::max(q, -(float)INT16_MAX), (float)INT16_MAX);
+        return (std::int16_t)q;
+    };
+    for(std::size_t i = 1; i < m_positions.size(); i++) {
+        sf::Vector3f d = m_positions[i] - rec;
+        std::int16_t qx = quantise(d.x);
+        std::int16_t qy = quantise(d.y);
+        std::int16_t qz = quantise(d.z);
+        write(&qx, sizeof(qx));
+        write(&qy, sizeof(qy));
+        write(&qz, sizeof(qz));
+        rec += sf::Vector3f(qx * scale, qy * scale, qz * scale);
+    }
+    return buf;
+}
+
+Trajectory Trajectory::decode(const std::vector<std::uint8_t>& buf)
+{
+    if(buf.size() < enc_header_size) {
+        Log::err << "Unable to decode trajectory: buffer is too short (" << buf.size() << " bytes).\n";
+        throw std::runtime_error("Malformed trajectory buffer.");
+    }
+    const std::uint8_t* ptr = buf.data();
+    auto read = [&ptr](void* v, std::size_t s) {
+        std::memcpy(v, ptr, s);
+        ptr += s;
+    };
+
+    std::uint32_t n;
+    double t0, step, t_first, t_last;
+    float scale;
+    sf::Vector3f p0;
+    read(&n, sizeof(n));
+    read(&t0, sizeof(t0));
+    read(&step, sizeof(step));
+    read(&t_first, sizeof(t_first));
+    read(&t_last, sizeof(t_last));
+    read(&scale, sizeof(scale));
+    read(&p0.x, sizeof(float));
+    read(&p0.y, sizeof(float));
+    read(&p0.z, sizeof(float));
+    if(n > 0 && buf.size() != enc_header_size + (n - 1) * 3 * sizeof(std::int16_t)) {
+        Log::err << "Unable to decode trajectory: expected " << n << " positions but buffer has "
+            << buf.size() << " bytes.\n";
+        throw std::runtime_error("Malformed trajectory buffer.");
+    }
+
+    Trajectory traj(t0, step);
+    traj.reserve(n);
+    if(n > 0) {
+        sf::Vector3f rec = p0;
+        traj.addPosition(rec);
+        for(std::uint32_t i = 1; i < n; i++) {
+            std::int16_t qx, qy, qz;
+            read(&qx, sizeof(qx));
+            read(&qy, sizeof(qy));
+            read(&qz, sizeof(qz));
+            rec += sf::Vector3f(qx * scale, qy * scale, qz * scale);
+            traj.addPosition(rec);
+        }
+        traj.m_t_first = t_first;
+        traj.m_t_last = t_last;
+    }
+    return traj;
+}
@@ -0,0 +1,139 @@
+/***********************************************************************************************//**
+ *  Uniformly sampled trajectory of an activity.
+ *  @class      Trajectory
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-10
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef TRAJECTORY_HPP
+#define TRAJECTORY_HPP
+
+#include "prot.hpp"
+#include <cstdint>
+
+class Trajectory
+{
+public:
+    /*******************************************************************************************//**
+     *  Constructs an empty trajectory sampled every `step` time units, starting at `t0`.
+     *  @param  t0      Time of the first position (i.e. origin of the time grid).
+     *  @param  step    Time between consecutive positions.
+     **********************************************************************************************/
+    Trajectory(double t0 = 0.0, double step = Config::time_step);
+
+    /*******************************************************************************************//**
+     *  Reserves memory for `n` positions.
+     **********************************************************************************************/
+    void reserve(std::size_t n) { m_positions.reserve(n); }
+
+    /*******************************************************************************************//**
+     *  Appends a position at the next point of the time grid (i.e. t0 + size() * step). The end
+     *  time is moved to that point as well.
+     **********************************************************************************************/
+    void addPosition(const sf::Vector3f& p);
+
+    /*******************************************************************************************//**
+     *  Returns the number of positions in the trajectory.
+     **********************************************************************************************/
+    std::size_t size(void) const { return m_positions.size(); }
+
+    /*******************************************************************************************//**
+     *  Returns true iff the trajectory has no positions.
+     **********************************************************************************************/
+    bool empty(void) const { return m_positions.empty(); }
+
+    /*******************************************************************************************//**
+     *  Getter for the time of the first position. For trajectories with a single position, start
+     *  and end times are equal.
+     **********************************************************************************************/
+    double getStartTime(void) const { return m_t_first; }
+
+    /*******************************************************************************************//**
+     *  Getter for the time of the last position.
+     **********************************************************************************************/
+    double getEndTime(void) const { return m_t_last; }
+
+    /*******************************************************************************************//**
+     *  Getter for the time between consecutive (inner) positions.
+     **********************************************************************************************/
+    double getStep(void) const { return m_step; }
+
+    /*******************************************************************************************//**
+     *  Returns the time for the position at index `i`. Inner positions lie on the uniform time
+     *  grid while the first and last ones use the start and end times, which may have been moved
+     *  (less than one step) with setStartTime and setEndTime.
+     **********************************************************************************************/
+    double getTime(std::size_t i) const;
+
+    /*******************************************************************************************//**
+     *  Returns the position at index `i`. Does not check bounds.
+     **********************************************************************************************/
+    const sf::Vector3f& at(std::size_t i) const { return m_positions[i]; }
+
+    /*******************************************************************************************//**
+     *  Finds the index of the last position whose time is lower or equal than `t`. Times outside
+     *  the trajectory are clamped to the first and last positions. Runs in constant time.
+     *  @throws     std::runtime_error if the trajectory is empty.
+     **********************************************************************************************/
+    std::size_t indexAt(double t) const;
+
+    /*******************************************************************************************//**
+     *  Returns the position at time `t`.
+     *  @param  t           The time. Values outside the trajectory are clamped.
+     *  @param  interpolate Whether to interpolate linearly between the two surrounding positions
+     *                      (true) or return the position at indexAt(t) (false).
+     **********************************************************************************************/
+    sf::Vector3f getPosition(double t, bool interpolate = false) const;
+
+    /*******************************************************************************************//**
+     *  Getter for the contiguous list of positions.
+     **********************************************************************************************/
+    const std::vector<sf::Vector3f>& getPositions(void) const { return m_positions; }
+
+    /*******************************************************************************************//**
+     *  Moves the start time of the trajectory. The first position is kept.
+     **********************************************************************************************/
+    void setStartTime(double t);
+
+    /*******************************************************************************************//**
+     *  Moves the end time of the trajectory. The last position is kept.
+     **********************************************************************************************/
+    void setEndTime(double t);
+
+    /*******************************************************************************************//**
+     *  Returns the size (in bytes) of the compact representation of this trajectory, as it would
+     *  be generated by encode(). This does not encode the trajectory.
+     **********************************************************************************************/
+    std::size_t getEncodedSize(void) const;
+
+    std::size_t getMemoryFootprint(void) const { return sizeof(Trajectory) + m_positions.capacity() * sizeof(sf::Vector3f); }
+
+    /*******************************************************************************************//**
+     *  Generates a compact representation of this trajectory. The header contains the time grid,
+     *  the quantisation scale and the first position (in full precision). The rest of positions
+     *  are encoded as 16-bit quantised deltas from the previously reconstructed position, so that
+     *  quantisation errors do not accumulate along the trajectory.
+     **********************************************************************************************/
+    std::vector<std::uint8_t> encode(void) const;
+
+    /*******************************************************************************************//**
+     *  Reconstructs a trajectory from the compact representation generated by encode().
+     *  @throws     std::runtime_error if the buffer is malformed.
+     **********************************************************************************************/
+    static Trajectory decode(const std::vector<std::uint8_t>& buf);
+
+private:
+    double m_t0;                            /* Origin of the time grid. */
+    double m_step;                          /* Time between consecutive positions. */
+    double m_t_first;                       /* Time of the first position. */
+    double m_t_last;                        /* Time of the last position. */
+    std::vector<sf::Vector3f> m_positions;  /* Positions, one per time grid point. */
+
+    static const std::size_t enc_header_size;   /* Size of the encoded header (in bytes). */
+    static const float enc_delta_max;           /* Max. absolute quantised delta value. */
+};
+
+#endif /* TRAJECTORY_HPP */
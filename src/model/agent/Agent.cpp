@@ -11,12 +11,15 @@
 
 #include "Agent.hpp"
 #include "AgentBuilder.hpp"
+#include "TaskPool.hpp"
+#include "Profiler.hpp"
 
 CREATE_LOGGER(Agent)
 
 Agent::Agent(std::string id, sf::Vector2f init_pos, sf::Vector2f init_vel)
     : ReportGenerator("agents/" + id + "/", std::string("state.csv"))
     , m_id(id)
+    , m_handle(IdRegistry::getAgentHandle(id))
     , m_self_view(id)
     , m_motion(this, {init_pos.x, init_pos.y, 0.f}, {init_vel.x, init_vel.y, 0.f})
     , m_environment(std::make_shared<EnvModel>(this, (Config::world_width / Config::model_unity_size), (Config::world_height / Config::model_unity_size)))
@@ -26,6 +29,7 @@ Agent::Agent(std::string id, sf::Vector2f init_pos, sf::Vector2f init_vel)
     , m_display_resources(false)
     , m_link_energy_available(false)
     , m_replan_horizon(VirtualTime::now() + ((Config::agent_replanning_window * Random::getUf(0.f, 0.25f)) * Config::time_step))
+    , m_ga_footprint(0)
     , m_add_resource_rate(nullptr)
     , m_remove_resource_rate(nullptr)
 {
@@ -51,6 +55,7 @@ Agent::Agent(std::string id, sf::Vector2f init_pos, sf::Vector2f init_vel)
 Agent::Agent(AgentBuilder* ab)
     : ReportGenerator("agents/" + ab->getAgentId() + "/", std::string("state.csv"))
     , m_id(ab->getAgentId())
+    , m_handle(IdRegistry::getAgentHandle(ab->getAgentId()))
     , m_self_view(ab->getAgentId())
     , m_motion(this, ab->getMeanAnomalyInit(), ab->getOrbitalParams())
     , m_environment(std::make_shared<EnvModel>(this, (Config::world_width / Config::model_unity_size), (Config::world_height / Config::model_unity_size)))
@@ -60,6 +65,7 @@ Agent::Agent(AgentBuilder* ab)
     , m_display_resources(false)
     , m_link_energy_available(false)
     , m_replan_horizon(VirtualTime::now() + ((Config::agent_replanning_window * Random::getUf(0.f, 0.25f)) * Config::time_step))
+    , m_ga_footprint(0)
     , m_add_resource_rate(nullptr)
     , m_remove_resource_rate(nullptr)
 {
@@ -86,6 +92,7 @@ Agent::Agent(AgentBuilder* ab)
 Agent::Agent(std::string id)
     : ReportGenerator("agents/" + id + "/", std::string("state.csv"))
     , m_id(id)
+    , m_handle(IdRegistry::getAgentHandle(id))
     , m_self_view(id)
     , m_motion(this, -1.0)
     , m_environment(std::make_shared<EnvModel>(this, (Config::world_width / Config::model_unity_size), (Config::world_height / Config::model_unity_size)))
@@ -95,6 +102,7 @@ Agent::Agent(std::string id)
     , m_display_resources(false)
     , m_link_energy_available(false)
     , m_replan_horizon(VirtualTime::now() + ((Config::agent_replanning_window * Random::getUf(0.f, 0.25f)) * Config::time_step))
+    , m_ga_footprint(0)
     , m_add_resource_rate(nullptr)
     , m_remove_resource_rate(nullptr)
 {
@@ -137,7 +145,9 @@ void Agent::updateAgentReport(void)
 
 void Agent::initializeResources(void)
 {
-    auto energy = std::make_shared<CumulativeResource>(this, "energy", 10.0, Config::link_reserved_capacity);
+    m_resource_bank = std::make_shared<ResourceBank>(this);
+    auto energy = std::make_shared<CumulativeResource>(m_resource_bank,
+        m_resource_bank->add(ResourceKind::CUMULATIVE, "energy", 10.0, Config::link_reserved_capacity));
     m_resources["energy"] = std::static_pointer_cast<Resource>(energy);
     m_resources["energy"]->addRate(Config::agent_energy_generation_rate, nullptr);  /* Constant generation of energy. */
     // auto storage = std::make_shared<CumulativeResource>(this, "storage", 10.0, 10.0);
@@ -151,11 +161,84 @@ void Agent::updatePosition(void)
     m_link->setPosition(m_motion.getPosition());
 }
 
+void Agent::propagatePosition(unsigned int nsteps)
+{
+    m_motion.propagate(nsteps);
+}
+
+double Agent::getNextEventTime(unsigned int k_max)
+{
+    /*  NOTE: positions of all agents must have been propagated, at least, `k_max + 1` steps ahead
+     *  (see Agent::propagatePosition) so that links can predict encounters.
+     **/
+    double t = VirtualTime::now();
+    if(m_current_activity != nullptr || m_activities->isCapturing() ||
+        m_add_resource_rate != nullptr || m_remove_resource_rate != nullptr
+    ) {
+        return t + Config::time_step;
+    }
+    for(auto& aep : m_activity_exchange_pool) {
+        if(aep.second.size() > 0) {
+            return t + Config::time_step;
+        }
+    }
+    double t_next = std::min(m_replan_horizon, t + (k_max + 1) * Config::time_step);
+    t_next = std::min(t_next, m_activities->getNextEventTime());
+    t_next = std::min(t_next, m_link->getNextEventTime(k_max));
+    return t_next;
+}
+
+void Agent::skipStep(void)
+{
+    /*  Equivalent to Agent::step when the agent is idle (see Agent::getNextEventTime): only moves
+     *  and integrates the resource rates.
+     **/
+    updatePosition();
+    if(m_resource_bank->step(Config::time_step) > 0) {
+        Log::err << "Resource violation. Will continue for debugging purposes.\n";
+    }
+}
 
 void Agent::step(void)
 {
     stepSequential();
     stepParallel();
+    commitStep();
+}
+
+void Agent::stepTwoPhase(const std::vector<std::shared_ptr<Agent> >& agents, bool parallel)
+{
+    /*  Links are updated sequentially, because connections and transfers modify the state of the
+     *  peers of each agent:
+     **/
+    for(auto& a : agents) {
+        a->stepSequential();
+    }
+
+    /*  (1) Compute phase: agents only modify their own state. Operations that affect other agents
+     *      (i.e. disconnections) are kept in each agent's link until the commit phase.
+     **/
+    TaskPool::parallelFor(agents.size(), 1, [&agents](std::size_t i) {
+        agents[i]->stepParallel();
+    }, "agent_step", (parallel ? 0 : 1));
+
+    /*  (2) Commit phase: deferred operations are completed in agent ID order, so that the result
+     *      does not depend on the scheduling of the compute phase.
+     **/
+    std::vector<Agent*> commit_order;
+    commit_order.reserve(agents.size());
+    for(auto& a : agents) {
+        commit_order.push_back(a.get());
+    }
+    std::sort(commit_order.begin(), commit_order.end(), [](const Agent* a, const Agent* b) { return a->getId() < b->getId(); });
+    for(auto& a : commit_order) {
+        a->commitStep();
+    }
+}
+
+void Agent::commitStep(void)
+{
+    m_link->commit();
 }
 
 void Agent::stepSequential(void)
@@ -168,7 +251,9 @@ void Agent::stepSequential(void)
 
 void Agent::stepParallel(void)
 {
-    /* IMPORTANT NOTE: Must have called stepSequential before! */
+    /*  IMPORTANT NOTE: Must have called stepSequential before, and commitStep has to be called
+     *  afterwards. This function only modifies the state of this agent (see Agent::stepTwoPhase).
+     **/
 
     listen();   /* May call AgentLink::scheduleSend but does not actually start transfers. */
     execute();
@@ -195,13 +280,14 @@ void Agent::stepParallel(void)
 
 void Agent::plan(void)
 {
+    PROFILE_ZONE("Agent::plan");
     /* Schedule activities: */
     double tv_now = VirtualTime::now();
     if((m_replan_horizon - tv_now <= 0.0) && m_current_activity == nullptr && !m_activities->isCapturing()) {
         /*  Ensures that old activities are removed from the agent's knowledge base:
          *  The following call also removes activities that have not been shared with other agents.
          **/
-        m_activities->purge(true, m_link->listSending(m_id));   /* NOT all the "old" activities are removed here. */
+        m_activities->purge(true, m_link->listSending(m_handle));   /* NOT all the "old" activities are removed here. */
         m_environment->cleanActivities();                       /* All the "old" activities are removed here. */
         /* Create a temporal activity (won't be added to the Activities Handler): */
         double t_end = tv_now + Config::agent_planning_window * Config::time_step;
@@ -327,6 +413,7 @@ void Agent::plan(void)
         std::vector<std::shared_ptr<Activity> > adis;
         GAScheduler::Solution result;
         auto gas_error_code = scheduler.schedule(adis, result);
+        m_ga_footprint = scheduler.getMemoryFootprint();
 
         if(gas_error_code != GASchedErr::FOUND_SOLUTION) {
             /* Could not find a valid solution, or there was an error: */
@@ -389,23 +476,24 @@ bool Agent::encounter(std::string aid)
 void Agent::connected(std::string aid)
 {
     /* Prepare the list of activities to send. */
-    m_activity_exchange_pool[aid] = m_activities->getActivitiesToExchange(aid);
+    AgentHandle ah = IdRegistry::getAgentHandle(aid);
+    m_activity_exchange_pool[ah] = m_activities->getActivitiesToExchange(ah);
 }
 
 void Agent::listen(void)
 {
     auto rcv = m_link->readRxQueue();
     if(rcv.size() > 0) {
-        for(auto& act : rcv) {
+        for(auto& rcv_act : rcv) {
+            /*  The received object is also referenced by the TX queue of the sender. Copy it, so
+             *  that changes done here are not seen by the sender:
+             **/
+            auto act = std::make_shared<Activity>(*rcv_act);
             if(Config::shared_memory == false) {
-                std::vector<sf::Vector3f> traj_vec;
                 auto traj = act->getTrajectory();
-                for(auto& p : *traj) {
-                    traj_vec.push_back(p.second);
-                }
-                BasicInstrument tmp_imodel(act->getAperture(), -1.f);
+                BasicInstrument tmp_imodel(act->getAperture(), -1.f, 0.f, 0.f);  /* Only for geometry. */
                 tmp_imodel.setDimensions(m_environment->getEnvModelInfo());
-                auto active_cells = findActiveCells(traj->cbegin()->first, traj->crbegin()->first, traj_vec, &tmp_imodel);
+                auto active_cells = findActiveCells(traj->getStartTime(), traj->getEndTime(), traj->getPositions(), &tmp_imodel);
                 act->setActiveCells(active_cells);
             }
             m_activities->add(act);
@@ -415,7 +503,7 @@ void Agent::listen(void)
         if(aep.second.size() > 0) {
             /* Push these to the link interface, for this agent: */
             for(auto& a : aep.second) {
-                if(a->isOwner(m_id)) {
+                if(a->isOwner(m_handle)) {
                     int aid = (int)a->getId();
                     m_link->scheduleSend(std::static_pointer_cast<const Activity>(a), aep.first, [this, aid](int /* tx_id */) {
                         m_activities->markAsSent(aid);
@@ -457,7 +545,7 @@ void Agent::execute(void)
         m_current_activity->setActive();
         if(!Config::link_allow_during_capture) {
             /* Must disable link at this point. */
-            m_link->disable();
+            m_link->requestDisable();
         }
         m_add_resource_rate = m_current_activity.get();
         m_payload.enable();
@@ -476,7 +564,7 @@ void Agent::consume(void)
         m_resources.at("energy")->applyOnce(reserved_capacity);
         Log::warn << "Agent " << m_id << " has consumed all the energy capacity reserved to links. ";
         Log::warn << "Disabling its link until next schedule cycle.\n";
-        m_link->disable();
+        m_link->requestDisable();
         m_link_energy_available = false;
     }
 
@@ -492,12 +580,8 @@ void Agent::consume(void)
     }
 
     /* Update/step resources: */
-    for(auto& r : m_resources) {
-        try {
-            r.second->step();
-        } catch(const std::runtime_error& e) {
-            Log::err << "Resource violation exception catched. Will continue for debugging purposes.\n";
-        }
+    if(m_resource_bank->step(Config::time_step) > 0) {
+        Log::err << "Resource violation. Will continue for debugging purposes.\n";
     }
     /* Add resource rates (if flagged): */
     if(m_add_resource_rate != nullptr) {
@@ -516,6 +600,18 @@ void Agent::showResources(bool d)
     m_display_resources = d;
 }
 
+void Agent::getMemoryUsage(MemoryUsage& mu) const
+{
+    mu.motion += m_motion.getMemoryFootprint();
+    m_environment->getMemoryUsage(mu);
+    m_activities->getMemoryUsage(mu);
+    mu.knowledge_base += MemoryUsage::bytes(m_activity_exchange_pool);
+    for(auto& p : m_activity_exchange_pool) {
+        mu.knowledge_base += MemoryUsage::bytes(p.second);
+    }
+    mu.ga_population += m_ga_footprint;
+}
+
 std::vector<sf::Vector2i> Agent::getWorldFootprint(const std::vector<std::vector<sf::Vector3f> >& lut) const
 {
     if(Config::interpos < 2) {
@@ -544,7 +640,7 @@ std::vector<ActivityCell> Agent::findActiveCells(
     double t0, double t1,
     const std::vector<sf::Vector3f>& ps,
     const Instrument* instrument,
-    std::map<double, sf::Vector3f>* a_pos) const
+    Trajectory* a_pos) const
 {
     return findActiveCells(t0, t1, ps.cbegin(), ps.cend(), instrument, a_pos);
 }
@@ -554,7 +650,7 @@ std::vector<ActivityCell> Agent::findActiveCells(
     const std::vector<sf::Vector3f>::const_iterator& ps0,
     const std::vector<sf::Vector3f>::const_iterator& ps1,
     const Instrument* instrument,
-    std::map<double, sf::Vector3f>* a_pos) const
+    Trajectory* a_pos) const
 {
     struct default_lut_idx {
         int v = -1;
@@ -568,13 +664,15 @@ std::vector<ActivityCell> Agent::findActiveCells(
     double t_prev = t0;
     int curr_it = 0;
     auto p_prev = ps0;
+    if(a_pos != nullptr) {
+        *a_pos = Trajectory(t0, Config::time_step);
+        a_pos->reserve(std::distance(ps0, ps1));
+    }
     for(auto p = ps0; p != ps1; p++) {
-        sf::Vector2f p2d = AgentMotion::getProjection2D(*p, t);
         if(a_pos != nullptr) {
+            a_pos->addPosition(*p);
             if(std::next(p) == ps1) {
-                a_pos->emplace(t1, *p);
-            } else {
-                a_pos->emplace(t, *p);
+                a_pos->setEndTime(t1);
             }
         }
         std::vector<sf::Vector2i> cell_coords;
@@ -588,6 +686,7 @@ std::vector<ActivityCell> Agent::findActiveCells(
             );
         } else {
             /* For 2-d motion models swath actually equals to the aperture. */
+            sf::Vector2f p2d = AgentMotion::getProjection2D(*p, t);
             cell_coords = instrument->getVisibleCells(instrument->getAperture(), p2d, false);
         }
         for(auto& cit : cell_coords) {
@@ -660,7 +759,7 @@ std::shared_ptr<Activity> Agent::createActivity(double t0, double t1)
         throw std::runtime_error("Error creating activity (2)");
     }
 
-    std::map<double, sf::Vector3f> a_pos;
+    Trajectory a_pos;
     std::vector<sf::Vector3f>::const_iterator it0 = ps.cbegin() + n_delay;
     std::vector<sf::Vector3f>::const_iterator it1 = ps.cbegin() + n_delay + n_steps;
     std::vector<ActivityCell> a_cells = findActiveCells(t0, t1, it0, it1, &m_payload, &a_pos);
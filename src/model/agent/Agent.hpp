@@ -25,6 +25,7 @@
 #include "BasicInstrument.hpp"
 #include "Resource.hpp"
 #include "CumulativeResource.hpp"
+#include "ResourceBank.hpp"
 #include "VirtualTime.hpp"
 
 #include "GAScheduler.hpp"
@@ -42,18 +43,26 @@ public:
     void step(void) override;
     void stepParallel(void);
     void stepSequential(void);
+    void commitStep(void);
+    static void stepTwoPhase(const std::vector<std::shared_ptr<Agent> >& agents, bool parallel);
     void plan(void);
     void updatePosition(void);
+    void propagatePosition(unsigned int nsteps);
+    double getNextEventTime(unsigned int k_max);
+    void skipStep(void);
     void showResources(bool d = true);
+    void getMemoryUsage(MemoryUsage& mu) const;
 
     /* Getters and setters: */
     std::string getId(void) const { return m_id; }
+    AgentHandle getHandle(void) const { return m_handle; }
     const AgentView& getView(void) const override { return m_self_view; }
     std::shared_ptr<EnvModel> getEnvironment(void) { return m_environment; }
     const AgentMotion& getMotion(void) const { return m_motion; }
     std::shared_ptr<const ActivityHandler> getActivityHandler(void) const { return m_activities; }
     std::vector<sf::Vector2i> getWorldFootprint(const std::vector<std::vector<sf::Vector3f> >& lut) const;
     bool isCapturing(void) const { return m_payload.isEnabled(); }
+    std::shared_ptr<const Resource> getResource(std::string rname) const { return m_resources.at(rname); }
 
     /* Agent Link: */
     std::shared_ptr<AgentLink> getLink(void) const { return m_link; }
@@ -73,26 +82,29 @@ private:
     bool m_link_energy_available;
     std::shared_ptr<ActivityHandler> m_activities;
     std::shared_ptr<Activity> m_current_activity;
-    std::map<std::string, std::vector<std::shared_ptr<Activity> > > m_activity_exchange_pool;
+    std::map<AgentHandle, std::vector<std::shared_ptr<Activity> > > m_activity_exchange_pool;
 
     /* State and resources: */
     std::shared_ptr<EnvModel> m_environment;
-    std::map<std::string, std::shared_ptr<Resource> > m_resources;
+    std::map<std::string, std::shared_ptr<Resource> > m_resources;     /* Adapters to m_resource_bank. */
+    std::shared_ptr<ResourceBank> m_resource_bank;
     Activity* m_add_resource_rate;
     Activity* m_remove_resource_rate;
 
     /* Other: */
     AgentView m_self_view;
     std::string m_id;
+    AgentHandle m_handle;           /**< Interned m_id (see IdRegistry). */
     bool m_display_resources;
     double m_replan_horizon;
+    std::size_t m_ga_footprint;     /**< Memory footprint of the scheduler in the last planning. */
 
     std::vector<ActivityCell> findActiveCells(double t0, double t1,
         const std::vector<sf::Vector3f>& ps,
-        const Instrument* instrument, std::map<double, sf::Vector3f>* a_pos = nullptr) const;
+        const Instrument* instrument, Trajectory* a_pos = nullptr) const;
     std::vector<ActivityCell> findActiveCells(double t0, double t1,
         const std::vector<sf::Vector3f>::const_iterator& ps0, const std::vector<sf::Vector3f>::const_iterator& ps1,
-        const Instrument* instrument, std::map<double, sf::Vector3f>* a_pos = nullptr) const;
+        const Instrument* instrument, Trajectory* a_pos = nullptr) const;
     std::shared_ptr<Activity> createActivity(double t0, double t1);
     void initializeResources(void);
 
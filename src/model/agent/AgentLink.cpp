@@ -22,11 +22,13 @@ AgentLink::AgentLink(Agent* aptr, float range)
 
 AgentLink::AgentLink(Agent* aptr, float range, float datarate)
     : m_enabled(false)
+    , m_disable_pending(false)
     , m_range(range)
     , m_datarate(datarate)
     , m_energy_consumed(0.f)
     , m_agent(aptr)
     , m_tx_count(0)
+    , m_handle(0)
     , m_encounter_callback([](std::string) -> bool { return true; })
     , m_connected_callback([](std::string) { })
 { }
@@ -34,11 +36,43 @@ AgentLink::AgentLink(Agent* aptr, float range, float datarate)
 
 void AgentLink::setAgents(std::vector<std::shared_ptr<Agent> > agents)
 {
-    for(auto& aptr : agents) {
-        if(*aptr != *m_agent) {
-            m_other_agents[aptr->getId()] = aptr;
+    m_peers.clear();
+    m_peers.resize(agents.size());
+    m_peer_order.clear();
+    m_handles.clear();
+    for(unsigned int h = 0; h < agents.size(); h++) {
+        m_handles[agents[h]->getHandle()] = h;
+        if(*agents[h] != *m_agent) {
+            m_peers[h].agent = agents[h];
+            m_peers[h].id = agents[h]->getId();
+            m_peer_order.push_back(h);
+        } else {
+            m_handle = h;
         }
     }
+    /* Peers are always visited in the same order (by agent ID): */
+    std::sort(m_peer_order.begin(), m_peer_order.end(), [this](unsigned int a, unsigned int b) {
+        return m_peers[a].id < m_peers[b].id;
+    });
+    m_peer_rank.assign(agents.size(), 0);
+    for(unsigned int r = 0; r < m_peer_order.size(); r++) {
+        m_peer_rank[m_peer_order[r]] = r;
+    }
+}
+
+unsigned int AgentLink::getHandle(AgentHandle ah) const
+{
+    auto it = m_handles.find(ah);
+    if(it == m_handles.end()) {
+        Log::err << "Agent " << getAgentId() << " does not know agent " << IdRegistry::getAgentName(ah) << ".\n";
+        throw std::runtime_error("Unknown agent ID in link");
+    }
+    return it->second;
+}
+
+long AgentLink::getStepIndex(double t) const
+{
+    return (long)std::floor((t - Config::start_epoch) / Config::time_step);
 }
 
 void AgentLink::setPosition(sf::Vector2f p)
@@ -58,14 +92,15 @@ bool AgentLink::tryConnect(std::shared_ptr<AgentLink> other)
 {
     if(m_enabled) {
         std::string aid = other->getAgentId();
-        if(m_connected[aid]) {
+        unsigned int h = other->m_handle;
+        if(m_peers[h].connected) {
             /* Already connected to this agent. Do nothing. */
             Log::warn << "Agent " << aid << " is trying to connect to "
                 << getAgentId() << " but they were already connected.\n";
             return true;
         } else {
             if(m_encounter_callback(aid)) {
-                doConnect(other->getAgentId());
+                doConnect(h);
                 return true;
             } else {
                 return false;
@@ -76,156 +111,140 @@ bool AgentLink::tryConnect(std::shared_ptr<AgentLink> other)
 }
 
 void AgentLink::notifyDisconnect(std::string aid_other)
+{
+    notifyDisconnect(getHandle(IdRegistry::getAgentHandle(aid_other)));
+}
+
+void AgentLink::notifyDisconnect(unsigned int h)
 {
     /* We need to complete on-going transfers that might have been left ready in the previous step: */
-    doPartialStep(aid_other);
-    doDisconnect(aid_other);
+    doPartialStep(h);
+    doDisconnect(h);
 }
 
-void AgentLink::doPartialStep(std::string aid)
+void AgentLink::doPartialStep(unsigned int h)
 {
     double t_now = VirtualTime::now();
     bool dummy;
-    for(auto& txt : m_tx_queue[aid]) {
-        bool fl = step1b(t_now, aid, txt, dummy);
-        step2(t_now, aid, txt, fl, dummy);
+    Peer& p = m_peers[h];
+    for(std::size_t i = 0; i < p.tx_queue.size(); i++) {
+        auto& txt = p.tx_queue[i];
+        bool fl = step1b(t_now, h, txt, dummy);
+        step2(t_now, h, txt, fl, dummy);
     }
-    cleanFinishedQueue(m_tx_queue[aid]);
+    cleanFinishedQueue(p);
 }
 
-void AgentLink::doConnect(std::string aid)
+void AgentLink::doConnect(unsigned int h)
 {
-    /* Create an empty vector of Transfer's in TX and RX queues if it doesn't exist. */
-    if(m_tx_queue.find(aid) == m_tx_queue.end()) {
-        m_tx_queue[aid] = std::vector<Transfer>();
-    }
-    if(m_rx_queue.find(aid) == m_rx_queue.end()) {
-        m_rx_queue[aid] = std::vector<Transfer>();
-    }
-    float r = m_other_agents[aid]->getLink()->getRange();
-    m_link_ranges[aid] = std::min(r, m_range);
-    m_reconnect_time[aid] = VirtualTime::now() + (Config::time_step * 10.0);
-    m_connected[aid] = true;
-    m_connected_callback(aid);
-    m_self_view.setLink(aid, AgentLinkView::State::CONNECTED, m_other_agents[aid]->getMotion().getPosition());
+    Peer& p = m_peers[h];
+    p.link_range = std::min(p.agent->getLink()->getRange(), m_range);
+    p.reconnect_time = VirtualTime::now() + (Config::time_step * 10.0);
+    p.connected = true;
+    scheduleVisit(h, getStepIndex(VirtualTime::now()));
+    m_connected_callback(p.id);
+    m_self_view.setLink(p.id, AgentLinkView::State::CONNECTED, p.agent->getMotion().getPosition());
 }
 
-void AgentLink::doDisconnect(std::string aid)
+void AgentLink::doDisconnect(unsigned int h)
 {
-    if(!m_connected[aid]) {
-        Log::dbg << "Agent " << getAgentId() << ", trying to disconnect from " << aid
+    Peer& p = m_peers[h];
+    if(!p.connected) {
+        Log::dbg << "Agent " << getAgentId() << ", trying to disconnect from " << p.id
             << " but was already disconnected.\n";
         return;
     }
 
     /* Cancel scheduled or on-going TX transfers with this agent: */
-    for(auto& tx : m_tx_queue.at(aid)) {
-        if(!tx.finished && tx.started) {
+    for(std::size_t i = 0; i < p.tx_queue.size(); i++) {
+        auto& tx = p.tx_queue[i];
+        if(tx.finished) {
+            continue;   /* Completed, waiting to be removed from the queue. */
+        }
+        if(tx.started) {
             // Log::warn << "Agent " << getAgentId() << " will cancel the on-going transfer " << tx.id << ".\n";
-            m_other_agents[aid]->getLink()->cancelTransfer(getAgentId(), tx);  /* Cancel this transfer. */
-        } else if(!tx.finished && !tx.started) {
+            p.agent->getLink()->cancelTransfer(m_handle, tx);  /* Cancel this transfer. */
+        } else {
             /* We don't have to do anything. */
             // Log::warn << "Agent " << getAgentId() << " had a tranfer scheduled that did not start: " << tx.id << ".\n";
-        } else {
-            Log::err << "Agent " << getAgentId() << ", while disconnecting from " << aid
-                << " found an error in the TX queue (1).\n";
-        }
-        auto txcb = m_callback_failure.find(tx.id);
-        if(txcb != m_callback_failure.end()) {
-            m_callback_failure[tx.id](tx.id);
-            m_callback_failure.erase(txcb);
-        } else {
-            Log::err << "Agent " << getAgentId() << ", while disconnecting from " << aid
-                << " found an error in the TX queue (2).\n";
-        }
-    }
-    std::vector<Transfer> empty_tx_queue;
-    m_tx_queue[aid].swap(empty_tx_queue);
-
-    /* Remove information: */
-    m_link_ranges.erase(m_link_ranges.find(aid));
-    try {
-        if(m_rx_queue.at(aid).size() > 0) {
-            std::vector<Transfer> only_finished;
-            for(auto& rxt : m_rx_queue.at(aid)) {
-                if(rxt.finished) {
-                    only_finished.push_back(rxt);
-                }
-            }
-            m_rx_queue.at(aid).swap(only_finished);
         }
-    } catch(std::out_of_range& e) {
-        Log::err << "Agent " << getAgentId() << ", while disconnecting from " << aid
-            << " found an error in the control structures.\n";
+        tx.on_failure(tx.id);
     }
-    m_connected[aid] = false;
-    m_self_view.setLink(aid, AgentLinkView::State::DISCONNECTED);
+    p.tx_queue.clear();
+    p.tx_pending = 0;
+
+    /* Remove information (only finished receptions are kept): */
+    p.rx_active.clear();
+    p.connected = false;
+    m_self_view.setLink(p.id, AgentLinkView::State::DISCONNECTED);
 
     if(Config::verbosity) {
-        Log::dbg << "Agent " << getAgentId() << " has disconnected from " << aid << ".\n";
+        Log::dbg << "Agent " << getAgentId() << " has disconnected from " << p.id << ".\n";
     }
 }
 
 void AgentLink::update(void)
 {
     /* Disconnect from agents that are no longer in range. */
-    std::vector<std::string> disconnect_list;
-    for(auto& l : m_connected) {
-        if(l.second) {
-            if(!hasLineOfSight(m_other_agents[l.first]) || !isInRange(m_other_agents[l.first])) {
-                disconnect_list.push_back(l.first);
+    std::vector<unsigned int> disconnect_list;
+    for(auto h : m_peer_order) {
+        if(m_peers[h].connected) {
+            if(!hasLineOfSight(m_peers[h].agent) || !isInRange(m_peers[h].agent)) {
+                disconnect_list.push_back(h);
             }
         }
     }
-    for(auto& aid : disconnect_list) {
+    for(auto h : disconnect_list) {
         if(Config::verbosity) {
-            Log::dbg << "Agent " << getAgentId() << " is going to disconnect from " << aid << ".\n";
+            Log::dbg << "Agent " << getAgentId() << " is going to disconnect from " << m_peers[h].id << ".\n";
         }
         /* We need to complete on-going transfers that might have been left ready in the previous step: */
-        doPartialStep(aid);
+        doPartialStep(h);
         /* Notify of disconnection: */
-        m_other_agents[aid]->getLink()->notifyDisconnect(getAgentId());
-        doDisconnect(aid);
+        m_peers[h].agent->getLink()->notifyDisconnect(m_handle);
+        doDisconnect(h);
     }
 
     /*  Find agents that are now in range: */
-    for(auto& a : m_other_agents) {
+    for(auto h : m_peer_order) {
         /* Check mutual visibility/range. */
-        std::string id = a.second->getId();
-        bool has_los = hasLineOfSight(a.second);
-        bool is_in_range = isInRange(a.second);
+        Peer& p = m_peers[h];
+        bool has_los = hasLineOfSight(p.agent);
+        bool is_in_range = isInRange(p.agent);
         /*
         if(has_los && !is_in_range) {
-            Log::err << "Agent " << m_agent->getId() << " is in LOS with " << id
-                << ". ISL range is: " << (a.second->getLink()->distanceFrom(m_position)) / 1e3 << " km.\n";
+            Log::err << "Agent " << m_agent->getId() << " is in LOS with " << p.id
+                << ". ISL range is: " << (p.agent->getLink()->distanceFrom(m_position)) / 1e3 << " km.\n";
         }
         */
         if(has_los && is_in_range) {
-            if(!m_connected[id]) {
-                m_self_view.setLink(id, AgentLinkView::State::LINE_OF_SIGHT, a.second->getMotion().getPosition());
+            if(!p.connected) {
+                m_self_view.setLink(p.id, AgentLinkView::State::LINE_OF_SIGHT, p.agent->getMotion().getPosition());
             }
-            if(!m_connected[id] && m_enabled) {
+            if(!p.connected && m_enabled) {
                 /* This agent wasn't in range before or we disconnected from it. */
-                if(m_encounter_callback(id)) {
-                    if(a.second->getLink()->tryConnect(shared_from_this())) {
-                        doConnect(id);
+                if(m_encounter_callback(p.id)) {
+                    if(p.agent->getLink()->tryConnect(shared_from_this())) {
+                        doConnect(h);
                         if(Config::verbosity) {
-                            Log::dbg << "Agents connected " << getAgentId() << " <--> " << id << ".\n";
+                            Log::dbg << "Agents connected " << getAgentId() << " <--> " << p.id << ".\n";
                         }
                     }
                 }
             }
         } else {
-            m_self_view.setLink(id, AgentLinkView::State::DISCONNECTED);
+            m_self_view.setLink(p.id, AgentLinkView::State::DISCONNECTED);
         }
     }
 }
 
 bool AgentLink::hasLineOfSight(const std::shared_ptr<Agent>& aptr)
 {
-    sf::Vector3f s = m_position;
-    sf::Vector3f d = aptr->getMotion().getPosition();
+    return hasLineOfSight(m_position, aptr->getMotion().getPosition());
+}
 
+bool AgentLink::hasLineOfSight(sf::Vector3f s, sf::Vector3f d)
+{
     float s_len  = MathUtils::norm(s);
     float theta  = std::asin(Config::earth_radius / s_len);
     auto ds_norm = MathUtils::makeUnitary(d - s);
@@ -251,18 +270,65 @@ bool AgentLink::isInRange(const std::shared_ptr<Agent>& aptr)
     return (d < ra && d < rb);
 }
 
+bool AgentLink::isInRange(const std::shared_ptr<Agent>& aptr, sf::Vector3f s, sf::Vector3f d) const
+{
+    float ra = aptr->getLink()->getRange();
+    float rb = m_range;
+    float dist = MathUtils::norm(s - d);    /* Same as AgentLink::distanceFrom. */
+    return (dist < ra && dist < rb);
+}
+
+double AgentLink::getNextEventTime(unsigned int k_max) const
+{
+    double t = VirtualTime::now();
+    double t_next = std::numeric_limits<double>::infinity();
+
+    /* On-going or scheduled transfers are advanced (and consume energy) on every step: */
+    if(m_energy_consumed != 0.f) {
+        return t + Config::time_step;
+    }
+    for(auto h : m_peer_order) {
+        const Peer& p = m_peers[h];
+        if(p.tx_pending > 0 || p.rx_active.size() > 0 || !p.rx_queue.empty()) {
+            return t + Config::time_step;
+        }
+    }
+
+    /* Idle connections are re-announced after their reconnection time (see AgentLink::step): */
+    if(m_enabled) {
+        for(auto h : m_peer_order) {
+            if(m_peers[h].connected) {
+                t_next = std::min(t_next, m_peers[h].reconnect_time);
+            }
+        }
+    }
+
+    /* Connections and disconnections (same conditions as in AgentLink::update): */
+    const auto& ps = m_agent->getMotion().getPropagatedPositions();
+    for(auto h : m_peer_order) {
+        const Peer& p = m_peers[h];
+        const auto& pd = p.agent->getMotion().getPropagatedPositions();
+        std::size_t n = std::min(std::min(ps.size(), pd.size()), (std::size_t)k_max + 2);
+        for(std::size_t j = 0; j < n; j++) {
+            bool visible = hasLineOfSight(ps[j], pd[j]) && isInRange(p.agent, ps[j], pd[j]);
+            if((p.connected && !visible) || (!p.connected && visible && m_enabled)) {
+                /* At j = 0, the connection is being retried on every step: */
+                t_next = std::min(t_next, t + std::max(j, (std::size_t)1) * Config::time_step);
+                break;
+            }
+        }
+    }
+    return t_next;
+}
 
 std::vector<std::shared_ptr<Activity> > AgentLink::readRxQueue(void)
 {
     std::vector<std::shared_ptr<Activity> > rcv_act;
-    for(auto& transfer_list : m_rx_queue) {
-        for(auto it = transfer_list.second.begin(); it != transfer_list.second.end(); ) {
-            if((*it).finished) {
-                rcv_act.push_back(((*it).msg));
-                it = transfer_list.second.erase(it);
-            } else {
-                it++;
-            }
+    for(auto h : m_peer_order) {
+        auto& rxq = m_peers[h].rx_queue;
+        while(!rxq.empty()) {
+            rcv_act.push_back(rxq.front().msg);
+            rxq.pop();
         }
     }
     return rcv_act;
@@ -276,60 +342,61 @@ float AgentLink::readEnergyConsumed(void)
 }
 
 /* To be called only by the sender AgentLink (to the receiver). */
-bool AgentLink::startTransfer(std::string aid, const Transfer& data)
+bool AgentLink::startTransfer(unsigned int h, const Transfer& data)
 {
+    Peer& p = m_peers[h];
     if(!m_enabled) {
-        Log::err << "A transfer start has been requested by agent " << aid << " to "
+        Log::err << "A transfer start has been requested by agent " << p.id << " to "
             << getAgentId() << ", but its link is disabled. Will not accept the transfer.\n";
         return false;
     }
-    if(!m_connected[aid]) {
-        Log::err << "A transfer start has been requested by agent " << aid << " to "
+    if(!p.connected) {
+        Log::err << "A transfer start has been requested by agent " << p.id << " to "
             << getAgentId() << ", but agents are not connected. Will not accept the transfer.\n";
         return false;
     }
     if(data.t_start > VirtualTime::now()) {
-        Log::err << "A transfer start has been requested by agent " << aid << " to "
+        Log::err << "A transfer start has been requested by agent " << p.id << " to "
             << getAgentId() << ", but start time is in future. Will not accept the transfer.\n";
         return false;
     }
     if(data.t_start >= data.t_end) {
-        Log::err << "A transfer start has been requested by agent " << aid << " to "
+        Log::err << "A transfer start has been requested by agent " << p.id << " to "
             << getAgentId() << ", but end time is wrong. Will not accept the transfer.\n";
         return false;
     }
-    m_rx_queue[aid].push_back(data);
+    p.rx_active.push_back(data);
     return true;
 }
 
 /* To be called only by the sender AgentLink (to the receiver). */
-void AgentLink::endTransfer(std::string aid, const Transfer& data)
+void AgentLink::endTransfer(unsigned int h, const Transfer& data)
 {
-    /* This transfer is in RX queue and should not have been completed: */
-    for(auto it = m_rx_queue[aid].begin(); it != m_rx_queue[aid].end(); it++) {
+    /* This transfer is on-going and should not have been completed: */
+    Peer& p = m_peers[h];
+    for(auto it = p.rx_active.begin(); it != p.rx_active.end(); it++) {
         if(*it == data) {
-            if(it->finished) {
-                Log::warn << "Agent " << aid << " finished a transfer that had already been completed\n";
-            }
             it->finished = true;
-            break;
+            p.rx_queue.push(*it);
+            p.rx_active.erase(it);
+            return;
         }
     }
+    Log::warn << "Agent " << p.id << " finished a transfer that was not on-going\n";
 }
 
 /* To be called only by the sender AgentLink (to the receiver). */
-void AgentLink::cancelTransfer(std::string aid, const Transfer& data)
+void AgentLink::cancelTransfer(unsigned int h, const Transfer& data)
 {
-    /* This transfer is in RX queue and should not have been completed: */
-    for(auto it = m_rx_queue[aid].begin(); it != m_rx_queue[aid].end(); it++) {
+    /* This transfer is on-going and should not have been completed: */
+    Peer& p = m_peers[h];
+    for(auto it = p.rx_active.begin(); it != p.rx_active.end(); it++) {
         if(*it == data) {
-            if(it->finished) {
-                Log::warn << "Agent " << aid << " requested a transfer cancel that had already been completed\n";
-            }
-            m_rx_queue[aid].erase(it);
-            break;
+            p.rx_active.erase(it);
+            return;
         }
     }
+    Log::warn << "Agent " << p.id << " requested a transfer cancel that was not on-going\n";
 }
 
 void AgentLink::enable(void)
@@ -346,29 +413,54 @@ void AgentLink::enable(void)
 
 void AgentLink::disable(void)
 {
-    Log::dbg << "Agent " << getAgentId() << " is going to disconnect from all agents (" << m_link_ranges.size() << " active connections).\n";
-    for(auto& a : m_other_agents) {
-        if(m_connected[a.first]) {
-            doPartialStep(a.second->getId());
+    unsigned int n_connected = 0;
+    for(auto h : m_peer_order) {
+        n_connected += (m_peers[h].connected ? 1 : 0);
+    }
+    Log::dbg << "Agent " << getAgentId() << " is going to disconnect from all agents (" << n_connected << " active connections).\n";
+    for(auto h : m_peer_order) {
+        if(m_peers[h].connected) {
+            doPartialStep(h);
             /* Notify of disconnection: */
-            m_other_agents[a.second->getId()]->getLink()->notifyDisconnect(getAgentId());
-            doDisconnect(a.second->getId());
+            m_peers[h].agent->getLink()->notifyDisconnect(m_handle);
+            doDisconnect(h);
         }
     }
     m_enabled = false;
 }
 
+void AgentLink::requestDisable(void)
+{
+    m_enabled = false;
+    m_disable_pending = true;
+}
+
+void AgentLink::commit(void)
+{
+    if(m_disable_pending) {
+        /* The link may have been re-enabled after the request: */
+        bool enabled = m_enabled;
+        m_disable_pending = false;
+        disable();
+        m_enabled = enabled;
+    }
+}
+
 double AgentLink::getTxTime(std::shared_ptr<Activity> msg, float dr) const
 {
     /* NOTE: m_datarate is in bits per second = (1/8) bytes/s. */
 
     double bytes = Config::activity_size;                       /* In bytes, static part. */
-    bytes += msg->getPositionCount() * (sizeof(float) * 3);     /* In bytes, trajectory part. */
+    if(Config::compact_trajectories) {
+        bytes += msg->getEncodedTrajectorySize();               /* In bytes, encoded trajectory part. */
+    } else {
+        bytes += msg->getPositionCount() * (sizeof(float) * 3); /* In bytes, trajectory part. */
+    }
 
     return VirtualTime::toVirtual(bytes / (dr / 8.0), TimeValueType::SECONDS);
 }
 
-void AgentLink::step1a(double t, std::string /* aid */, Transfer& txt, bool& new_tx, double& next_start)
+void AgentLink::step1a(double t, unsigned int /* h */, Transfer& txt, bool& new_tx, double& next_start)
 {
     /*  (1a) Start condition: ======================================================
      *  Prepare start and end times for new transfers.
@@ -392,7 +484,7 @@ void AgentLink::step1a(double t, std::string /* aid */, Transfer& txt, bool& new
     }
 }
 
-bool AgentLink::step1b(double t, std::string aid, Transfer& txt, bool& sending)
+bool AgentLink::step1b(double t, unsigned int h, Transfer& txt, bool& sending)
 {
     /*  (1b) Start condition: ======================================================
      *  Do start those transfers that have to, according to their start time.
@@ -402,12 +494,13 @@ bool AgentLink::step1b(double t, std::string aid, Transfer& txt, bool& sending)
         /* Start the transfer now. */
         txt.started = true;
         txt.t_end   = txt.t_start + getTxTime(txt.msg, m_datarate);
-        if(!m_other_agents[aid]->getLink()->startTransfer(getAgentId(), txt)) {
+        if(!m_peers[h].agent->getLink()->startTransfer(m_handle, txt)) {
             /* Error, could not be started: */
             txt.t_start  = -1.f;
             txt.t_end    = -1.f;
             txt.finished = true;
-            Log::warn << "Agent " << getAgentId() << " failed to start a transfer with " << aid << ".\n";
+            m_peers[h].tx_pending--;
+            Log::warn << "Agent " << getAgentId() << " failed to start a transfer with " << m_peers[h].id << ".\n";
         } else {
             start_flag = true;
             /*
@@ -421,7 +514,7 @@ bool AgentLink::step1b(double t, std::string aid, Transfer& txt, bool& sending)
     return start_flag;
 }
 
-void AgentLink::step2(double t, std::string aid, Transfer& txt, bool start_flag, bool& sending)
+void AgentLink::step2(double t, unsigned int h, TxTransfer& txt, bool start_flag, bool& sending)
 {
     /*  (2) End condition: =========================================================================
      *  Do end those transfers that have to, according to their end time.
@@ -431,11 +524,10 @@ void AgentLink::step2(double t, std::string aid, Transfer& txt, bool start_flag,
         Log::dbg << "Agent " << getAgentId() << " completed transfer " << txt.id << " with " << aid
             << " after " << (txt.t_end - txt.t_start) * 24.0 * 3600.0 << " sec.\n";
         */
-        m_callback_success[txt.id](txt.id);
-        m_other_agents[aid]->getLink()->endTransfer(getAgentId(), txt);
-        m_callback_success.erase(m_callback_success.find(txt.id));
-        m_callback_failure.erase(m_callback_failure.find(txt.id));
+        txt.on_sent(txt.id);
+        m_peers[h].agent->getLink()->endTransfer(m_handle, txt);
         txt.finished = true;
+        m_peers[h].tx_pending--;
 
         if(start_flag) {
             /* This transfer started and ended in the same time step: */
@@ -461,14 +553,37 @@ void AgentLink::step2(double t, std::string aid, Transfer& txt, bool start_flag,
     }
 }
 
-void AgentLink::cleanFinishedQueue(std::vector<Transfer>& queue)
+void AgentLink::cleanFinishedQueue(Peer& p)
 {
-    for(auto txtit = queue.begin(); txtit != queue.end(); ) {
-        if(txtit->finished) {
-            txtit = queue.erase(txtit);
-        } else {
-            txtit++;
+    while(!p.tx_queue.empty() && p.tx_queue.front().finished) {
+        p.tx_queue.pop();
+    }
+}
+
+void AgentLink::setBusy(unsigned int h)
+{
+    if(!m_peers[h].busy) {
+        m_peers[h].busy = true;
+        m_busy.push_back(h);
+    }
+}
+
+void AgentLink::scheduleVisit(unsigned int h, long k)
+{
+    Peer& p = m_peers[h];
+    if(p.tx_pending > 0) {
+        /* All the transfers in the queue have been configured (see AgentLink::step1a): */
+        double t_start = std::numeric_limits<double>::infinity();
+        for(std::size_t i = 0; i < p.tx_queue.size(); i++) {
+            if(!p.tx_queue[i].finished && !p.tx_queue[i].started) {
+                t_start = std::min(t_start, p.tx_queue[i].t_start);
+            }
+        }
+        if(t_start != std::numeric_limits<double>::infinity()) {
+            m_timers.schedule(std::max(k + 1, getStepIndex(t_start)), h);
         }
+    } else if(p.connected) {
+        m_timers.schedule(std::max(k + 1, getStepIndex(p.reconnect_time)), h);
     }
 }
 
@@ -477,41 +592,67 @@ void AgentLink::step(void)
     if(m_enabled) {
         /* Start new transfers: */
         double t = VirtualTime::now();
-        for(auto& txq : m_tx_queue) {
+        long k = getStepIndex(t);
+        std::vector<unsigned int> visit;
+        m_timers.collect(k, visit);
+        visit.insert(visit.end(), m_busy.begin(), m_busy.end());
+        std::sort(visit.begin(), visit.end(), [this](unsigned int a, unsigned int b) {
+            return m_peer_rank[a] < m_peer_rank[b];
+        });
+        visit.erase(std::unique(visit.begin(), visit.end()), visit.end());
+        for(auto h : m_busy) {
+            m_peers[h].busy = false;
+        }
+        m_busy.clear();
+
+        for(auto h : visit) {
+            Peer& p = m_peers[h];
             bool sending = false;
-            if(txq.second.size() > 0) {
+            if(p.tx_pending > 0) {
                 double next_start = t;
                 bool new_tx = false;
-                for(auto& txt : txq.second) {
+                for(std::size_t i = 0; i < p.tx_queue.size(); i++) {
+                    auto& txt = p.tx_queue[i];
                     /* === (1a) Prepare new transfers =========================================== */
-                    step1a(t, txq.first, txt, new_tx, next_start);
+                    step1a(t, h, txt, new_tx, next_start);
                     /* === (1b) Start transfers ================================================= */
-                    bool fl = step1b(t, txq.first, txt, sending);
+                    bool fl = step1b(t, h, txt, sending);
                     /* === (2) End or continue on-going transfers =============================== */
-                    step2(t, txq.first, txt, fl, sending);
+                    step2(t, h, txt, fl, sending);
                 }
 
                 /* === Clean finished transfers ================================================= */
-                cleanFinishedQueue(txq.second);
+                cleanFinishedQueue(p);
             } else {
                 /* The queue to this agent is empty (all have finished): */
-                if(m_reconnect_time[txq.first] < t && m_connected[txq.first]) {
+                if(p.reconnect_time < t && p.connected) {
                     if(Config::verbosity) {
-                        Log::dbg << "Agent " << getAgentId() << " is reconnecting to " << txq.first << "\n";
+                        Log::dbg << "Agent " << getAgentId() << " is reconnecting to " << p.id << "\n";
                     }
-                    m_connected_callback(txq.first);    /* This updates the connection state. */
-                    m_reconnect_time[txq.first] = t + (Config::time_step * 10.0);
+                    m_connected_callback(p.id);    /* This updates the connection state. */
+                    p.reconnect_time = t + (Config::time_step * 10.0);
                 }
             }
+            /* On-going transfers consume energy in every step. Otherwise, wait for the next event: */
             if(sending) {
-                m_self_view.setLink(txq.first, AgentLinkView::State::SENDING, m_other_agents[txq.first]->getMotion().getPosition());
-            } else if(m_connected[txq.first]) {
-                m_self_view.setLink(txq.first, AgentLinkView::State::CONNECTED, m_other_agents[txq.first]->getMotion().getPosition());
+                setBusy(h);
+            } else {
+                scheduleVisit(h, k);
             }
+            p.sending = sending;
         }
-        for(auto& rxq : m_rx_queue) {
-            for(auto& rxt : rxq.second) {
-                if(!rxt.finished && rxt.t_start <= t && rxt.t_end > t && rxt.started) {
+        for(auto h : m_peer_order) {
+            Peer& p = m_peers[h];
+            if(p.sending) {
+                m_self_view.setLink(p.id, AgentLinkView::State::SENDING, p.agent->getMotion().getPosition());
+            } else if(p.connected) {
+                m_self_view.setLink(p.id, AgentLinkView::State::CONNECTED, p.agent->getMotion().getPosition());
+            }
+            p.sending = false;
+
+            /* Receptions: */
+            for(auto& rxt : p.rx_active) {
+                if(rxt.t_start <= t && rxt.t_end > t) {
                     /* It has not finished: */
                     if(rxt.t_start > t - Config::time_step) {
                         m_energy_consumed += Config::link_rx_energy_rate * ((t - rxt.t_start) / Config::time_step);
@@ -520,29 +661,40 @@ void AgentLink::step(void)
                     }
                 } else if(rxt.t_end > t - Config::time_step) {
                     /*  It has just finished.
-                     *  NOTE: the condition (rxt.finished) is not checked in this branch because
-                     *      depending on the agent update/step order, some transfers that have
-                     *      actually finished may still have this flag unset.
+                     *  NOTE: depending on the agent update/step order, some transfers that have
+                     *      actually finished may still be on-going for the receiver.
                      **/
-                    if(rxt.t_end - rxt.t_start <= Config::time_step) {
-                        double t_total = rxt.t_end - rxt.t_start;
-                        m_energy_consumed += Config::link_rx_energy_rate * (t_total / Config::time_step);
-                    } else {
-                        m_energy_consumed += Config::link_rx_energy_rate * ((Config::time_step - (t - rxt.t_end)) / Config::time_step);
-                    }
+                    m_energy_consumed += getRxEnergyAfterEnd(t, rxt);
+                }
+            }
+            for(std::size_t i = 0; i < p.rx_queue.size(); i++) {
+                if(p.rx_queue[i].t_end > t - Config::time_step) {
+                    /* It has just finished: */
+                    m_energy_consumed += getRxEnergyAfterEnd(t, p.rx_queue[i]);
                 }
             }
         }
     }
 }
 
-std::set<int> AgentLink::listSending(std::string agent_id) const
+double AgentLink::getRxEnergyAfterEnd(double t, const Transfer& rxt) const
+{
+    if(rxt.t_end - rxt.t_start <= Config::time_step) {
+        double t_total = rxt.t_end - rxt.t_start;
+        return Config::link_rx_energy_rate * (t_total / Config::time_step);
+    } else {
+        return Config::link_rx_energy_rate * ((Config::time_step - (t - rxt.t_end)) / Config::time_step);
+    }
+}
+
+std::set<int> AgentLink::listSending(AgentHandle ah) const
 {
     std::set<int> retset;    /* We build a set to prevent repeated. */
-    for(auto& txq : m_tx_queue) {
-        for(auto& txt : txq.second) {
-            if(txt.msg->getAgentId() == agent_id) {
-                retset.insert(txt.msg->getId());
+    for(auto h : m_peer_order) {
+        auto& txq = m_peers[h].tx_queue;
+        for(std::size_t i = 0; i < txq.size(); i++) {
+            if(!txq[i].finished && txq[i].msg->isOwner(ah)) {
+                retset.insert(txq[i].msg->getId());
             }
         }
     }
@@ -555,21 +707,26 @@ float AgentLink::distanceFrom(sf::Vector3f p) const
     return MathUtils::norm(v);
 }
 
-int AgentLink::scheduleSend(std::shared_ptr<const Activity> a, std::string aid, std::function<void(int)> on_sent, std::function<void(int)> on_failure)
+int AgentLink::scheduleSend(std::shared_ptr<const Activity> a, AgentHandle ah, std::function<void(int)> on_sent, std::function<void(int)> on_failure)
 {
-    Transfer new_transfer;
+    unsigned int h = getHandle(ah);
+    Peer& p = m_peers[h];
+    TxTransfer new_transfer;
     new_transfer.t_start  = -1.0;
     new_transfer.t_end    = -1.0;
     new_transfer.finished = false;
     new_transfer.started  = false;
     new_transfer.id       = m_tx_count;
     new_transfer.msg      = std::make_shared<Activity>(*a); /* Copies the activity (but does not duplicate its internal data). */
+    new_transfer.on_sent    = on_sent;
+    new_transfer.on_failure = on_failure;
 
     /* Look for this activity in the list of finished transfers with this agent: */
     bool enqueue = false;
     bool sent_previously = false;
-    for(auto txt : m_tx_queue[aid]) {
-        if(txt.finished && txt.msg->getAgentId() == a->getAgentId() && txt.msg->getId() == a->getId()) {
+    for(std::size_t i = 0; i < p.tx_queue.size(); i++) {
+        auto& txt = p.tx_queue[i];
+        if(txt.finished && txt.msg->getHandle() == a->getHandle()) {
             /* This activity was already shared with this agent: */
             sent_previously = true;
             if(a->getLastUpdateTime() > txt.msg->getLastUpdateTime()) {
@@ -577,9 +734,9 @@ int AgentLink::scheduleSend(std::shared_ptr<const Activity> a, std::string aid,
                 enqueue = true;
             }
             break;
-        } else if(!txt.finished && txt.msg->getAgentId() == a->getAgentId() && txt.msg->getId() == a->getId()) {
+        } else if(!txt.finished && txt.msg->getHandle() == a->getHandle()) {
             /* This activity is being shared now. This should not happen. */
-            Log::warn << "Agent " << m_agent->getId() << " is trying to enqueue a message for " << aid << " that is already in its queue:  ["
+            Log::warn << "Agent " << m_agent->getId() << " is trying to enqueue a message for " << p.id << " that is already in its queue:  ["
                 << txt.msg->getAgentId() << ":" << txt.msg->getId() << "].\n";
             sent_previously = true;
         }
@@ -589,11 +746,11 @@ int AgentLink::scheduleSend(std::shared_ptr<const Activity> a, std::string aid,
     }
 
     if(enqueue) {
-        m_tx_queue[aid].push_back(new_transfer);
-        m_callback_success[m_tx_count] = on_sent;
-        m_callback_failure[m_tx_count] = on_failure;
+        p.tx_queue.push(new_transfer);
+        p.tx_pending++;
+        setBusy(h);     /* Configured in the next step (see AgentLink::step1a). */
         m_tx_count++;
-        // Log::dbg << "Agent " << getAgentId() << " equeued [" << a->getAgentId() << ":" << a->getId() << "] for " << aid << "\n";
+        // Log::dbg << "Agent " << getAgentId() << " equeued [" << a->getAgentId() << ":" << a->getId() << "] for " << p.id << "\n";
     }
     return 0;
 }
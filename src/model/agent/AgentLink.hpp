@@ -12,10 +12,13 @@
 #define AGENT_LINK_HPP
 
 #include "prot.hpp"
+#include <unordered_map>
 #include "MathUtils.hpp"
 #include "Activity.hpp"
 #include "VirtualTime.hpp"
 #include "AgentLinkView.hpp"
+#include "RingBuffer.hpp"
+#include "TimerWheel.hpp"
 
 class Agent;
 
@@ -59,7 +62,8 @@ public:
     float getDatarate(void) const { return m_datarate; }
 
     /*******************************************************************************************//**
-     *  Defines references to all the other existing agents.
+     *  Defines references to all the other existing agents. The position of each agent in the
+     *  vector is used as its handle in the link, so all the links have to be given the same vector.
      **********************************************************************************************/
     void setAgents(std::vector<std::shared_ptr<Agent> > agents);
 
@@ -115,9 +119,23 @@ public:
      *  an internal counter that can be read and cleared with AgentLink::readEnergyConsumed.
      *  For each Agent, only one transfer (Tx) and one reception (Rx) can occur simultaneously. That
      *  is: agents can send to multiple peers at the same time but each peer queue is a FIFO.
+     *  Only the peers with on-going or new transfers are visited on every step. Peers with
+     *  transfers scheduled in the future, or with idle connections, are visited when their timer
+     *  expires.
      **********************************************************************************************/
     void step(void) override;
 
+    /*******************************************************************************************//**
+     *  Computes the next time at which this link will change its state on its own. That is: when
+     *  it will connect to or disconnect from other agents (predicted with the positions already
+     *  propagated by each AgentMotion, up to `k_max + 1` steps ahead) or when an idle connection
+     *  will be re-announced (see AgentLink::step). If there are transfers in any of the queues the
+     *  link is busy and this function returns the time of the next step.
+     *  @param  k_max   Maximum number of steps that can be skipped.
+     *  @return         The time of the next event, or infinity if none is found.
+     **********************************************************************************************/
+    double getNextEventTime(unsigned int k_max) const;
+
     /*******************************************************************************************//**
      *  Requests a connection to the agent other. This function triggers a call to the encounter
      *  callback for the agent other.
@@ -146,14 +164,14 @@ public:
     /*******************************************************************************************//**
      *  Adds a new activity to the transfer queue of an agent peer.
      *  @param  a           The activity to send to the other agent.
-     *  @param  aid         The agent to send the activity to.
+     *  @param  ah          The agent to send the activity to (see IdRegistry).
      *  @param  on_sent     A callback that will be invoked once the transfer is successfully
      *                      completed. The int argument identifies the transfer.
      *  @param  on_failure  A callback that will be invoked if the transfer is cancelled. The int
      *                      argument identifies the transfer.
      *  @return An ID of this transfer.
      **********************************************************************************************/
-    int scheduleSend(std::shared_ptr<const Activity> a, std::string aid,
+    int scheduleSend(std::shared_ptr<const Activity> a, AgentHandle ah,
         std::function<void(int)> on_sent = [](int) { },
         std::function<void(int)> on_failure = [](int) { });
 
@@ -168,6 +186,18 @@ public:
      **********************************************************************************************/
     void disable(void);
 
+    /*******************************************************************************************//**
+     *  Disables this link but defers the disconnection from other agents until AgentLink::commit
+     *  is called. Disconnecting modifies the queues of the peers, so this is used instead of
+     *  AgentLink::disable while agents are stepped in parallel (see Agent::stepTwoPhase).
+     **********************************************************************************************/
+    void requestDisable(void);
+
+    /*******************************************************************************************//**
+     *  Completes the operations deferred by AgentLink::requestDisable, if any.
+     **********************************************************************************************/
+    void commit(void);
+
     /*******************************************************************************************//**
      *  Whether the link is in enabled state or not.
      **********************************************************************************************/
@@ -176,12 +206,12 @@ public:
     /*******************************************************************************************//**
      *  Returns a reference to the visual representation of this link.
      **********************************************************************************************/
-    const sf::Drawable& getView(void) const { return m_self_view; }
+    const AgentLinkView& getView(void) const { return m_self_view; }
 
     /*******************************************************************************************//**
-     *  Report which activities (their ID's) are being sent that belong to `agent_id`.
+     *  Report which activities (their ID's) are being sent that belong to agent `ah`.
      **********************************************************************************************/
-    std::set<int> listSending(std::string agent_id) const;
+    std::set<int> listSending(AgentHandle ah) const;
 
 private:
     struct Transfer {
@@ -197,59 +227,113 @@ private:
         }
     };
 
+    struct TxTransfer : public Transfer {
+        std::function<void(int)> on_sent;       /**< Invoked when the transfer is completed. */
+        std::function<void(int)> on_failure;    /**< Invoked when the transfer is cancelled. */
+    };
+
+    /*******************************************************************************************//**
+     *  State of the link with another agent. TX queues are only used by the owner of the link. RX
+     *  queues are written by the sender (the peer) and read by the owner.
+     **********************************************************************************************/
+    struct Peer {
+        std::shared_ptr<Agent> agent;       /**< The other agent (null for the owner's handle). */
+        std::string id;                     /**< Agent ID of the other agent. */
+        bool connected = false;             /**< Whether the agents are connected or not. */
+        bool sending = false;               /**< Whether a transfer has been advanced in this step. */
+        bool busy = false;                  /**< Whether the peer is in AgentLink::m_busy. */
+        float link_range = 0.f;             /**< Minimum range of both agents. */
+        double reconnect_time = 0.0;        /**< Time of reconnection when the transfer queue is empty. */
+        unsigned int tx_pending = 0;        /**< Number of transfers in the TX queue not finished. */
+        RingBuffer<TxTransfer> tx_queue;    /**< Transfer queue to this agent. */
+        std::vector<Transfer> rx_active;    /**< On-going receptions from this agent. */
+        RingBuffer<Transfer> rx_queue;      /**< Completed receptions from this agent. */
+    };
+
     sf::Vector3f m_position;            /**< The current position of this agent (used to compute ranges). */
     bool m_enabled;                     /**< Whether the link is enabled or not. */
+    bool m_disable_pending;             /**< Whether disconnections have been deferred until AgentLink::commit. */
     float m_range;                      /**< Maximum range for this communication link. */
     float m_datarate;                   /**< Maximum datarate for this communication link. */
     float m_energy_consumed;            /**< The accumulated energy consumption. */
     int m_tx_count;                     /**< Internal counter of transfers (used to generated transfer ID's). */
     Agent* m_agent;                     /**< Pointer to the owning agent object. */
+    unsigned int m_handle;              /**< Handle of the owning agent (see AgentLink::setAgents). */
     std::function<bool(std::string)> m_encounter_callback;          /**< Invoked when one agent is in range with another. */
     std::function<void(std::string)> m_connected_callback;          /**< Invoked when one agent is connected to another. */
-    std::map<std::string, std::shared_ptr<Agent> > m_other_agents;  /**< Stays constant throughout execution. */
-    std::map<std::string, bool> m_connected;                        /**< Connection look up table. */
-    std::map<std::string, float> m_link_ranges;                     /**< Constantly updated and changed. */
-    std::map<std::string, std::vector<Transfer> > m_tx_queue;       /**< Transfer queue to each connected agent. */
-    std::map<std::string, std::vector<Transfer> > m_rx_queue;       /**< Reception queue for each conencted agent. */
-    std::map<std::string, double> m_reconnect_time;                 /**< Values of reconnection for agents whose transfer queue is empty. */
-    std::map<int, std::function<void(int)> > m_callback_success;    /**< Callbacks for each transfer (on success). */
-    std::map<int, std::function<void(int)> > m_callback_failure;    /**< Callbacks for each transfer (on cancellation). */
+    std::vector<Peer> m_peers;                                      /**< Peer states, indexed by handle. */
+    std::vector<unsigned int> m_peer_order;                         /**< Handles of the other agents, sorted by agent ID. */
+    std::vector<unsigned int> m_peer_rank;                          /**< Position of each handle in m_peer_order. */
+    std::unordered_map<AgentHandle, unsigned int> m_handles;        /**< Handle of each interned agent ID. */
+    std::vector<unsigned int> m_busy;                               /**< Peers with on-going or new transfers. */
+    TimerWheel m_timers;                                            /**< Scheduled transfer starts and reconnections. */
     AgentLinkView m_self_view;
 
     /*******************************************************************************************//**
-     *  Establishes a connection with the agent aid.
+     *  Gets the handle of agent `ah` (interned ID, see IdRegistry). Throws if the agent is unknown.
+     **********************************************************************************************/
+    unsigned int getHandle(AgentHandle ah) const;
+
+    /*******************************************************************************************//**
+     *  Gets the index of the step at time `t` (used by the timers).
+     **********************************************************************************************/
+    long getStepIndex(double t) const;
+
+    /*******************************************************************************************//**
+     *  Notify of the irrevocable disconnection from agent with handle h.
      **********************************************************************************************/
-    void doConnect(std::string aid);
+    void notifyDisconnect(unsigned int h);
+
+    /*******************************************************************************************//**
+     *  Establishes a connection with the agent with handle h.
+     **********************************************************************************************/
+    void doConnect(unsigned int h);
 
     /*******************************************************************************************//**
      *  Disconnects from an agent to which it was previously connected.
      **********************************************************************************************/
-    void doDisconnect(std::string aid);
+    void doDisconnect(unsigned int h);
 
     /*******************************************************************************************//**
-     *  Starts a new transfer. Registers the transfer in the RX queue.
+     *  Starts a new transfer. Registers the transfer in the on-going RX transfers of the sender.
+     *  @param  h       Handle of the sender.
      *  @return True if the transfer is successfully started, false otherwise.
      *  @note   To be called only by the sender AgentLink (to the receiver).
      **********************************************************************************************/
-    bool startTransfer(std::string aid, const Transfer& data);
+    bool startTransfer(unsigned int h, const Transfer& data);
 
     /*******************************************************************************************//**
-     *  Cancels an on-going transfer. Removes the active transfer from the internal RX queue.
+     *  Cancels an on-going transfer. Removes the active transfer from the on-going RX transfers.
+     *  @param  h       Handle of the sender.
      *  @note   To be called only by the sender AgentLink (to the receiver).
      **********************************************************************************************/
-    void cancelTransfer(std::string aid, const Transfer& data);
+    void cancelTransfer(unsigned int h, const Transfer& data);
 
     /*******************************************************************************************//**
-     *  Cancels an on-going transfer. Keeps transfer in the internal RX queue and sets its finished
-     *  flag.
+     *  Ends an on-going transfer. Moves the transfer from the on-going RX transfers to the RX queue
+     *  and sets its finished flag.
+     *  @param  h       Handle of the sender.
      *  @note   To be called only by the sender AgentLink (to the receiver).
      **********************************************************************************************/
-    void endTransfer(std::string aid, const Transfer& data);
+    void endTransfer(unsigned int h, const Transfer& data);
+
+    /*******************************************************************************************//**
+     *  Cleans the TX queue of a peer by removing the completed transfers at its front. Transfers
+     *  that finish before those in front of them are removed once they reach the front (until
+     *  then, they are ignored).
+     **********************************************************************************************/
+    void cleanFinishedQueue(Peer& p);
 
     /*******************************************************************************************//**
-     *  Cleans a queue by removing all the completed transfers.
+     *  Adds a peer to the list of peers that are visited in every step.
      **********************************************************************************************/
-    void cleanFinishedQueue(std::vector<Transfer>& queue);
+    void setBusy(unsigned int h);
+
+    /*******************************************************************************************//**
+     *  Schedules the next visit to a peer that is not busy, after step k: at the start of its next
+     *  transfer or, if its queue is empty, at its reconnection time.
+     **********************************************************************************************/
+    void scheduleVisit(unsigned int h, long k);
 
     /*******************************************************************************************//**
      *  Compute the distance to an agent located at p.
@@ -270,6 +354,23 @@ private:
      **********************************************************************************************/
     bool isInRange(const std::shared_ptr<Agent>& aptr);
 
+    /*******************************************************************************************//**
+     *  Determines whether two positions are in line of sight (i.e. the segment between them does
+     *  not cross the Earth).
+     *  @param  s   Position of this agent.
+     *  @param  d   Position of the other agent.
+     **********************************************************************************************/
+    static bool hasLineOfSight(sf::Vector3f s, sf::Vector3f d);
+
+    /*******************************************************************************************//**
+     *  Determines whether agent aptr would be within mutual link ranges if both agents were at the
+     *  given positions.
+     *  @param  aptr    Pointer to the other agent.
+     *  @param  s       Position of this agent.
+     *  @param  d       Position of the other agent.
+     **********************************************************************************************/
+    bool isInRange(const std::shared_ptr<Agent>& aptr, sf::Vector3f s, sf::Vector3f d) const;
+
     /*******************************************************************************************//**
      *  Estimates the duration of a transfer (best-case scenario). The time is computed as B/D,
      *  where B is the size of the activity in bytes, and D is the datarate in bytes per second.
@@ -282,44 +383,49 @@ private:
      **********************************************************************************************/
     double getTxTime(std::shared_ptr<Activity> msg, float dr) const;
 
+    /*******************************************************************************************//**
+     *  Energy consumed in the current step by a reception that has ended (i.e. only until its end).
+     **********************************************************************************************/
+    double getRxEnergyAfterEnd(double t, const Transfer& rxt) const;
+
     /*******************************************************************************************//**
      *  Performs a partial step: detects newly scheduled transfers and prepares them.
      *  @param  t           The current virtual time.
-     *  @param  aid         Agent to which txt is being sent to.
+     *  @param  h           Handle of the agent to which txt is being sent to.
      *  @param  txt         The transfer object to step.
      *  @param  new_tx      A flag that will be set to true if new transfers have been detected.
      *                      Else its value will not be changed.
      *  @param  next_start  Accumulator of time used to concatenate transfers.
      **********************************************************************************************/
-    void step1a(double t, std::string aid, Transfer& txt, bool& new_tx, double& next_start);
+    void step1a(double t, unsigned int h, Transfer& txt, bool& new_tx, double& next_start);
 
     /*******************************************************************************************//**
      *  Performs a partial step: starts transfers that have to be started (or had to be started int
      *  the past).
      *  @param  t           The current virtual time.
-     *  @param  aid         Agent to which txt is being sent to.
+     *  @param  h           Handle of the agent to which txt is being sent to.
      *  @param  txt         The transfer object to step.
      *  @param  sending     A flag that will be set to true if agent is currently transferring data.
      *  @return             True if the transfer has been started. False otherwise.
      **********************************************************************************************/
-    bool step1b(double t, std::string aid, Transfer& txt, bool& sending);
+    bool step1b(double t, unsigned int h, Transfer& txt, bool& sending);
 
     /*******************************************************************************************//**
      *  Performs a partial step: (1) ends transfers that have to end; and (2) identifies transfers
      *  that still need to continue.
      *  @param  t           The current virtual time.
-     *  @param  aid         Agent to which txt is being sent to.
+     *  @param  h           Handle of the agent to which txt is being sent to.
      *  @param  txt         The transfer object to step.
      *  @param  start_flag  The value returned by step1 (i.e. true if some transfer was started,
      *                      false otherwise).
      *  @param  sending     A flag that will be set to true if agent is currently transferring data.
      **********************************************************************************************/
-    void step2(double t, std::string aid, Transfer& txt, bool start_flag, bool& sending);
+    void step2(double t, unsigned int h, TxTransfer& txt, bool start_flag, bool& sending);
 
     /*******************************************************************************************//**
      *  Executes step 1b and 2, and calls cleanFinishedQueue.
      **********************************************************************************************/
-    void doPartialStep(std::string aid);
+    void doPartialStep(unsigned int h);
 };
 
 #include "Agent.hpp"
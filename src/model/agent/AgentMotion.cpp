@@ -373,6 +373,26 @@ sf::Vector2f AgentMotion::getProjection2D(sf::Vector3f p, double t)
     );
 }
 
+std::vector<sf::Vector2f> AgentMotion::getProjection2D(const Trajectory& traj)
+{
+    std::size_t n = traj.size();
+    std::vector<double> ts(n);
+    for(std::size_t i = 0; i < n; i++) {
+        ts[i] = traj.getTime(i);
+    }
+    Vec3Array<double> ecef;
+    std::vector<double> lat, lng, h;
+    CoordinateSystemUtils::fromECIToECEF(traj.getPositions().data(), ts.data(), n, ecef);
+    CoordinateSystemUtils::fromECEFToGeographic(ecef, lat, lng, h);
+
+    std::vector<sf::Vector2f> retvec(n);
+    for(std::size_t i = 0; i < n; i++) {
+        retvec[i].x = (float)(World::getWidth() * ( lng[i]) / 360.f) + (World::getWidth() / 2.f);
+        retvec[i].y = (float)(World::getHeight() * (-lat[i]) / 180.f) + (World::getHeight() / 2.f);
+    }
+    return retvec;
+}
+
 sf::Vector2f AgentMotion::getDirection2D(void)
 {
     sf::Vector2f retvec;
@@ -19,6 +19,7 @@
 #include "CoordinateSystemUtils.hpp"
 #include "VirtualTime.hpp"
 #include "MathUtils.hpp"
+#include "Trajectory.hpp"
 
 #include <math.h>
 
@@ -91,6 +92,12 @@ public:
      **********************************************************************************************/
     sf::Vector3f getPosition(void) const { return m_position.front(); }
 
+    /*******************************************************************************************//**
+     *  Getter of the current and the already propagated positions (i.e. the position at each of the
+     *  following steps, see AgentMotion::propagate). The first element is the current position.
+     **********************************************************************************************/
+    const std::vector<sf::Vector3f>& getPropagatedPositions(void) const { return m_position; }
+
     /*******************************************************************************************//**
      *  Gets the current position and the previous (i.e. for the previous time step) so that it can
      *  be interpolated for display and metrics purposes. Previous position is updated on every
@@ -115,6 +122,13 @@ public:
      **********************************************************************************************/
     static sf::Vector2f getProjection2D(sf::Vector3f p, double t);
 
+    /*******************************************************************************************//**
+     *  Returns the equirectangular projection of every position of a trajectory (ECI coordinates).
+     *  The whole trajectory is transformed at once with the batch functions of
+     *  CoordinateSystemUtils.
+     **********************************************************************************************/
+    static std::vector<sf::Vector2f> getProjection2D(const Trajectory& traj);
+
     /*******************************************************************************************//**
      *  Returns the normalized projection of velocity so as to determine the current direction.
      **********************************************************************************************/
@@ -141,6 +155,15 @@ public:
      **********************************************************************************************/
     double getMinAltitude(void) const;
 
+    /*******************************************************************************************//**
+     *  Estimated memory footprint of the propagation buffers (bytes).
+     **********************************************************************************************/
+    std::size_t getMemoryFootprint(void) const
+    {
+        return (m_position.capacity() + m_velocity.capacity()) * sizeof(sf::Vector3f)
+            + m_orbital_state.capacity() * sizeof(OrbitalState);
+    }
+
     /*******************************************************************************************//**
      *  Shows debug info for the agent motion model.
      **********************************************************************************************/
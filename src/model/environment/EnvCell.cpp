@@ -18,18 +18,24 @@ EnvCell::EnvCell(Agent* agnt, unsigned int cx, unsigned int cy)
     : x(cx)
     , y(cy)
     , m_agent(agnt)
+    , m_dirty(true)
+    , m_eval_owner(0)
+    , m_eval_t_next(0.0)
 { }
 
 EnvCell::EnvCell(Agent* agnt, unsigned int cx, unsigned int cy, EnvCellPayoffFunc fp, EnvCellCleanFunc fc)
     : x(cx)
     , y(cy)
     , m_agent(agnt)
+    , m_dirty(true)
+    , m_eval_owner(0)
+    , m_eval_t_next(0.0)
 {
     m_payoff_func.push_back(fp);
     m_clean_func.push_back(fc);
 }
 
-void EnvCell::addCellActivity(std::shared_ptr<Activity> aptr)
+bool EnvCell::addCellActivity(std::shared_ptr<Activity> aptr)
 {
     /* The Activity must have this cell as an active cell: */
     double* t0s;
@@ -38,7 +44,16 @@ void EnvCell::addCellActivity(std::shared_ptr<Activity> aptr)
     if(nts <= 0) {
         Log::err << "(" << x << "-" << y << ") Error adding activity " << *aptr << " in a cell, for \'"
             << aptr->getAgentId() << ":" << aptr->getId() << "\'.\n";
+        return false;
     } else {
+        bool added = true;
+        auto it = m_activities.find(aptr);
+        if(it != m_activities.end()) {
+            /* Was already here, times are replaced: */
+            delete[] it->second.t0s;
+            delete[] it->second.t1s;
+            added = false;
+        }
         m_activities[aptr].t0s = new double[nts];
         m_activities[aptr].t1s = new double[nts];
         m_activities[aptr].nts = nts;
@@ -46,6 +61,8 @@ void EnvCell::addCellActivity(std::shared_ptr<Activity> aptr)
             m_activities[aptr].t0s[i] = t0s[i];
             m_activities[aptr].t1s[i] = t1s[i];
         }
+        m_dirty = true;
+        return added;
     }
 }
 
@@ -59,6 +76,7 @@ bool EnvCell::removeCellActivity(std::shared_ptr<Activity> aptr)
             delete[] it->second.t1s;
         }
         m_activities.erase(it);
+        m_dirty = true;
         return true;
     } else {
         /*  This activity might have been automatically cleaned from this cell with EnvCell::clean.
@@ -68,15 +86,16 @@ bool EnvCell::removeCellActivity(std::shared_ptr<Activity> aptr)
     }
 }
 
-bool EnvCell::removeCellActivityById(std::string agent_id, unsigned int activity_id)
+bool EnvCell::removeCellActivityById(ActivityHandle h)
 {
     for(auto it = m_activities.begin(); it != m_activities.end(); ) {
-        if(it->first->getAgentId() == agent_id && it->first->getId() == (int)activity_id) {
+        if(it->first->getHandle() == h) {
             if(it->second.nts > 0) {
                 delete[] it->second.t0s;
                 delete[] it->second.t1s;
             }
             it = m_activities.erase(it);
+            m_dirty = true;
             return true;
         } else {
             it++;
@@ -88,8 +107,9 @@ bool EnvCell::removeCellActivityById(std::string agent_id, unsigned int activity
 bool EnvCell::updateCellActivity(std::shared_ptr<Activity> aptr)
 {
     for(auto& a : m_activities) {
-        if(a.first->getAgentId() == aptr->getAgentId() && a.first->getId() == aptr->getId()) {
+        if(a.first->getHandle() == aptr->getHandle()) {
             a.first->clone(aptr);
+            m_dirty = true;
             return true;
         }
     }
@@ -99,89 +119,221 @@ bool EnvCell::updateCellActivity(std::shared_ptr<Activity> aptr)
 
 float EnvCell::computeCellPayoff(double* at0s, double* at1s, int nts)
 {
-    m_payoff.clear();
-    for(int i = 0; i < nts; i++) {
-        /*  Payoff function for one cell:
-         *  Arg. #0:                   pair<double, double>  --> t0 & t1 of the potential new activity.
-         *  Arg. #1: vector<vector<pair<double, double> > >  --> vector of t0 & t1 of the activities for this cell.
-         *  Arg. #2:          vector<shared_ptr<Activity> >  --> Pointer to the activities (same index than arg2).
+    return updatePayoff(at0s, at1s, nts, m_agent->getHandle(), VirtualTime::now());
+}
+
+float EnvCell::updatePayoff(const double* at0s, const double* at1s, int nts, AgentHandle owner, double t_now)
+{
+    std::vector<EnvCellPayoff> po;
+    bool reuse = Config::payoff_incremental && !m_dirty && owner == m_eval_owner && t_now < m_eval_t_next
+        && !m_payoff_t1.empty();
+    if(reuse) {
+        /*  The activities of this cell have not changed since the last evaluation, and neither has
+         *  the set of owned activities that are skipped. Payoff of an interval only depends on
+         *  those, so intervals that were already evaluated keep their value. Between two plans the
+         *  window slides forward, hence most intervals are found (in the same order) and only the
+         *  trailing ones have to be evaluated. Times are matched with some tolerance, because they
+         *  are generated from different origins.
          **/
-        auto arg1 = std::make_pair(at0s[i], at1s[i]);
-        std::vector<std::vector<std::pair<double, double> > > arg2;
-        std::vector<std::shared_ptr<Activity> > arg3;
-        for(auto& ra : m_activities) {
-            if(ra.first->isOwner(m_agent->getId()) && ra.first->getStartTime() > VirtualTime::now()) {
-                /*  This activity is owned by the agent that is computing payoff and is in the future.
-                 *  We will not consider it because we might be re-scheduling.
-                 **/
-                continue;
+        double tol = Config::time_step * 1e-3;
+        std::vector<double> mt0s, mt1s;     /* Intervals that have to be evaluated. */
+        std::vector<int> midx;              /* Index of those intervals in `po`. */
+        po.resize(nts);
+        std::size_t j = 0;
+        for(int i = 0; i < nts; i++) {
+            while(j < m_payoff.size() && m_payoff[j].t < at0s[i] - tol) {
+                j++;
             }
-            std::vector<std::pair<double, double> > vec_ts;
-            for(int j = 0; j < ra.second.nts; j++) {
-                vec_ts.push_back({ra.second.t0s[j], ra.second.t1s[j]});
+            if(j < m_payoff.size() && std::abs(m_payoff[j].t - at0s[i]) <= tol && std::abs(m_payoff_t1[j] - at1s[i]) <= tol) {
+                po[i] = {at0s[i], m_payoff[j].payoff, m_payoff[j].utility};
+            } else {
+                mt0s.push_back(at0s[i]);
+                mt1s.push_back(at1s[i]);
+                midx.push_back(i);
             }
-            arg2.push_back(vec_ts);
-            arg3.push_back(ra.first);
         }
-        /*  IMPORTANT NOTE:
-         *  The following conditions are necessary:
-         *  - Forwards revisit time payoff needs arg2/arg3 to be sorted with start time asc.
-         *  - Backwards revisit time payoff needs arg2/arg3 to be sorted with end time asc.
-         *  The conditions are always met, as long as EnvCellState objects are sorted. Given
-         *  that these intervals are provided in an activity basis (i.e. several activities are
-         *  not mixed, because we create independent vectors), then it is just a matter of
-         *  ensuring that EnvCellState times are sorted.
+        if(midx.size() > 0) {
+            std::vector<EnvCellPayoff> mpo;
+            evaluatePayoff(mt0s.data(), mt1s.data(), midx.size(), owner, t_now, mpo);
+            for(std::size_t k = 0; k < midx.size(); k++) {
+                po[midx[k]] = mpo[k];
+            }
+        }
+    } else {
+        evaluatePayoff(at0s, at1s, nts, owner, t_now, po);
+        /*  Owned activities in the future are skipped by evaluatePayoff. The result is no longer
+         *  valid once the first of them starts:
          **/
-        float po = 0.f;
+        m_eval_owner = owner;
+        m_eval_t_next = std::numeric_limits<double>::infinity();
+        for(auto& ra : m_activities) {
+            if(ra.first->isOwner(owner) && ra.first->getStartTime() > t_now) {
+                m_eval_t_next = std::min(m_eval_t_next, ra.first->getStartTime());
+            }
+        }
+        m_dirty = false;
+    }
+    float retval = setPayoffSeries(std::move(po));
+
+    /* End times are only kept if the series has exactly the same intervals (i.e. same order): */
+    bool aligned = (m_payoff.size() == (std::size_t)nts);
+    for(int i = 1; aligned && i < nts; i++) {
+        aligned = (at0s[i - 1] < at0s[i]);
+    }
+    if(aligned) {
+        m_payoff_t1.assign(at1s, at1s + nts);
+    }
+    return retval;
+}
+
+void EnvCell::evaluatePayoff(const double* at0s, const double* at1s, int nts, AgentHandle owner, double t_now,
+    std::vector<EnvCellPayoff>& po) const
+{
+    /*  NOTE: This function does not modify the cell nor the activities it holds, and only reads the
+     *  global configuration. It can be safely called concurrently for different cells as long as
+     *  payoff functions are reentrant (i.e. they don't use Random).
+     **/
+    po.clear();
+    po.reserve(nts);
+
+    /*  Payoff function for one cell:
+     *  Arg. #0:                   pair<double, double>  --> t0 & t1 of the potential new activity.
+     *  Arg. #1: vector<vector<pair<double, double> > >  --> vector of t0 & t1 of the activities for this cell.
+     *  Arg. #2:          vector<shared_ptr<Activity> >  --> Pointer to the activities (same index than arg2).
+     *  Arguments #1 and #2 do not depend on the potential activity and are built once.
+     **/
+    std::vector<std::vector<std::pair<double, double> > > arg2;
+    std::vector<std::shared_ptr<Activity> > arg3;
+    for(auto& ra : m_activities) {
+        if(ra.first->isOwner(owner) && ra.first->getStartTime() > t_now) {
+            /*  This activity is owned by the agent that is computing payoff and is in the future.
+             *  We will not consider it because we might be re-scheduling.
+             **/
+            continue;
+        }
+        std::vector<std::pair<double, double> > vec_ts;
+        vec_ts.reserve(ra.second.nts);
+        for(int j = 0; j < ra.second.nts; j++) {
+            vec_ts.push_back({ra.second.t0s[j], ra.second.t1s[j]});
+        }
+        arg2.push_back(vec_ts);
+        arg3.push_back(ra.first);
+    }
+    /*  IMPORTANT NOTE:
+     *  The following conditions are necessary:
+     *  - Forwards revisit time payoff needs arg2/arg3 to be sorted with start time asc.
+     *  - Backwards revisit time payoff needs arg2/arg3 to be sorted with end time asc.
+     *  The conditions are always met, as long as EnvCellState objects are sorted. Given
+     *  that these intervals are provided in an activity basis (i.e. several activities are
+     *  not mixed, because we create independent vectors), then it is just a matter of
+     *  ensuring that EnvCellState times are sorted.
+     **/
+    for(int i = 0; i < nts; i++) {
+        auto arg1 = std::make_pair(at0s[i], at1s[i]);
+        float p = 0.f;
         float uavg = 0.f;
         std::pair<float, float> po_uavg;
         for(unsigned int po_func_idx = 0; po_func_idx < m_payoff_func.size(); po_func_idx++) {
             po_uavg = m_payoff_func[po_func_idx](arg1, arg2, arg3);
-            if(po_uavg.first > po) {
-                po   = po_uavg.first;   /* Update payoff.       */
+            if(po_uavg.first > p) {
+                p    = po_uavg.first;   /* Update payoff.       */
                 uavg = po_uavg.second;  /* Update utility avg.  */
             }
         }
-        m_payoff[at0s[i]].first  = po;      /* Set final value. */
-        m_payoff[at0s[i]].second = uavg;    /* Set final value. */
+        po.push_back({at0s[i], p, uavg});
     }
-    return m_payoff.crbegin()->second.first;   /* Returns the "last" payoff. */
 }
 
-void EnvCell::getPayoff(double t, float& payoff, float& utility) const
+float EnvCell::setPayoffSeries(std::vector<EnvCellPayoff>&& po)
 {
-    double t_diff;
-    bool started = false;
-    for(auto& po : m_payoff) {
-        if(!started) {
-            t_diff = std::abs(po.first - t);
-            payoff  = po.second.first;
-            utility = po.second.second;
-            started = true;
-        } else {
-            if(std::abs(po.first - t) < t_diff) {
-                t_diff = std::abs(po.first - t);
-                payoff  = po.second.first;
-                utility = po.second.second;
-            }
+    m_payoff.clear();
+    m_payoff_t1.clear();
+    if(std::is_sorted(po.begin(), po.end(), [](const EnvCellPayoff& a, const EnvCellPayoff& b) { return a.t < b.t; })) {
+        m_payoff = std::move(po);
+        /* Repeated times keep the last value: */
+        auto last = std::unique(m_payoff.rbegin(), m_payoff.rend(),
+            [](const EnvCellPayoff& a, const EnvCellPayoff& b) { return a.t == b.t; });
+        m_payoff.erase(m_payoff.begin(), last.base());
+    } else {
+        for(auto& p : po) {
+            setPayoff(p.t, p.payoff, p.utility);
         }
     }
-    if(!started) {
+    if(m_payoff.empty()) {
+        return 0.f;
+    }
+    return m_payoff.back().payoff;      /* Returns the "last" payoff. */
+}
+
+void EnvCell::setPayoff(double t, float payoff, float utility)
+{
+    m_payoff_t1.clear();
+    /* Times are generated in ascending order, so this is usually an append: */
+    if(m_payoff.empty() || m_payoff.back().t < t) {
+        m_payoff.push_back({t, payoff, utility});
+        return;
+    }
+    auto it = std::lower_bound(m_payoff.begin(), m_payoff.end(), t,
+        [](const EnvCellPayoff& p, double tt) { return p.t < tt; });
+    if(it != m_payoff.end() && it->t == t) {
+        it->payoff  = payoff;
+        it->utility = utility;
+    } else {
+        m_payoff.insert(it, {t, payoff, utility});
+    }
+}
+
+void EnvCell::getPayoff(double t, float& payoff, float& utility, bool interpolate) const
+{
+    if(m_payoff.empty()) {
         Log::warn << "Cell " << *this << " does not have payoffs to retrieve.\n";
         payoff  = -1.f;
         utility = -1.f;
+        return;
+    }
+    /* Find the first payoff at or after `t`: */
+    auto it = std::lower_bound(m_payoff.begin(), m_payoff.end(), t,
+        [](const EnvCellPayoff& p, double tt) { return p.t < tt; });
+    if(it == m_payoff.begin()) {
+        payoff  = it->payoff;
+        utility = it->utility;
+    } else if(it == m_payoff.end()) {
+        payoff  = m_payoff.back().payoff;
+        utility = m_payoff.back().utility;
+    } else {
+        auto prev = std::prev(it);
+        if(interpolate) {
+            float k = (t - prev->t) / (it->t - prev->t);
+            payoff  = prev->payoff  + k * (it->payoff  - prev->payoff);
+            utility = prev->utility + k * (it->utility - prev->utility);
+        } else if(std::abs(it->t - t) < std::abs(prev->t - t)) {
+            /* Nearest payoff; ties resolve to the earlier one. */
+            payoff  = it->payoff;
+            utility = it->utility;
+        } else {
+            payoff  = prev->payoff;
+            utility = prev->utility;
+        }
     }
 }
 
+Span<const EnvCellPayoff> EnvCell::getPayoffSeries(double t0, double t1) const
+{
+    auto cmp = [](const EnvCellPayoff& p, double tt) { return p.t < tt; };
+    auto it0 = std::lower_bound(m_payoff.begin(), m_payoff.end(), t0, cmp);
+    auto it1 = std::lower_bound(it0, m_payoff.end(), t1, cmp);
+    return Span<const EnvCellPayoff>(m_payoff.data() + (it0 - m_payoff.begin()), it1 - it0);
+}
+
 bool EnvCell::findActivity(std::shared_ptr<Activity> act) const
 {
     return m_activities.find(act) != m_activities.end();
 }
 
-std::shared_ptr<Activity> EnvCell::getActivity(std::string agent_id, int activity_id) const
+std::shared_ptr<Activity> EnvCell::getActivity(ActivityHandle h) const
 {
     for(auto& a : m_activities) {
-        if(a.first->getAgentId() == agent_id && a.first->getId() == activity_id) {
+        if(a.first->getHandle() == h) {
             return a.first;
         }
     }
@@ -197,22 +349,26 @@ std::vector<std::shared_ptr<Activity> > EnvCell::getAllActivities(void) const
     return retval;
 }
 
-void EnvCell::clean(double t)
+std::vector<std::shared_ptr<Activity> > EnvCell::clean(double t)
 {
+    std::vector<std::shared_ptr<Activity> > retval;
     for(unsigned int fidx = 0; fidx < m_clean_func.size(); fidx++) {
         auto activities = m_clean_func[fidx](t, getAllActivities());
         for(auto& ac : activities) {
-            removeCellActivity(ac);
+            if(removeCellActivity(ac)) {    /* Sets the dirty flag if removed. */
+                retval.push_back(ac);
+            }
         }
     }
+    return retval;
 }
 
-std::set<std::pair<std::string, unsigned int> > EnvCell::getCellCrosscheckList(void) const
+std::set<ActivityHandle> EnvCell::getCellCrosscheckList(void) const
 {
-    std::set<std::pair<std::string, unsigned int> > retset;
+    std::set<ActivityHandle> retset;
     auto all_activities = getAllActivities();
     for(auto& ac : all_activities) {
-        retset.insert(std::make_pair(ac->getAgentId(), ac->getId()));
+        retset.insert(ac->getHandle());
     }
     return retset;
 }
@@ -229,12 +385,22 @@ std::size_t EnvCell::pushPayoffFunc(const std::pair<EnvCellPayoffFunc, EnvCellCl
     return pushPayoffFunc(f.first, f.second);
 }
 
+void EnvCell::getMemoryUsage(MemoryUsage& mu) const
+{
+    /* sizeof(EnvCell) is accounted by the owner of the cell grid. */
+    mu.env_cells += MemoryUsage::bytes(m_payoff_func) + MemoryUsage::bytes(m_clean_func);
+    mu.env_activities += MemoryUsage::bytes(m_activities);
+    for(auto& a : m_activities) {
+        mu.env_activities += 2 * MemoryUsage::chunk(a.second.nts * sizeof(double));
+    }
+    mu.env_payoff += MemoryUsage::bytes(m_payoff) + MemoryUsage::bytes(m_payoff_t1);
+}
 
 std::ostream& operator<<(std::ostream& os, const EnvCell& ec)
 {
     os << "(" << ec.x << "," << ec.y << ")[" << ec.m_payoff.size() << " PO";
-    for(auto po : ec.m_payoff) {
-        os << ":(" << po.first << "|" << po.second.first << "|" << po.second.second << ")";
+    for(auto& po : ec.m_payoff) {
+        os << ":(" << po.t << "|" << po.payoff << "|" << po.utility << ")";
     }
     os << "]";
     return os;
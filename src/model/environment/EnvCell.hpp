@@ -12,6 +12,9 @@
 #define ENV_CELL_HPP
 
 #include "prot.hpp"
+#include "Span.hpp"
+#include "IdRegistry.hpp"
+#include "MemoryReport.hpp"
 
 class Activity;
 class Agent;
@@ -22,6 +25,12 @@ struct EnvCellState {
     int nts;            /* Number of times that an activity influences over this cell. */
 };
 
+struct EnvCellPayoff {
+    double t;           /* Time of payoff (i.e. start time of the activity interval). */
+    float payoff;       /* Payoff value. */
+    float utility;      /* Avg. utility. */
+};
+
 class EnvCell
 {
 public:
@@ -57,22 +66,30 @@ public:
     EnvCell(Agent* agnt, unsigned int cx, unsigned int cy);
     EnvCell(Agent* agnt, unsigned int cx, unsigned int cy, EnvCellPayoffFunc fp, EnvCellCleanFunc fc);
 
-    void addCellActivity(std::shared_ptr<Activity> aptr);
+    bool addCellActivity(std::shared_ptr<Activity> aptr);
     bool removeCellActivity(std::shared_ptr<Activity> aptr);
-    bool removeCellActivityById(std::string agent_id, unsigned int activity_id);
+    bool removeCellActivityById(ActivityHandle h);
     bool updateCellActivity(std::shared_ptr<Activity> aptr);
     std::vector<std::shared_ptr<Activity> > getAllActivities(void) const;
-    std::shared_ptr<Activity> getActivity(std::string agent_id, int activity_id) const;
+    std::shared_ptr<Activity> getActivity(ActivityHandle h) const;
     bool findActivity(std::shared_ptr<Activity> act) const;
     float computeCellPayoff(double* at0s, double* at1s, int nts);
-    void clean(double t);
-    std::set<std::pair<std::string, unsigned int> > getCellCrosscheckList(void) const;
+    void evaluatePayoff(const double* at0s, const double* at1s, int nts, AgentHandle owner, double t_now,
+        std::vector<EnvCellPayoff>& po) const;
+    float setPayoffSeries(std::vector<EnvCellPayoff>&& po);
+    float updatePayoff(const double* at0s, const double* at1s, int nts, AgentHandle owner, double t_now);
+    void setDirty(void) { m_dirty = true; }
+    bool isDirty(void) const { return m_dirty; }
+    std::vector<std::shared_ptr<Activity> > clean(double t);
+    std::set<ActivityHandle> getCellCrosscheckList(void) const;
     std::size_t pushPayoffFunc(const EnvCellPayoffFunc fp, const EnvCellCleanFunc fc);
     std::size_t pushPayoffFunc(const std::pair<EnvCellPayoffFunc, EnvCellCleanFunc> f);
     std::size_t getPayoffFuncCount(void) { return m_payoff_func.size(); }
-    void getPayoff(double t, float& payoff, float& utility) const;
-    std::map<double, std::pair<float, float> > getAllPayoffs(void) const { return m_payoff; }
+    void getPayoff(double t, float& payoff, float& utility, bool interpolate = false) const;
+    Span<const EnvCellPayoff> getPayoffSeries(void) const { return Span<const EnvCellPayoff>(m_payoff); }
+    Span<const EnvCellPayoff> getPayoffSeries(double t0, double t1) const;
     std::size_t getPayoffCount(void) const { return m_payoff.size(); }
+    void getMemoryUsage(MemoryUsage& mu) const;
 
     /* Friend debug functions: */
     friend std::ostream& operator<<(std::ostream& os, const EnvCell& ec);
@@ -82,7 +99,13 @@ private:
     std::map<std::shared_ptr<Activity>, EnvCellState> m_activities;
     std::vector<EnvCellPayoffFunc> m_payoff_func;
     std::vector<EnvCellCleanFunc> m_clean_func;
-    std::map<double, std::pair<float, float> > m_payoff;    /**< Time of payoff <-> {Payoff value, Avg. utility}. */
+    std::vector<EnvCellPayoff> m_payoff;                    /**< Payoff series, sorted by time. */
+    std::vector<double> m_payoff_t1;                        /**< End times of the intervals in m_payoff (if known). */
+    bool m_dirty;                                           /**< Activities have changed since the last evaluation. */
+    AgentHandle m_eval_owner;                               /**< Agent used in the last evaluation. */
+    double m_eval_t_next;                                   /**< Time when an excluded (owned) activity starts. */
+
+    void setPayoff(double t, float payoff, float utility);
 };
 
 #endif /* ENV_CELL_HPP */
@@ -10,6 +10,8 @@
 
 #include "EnvModel.hpp"
 #include "Agent.hpp"
+#include "TaskPool.hpp"
+#include "Profiler.hpp"
 
 CREATE_LOGGER(EnvModel)
 
@@ -84,37 +86,54 @@ void EnvModel::clearView(void)
 
 void EnvModel::computePayoff(std::shared_ptr<Activity> tmp_act, bool display_in_view)
 {
-    Log::dbg << "Agent " << m_agent->getId() << " is computing payoff\n";
-    double* t0s;
-    double* t1s;
-    float po;
+    PROFILE_ZONE("EnvModel::computePayoff");
+    std::string aid = (m_agent != nullptr ? m_agent->getId() : "");
+    AgentHandle ah = (m_agent != nullptr ? m_agent->getHandle() : IdRegistry::getAgentHandle(aid));
+    Log::dbg << "Agent " << aid << " is computing payoff\n";
     if(display_in_view && m_payoff_view) {
         clearView();
     }
-    int nts;
-
+    double t_now = VirtualTime::now();
     auto cells = tmp_act->getActiveCells();
-    /*  #pragma omp parallel for
-     *  NOTE: I don't think it is a good idea to parallelise here, because a lot of accesses to
-     *  shared objects is done inside this loop (i.e. functions getCellTimes and computeCellPayoff).
+    std::vector<float> pos(cells.size());
+
+    /*  Each iteration only reads the activities of its own cell and writes its own payoff series
+     *  (active cells are unique). Cell costs vary a lot, hence the small chunks.
+     *  NOTE: When called from a planner task, chunks are run by the same team of threads (only if
+     *  nested parallelism is enabled).
      **/
-    for(std::size_t i = 0; i < cells.size(); i++) {
+    TaskPool::parallelFor(cells.size(), 8, [&](std::size_t i) {
         auto& c = cells[i];
-        nts = tmp_act->getCellTimes(c.x, c.y, &t0s, &t1s);
-        po = m_cells[c.x][c.y].computeCellPayoff(t0s, t1s, nts);
-        if(display_in_view && m_payoff_view) {
-            m_payoff_view->setValue(c.x, c.y, po);
+        double* t0s;
+        double* t1s;
+        int nts = tmp_act->getCellTimes(c.x, c.y, &t0s, &t1s);
+        pos[i] = m_cells[c.x][c.y].updatePayoff(t0s, t1s, nts, ah, t_now);
+    }, "payoff", (Config::parallel_payoff ? 0 : 1));
+    if(display_in_view && m_payoff_view) {
+        for(std::size_t i = 0; i < cells.size(); i++) {
+            m_payoff_view->setValue(cells[i].x, cells[i].y, pos[i]);
         }
     }
-    Log::dbg << "Agent " << m_agent->getId() << " has completed computing payoff\n";
+    Log::dbg << "Agent " << aid << " has completed computing payoff\n";
 }
 
 void EnvModel::addActivity(std::shared_ptr<Activity> act)
 {
     auto cells = act->getActiveCells();
+    double te = act->getEndTime();
     for(std::size_t i = 0; i < cells.size(); i++) {
         auto& c = cells[i];
-        m_cells[c.x][c.y].addCellActivity(act);
+        if(m_cells[c.x][c.y].addCellActivity(act)) {
+            crosscheckInsert(act);
+        }
+        /*  Cleaning functions (see PayoffFunctions) remove activities that ended before the last
+         *  confirmed one in the cell, or Config::goal_target before now:
+         **/
+        m_clean_queue.push({te, c.x, c.y, act, false});
+        m_clean_queue.push({te + Config::goal_target, c.x, c.y, act, true});
+        if(act->isDiscarded()) {
+            m_clean_pending.push_back(c.x * m_model_h + c.y);
+        }
     }
 }
 
@@ -124,11 +143,13 @@ void EnvModel::removeActivity(std::shared_ptr<Activity> act)
     /* We get the pointer once, since it was added for all cells at the same time and should be the same. */
     std::shared_ptr<Activity> real_aptr;
     if(cells.size() > 0) {
-        real_aptr = m_cells[cells[0].x][cells[0].y].getActivity(act->getAgentId(), act->getId());
+        real_aptr = m_cells[cells[0].x][cells[0].y].getActivity(act->getHandle());
     }
     for(std::size_t i = 0; i < cells.size(); i++) {
         auto& c = cells[i];
-        m_cells[c.x][c.y].removeCellActivity(real_aptr);
+        if(m_cells[c.x][c.y].removeCellActivity(real_aptr)) {
+            crosscheckRemove(real_aptr);
+        }
     }
 }
 
@@ -138,7 +159,7 @@ void EnvModel::updateActivity(std::shared_ptr<Activity> act)
     bool updated = false;
     for(std::size_t i = 0; i < cells.size(); i++) {
         auto& c = cells[i];
-        auto aptr = m_cells[c.x][c.y].getActivity(act->getAgentId(), act->getId());
+        auto aptr = m_cells[c.x][c.y].getActivity(act->getHandle());
         if(aptr != nullptr) {
             /*  The environment model has this activity. Update it here, once.
              *  NOTE: Cells hold a pointer to activities. Therefore, updating the activity once
@@ -153,39 +174,94 @@ void EnvModel::updateActivity(std::shared_ptr<Activity> act)
             break;
         }
     }
+    if(updated) {
+        for(auto& c : cells) {
+            m_cells[c.x][c.y].setDirty();
+            m_clean_pending.push_back(c.x * m_model_h + c.y);
+        }
+    }
     if(!updated) {
         Log::err << "Unable to update activity [" << act->getAgentId() << ":" << act->getId() << "] in the environment model of "
             << m_agent->getId() << ". The agent does not remember this activity.\n";
     }
 }
 
+void EnvModel::touchActivity(std::shared_ptr<Activity> act)
+{
+    auto cells = act->getActiveCells();
+    for(auto& c : cells) {
+        m_cells[c.x][c.y].setDirty();
+        m_clean_pending.push_back(c.x * m_model_h + c.y);
+    }
+}
 
 void EnvModel::cleanActivities(double t)
 {
     if(t == -1.f) {
         t = VirtualTime::now();
     }
-    #pragma omp parallel for
-    for(unsigned int xx = 0; xx < m_model_w; xx++) {
-        #pragma omp parallel for
-        for(unsigned int yy = 0; yy < m_model_h; yy++) {
-            m_cells[xx][yy].clean(t);
+    std::vector<unsigned int> cidx;
+    std::vector<EnvCleanEvent> expiring;
+    cidx.swap(m_clean_pending);
+    while(!m_clean_queue.empty() && m_clean_queue.top().t <= t) {
+        EnvCleanEvent e = m_clean_queue.top();
+        m_clean_queue.pop();
+        auto aptr = e.act.lock();
+        if(aptr != nullptr && m_cells[e.x][e.y].findActivity(aptr)) {
+            cidx.push_back(e.x * m_model_h + e.y);
+            if(e.expiry) {
+                expiring.push_back(e);
+            }
+        } /* ... else: the activity has already been removed from this cell. */
+    }
+    std::sort(cidx.begin(), cidx.end());
+    cidx.erase(std::unique(cidx.begin(), cidx.end()), cidx.end());
+
+    std::vector<std::vector<std::shared_ptr<Activity> > > removed(cidx.size());
+    TaskPool::parallelFor(cidx.size(), 1, [&](std::size_t i) {
+        removed[i] = m_cells[cidx[i] / m_model_h][cidx[i] % m_model_h].clean(t);
+    }, "clean");
+    for(auto& rv : removed) {
+        for(auto& aptr : rv) {
+            crosscheckRemove(aptr);
+        }
+    }
+    /*  Cleaning functions compare times strictly. Expiring activities that have not been removed
+     *  yet are checked again in the next call:
+     **/
+    for(auto& e : expiring) {
+        auto aptr = e.act.lock();
+        if(aptr != nullptr && m_cells[e.x][e.y].findActivity(aptr)) {
+            m_clean_queue.push(e);
         }
     }
 }
 
-std::set<std::pair<std::string, unsigned int> > EnvModel::getCrosscheckList(void) const
+void EnvModel::crosscheckInsert(std::shared_ptr<Activity> act)
 {
-    std::set<std::pair<std::string, unsigned int> > retset;
-    for(unsigned int xx = 0; xx < m_model_w; xx++) {
-        for(unsigned int yy = 0; yy < m_model_h; yy++) {
-            auto cellset = m_cells[xx][yy].getCellCrosscheckList();
-            for(auto& cellpair : cellset) {
-                retset.insert(cellpair);
-            }
-        }
+    ActivityHandle key = act->getHandle();
+    auto it = std::lower_bound(m_crosscheck.begin(), m_crosscheck.end(), key);
+    std::size_t i = it - m_crosscheck.begin();
+    if(it == m_crosscheck.end() || *it != key) {
+        m_crosscheck.insert(it, key);
+        m_crosscheck_count.insert(m_crosscheck_count.begin() + i, 0);
+    }
+    m_crosscheck_count[i]++;
+}
+
+void EnvModel::crosscheckRemove(std::shared_ptr<Activity> act)
+{
+    ActivityHandle key = act->getHandle();
+    auto it = std::lower_bound(m_crosscheck.begin(), m_crosscheck.end(), key);
+    if(it == m_crosscheck.end() || *it != key) {
+        Log::err << "Activity [" << IdRegistry::toString(key) << "] was not in the crosscheck list.\n";
+        return;
+    }
+    std::size_t i = it - m_crosscheck.begin();
+    if(--m_crosscheck_count[i] == 0) {
+        m_crosscheck.erase(it);
+        m_crosscheck_count.erase(m_crosscheck_count.begin() + i);
     }
-    return retset;
 }
 
 
@@ -251,8 +327,8 @@ double EnvModel::findEndTime(double t0, double max_t1, std::shared_ptr<Activity>
         for(auto it = cells.begin(); it != cells.end(); ) {
             EnvCell& c = m_cells[it->x][it->y];
             bool remove_cell = true;
-            for(auto p : c.getAllPayoffs()) {
-                if(p.second.first >= Config::min_payoff || Config::mode == SandboxMode::RANDOM) {
+            for(auto& p : c.getPayoffSeries()) {
+                if(p.payoff >= Config::min_payoff || Config::mode == SandboxMode::RANDOM) {
                     remove_cell = false;
                     break;
                 }
@@ -286,8 +362,8 @@ double EnvModel::findEndTime(double t0, double max_t1, std::shared_ptr<Activity>
             for(auto it = cells.begin(); it != cells.end(); ) {
                 EnvCell& c = m_cells[it->x][it->y];
                 bool remove_cell = true;
-                for(auto p : c.getAllPayoffs()) {
-                    if(p.second.first >= Config::min_payoff || Config::mode == SandboxMode::RANDOM) {
+                for(auto& p : c.getPayoffSeries()) {
+                    if(p.payoff >= Config::min_payoff || Config::mode == SandboxMode::RANDOM) {
                         remove_cell = false;
                         break;
                     }
@@ -487,6 +563,25 @@ const GridView& EnvModel::getView(void) const
     return *m_payoff_view;
 }
 
+void EnvModel::getMemoryUsage(MemoryUsage& mu) const
+{
+    mu.env_cells += sizeof(EnvModel) + MemoryUsage::bytes(m_cells) + MemoryUsage::bytes(m_world_positions);
+    mu.env_cells += m_clean_queue.size() * sizeof(EnvCleanEvent) + MemoryUsage::bytes(m_clean_pending);
+    mu.env_cells += MemoryUsage::bytes(m_crosscheck) + MemoryUsage::bytes(m_crosscheck_count);
+    for(auto& col : m_cells) {
+        mu.env_cells += MemoryUsage::bytes(col);
+        for(auto& c : col) {
+            c.getMemoryUsage(mu);
+        }
+    }
+    for(auto& col : m_world_positions) {
+        mu.env_cells += MemoryUsage::bytes(col);
+    }
+    if(m_payoff_view) {
+        mu.views += m_payoff_view->getMemoryFootprint();
+    }
+}
+
 std::vector<sf::Vector2i> EnvModel::getWorldCells(EnvCell model_cell) const
 {
     return getWorldCells(sf::Vector2i(model_cell.x, model_cell.y));
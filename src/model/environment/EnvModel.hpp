@@ -14,6 +14,7 @@
 #include "prot.hpp"
 #include "hashers.hpp"
 #include <unordered_set>
+#include <queue>
 #include "World.hpp"
 #include "GridView.hpp"
 #include "EnvCell.hpp"
@@ -40,6 +41,16 @@ struct ActivityGen {
     bool valid;                         /* Whether this activity generator is valid or not. */
 };
 
+struct EnvCleanEvent {
+    double t;                           /* Time from which the cell may need to be cleaned. */
+    unsigned int x;                     /* Cell x-axis coordinate. */
+    unsigned int y;                     /* Cell y-axis coordinate. */
+    std::weak_ptr<Activity> act;        /* The activity that triggers this event. */
+    bool expiry;                        /* Whether the activity itself expires at `t`. */
+
+    bool operator>(const EnvCleanEvent& other) const { return t > other.t; }
+};
+
 class EnvModel : public HasView
 {
 public:
@@ -53,8 +64,12 @@ public:
     EnvModel(Agent* aptr, unsigned int mw, unsigned int mh);
 
     /*******************************************************************************************//**
-     *  Compute the payoff value for some cells of the model. EnvCell::computeCellPayoff is called
-     *  iteratively in a parallel pipeline (OpenMP's parallel for). Payoff is only computed for
+     *  Compute the payoff value for some cells of the model. EnvCell::evaluatePayoff is called
+     *  iteratively in a parallel pipeline (OpenMP's parallel for) if Config::parallel_payoff is
+     *  set; results are identical to those of the sequential loop. If Config::payoff_incremental
+     *  is set, cells whose activities have not changed since the previous call (see
+     *  EnvCell::updatePayoff) reuse the payoff of the intervals that were already evaluated, so
+     *  that the cost of this function depends on what has changed. Payoff is only computed for
      *  cells that are active in tmp_act (see Activity::getActiveCells). Ideally, this temporal
      *  activity (tmp_act) should be a long task that comprises the whole scheduling window of an
      *  agent. The optional argument display_in_view determines whether the resulting cell payoff
@@ -117,6 +132,14 @@ public:
      **********************************************************************************************/
     void updateActivity(std::shared_ptr<Activity> act);
 
+    /*******************************************************************************************//**
+     *  Notifies that the state of an activity (e.g. confirmed, discarded, confidence) has been
+     *  modified in place. The payoff of its active cells will be computed again in the next call
+     *  to EnvModel::computePayoff. Not needed after addActivity, removeActivity, updateActivity or
+     *  cleanActivities.
+     **********************************************************************************************/
+    void touchActivity(std::shared_ptr<Activity> act);
+
     /*******************************************************************************************//**
      *  Calls the clean function for each cell of this environment. This function automatically
      *  unbinds/removes activities that are meaningless in the context of a cell. This is partially
@@ -126,15 +149,19 @@ public:
      *  number of activities to consider in each cell.
      *  Cells are cleaned for time `t`. If this is not provided (or is equal to -1), the current
      *  virtual time will be used.
+     *  Only cells that may have changed are visited: those with an activity whose end time (or end
+     *  time plus Config::goal_target) has been reached, which are kept in a priority queue, and
+     *  those with activities modified through updateActivity or touchActivity.
      **********************************************************************************************/
     void cleanActivities(double t = -1.f);
 
     /*******************************************************************************************//**
-     *  Generates a list of activity identifiers from all agents so that the ActivityHandler can
+     *  Gets the list of activity identifiers from all agents so that the ActivityHandler can
      *  remove activities more efficiently. This only takes into account confirmed and undecided,
-     *  because discarded activities are automatically cleaned from EnvCells.
+     *  because discarded activities are automatically cleaned from EnvCells. The list is sorted
+     *  and is kept up to date as activities are added to and removed from cells.
      **********************************************************************************************/
-    std::set<std::pair<std::string, unsigned int> > getCrosscheckList(void) const;
+    const std::vector<ActivityHandle>& getCrosscheckList(void) const { return m_crosscheck; }
 
     /*******************************************************************************************//**
      *  Getter for the environment model size information.
@@ -153,6 +180,11 @@ public:
      **********************************************************************************************/
     unsigned int getModelHeight(void) const { return m_model_h; }
 
+    /*******************************************************************************************//**
+     *  Getter for the cell with model coordinates x and y. Does not check bounds.
+     **********************************************************************************************/
+    const EnvCell& getCell(unsigned int x, unsigned int y) const { return m_cells[x][y]; }
+
     /*******************************************************************************************//**
      *  Get the world cell coordinates that correspond to a model cell.
      *  @param  model_cell  Cell from which world coordinates will be found.
@@ -220,6 +252,12 @@ public:
      **********************************************************************************************/
     const GridView& getView(void) const;
 
+    /*******************************************************************************************//**
+     *  Adds the estimated footprint of the cells, their activity maps and payoff series and the
+     *  payoff view.
+     **********************************************************************************************/
+    void getMemoryUsage(MemoryUsage& mu) const;
+
 private:
     Agent* m_agent;             /* Owner. */
     unsigned int m_model_h;     /* Cover a number of pixels. */
@@ -231,6 +269,14 @@ private:
     std::vector<std::vector<EnvCell> > m_cells;                 /**< Cells in which the environment is tesselated. */
     std::shared_ptr<GridView> m_payoff_view;                    /**< Environment graphical representation (payoff values). */
     std::vector<std::vector<sf::Vector3f> > m_world_positions;  /**< Look-up table of cell 3D coordinates (ECEF) in the world. */
+    std::priority_queue<EnvCleanEvent, std::vector<EnvCleanEvent>, std::greater<EnvCleanEvent> > m_clean_queue;
+                                                                /**< Cells to clean, sorted by time. */
+    std::vector<unsigned int> m_clean_pending;                  /**< Cells to clean regardless of time (index x * h + y). */
+    std::vector<ActivityHandle> m_crosscheck;                   /**< Sorted handles of the activities in cells. */
+    std::vector<unsigned int> m_crosscheck_count;               /**< Number of cells that hold each activity in m_crosscheck. */
+
+    void crosscheckInsert(std::shared_ptr<Activity> act);
+    void crosscheckRemove(std::shared_ptr<Activity> act);
 };
 
 template <class T>
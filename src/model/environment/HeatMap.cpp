@@ -129,6 +129,13 @@ void HeatMap::saveHeatMap(void)
     }
 }
 
+std::size_t HeatMap::getMemoryFootprint(void) const
+{
+    std::size_t rows = MemoryUsage::chunk(m_lng_range * sizeof(double*)) + MemoryUsage::chunk(m_lng_range * sizeof(unsigned int*));
+    std::size_t cols = MemoryUsage::chunk(m_lat_range * sizeof(double)) + MemoryUsage::chunk(m_lat_range * sizeof(unsigned int));
+    return sizeof(HeatMap) + rows + m_lng_range * cols;
+}
+
 unsigned int HeatMap::getLongitudeDimension(void)
 {
     return m_lng_range;
@@ -15,6 +15,7 @@
 // #include "mat.h"        /* Matlab library. */
 // #include <string.h>     /* Dependencies of Matlab library. */
 #include "ReportGenerator.hpp"
+#include "MemoryReport.hpp"
 
 class HeatMap : public ReportGenerator
 {
@@ -25,6 +26,7 @@ public:
     void setType(Aggregate hmt) { m_hm_type = hmt; }
     void setRevisitTime(unsigned int x, unsigned int y, double rt);
     void saveHeatMap(void);
+    std::size_t getMemoryFootprint(void) const;
     static unsigned int getLongitudeDimension(void);
     static unsigned int getLatitudeDimension(void);
 
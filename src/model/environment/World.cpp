@@ -10,6 +10,8 @@
 
 #include "World.hpp"
 #include "Agent.hpp"
+#include "TaskPool.hpp"
+#include "Profiler.hpp"
 
 CREATE_LOGGER(World)
 
@@ -19,7 +21,8 @@ std::vector<std::vector<sf::Vector3f> > World::m_world_positions;
 
 World::World(void)
     : ReportGenerator(std::string("world_metrics.csv"))
-    , m_self_view(m_width, m_height, 1.f, 1.f, sf::Color(127, 127, 127))
+    , m_display_layer(0)
+    , m_display_lod(0)
     , m_hm_max_actual(std::string("heatmap_max_actual.csv"), Aggregate::MAX_VALUE)
     , m_hm_max_utopia(std::string("heatmap_max_utopia.csv"), Aggregate::MAX_VALUE)
     , m_hm_avg_actual(std::string("heatmap_avg_actual.csv"), Aggregate::MEAN_VALUE)
@@ -27,7 +30,16 @@ World::World(void)
     , m_hm_count_actual(std::string("heatmap_count_actual.csv"), Aggregate::COUNT)
     , m_hm_count_utopia(std::string("heatmap_count_utopia.csv"), Aggregate::COUNT)
     , m_delay_hm(0)
+    , m_skip_step(0)
 {
+    if(Config::world_lod_metrics || (Config::enable_graphics && Config::world_lod != 0)) {
+        m_pyramid.reset(new WorldPyramid(m_width, m_height));
+        if(Config::world_lod > 0) {
+            m_display_lod = std::min((unsigned int)Config::world_lod, m_pyramid->getLevels() - 1);
+        }
+    }
+    createViews();
+
     /* Prepare HeatMap control variables: */
     unsigned int hm_dim_lng = HeatMap::getLongitudeDimension();
     unsigned int hm_dim_lat = HeatMap::getLatitudeDimension();
@@ -97,8 +109,53 @@ World::World(void)
         }
         m_cells.push_back(column);
     }
-    if(m_world_positions.size() == 0 && Config::motion_model == AgentMotionType::ORBITAL) {
-        /* Build the positions LUT: */
+    if(Config::motion_model == AgentMotionType::ORBITAL) {
+        buildPositionLUT();
+    }
+}
+
+void World::createViews(void)
+{
+    unsigned int vw = m_width;
+    unsigned int vh = m_height;
+    if(m_display_lod > 0) {
+        vw = m_pyramid->getWidth(m_display_lod);
+        vh = m_pyramid->getHeight(m_display_lod);
+    }
+    float cs = (float)(1u << m_display_lod);
+
+    /* Vertex arrays are too large to keep one per layer, layers share it and are recolored: */
+    m_layer_views.clear();
+    for(unsigned int ll = 0; ll < n_layers; ll++) {
+        if(ll == 0 || Config::grid_textures) {
+            m_layer_views.push_back(std::make_shared<GridView>(vw, vh, cs, cs, sf::Color(127, 127, 127)));
+        } else {
+            m_layer_views.push_back(m_layer_views[0]);
+        }
+    }
+}
+
+void World::setDisplaySize(unsigned int w, unsigned int h)
+{
+    if(Config::world_lod >= 0 || !m_pyramid) {
+        return;
+    }
+    /* Coarsest level with (at least) one entry per pixel: */
+    unsigned int k = 0;
+    while(k + 1 < m_pyramid->getLevels() && m_pyramid->getWidth(k + 1) >= w && m_pyramid->getHeight(k + 1) >= h) {
+        k++;
+    }
+    if(k != m_display_lod) {
+        m_display_lod = k;
+        createViews();
+        Log::dbg << "World views are shown at level " << k << " (" << m_pyramid->getWidth(k) << "x"
+            << m_pyramid->getHeight(k) << ").\n";
+    }
+}
+
+void World::buildPositionLUT(void)
+{
+    if(m_world_positions.size() == 0) {
         float lat, lng;
         m_world_positions.reserve(m_width);
         for(unsigned int i = 0; i < m_width; i++) {
@@ -129,26 +186,91 @@ World::~World(void)
     delete[] m_update_heatmaps;
 }
 
-void World::display(Layer l)
+void World::getMemoryUsage(MemoryUsage& mu) const
 {
-    #pragma omp parallel for
-    for(unsigned int i = 0; i < m_width; i++) {
-        for(unsigned int j = 0; j < m_height; j++) {
-            float cell_val, norm_val;
-            cell_val = m_cells[i][j][(int)l].value;
-            if(cell_val >= 0.f) {
-                norm_val = 1.f - (cell_val / (2.f * Config::goal_target));
-                norm_val = std::max(norm_val, 0.f);
-                m_self_view.setValue(i, j, norm_val);
-            } else {
-                m_self_view.setValue(i, j, -1.f);
-            }
+    mu.world_layers += sizeof(World) + MemoryUsage::bytes(m_cells) + MemoryUsage::bytes(m_world_positions);
+    for(auto& col : m_cells) {
+        mu.world_layers += MemoryUsage::bytes(col);
+        for(auto& c : col) {
+            mu.world_layers += MemoryUsage::bytes(c);
+        }
+    }
+    for(auto& col : m_world_positions) {
+        mu.world_layers += MemoryUsage::bytes(col);
+    }
+    std::size_t hm_dim_lng = HeatMap::getLongitudeDimension();
+    std::size_t hm_dim_lat = HeatMap::getLatitudeDimension();
+    mu.world_layers += MemoryUsage::chunk(hm_dim_lng * sizeof(bool**));
+    mu.world_layers += hm_dim_lng * (MemoryUsage::chunk(hm_dim_lat * sizeof(bool*)) + hm_dim_lat * MemoryUsage::chunk(n_layers));
+    mu.world_layers += MemoryUsage::bytes(m_skip_cell_step) + MemoryUsage::bytes(m_skip_hm_step);
+
+    for(const HeatMap* hm : { &m_hm_max_actual, &m_hm_max_utopia, &m_hm_avg_actual, &m_hm_avg_utopia,
+        &m_hm_count_actual, &m_hm_count_utopia }) {
+        mu.heatmaps += hm->getMemoryFootprint();
+    }
+    if(m_pyramid) {
+        mu.world_layers += m_pyramid->getMemoryFootprint();
+    }
+    for(unsigned int ll = 0; ll < n_layers; ll++) {
+        if(ll == 0 || m_layer_views[ll] != m_layer_views[0]) {
+            mu.views += m_layer_views[ll]->getMemoryFootprint();
+        }
+    }
+}
+
+template <typename F>
+void World::forEachDisplayValue(Layer l, F set_value)
+{
+    /* Values are normalized to [0, 1] (-1 for cells that have not been seen): */
+    auto set_age = [&set_value](unsigned int i, unsigned int j, float cell_val) {
+        if(cell_val >= 0.f) {
+            float norm_val = 1.f - (cell_val / (2.f * Config::goal_target));
+            set_value(i, j, std::max(norm_val, 0.f));
+        } else {
+            set_value(i, j, -1.f);
         }
+    };
+    if(m_display_lod == 0) {
+        TaskPool::parallelFor(m_width, 0, [this, l, &set_age](std::size_t i) {
+            for(unsigned int j = 0; j < m_height; j++) {
+                set_age(i, j, m_cells[i][j][(int)l].value);
+            }
+        }, "world_display");
+    } else {
+        std::lock_guard<std::mutex> lock(m_pyramid_mutex);
+        m_pyramid->refresh();
+        unsigned int k = m_display_lod;
+        TaskPool::parallelFor(m_pyramid->getWidth(k), 0, [this, l, k, &set_age](std::size_t i) {
+            for(unsigned int j = 0; j < m_pyramid->getHeight(k); j++) {
+                double age = m_pyramid->getAge((unsigned int)l, k, i, j, Config::world_lod_aggregate);
+                set_age(i, j, (age >= 0.0 ? (float)(age * Config::time_step) : -1.f));
+            }
+        }, "world_display");
     }
 }
 
+void World::display(Layer l)
+{
+    m_display_layer = (unsigned int)l;
+    GridView& view = *m_layer_views[m_display_layer];
+    forEachDisplayValue(l, [&view](unsigned int i, unsigned int j, float v) {
+        view.setValue(i, j, v);
+    });
+}
+
+void World::getDisplayEntries(Layer l, std::vector<std::uint16_t>& entries)
+{
+    unsigned int h = (m_display_lod == 0 ? m_height : m_pyramid->getHeight(m_display_lod));
+    unsigned int w = (m_display_lod == 0 ? m_width : m_pyramid->getWidth(m_display_lod));
+    entries.resize((std::size_t)w * h);
+    forEachDisplayValue(l, [&entries, h](unsigned int i, unsigned int j, float v) {
+        entries[(std::size_t)i * h + j] = GridView::getEntry(v);
+    });
+}
+
 void World::computeMetrics(bool last)
 {
+    PROFILE_ZONE("World::computeMetrics");
     std::vector<float> avgs_utop(m_metrics_grids.size());
     std::vector<float> avgs_diff(m_metrics_grids.size());
     std::vector<float> avgs_curr(m_metrics_grids.size());
@@ -159,6 +281,17 @@ void World::computeMetrics(bool last)
     std::vector<float> unmet_coverage_curr(m_metrics_grids.size());
     std::vector<float> unmet_avg_utop(m_metrics_grids.size());
     std::vector<float> unmet_avg_curr(m_metrics_grids.size());
+    bool use_pyramid = (m_pyramid && Config::world_lod_metrics);
+    std::unique_lock<std::mutex> lock(m_pyramid_mutex, std::defer_lock);
+    std::uint32_t unmet_age = 0;    /* Minimum age (in steps) of the cells above the goal. */
+    if(use_pyramid) {
+        lock.lock();
+        m_pyramid->refresh();
+        unmet_age = (std::uint32_t)std::floor(std::max(Config::goal_target, 0.0) / Config::time_step);
+        while(unmet_age * Config::time_step <= Config::goal_target) {
+            unmet_age++;
+        }
+    }
     for(unsigned int q = 0; q < m_metrics_grids.size(); q++) {
         unsigned int x0, x1, y0, y1;
         {
@@ -167,6 +300,25 @@ void World::computeMetrics(bool last)
             y0 = m_metrics_grids[q].y0;
             y1 = m_metrics_grids[q].y1;
         }
+        if(use_pyramid) {
+            /*  Same aggregates as the loop below (including the extra cell in the averages), but only
+             *  the pyramid entries that are not entirely inside the region and met/unmet are descended:
+             **/
+            WorldPyramid::RegionStats rs = m_pyramid->getRegionStats(x0, x1, y0, y1, unmet_age);
+            double dt = Config::time_step;
+            double count_cells = (double)(rs.count + 1);
+            avgs_utop[q] = (float)(rs.utop_sum * dt / count_cells);
+            avgs_diff[q] = (float)(rs.diff_sum * dt / count_cells);
+            avgs_curr[q] = (float)(rs.curr_sum * dt / count_cells);
+            maxs_utop[q] = (float)(rs.utop_max * dt);
+            maxs_diff[q] = (float)(rs.diff_max * dt);
+            maxs_curr[q] = (float)(rs.curr_max * dt);
+            unmet_coverage_utop[q] = (float)(rs.utop_unmet_count / count_cells);
+            unmet_coverage_curr[q] = (float)(rs.curr_unmet_count / count_cells);
+            unmet_avg_utop[q] = (rs.utop_unmet_count == 0 ? 0.f : (float)(rs.utop_unmet_sum * dt / rs.utop_unmet_count));
+            unmet_avg_curr[q] = (rs.curr_unmet_count == 0 ? 0.f : (float)(rs.curr_unmet_sum * dt / rs.curr_unmet_count));
+            continue;
+        }
         float utop_val = 0.f;
         float diff_val = 0.f;
         float curr_val = 0.f;
@@ -230,6 +382,9 @@ void World::computeMetrics(bool last)
         unmet_avg_utop[q] = utop_unmet_val;
         unmet_avg_curr[q] = curr_unmet_val;
     }
+    if(use_pyramid) {
+        lock.unlock();
+    }
     for(unsigned int q = 0; q < m_metrics_grids.size(); q++) {
         setReportColumnValue((10 * q) + 0, avgs_utop[q]);
         setReportColumnValue((10 * q) + 1, maxs_utop[q]);
@@ -287,20 +442,136 @@ void World::addAgent(std::vector<std::shared_ptr<Agent> > aptrs)
 
 void World::step(void)
 {
-    #pragma omp parallel for
-    for(unsigned int xx = 0; xx < m_width; xx++) {
+    PROFILE_ZONE("World::step");
+    if(m_pyramid) {
+        m_pyramid->step();
+    }
+    TaskPool::parallelFor(m_width, 0, [this](std::size_t xx) {
         for(unsigned int yy = 0; yy < m_height; yy++) {
             updateAllLayers(xx, yy, false);
         }
+    }, "world");
+    for(auto& a : m_agents) {
+        auto cells = a->getWorldFootprint(m_world_positions);
+        bool capturing = a->isCapturing();
+        for(auto& c : cells) {
+            updateLayer(Layer::REVISIT_TIME_UTOPIA, c.x, c.y, true);
+            updateLayer(Layer::REVISIT_TIME_ACTUAL, c.x, c.y, capturing);
+            if(m_pyramid) {
+                m_pyramid->visit(c.x, c.y, capturing);
+            }
+        }
     }
+}
+
+void World::beginSkip(void)
+{
+    m_skip_step = 0;
+    m_skip_cell_step.assign(m_width * m_height, 0);
+    m_skip_hm_step.assign(HeatMap::getLongitudeDimension() * HeatMap::getLatitudeDimension() * n_layers, 0);
+}
+
+void World::skipStep(void)
+{
+    /*  Equivalent to World::step, but cells that are not seen by any agent are not aged here. Instead,
+     *  each cell keeps the last step up to which it was updated and is brought up to date (with all
+     *  the pending steps at once) when it is seen again, or in World::endSkip.
+     **/
+    m_skip_step++;
+    if(m_pyramid) {
+        m_pyramid->step();
+    }
+    unsigned int hm_dim_lat = HeatMap::getLatitudeDimension();
     for(auto& a : m_agents) {
         auto cells = a->getWorldFootprint(m_world_positions);
         bool capturing = a->isCapturing();
         for(auto& c : cells) {
+            catchUp(c.x, c.y);
+            bool is_heatmap_pixel = (c.x % m_hm_dim_ratio_lng == 0) && (c.y % m_hm_dim_ratio_lat == 0);
+            unsigned int hm_x = c.x / m_hm_dim_ratio_lng;
+            unsigned int hm_y = c.y / m_hm_dim_ratio_lat;
+            bool hm_flags[n_layers];
+            if(is_heatmap_pixel) {
+                /*  Heatmap flags are raised when any cell of the block ages (see World::updateLayer).
+                 *  The other cells of this block may not be up to date, so their pending steps are
+                 *  checked before the flag is used:
+                 **/
+                unsigned int x1 = std::min((hm_x + 1) * m_hm_dim_ratio_lng, m_width);
+                unsigned int y1 = std::min((hm_y + 1) * m_hm_dim_ratio_lat, m_height);
+                for(unsigned int l = 0; l < n_layers; l++) {
+                    unsigned int t_clear = m_skip_hm_step[(hm_x * hm_dim_lat + hm_y) * n_layers + l];
+                    for(unsigned int xx = c.x; xx < x1 && !m_update_heatmaps[hm_x][hm_y][l]; xx++) {
+                        for(unsigned int yy = c.y; yy < y1; yy++) {
+                            if(hasPendingHeatmapUpdate(static_cast<Layer>(l), xx, yy, t_clear)) {
+                                m_update_heatmaps[hm_x][hm_y][l] = true;
+                                break;
+                            }
+                        }
+                    }
+                    hm_flags[l] = m_update_heatmaps[hm_x][hm_y][l];
+                }
+            }
             updateLayer(Layer::REVISIT_TIME_UTOPIA, c.x, c.y, true);
             updateLayer(Layer::REVISIT_TIME_ACTUAL, c.x, c.y, capturing);
+            if(m_pyramid) {
+                m_pyramid->visit(c.x, c.y, capturing);
+            }
+            if(is_heatmap_pixel) {
+                for(unsigned int l = 0; l < n_layers; l++) {
+                    if(hm_flags[l] && !m_update_heatmaps[hm_x][hm_y][l]) {
+                        m_skip_hm_step[(hm_x * hm_dim_lat + hm_y) * n_layers + l] = m_skip_step;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void World::endSkip(void)
+{
+    TaskPool::parallelFor(m_width, 0, [this](std::size_t xx) {
+        for(unsigned int yy = 0; yy < m_height; yy++) {
+            catchUp(xx, yy);
         }
+    }, "world");
+    m_skip_step = 0;
+}
+
+void World::catchUp(int x, int y)
+{
+    unsigned int& t_cell = m_skip_cell_step[x * m_height + y];
+    if(t_cell == m_skip_step) {
+        return;
+    }
+    unsigned int hm_x = x / m_hm_dim_ratio_lng;
+    unsigned int hm_y = y / m_hm_dim_ratio_lat;
+    unsigned int hm_idx = (hm_x * HeatMap::getLatitudeDimension() + hm_y) * n_layers;
+    for(unsigned int l = 0; l < n_layers; l++) {
+        auto& cell = m_cells[x][y][l];
+        if(cell.value >= 0.f) {
+            if(hasPendingHeatmapUpdate(static_cast<Layer>(l), x, y, m_skip_hm_step[hm_idx + l])) {
+                m_update_heatmaps[hm_x][hm_y][l] = true;
+            }
+            cell.value += (m_skip_step - t_cell) * Config::time_step;
+        }
+    }
+    t_cell = m_skip_step;
+}
+
+bool World::hasPendingHeatmapUpdate(Layer l, int x, int y, unsigned int t_clear) const
+{
+    /*  When a cell ages in World::updateLayer, it raises the flag of its heatmap block if its value
+     *  was positive. For the steps that are pending in this cell, that is: all of them if the value
+     *  is already positive, or all but the first if the value is zero. Only the steps after the flag
+     *  was last cleared are relevant.
+     **/
+    unsigned int t_cell = m_skip_cell_step[x * m_height + y];
+    float value = m_cells[x][y][(int)l].value;
+    unsigned int t_first = std::max(t_cell, t_clear) + 1;
+    if(value < 0.f || t_first > m_skip_step) {
+        return false;
     }
+    return (value > 0.f || m_skip_step >= std::max(t_first, t_cell + 2));
 }
 
 void World::updateAllLayers(int x, int y, bool active)
@@ -17,6 +17,7 @@
 #include "GridView.hpp"
 #include "ReportGenerator.hpp"
 #include "HeatMap.hpp"
+#include "WorldPyramid.hpp"
 
 class Agent;
 
@@ -34,11 +35,18 @@ public:
     void addAgent(std::shared_ptr<Agent> aptr);
     void addAgent(std::vector<std::shared_ptr<Agent> > aptrs);
     void step(void) override;
+    void beginSkip(void);
+    void skipStep(void);
+    void endSkip(void);
     void display(Layer l);
+    void getDisplayEntries(Layer l, std::vector<std::uint16_t>& entries);   /**< As display, without updating views (see GridView::setEntries). */
+    void setDisplaySize(unsigned int w, unsigned int h);   /**< Fits the views level to w x h pixels (if world_lod = -1). */
     void computeMetrics(bool last = false);
-    const GridView& getView(void) const override { return m_self_view; }
+    const GridView& getView(void) const override { return *m_layer_views[m_display_layer]; }
+    void getMemoryUsage(MemoryUsage& mu) const;
 
     static const std::vector<std::vector<sf::Vector3f> >& getPositionLUT(void) { return m_world_positions; }
+    static void buildPositionLUT(void);     /**< Built once by the first (orbital) World, can be built earlier. */
     static unsigned int getWidth(void) { return m_width; }
     static unsigned int getHeight(void) { return m_height; }
     static const unsigned int n_layers = 2;
@@ -57,7 +65,11 @@ private:
     static unsigned int m_width;
     static unsigned int m_height;
     std::vector<MetricsGrid> m_metrics_grids;
-    GridView m_self_view;
+    std::vector<std::shared_ptr<GridView> > m_layer_views;  /**< One view per layer (cells are only recolored when they change). */
+    unsigned int m_display_layer;                           /**< Layer of the last World::display. */
+    unsigned int m_display_lod;                             /**< Pyramid level shown by the views. */
+    std::unique_ptr<WorldPyramid> m_pyramid;                /**< Downsampled layers (display and metrics). */
+    std::mutex m_pyramid_mutex;                             /**< Display and metrics refresh it from different threads. */
     std::vector<std::vector<std::vector<WorldCell> > > m_cells;
     std::vector<std::shared_ptr<Agent> > m_agents;
     std::map<unsigned int, std::tuple<std::string, unsigned int, unsigned int, unsigned int> > m_spots; /* report Idx. -> name, m_cell indices. */
@@ -71,11 +83,18 @@ private:
     unsigned int m_delay_hm;
     unsigned int m_hm_dim_ratio_lng;
     unsigned int m_hm_dim_ratio_lat;
+    unsigned int m_skip_step;                       /* Number of steps skipped since World::beginSkip. */
+    std::vector<unsigned int> m_skip_cell_step;     /* Skipped step up to which each cell has been updated. */
+    std::vector<unsigned int> m_skip_hm_step;       /* Skipped step at which each heatmap flag was last cleared. */
 
     static std::vector<std::vector<sf::Vector3f> > m_world_positions;  /**< Look-up table of world 3D coordinates (ECEF). */
 
+    void createViews(void);
+    template <typename F> void forEachDisplayValue(Layer l, F set_value);
     void updateLayer(Layer l, int x, int y, bool active);
     void updateAllLayers(int x, int y, bool active);
+    void catchUp(int x, int y);
+    bool hasPendingHeatmapUpdate(Layer l, int x, int y, unsigned int t_clear) const;
 };
 
 #endif /* WORLD_HPP */
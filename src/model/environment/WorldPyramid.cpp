@@ -0,0 +1,262 @@
+/***********************************************************************************************//**
+ *  Level-of-detail pyramid of the world revisit times.
+ *  @class      WorldPyramid
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#include "WorldPyramid.hpp"
+#include "MemoryReport.hpp"
+
+WorldPyramid::WorldPyramid(unsigned int w, unsigned int h)
+    : m_width(w)
+    , m_height(h)
+    , m_step(origin)
+    , m_utop_step(w * h, unseen)
+    , m_curr_step(w * h, origin)
+{
+    for(unsigned int k = 1; getWidth(k - 1) > 1 || getHeight(k - 1) > 1; k++) {
+        std::size_t n = (std::size_t)getWidth(k) * getHeight(k);
+        m_levels.push_back(std::vector<Entry>(n, emptyEntry()));
+        m_dirty.push_back(std::vector<unsigned char>(n, 0));
+        m_dirty_list.push_back(std::vector<std::uint32_t>());
+    }
+}
+
+WorldPyramid::Entry WorldPyramid::emptyEntry(void)
+{
+    Entry e;
+    e.count = 0;
+    e.utop_min = unseen;
+    e.utop_max = 0;
+    e.curr_min = unseen;
+    e.curr_max = 0;
+    e.diff_max = 0;
+    e.utop_sum = 0;
+    e.curr_sum = 0;
+    return e;
+}
+
+void WorldPyramid::merge(Entry& e, const Entry& child)
+{
+    e.count += child.count;
+    e.utop_min = std::min(e.utop_min, child.utop_min);
+    e.utop_max = std::max(e.utop_max, child.utop_max);
+    e.curr_min = std::min(e.curr_min, child.curr_min);
+    e.curr_max = std::max(e.curr_max, child.curr_max);
+    e.diff_max = std::max(e.diff_max, child.diff_max);
+    e.utop_sum += child.utop_sum;
+    e.curr_sum += child.curr_sum;
+}
+
+WorldPyramid::Entry WorldPyramid::getCellEntry(unsigned int x, unsigned int y) const
+{
+    Entry e = emptyEntry();
+    std::uint32_t s_utop = m_utop_step[x * m_height + y];
+    if(s_utop != unseen) {
+        std::uint32_t s_curr = m_curr_step[x * m_height + y];
+        e.count = 1;
+        e.utop_min = e.utop_max = s_utop;
+        e.curr_min = e.curr_max = s_curr;
+        e.diff_max = s_utop - s_curr;
+        e.utop_sum = s_utop;
+        e.curr_sum = s_curr;
+    }
+    return e;
+}
+
+WorldPyramid::Entry WorldPyramid::getEntry(unsigned int k, unsigned int x, unsigned int y) const
+{
+    if(k == 0) {
+        return getCellEntry(x, y);
+    }
+    return m_levels[k - 1][x * getHeight(k) + y];
+}
+
+void WorldPyramid::setDirty(unsigned int k, unsigned int x, unsigned int y)
+{
+    std::uint32_t idx = x * getHeight(k) + y;
+    if(!m_dirty[k - 1][idx]) {
+        m_dirty[k - 1][idx] = 1;
+        m_dirty_list[k - 1].push_back(idx);
+    }
+}
+
+void WorldPyramid::visit(unsigned int x, unsigned int y, bool capturing)
+{
+    m_utop_step[x * m_height + y] = m_step;
+    if(capturing) {
+        m_curr_step[x * m_height + y] = m_step;
+    } else {
+        m_curr_step[x * m_height + y]--;
+    }
+    if(!m_levels.empty()) {
+        setDirty(1, x >> 1, y >> 1);
+    }
+}
+
+void WorldPyramid::refresh(void)
+{
+    for(unsigned int k = 1; k <= m_levels.size(); k++) {
+        unsigned int h = getHeight(k);
+        unsigned int w_child = getWidth(k - 1);
+        unsigned int h_child = getHeight(k - 1);
+        for(auto idx : m_dirty_list[k - 1]) {
+            unsigned int x = idx / h;
+            unsigned int y = idx % h;
+            Entry e = emptyEntry();
+            for(unsigned int cx = 2 * x; cx < std::min(2 * x + 2, w_child); cx++) {
+                for(unsigned int cy = 2 * y; cy < std::min(2 * y + 2, h_child); cy++) {
+                    merge(e, getEntry(k - 1, cx, cy));
+                }
+            }
+            m_levels[k - 1][idx] = e;
+            m_dirty[k - 1][idx] = 0;
+            if(k < m_levels.size()) {
+                setDirty(k + 1, x >> 1, y >> 1);
+            }
+        }
+        m_dirty_list[k - 1].clear();
+    }
+}
+
+double WorldPyramid::getAge(unsigned int layer, unsigned int k, unsigned int x, unsigned int y, Aggregate a) const
+{
+    Entry e = getEntry(k, x, y);
+    std::uint32_t s_min, s_max, count;
+    std::uint64_t s_sum;
+    if(layer == 0) {
+        if(e.count == 0) {
+            return -1.0;
+        }
+        s_min = e.utop_min;
+        s_max = e.utop_max;
+        s_sum = e.utop_sum;
+        count = e.count;
+    } else {
+        /* Unseen cells have not been visited in the actual layer either (i.e. last visit at origin): */
+        count = (std::min((x + 1) << k, m_width) - (x << k)) * (std::min((y + 1) << k, m_height) - (y << k));
+        s_min = (e.count < count ? std::min(e.curr_min, origin) : e.curr_min);
+        s_max = (e.count < count ? std::max(e.curr_max, origin) : e.curr_max);
+        s_sum = e.curr_sum + (std::uint64_t)(count - e.count) * origin;
+    }
+    switch(a) {
+        case Aggregate::MIN_VALUE:
+            return (double)(m_step - s_max);
+        case Aggregate::MAX_VALUE:
+            return (double)(m_step - s_min);
+        default:
+            return (double)((std::uint64_t)count * m_step - s_sum) / count;
+    }
+}
+
+WorldPyramid::RegionStats WorldPyramid::getRegionStats(unsigned int x0, unsigned int x1, unsigned int y0,
+    unsigned int y1, std::uint32_t unmet_age) const
+{
+    RegionStats rs = RegionStats();
+    unsigned int k_top = m_levels.size();
+    for(unsigned int x = 0; x < getWidth(k_top); x++) {
+        for(unsigned int y = 0; y < getHeight(k_top); y++) {
+            accumulate(k_top, x, y, x0, x1, y0, y1, unmet_age, rs);
+        }
+    }
+    return rs;
+}
+
+void WorldPyramid::accumulate(unsigned int k, unsigned int x, unsigned int y, unsigned int x0,
+    unsigned int x1, unsigned int y0, unsigned int y1, std::uint32_t unmet_age, RegionStats& rs) const
+{
+    unsigned int cx0 = x << k;
+    unsigned int cy0 = y << k;
+    unsigned int cx1 = std::min((x + 1) << k, m_width);
+    unsigned int cy1 = std::min((y + 1) << k, m_height);
+    if(cx1 <= x0 || cx0 >= x1 || cy1 <= y0 || cy0 >= y1) {
+        return;
+    }
+    Entry e = getEntry(k, x, y);
+    if(e.count == 0) {
+        return;
+    }
+    if(cx0 < x0 || cx1 > x1 || cy0 < y0 || cy1 > y1) {
+        /* Partially inside (never a single cell): */
+        for(unsigned int cx = 2 * x; cx < std::min(2 * x + 2, getWidth(k - 1)); cx++) {
+            for(unsigned int cy = 2 * y; cy < std::min(2 * y + 2, getHeight(k - 1)); cy++) {
+                accumulate(k - 1, cx, cy, x0, x1, y0, y1, unmet_age, rs);
+            }
+        }
+        return;
+    }
+    rs.count += e.count;
+    rs.utop_sum += (std::uint64_t)e.count * m_step - e.utop_sum;
+    rs.curr_sum += (std::uint64_t)e.count * m_step - e.curr_sum;
+    rs.diff_sum += e.utop_sum - e.curr_sum;
+    rs.utop_max = std::max(rs.utop_max, m_step - e.utop_min);
+    rs.curr_max = std::max(rs.curr_max, m_step - e.curr_min);
+    rs.diff_max = std::max(rs.diff_max, e.diff_max);
+    accumulateUnmet(k, x, y, e, true, true, unmet_age, rs);
+}
+
+void WorldPyramid::accumulateUnmet(unsigned int k, unsigned int x, unsigned int y, const Entry& e,
+    bool utop, bool curr, std::uint32_t unmet_age, RegionStats& rs) const
+{
+    /* Layers where all the cells of the entry are either met or unmet are done: */
+    if(utop && m_step - e.utop_max >= unmet_age) {
+        rs.utop_unmet_count += e.count;
+        rs.utop_unmet_sum += (std::uint64_t)e.count * m_step - e.utop_sum;
+        utop = false;
+    } else if(utop && m_step - e.utop_min < unmet_age) {
+        utop = false;
+    }
+    if(curr && m_step - e.curr_max >= unmet_age) {
+        rs.curr_unmet_count += e.count;
+        rs.curr_unmet_sum += (std::uint64_t)e.count * m_step - e.curr_sum;
+        curr = false;
+    } else if(curr && m_step - e.curr_min < unmet_age) {
+        curr = false;
+    }
+    if(!utop && !curr) {
+        return;
+    }
+    if(k <= scan_level) {
+        for(unsigned int cx = (x << k); cx < std::min((x + 1) << k, m_width); cx++) {
+            for(unsigned int cy = (y << k); cy < std::min((y + 1) << k, m_height); cy++) {
+                std::uint32_t s_utop = m_utop_step[cx * m_height + cy];
+                if(s_utop == unseen) {
+                    continue;
+                }
+                std::uint32_t utop_age = m_step - s_utop;
+                std::uint32_t curr_age = m_step - m_curr_step[cx * m_height + cy];
+                if(utop && utop_age >= unmet_age) {
+                    rs.utop_unmet_count++;
+                    rs.utop_unmet_sum += utop_age;
+                }
+                if(curr && curr_age >= unmet_age) {
+                    rs.curr_unmet_count++;
+                    rs.curr_unmet_sum += curr_age;
+                }
+            }
+        }
+        return;
+    }
+    for(unsigned int cx = 2 * x; cx < std::min(2 * x + 2, getWidth(k - 1)); cx++) {
+        for(unsigned int cy = 2 * y; cy < std::min(2 * y + 2, getHeight(k - 1)); cy++) {
+            const Entry& child = m_levels[k - 2][cx * getHeight(k - 1) + cy];
+            if(child.count > 0) {
+                accumulateUnmet(k - 1, cx, cy, child, utop, curr, unmet_age, rs);
+            }
+        }
+    }
+}
+
+std::size_t WorldPyramid::getMemoryFootprint(void) const
+{
+    std::size_t bytes = sizeof(WorldPyramid) + MemoryUsage::bytes(m_utop_step) + MemoryUsage::bytes(m_curr_step);
+    bytes += MemoryUsage::bytes(m_levels) + MemoryUsage::bytes(m_dirty) + MemoryUsage::bytes(m_dirty_list);
+    for(unsigned int k = 0; k < m_levels.size(); k++) {
+        bytes += MemoryUsage::bytes(m_levels[k]) + MemoryUsage::bytes(m_dirty[k]) + MemoryUsage::bytes(m_dirty_list[k]);
+    }
+    return bytes;
+}
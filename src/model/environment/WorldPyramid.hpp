@@ -0,0 +1,129 @@
+/***********************************************************************************************//**
+ *  Level-of-detail pyramid of the world revisit times.
+ *  @class      WorldPyramid
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef WORLD_PYRAMID_HPP
+#define WORLD_PYRAMID_HPP
+
+#include "prot.hpp"
+
+/***********************************************************************************************//**
+ *  Downsampled copies of the two World layers (utopia and actual revisit times). Level 0 has one
+ *  entry per world cell and each entry of level k covers 2x2 entries of level k-1, up to a single
+ *  entry for the whole world. Entries keep the number of cells that have been seen and the min, max
+ *  and sum of their values, so any level can be displayed with a mean, min or max reduction.
+ *
+ *  Instead of revisit times, the pyramid keeps the step at which each cell was last visited. Cells
+ *  age all at once but visit steps only change when cells are visited, which means that entries
+ *  only have to be recomputed above the visited cells (see WorldPyramid::refresh). Ages are given in
+ *  steps (World multiplies them by the time step).
+ *
+ *  Like in World, cells are valid in the utopia layer once they have been seen and are always valid
+ *  in the actual layer. A cell is never visited in the actual layer before the utopia layer (see
+ *  WorldPyramid::visit), hence entries only aggregate seen cells and the actual layer of unseen
+ *  cells is known to have aged since the first step.
+ **************************************************************************************************/
+class WorldPyramid
+{
+public:
+    /*******************************************************************************************//**
+     *  Aggregates of the seen cells in a region (ages in steps). Cells are unmet when their age is
+     *  greater or equal to the threshold given to WorldPyramid::getRegionStats.
+     **********************************************************************************************/
+    struct RegionStats {
+        std::uint64_t count;                    /**< Seen cells. */
+        std::uint64_t utop_sum;
+        std::uint64_t curr_sum;
+        std::uint64_t diff_sum;                 /**< Sum of actual - utopia ages. */
+        std::uint32_t utop_max;
+        std::uint32_t curr_max;
+        std::uint32_t diff_max;
+        std::uint64_t utop_unmet_count;
+        std::uint64_t utop_unmet_sum;
+        std::uint64_t curr_unmet_count;
+        std::uint64_t curr_unmet_sum;
+    };
+
+    WorldPyramid(unsigned int w, unsigned int h);
+
+    /*******************************************************************************************//**
+     *  Advances one step (all cells age by one step).
+     **********************************************************************************************/
+    void step(void) { m_step++; }
+
+    /*******************************************************************************************//**
+     *  Records a visit to cell (x, y) in the current step. The utopia layer is always visited. As in
+     *  World::updateLayer, agents that are not capturing age the actual layer by one more step.
+     **********************************************************************************************/
+    void visit(unsigned int x, unsigned int y, bool capturing);
+
+    /*******************************************************************************************//**
+     *  Recomputes the entries above the cells visited since the last refresh. Must be called before
+     *  reading levels above 0.
+     **********************************************************************************************/
+    void refresh(void);
+
+    /*******************************************************************************************//**
+     *  Age (in steps) of entry (x, y) of level k, reduced with a, or -1 if no cell has been seen
+     *  (utopia layer only).
+     *  @param  layer   0 for the utopia layer, 1 for the actual one (as World::Layer).
+     *  @param  a       One of MIN_VALUE, MAX_VALUE or MEAN_VALUE.
+     **********************************************************************************************/
+    double getAge(unsigned int layer, unsigned int k, unsigned int x, unsigned int y, Aggregate a) const;
+
+    /*******************************************************************************************//**
+     *  Aggregates the seen cells in [x0, x1) x [y0, y1). Entries that lie in the region are only
+     *  descended where they mix met and unmet cells, so the cost depends on the length of the region
+     *  border and of the unmet areas border instead of the area.
+     *  @param  unmet_age   Minimum age of unmet cells (in steps).
+     **********************************************************************************************/
+    RegionStats getRegionStats(unsigned int x0, unsigned int x1, unsigned int y0, unsigned int y1,
+        std::uint32_t unmet_age) const;
+
+    unsigned int getLevels(void) const { return m_levels.size() + 1; }
+    unsigned int getWidth(unsigned int k) const { return (m_width + (1u << k) - 1) >> k; }
+    unsigned int getHeight(unsigned int k) const { return (m_height + (1u << k) - 1) >> k; }
+    std::size_t getMemoryFootprint(void) const;
+
+private:
+    struct Entry {
+        std::uint32_t count;                    /**< Seen cells. */
+        std::uint32_t utop_min;                 /**< Visit steps (min and max) of the seen cells. */
+        std::uint32_t utop_max;
+        std::uint32_t curr_min;
+        std::uint32_t curr_max;
+        std::uint32_t diff_max;                 /**< Max. utopia step - actual step. */
+        std::uint64_t utop_sum;
+        std::uint64_t curr_sum;
+    };
+    static const std::uint32_t unseen = 0xFFFFFFFF;
+    static const std::uint32_t origin = 0x80000000;  /**< First step (visits can push actual steps below it). */
+    static const unsigned int scan_level = 3;   /**< Entries up to this level are scanned cell by cell. */
+
+    unsigned int m_width;
+    unsigned int m_height;
+    std::uint32_t m_step;
+    std::vector<std::uint32_t> m_utop_step;     /**< Level 0: last visit of each cell (column-major). */
+    std::vector<std::uint32_t> m_curr_step;
+    std::vector<std::vector<Entry> > m_levels;  /**< Levels 1 and above (column-major). */
+    std::vector<std::vector<unsigned char> > m_dirty;
+    std::vector<std::vector<std::uint32_t> > m_dirty_list;
+
+    static Entry emptyEntry(void);
+    static void merge(Entry& e, const Entry& child);
+    Entry getCellEntry(unsigned int x, unsigned int y) const;
+    Entry getEntry(unsigned int k, unsigned int x, unsigned int y) const;
+    void setDirty(unsigned int k, unsigned int x, unsigned int y);
+    void accumulate(unsigned int k, unsigned int x, unsigned int y, unsigned int x0, unsigned int x1,
+        unsigned int y0, unsigned int y1, std::uint32_t unmet_age, RegionStats& rs) const;
+    void accumulateUnmet(unsigned int k, unsigned int x, unsigned int y, const Entry& e, bool utop, bool curr,
+        std::uint32_t unmet_age, RegionStats& rs) const;
+};
+
+#endif /* WORLD_PYRAMID_HPP */
@@ -13,19 +13,45 @@
 
 CREATE_LOGGER(BasicInstrument)
 
+const unsigned int BasicInstrument::fp_cache_max_buckets = 8;
+
 BasicInstrument::BasicInstrument(void)
     : BasicInstrument(Random::getUf(Config::agent_aperture_min, Config::agent_aperture_max), -1.f)
 { }
 
 BasicInstrument::BasicInstrument(float aperture, float max_h)
+    : BasicInstrument(aperture, max_h, 0.f, 0.f)
+{
+    m_energy_rate  = Random::getUf(Config::instrument_energy_min, Config::instrument_energy_max);
+    m_storage_rate = Random::getUf(Config::instrument_storage_min, Config::instrument_storage_max);
+}
+
+BasicInstrument::BasicInstrument(float aperture, float max_h, float energy_rate, float storage_rate)
     : m_swath(-1.f)
-    , m_energy_rate(Random::getUf(Config::instrument_energy_min, Config::instrument_energy_max))
-    , m_storage_rate(Random::getUf(Config::instrument_storage_min, Config::instrument_storage_max))
+    , m_energy_rate(energy_rate)
+    , m_storage_rate(storage_rate)
     , m_enabled(false)
 {
+    for(auto& fpc : m_fp_cache) {
+        fpc = std::make_shared<FootprintCache>();
+        fpc->span_hor = 0;
+        fpc->span_ver = 0;
+        fpc->enabled = true;
+    }
     setAperture(aperture, max_h);
 }
 
+void BasicInstrument::setDimensions(EnvModelInfo emi)
+{
+    m_env_info = emi;
+    /* Model templates will be rebuilt (dimensions are checked anyway): */
+    auto fpc = std::make_shared<FootprintCache>();
+    fpc->span_hor = 0;
+    fpc->span_ver = 0;
+    fpc->enabled = true;
+    m_fp_cache[0] = fpc;
+}
+
 void BasicInstrument::setAperture(float ap, float max_h)
 {
     float max_ap = findMaxAperture(max_h);
@@ -195,6 +221,17 @@ void BasicInstrument::applyToDistance3D(
     };
     ox %= lut.size();
     oy %= lut.at(0).size();
+
+    std::vector<FootprintSpan> spans;
+    if(Config::instrument_footprint_cache && getFootprintTemplate(oy, r, world_cells, lut, spans)) {
+        int w = lut.size();
+        for(auto& s : spans) {
+            for(int dx = s.dx0; dx <= s.dx1; dx++) {
+                f((((int)ox + dx) % w + w) % w, s.y);
+            }
+        }
+        return;
+    } /* ... else: use exact geometry. */
     // /*
     check_cell(ox, oy);
     if(!at_r) {
@@ -264,6 +301,89 @@ void BasicInstrument::applyToDistance3D(
     }
 }
 
+bool BasicInstrument::getFootprintTemplate(int oy, double r, bool world_cells,
+    const std::vector<std::vector<sf::Vector3f> >& lut, std::vector<FootprintSpan>& spans) const
+{
+    FootprintCache& cache = *m_fp_cache[world_cells ? 1 : 0];
+    int span_hor = lut.size();
+    int span_ver = lut.at(0).size();
+    double r_res = 1e-3 * 2.0 * Config::pi * Config::earth_radius / span_hor;
+    long int bucket = std::lround(r / r_res);
+    auto key = std::make_pair(bucket, oy);
+
+    std::lock_guard<std::mutex> lock(cache.mtx);
+    if(!cache.enabled) {
+        return false;
+    }
+    if(cache.span_hor != span_hor || cache.span_ver != span_ver) {
+        cache.templates.clear();
+        cache.buckets.clear();
+        cache.span_hor = span_hor;
+        cache.span_ver = span_ver;
+    }
+    auto it = cache.templates.find(key);
+    if(it != cache.templates.end()) {
+        spans = it->second;
+        return true;
+    }
+    if(std::find(cache.buckets.begin(), cache.buckets.end(), bucket) == cache.buckets.end()) {
+        if(cache.buckets.size() >= fp_cache_max_buckets) {
+            Log::dbg << "Instrument footprint radius changes too much (" << r / 1e3 << " km). "
+                << "Footprint templates are disabled.\n";
+            cache.enabled = false;
+            cache.templates.clear();
+            return false;
+        }
+        cache.buckets.push_back(bucket);
+    }
+
+    /*  Build the template with the origin at column 0. Distance grows with the longitude difference
+     *  (for any pair of rows), so each row is a single span around the origin column, and rows are
+     *  contiguous around the origin row.
+     **/
+    double rr = bucket * r_res;
+    std::vector<double> arcs;
+    auto within = [&](int dx) {
+        return arcs[((dx % span_hor) + span_hor) % span_hor] * Config::earth_radius <= rr;
+    };
+    std::vector<FootprintSpan>& tpl = cache.templates[key];
+    for(int dir = 1; dir >= -1; dir -= 2) {
+        for(int y = (dir > 0 ? oy : oy - 1); y >= 0 && y < span_ver; y += dir) {
+            getRowArcs(lut, y, lut.at(0).at(oy), arcs);
+            if(!within(0)) {
+                break;
+            }
+            int hp = 0;
+            int hn = 0;
+            while(hp + 1 < span_hor && within(hp + 1)) {
+                hp++;
+            }
+            while(hp + hn + 1 < span_hor && within(-(hn + 1))) {
+                hn++;
+            }
+            tpl.push_back({y, -hn, hp});
+        }
+    }
+    spans = tpl;
+    return true;
+}
+
+void BasicInstrument::getRowArcs(const std::vector<std::vector<sf::Vector3f> >& lut, int y, sf::Vector3f o,
+    std::vector<double>& arcs)
+{
+    switch(Config::instrument_precision) {
+        case GeometryPrecision::FLOAT:
+            getRowArcsAs<float>(lut, y, o, arcs);
+            break;
+        case GeometryPrecision::DOUBLE:
+            getRowArcsAs<double>(lut, y, o, arcs);
+            break;
+        case GeometryPrecision::LONG_DOUBLE:
+            getRowArcsAs<long double>(lut, y, o, arcs);
+            break;
+    }
+}
+
 std::vector<sf::Vector2i> BasicInstrument::getVisibleCells(
     const std::vector<std::vector<sf::Vector3f> >& lut,
     double dist, sf::Vector3f position,
@@ -355,36 +475,130 @@ std::vector<sf::Vector2i> BasicInstrument::getVisibleCellsFromTo(const std::vect
 {
     if(Config::interpos < 2) {
         return getVisibleCells(lut, getSwath(p1, ap) / 2.f, p1, world_cells, t1);
-    } else {
-        sf::Vector3f pi;
-        auto dvec = (p1 - p0) / ((float)Config::interpos - 1.f);
-        std::vector<sf::Vector3f> posit_interp;
-        std::vector<float> swath_interp;
-        posit_interp.push_back(p0);
-        swath_interp.push_back(getSwath(p0, ap));
-        pi = p0;
-        int pcount = 1;
-        while(pcount < (Config::interpos - 1)) {
-            pi += dvec;
-            pcount++;
-            posit_interp.push_back(pi);
-            swath_interp.push_back(getSwath(pi, ap));
+    }
+    if(Config::motion_model != AgentMotionType::ORBITAL) {
+        Log::err << "Computing visible cells in motion type different than ORBITAL is deprecated.\n";
+        throw std::runtime_error("Computing visible cells in motion type different than ORBITAL is deprecated.");
+    }
+    typedef sf::Vector3<double> Vec3d;
+    auto unitary = [](sf::Vector3f v) {
+        Vec3d vd(v.x, v.y, v.z);
+        return vd / std::sqrt(vd.x * vd.x + vd.y * vd.y + vd.z * vd.z);
+    };
+    auto dot = [](const Vec3d& a, const Vec3d& b) { return a.x * b.x + a.y * b.y + a.z * b.z; };
+    auto cross = [](const Vec3d& a, const Vec3d& b) {
+        return Vec3d(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    };
+    auto arc = [&dot](const Vec3d& a, const Vec3d& b) { return std::acos(std::max(-1.0, std::min(1.0, dot(a, b)))); };
+
+    /* Ground track segment (sub-satellite points, in ECEF) and footprint radius at both ends: */
+    Vec3d g0 = unitary(CoordinateSystemUtils::fromECIToECEF(p0, t0));
+    Vec3d g1 = unitary(CoordinateSystemUtils::fromECIToECEF(p1, t1));
+    double r0 = getSwath(p0, ap) / 2.0 / Config::earth_radius;      /* In radians. */
+    double r1 = getSwath(p1, ap) / 2.0 / Config::earth_radius;      /* In radians. */
+    double theta = arc(g0, g1);
+    Vec3d n = cross(g0, g1);
+    double n_norm = std::sqrt(dot(n, n));
+    bool is_point = (n_norm < 1e-12);
+    if(!is_point) {
+        n /= n_norm;
+    }
+
+    int span_hor = lut.size();
+    int span_ver = lut.at(0).size();
+    auto wrap = [span_hor](int x) { return ((x % span_hor) + span_hor) % span_hor; };
+    auto within = [&](int x, int y) {
+        const sf::Vector3f& sf_s = lut[wrap(x)][y];
+        Vec3d s = unitary(sf_s);
+        double d, u;
+        double a = -1.0;
+        if(!is_point) {
+            /* Angle from g0 to the projection of s on the great circle of the track: */
+            Vec3d q = s - n * dot(s, n);
+            a = std::atan2(dot(cross(g0, q), n), dot(g0, q));
         }
-        posit_interp.push_back(p1);
-        swath_interp.push_back(getSwath(p1, ap));
-
-        std::unordered_set<sf::Vector2i, Vector2iHash> retset;
-        double ti = t0;
-        double dt = (t1 - t0) / (double)(posit_interp.size() - 1);
-        for(unsigned int j = 0; j < posit_interp.size(); j++) {
-            auto fpj = getVisibleCells(lut, swath_interp[j] / 2.f, posit_interp[j], world_cells, ti);
-            for(auto& fp_cell : fpj) {
-                retset.insert(fp_cell);
+        if(!is_point && a >= 0.0 && a <= theta) {
+            d = std::asin(std::min(1.0, std::abs(dot(s, n))));
+            u = a / theta;
+        } else {
+            double d0 = arc(s, g0);
+            double d1 = arc(s, g1);
+            d = std::min(d0, d1);
+            u = (d0 <= d1 ? 0.0 : 1.0);
+        }
+        return d <= r0 + u * (r1 - r0);
+    };
+
+    /* Columns and rows of the LUT are uniform in geographic longitude and latitude: */
+    auto toColumn = [span_hor](const Vec3d& g) {
+        double lng = MathUtils::radToDeg(std::atan2(g.y, g.x));
+        return (int)std::lround((lng + 180.0) * span_hor / 360.0);
+    };
+    auto toRow = [span_ver](const Vec3d& g) {
+        double lat = MathUtils::radToDeg(std::asin(std::max(-1.0, std::min(1.0, g.z))));
+        return std::max(0, std::min(span_ver - 1, (int)std::lround((90.0 - lat) * span_ver / 180.0)));
+    };
+    int x0 = toColumn(g0);
+    int x1 = toColumn(g1);
+    int y0 = toRow(g0);
+    int y1 = toRow(g1);
+    int dx01 = wrap(x1 - x0);
+    if(dx01 > span_hor / 2) {
+        dx01 -= span_hor;           /* Shortest way in longitude. */
+    }
+
+    /*  For every row, spans are grown from the columns where the track (or its ends) are, while
+     *  cells are within the swept area. Returns false if no cell in that row is.
+     **/
+    std::vector<sf::Vector2i> retvec;
+    auto rasterRow = [&](int y) {
+        std::vector<int> seeds = { x0, x0 + dx01 };
+        if(y0 != y1 && (y - y0) * (y - y1) <= 0) {
+            seeds.push_back(x0 + (int)std::lround((double)dx01 * (y - y0) / (y1 - y0)));
+        }
+        std::vector<std::pair<int, int> > spans;
+        for(int c : seeds) {
+            bool covered = false;
+            for(auto& sp : spans) {
+                covered |= (c >= sp.first && c <= sp.second);
+            }
+            if(covered || !within(c, y)) {
+                continue;
+            }
+            int hp = 0;
+            int hn = 0;
+            while(hp + 1 < span_hor && within(c + hp + 1, y)) {
+                hp++;
             }
-            ti += dt;
+            while(hp + hn + 1 < span_hor && within(c - hn - 1, y)) {
+                hn++;
+            }
+            spans.push_back(std::make_pair(c - hn, c + hp));
         }
-        return std::vector<sf::Vector2i>(retset.begin(), retset.end());
+        for(auto& sp : spans) {
+            for(int x = sp.first; x <= sp.second; x++) {
+                retvec.push_back(sf::Vector2i(wrap(x), y));
+            }
+        }
+        return spans.size() > 0;
+    };
+    int ymin = std::min(y0, y1);
+    int ymax = std::max(y0, y1);
+    for(int y = ymin; y <= ymax; y++) {
+        rasterRow(y);
     }
+    for(int y = ymin - 1; y >= 0 && rasterRow(y); y--) { }
+    for(int y = ymax + 1; y < span_ver && rasterRow(y); y++) { }
+
+    /* Spans grown from different seeds may overlap: */
+    auto cmp = [](const sf::Vector2i& a, const sf::Vector2i& b) { return (a.y < b.y) || (a.y == b.y && a.x < b.x); };
+    std::sort(retvec.begin(), retvec.end(), cmp);
+    retvec.erase(std::unique(retvec.begin(), retvec.end()), retvec.end());
+    if(retvec.empty()) {
+        /* Same as BasicInstrument::getVisibleCells, provide (at least) the cell under the agent: */
+        retvec.push_back(sf::Vector2i(wrap(x1), y1));
+    }
+    return retvec;
 }
 
 float BasicInstrument::getSlantRangeAt(long double deg, sf::Vector3f p) const
@@ -397,12 +611,23 @@ float BasicInstrument::getSlantRangeAt(long double deg, sf::Vector3f p) const
      **/
     long double ang_rad = MathUtils::degToRad(std::fmod((long double)deg, 180.0L));
     long double h = MathUtils::norm(sf::Vector3<long double>(p.x, p.y, p.z));
-    long double lambda = Config::pi - std::asin((h / Config::earth_wgs84_a) * std::sin(ang_rad));
-    long double alpha  = Config::pi - lambda - ang_rad;
-    long double sr = Config::earth_wgs84_a * std::sin(alpha) / std::sin(ang_rad);
+    long double sr;
+    switch(Config::instrument_precision) {
+        case GeometryPrecision::FLOAT:
+            sr = GeometryKernels::slantRange<float>(ang_rad, h, Config::earth_wgs84_a);
+            break;
+        case GeometryPrecision::DOUBLE:
+            sr = GeometryKernels::slantRange<double>(ang_rad, h, Config::earth_wgs84_a);
+            break;
+        default:
+            sr = GeometryKernels::slantRange<long double>(ang_rad, h, Config::earth_wgs84_a);
+            break;
+    }
     if(std::isnan(sr) || sr <= 1.0) {
         Log::err << "Computing slant range gave \'" << sr << "\' for instrument at " << deg << "º\n";
         Log::err << "  h = " << h << " meters.\n";
+        long double alpha  = GeometryKernels::footprintArc(ang_rad, h, Config::earth_wgs84_a);
+        long double lambda = Config::pi - alpha - ang_rad;
         Log::err << "  (h/R)·sin(ẟ) = " << (h / Config::earth_wgs84_a) * std::sin(ang_rad) << ".\n";
         Log::err << "  ẟ = " << deg << "º = " << ang_rad << " rad.\n";
         Log::err << "  λ = " << MathUtils::radToDeg(lambda) << "º = " << lambda << " rad.\n";
@@ -419,11 +644,21 @@ float BasicInstrument::getSwath(sf::Vector3f p, float aperture) const
     if(Config::motion_model != AgentMotionType::ORBITAL) {
         Log::warn << "Attempting to compute instrument swath for a 2-d motion model.\n";
     }
-    float ang_rad = MathUtils::degToRad(std::fmod(aperture, 180.f)) / 2.f;
-    float h = MathUtils::norm(p);
-    float lambda = Config::pi - std::asin((h / Config::earth_wgs84_a) * std::sin(ang_rad));
-    float alpha  = Config::pi - lambda - ang_rad;
-    return 2.f * alpha * Config::earth_wgs84_a;
+    long double ang_rad = MathUtils::degToRad(std::fmod(aperture, 180.f)) / 2.0L;
+    long double h = MathUtils::norm(sf::Vector3<long double>(p.x, p.y, p.z));
+    long double alpha;
+    switch(Config::instrument_precision) {
+        case GeometryPrecision::FLOAT:
+            alpha = GeometryKernels::footprintArc<float>(ang_rad, h, Config::earth_wgs84_a);
+            break;
+        case GeometryPrecision::DOUBLE:
+            alpha = GeometryKernels::footprintArc<double>(ang_rad, h, Config::earth_wgs84_a);
+            break;
+        default:
+            alpha = GeometryKernels::footprintArc<long double>(ang_rad, h, Config::earth_wgs84_a);
+            break;
+    }
+    return 2.0L * alpha * Config::earth_wgs84_a;
 }
 
 std::vector<sf::Vector2f> BasicInstrument::getFootprint(void) const
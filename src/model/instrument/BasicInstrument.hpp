@@ -19,6 +19,16 @@
 #include "Random.hpp"
 #include "Utils.hpp"
 #include "MathUtils.hpp"
+#include "GeometryKernels.hpp"
+
+/*  A row of cells of a footprint: cells (ox + dx0, y) to (ox + dx1, y), where ox is the column of the
+ *  footprint origin. Columns wrap around in longitude.
+ **/
+struct FootprintSpan {
+    int y;          /* Row. */
+    int dx0;        /* First column, relative to the origin. */
+    int dx1;        /* Last column, relative to the origin (inclusive). */
+};
 
 /***********************************************************************************************//**
  *  Nadir-looking instrument with circular footprint. This instrument is defined with an aperture
@@ -49,6 +59,17 @@ public:
      **********************************************************************************************/
     BasicInstrument(float aperture, float max_h);
 
+    /*******************************************************************************************//**
+     *  Creates a BasicInstrument with the given aperture and resource rates. Unlike the other
+     *  constructors, this one does not draw any random number (i.e. it does not modify the state of
+     *  Random) and can be used concurrently.
+     *  @param  aperture        See BasicInstrument(float, float).
+     *  @param  max_h           See BasicInstrument(float, float).
+     *  @param  energy_rate     Energy consumption rate.
+     *  @param  storage_rate    Storage consumption rate.
+     **********************************************************************************************/
+    BasicInstrument(float aperture, float max_h, float energy_rate, float storage_rate);
+
     /*******************************************************************************************//**
      *  Enable the instrument. This is just a setter for an internal attribute and does not modify
      *  the behaviour of the class.
@@ -83,7 +104,7 @@ public:
      *  model cells.
      *  @param  emi     The environment model information for the Agent that owns this instrument.
      **********************************************************************************************/
-    void setDimensions(EnvModelInfo emi) override { m_env_info = emi; }
+    void setDimensions(EnvModelInfo emi) override;
 
     /*******************************************************************************************//**
      *  Update the position of the instrument.
@@ -139,10 +160,12 @@ public:
         bool world_cells = false) const override;
 
     /*******************************************************************************************//**
-     *  Computes visible cells for an instrument that is traveling from point p0 to point p0 and has
-     *  aperture ap. Position points are interpolated according to configuration parameters of the
-     *  simulation. Footprint is computed as visible cells of that instrument at every position step
-     *  (cells with r <= swath/2).
+     *  Computes visible cells for an instrument that is traveling from point p0 to point p1 and has
+     *  aperture ap. The footprint is the area swept by the instrument: cells whose great-circle
+     *  distance to the ground track segment (i.e. the arc between the sub-satellite points at t0
+     *  and t1) is within swath/2. Swath is interpolated linearly along the segment. This is
+     *  rasterised row by row, without interpolating positions. If Config::interpos is lower than 2,
+     *  only the footprint at p1 is computed.
      *  @param  lut         A look-up table of the ECEF position of every world or model cell.
      *  @param  ap          Instrument aperture.
      *  @param  p0          Initial position.
@@ -226,6 +249,21 @@ private:
     sf::Vector3f m_position;    /**< Current position of the instrument. */
     bool m_enabled;             /**< Whether the instrument is enabled (true) or not (false). */
 
+    /*  Footprint templates. Visible cells are those whose great-circle distance to the origin cell
+     *  is lower than the radius, hence (up to a shift in longitude) they only depend on the row of
+     *  the origin and the radius. Radius values are quantised in buckets.
+     **/
+    struct FootprintCache {
+        std::mutex mtx;
+        int span_hor;                       /* Number of columns the templates were built for. */
+        int span_ver;                       /* Number of rows the templates were built for. */
+        bool enabled;                       /* False if the radius has changed too much. */
+        std::vector<long int> buckets;      /* Radius buckets found so far. */
+        std::map<std::pair<long int, int>, std::vector<FootprintSpan> > templates;  /* (bucket, row). */
+    };
+    std::shared_ptr<FootprintCache> m_fp_cache[2];  /**< Footprint templates for model (0) and world (1) cells. */
+    static const unsigned int fp_cache_max_buckets; /**< Max. number of radius buckets to cache. */
+
     /* Parameters related to number of points in footprint */
     const int m_min_fp_points = 20;
     const int m_max_fp_points = 100;
@@ -279,8 +317,56 @@ private:
     void applyToDistance3D(unsigned int ox, unsigned int oy, sf::Vector3f p, double t, double r, bool world_cells = false,
         std::function<void(unsigned int, unsigned int)> f = [](unsigned int, unsigned int) { },
         const std::vector<std::vector<sf::Vector3f> >& lut = { }) const;
+
+    /*******************************************************************************************//**
+     *  Gets the footprint template for an origin in row `oy` and radius `r`, which is built (and
+     *  cached) from the look-up table the first time. Radius is quantised to 1/1000 of the width
+     *  of a cell at the Equator. Templates are no longer used (and this function returns false)
+     *  once more than BasicInstrument::fp_cache_max_buckets radius buckets are requested, which
+     *  happens when the altitude of the orbit changes (i.e. it is not near-circular).
+     *  @param  oy          Row of the footprint origin.
+     *  @param  r           The distance (in meters).
+     *  @param  world_cells Whether to use world pixels or model cell units.
+     *  @param  lut         A pre-computed look-up table of positions in ECEF for every cell.
+     *  @param  spans       Output: the footprint, as row spans relative to the origin column.
+     *  @return True if the template could be used, false if exact geometry should be used.
+     **********************************************************************************************/
+    bool getFootprintTemplate(int oy, double r, bool world_cells, const std::vector<std::vector<sf::Vector3f> >& lut,
+        std::vector<FootprintSpan>& spans) const;
+
+    /*******************************************************************************************//**
+     *  Computes the great-circle arc (in radians) between `o` and every cell in row `y` of the
+     *  look-up table, using the batch kernels with the precision set in Config::instrument_precision.
+     *  @param  lut         A pre-computed look-up table of positions in ECEF for every cell.
+     *  @param  y           The row.
+     *  @param  o           The origin, in ECEF.
+     *  @param  arcs        Output: one arc per column.
+     **********************************************************************************************/
+    static void getRowArcs(const std::vector<std::vector<sf::Vector3f> >& lut, int y, sf::Vector3f o,
+        std::vector<double>& arcs);
+
+    template <class T>
+    static void getRowArcsAs(const std::vector<std::vector<sf::Vector3f> >& lut, int y, sf::Vector3f o,
+        std::vector<double>& arcs);
 };
 
+template <class T>
+void BasicInstrument::getRowArcsAs(const std::vector<std::vector<sf::Vector3f> >& lut, int y, sf::Vector3f o,
+    std::vector<double>& arcs)
+{
+    std::size_t n = lut.size();
+    Vec3Array<T> s;
+    s.resize(n);
+    for(std::size_t x = 0; x < n; x++) {
+        sf::Vector3<T> v(lut[x][y].x, lut[x][y].y, lut[x][y].z);
+        s.set(x, v / MathUtils::norm(v));
+    }
+    sf::Vector3<T> ou(o.x, o.y, o.z);
+    std::vector<T> out(n);
+    GeometryKernels::arc(ou / MathUtils::norm(ou), s.x.data(), s.y.data(), s.z.data(), n, out.data());
+    arcs.assign(out.begin(), out.end());
+}
+
 #include "AgentMotion.hpp"
 
 
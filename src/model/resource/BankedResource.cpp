@@ -0,0 +1,75 @@
+/***********************************************************************************************//**
+ *  Adapter of one entry of a resource bank to the Resource interface.
+ *  @class      BankedResource
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-27
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#include "BankedResource.hpp"
+#include "Activity.hpp"
+
+CREATE_LOGGER(BankedResource)
+
+const ActivityHandle BankedResource::undefined_rate;
+
+BankedResource::BankedResource(std::shared_ptr<ResourceBank> bank, std::size_t idx)
+    : m_bank(bank)
+    , m_index(idx)
+{ }
+
+BankedResource::BankedResource(const BankedResource& other)
+    : m_bank(std::make_shared<ResourceBank>(*other.m_bank))
+    , m_index(other.m_index)
+    , m_rates(other.m_rates)
+{ }
+
+void BankedResource::addRate(double dc, Activity* ptr)
+{
+    ActivityHandle rate_id = (ptr == nullptr ? undefined_rate : ptr->getHandle());
+    auto it = m_rates.find(rate_id);
+    if(it != m_rates.end()) {
+        /* Replaces the previous rate of this activity: */
+        m_bank->removeRate(it->second);
+        it->second = m_bank->addRate(m_index, dc);
+    } else {
+        m_rates[rate_id] = m_bank->addRate(m_index, dc);
+    }
+}
+
+void BankedResource::removeRate(Activity* ptr)
+{
+    ActivityHandle rate_id = (ptr == nullptr ? undefined_rate : ptr->getHandle());
+    auto it = m_rates.find(rate_id);
+    if(it != m_rates.end()) {
+        m_bank->removeRate(it->second);
+        m_rates.erase(it);
+    } else {
+        Log::err << "Could not remove resource consumption rate for activity " << getRateName(rate_id)
+            << " and resource \'" << getName() << "\'.\n";
+    }
+}
+
+void BankedResource::step(void)
+{
+    if(m_bank->step(m_index, Config::time_step) == ResourceStatus::VIOLATED) {
+        throw std::runtime_error("Resource capacity exceeded.");
+    }
+}
+
+void BankedResource::showStatus(void) const
+{
+    Log::dbg << "Resource status [" << getName() << "]: capacity is " << getCapacity() << "/" << getMaxCapacity()
+        << " (" << std::fixed << std::setprecision(0) << (100.f * getCapacity() / getMaxCapacity()) << "%). Active rates: " << m_rates.size() << ".\n";
+    for(auto& r : m_rates) {
+        Log::dbg << " # " << getRateName(r.first) << " -> " << std::defaultfloat << m_bank->getRate(r.second) << ".\n";
+    }
+    Log::dbg << std::defaultfloat;
+}
+
+std::string BankedResource::getRateName(ActivityHandle h) const
+{
+    return (h == undefined_rate ? std::string("undefined") : IdRegistry::toString(h));
+}
@@ -0,0 +1,62 @@
+/***********************************************************************************************//**
+ *  Adapter of one entry of a resource bank to the Resource interface.
+ *  @class      BankedResource
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-27
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef BANKED_RESOURCE_HPP
+#define BANKED_RESOURCE_HPP
+
+#include "prot.hpp"
+#include <unordered_map>
+#include "Resource.hpp"
+#include "ResourceBank.hpp"
+#include "IdRegistry.hpp"
+
+class Activity;
+class Agent;
+
+/***********************************************************************************************//**
+ *  Resource whose state is stored in a ResourceBank, which may be shared with other resources
+ *  (e.g. all the resources of an agent, stepped at once by Agent::consume). Rates are identified
+ *  by the handle of their activity. Copies (see Resource::clone) own a copy of the bank.
+ **************************************************************************************************/
+class BankedResource : public Resource
+{
+public:
+    BankedResource(std::shared_ptr<ResourceBank> bank, std::size_t idx);
+    BankedResource(const BankedResource& other);
+
+    double getCapacity(void) const override { return m_bank->getCapacity(m_index); }
+    double getMaxCapacity(void) const override { return m_bank->getMaxCapacity(m_index); }
+    double getReservedCapacity(void) const override { return m_bank->getReservedCapacity(m_index); }
+    void setMaxCapacity(double c) override { m_bank->setMaxCapacity(m_index, c); }
+    void setReservedCapacity(double c) override { m_bank->setReservedCapacity(m_index, c); }
+    void applyOnce(double c) override { m_bank->applyOnce(m_index, c); }
+    bool applyFor(double c, double t, bool verbose = false) override { return m_bank->applyFor(m_index, c, t, verbose); }
+    bool isFull(void) const override { return getCapacity() == getMaxCapacity(); }
+    bool isEmpty(void) const override { return getCapacity() == 0.f; }
+    bool tryApplyOnce(double c) const override { return m_bank->tryApplyOnce(m_index, c); }
+    void addRate(double dc, Activity* ptr) override;
+    void removeRate(Activity* ptr) override;
+    void setName(std::string name) override { m_bank->setName(m_index, name); }
+    std::string getName(void) const override { return m_bank->getName(m_index); }
+    void showStatus(void) const override;
+
+    void step(void) override;
+
+    static const ActivityHandle undefined_rate = ~(ActivityHandle)0;     /**< Key of rates without activity. */
+
+protected:
+    std::shared_ptr<ResourceBank> m_bank;
+    std::size_t m_index;                                                /**< Entry in m_bank. */
+    std::unordered_map<ActivityHandle, ResourceBank::RateHandle> m_rates;
+
+    std::string getRateName(ActivityHandle h) const;
+};
+
+#endif /* BANKED_RESOURCE_HPP */
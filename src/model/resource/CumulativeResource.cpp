@@ -9,7 +9,7 @@
  **************************************************************************************************/
 
 #include "CumulativeResource.hpp"
-#include "Agent.hpp"
+#include "Activity.hpp"
 
 CREATE_LOGGER(CumulativeResource)
 
@@ -22,129 +22,16 @@ CumulativeResource::CumulativeResource(Agent* aptr, std::string name, double c)
 { }
 
 CumulativeResource::CumulativeResource(Agent* aptr, std::string name, double c, double c_init)
-    : m_max_capacity(c)
-    , m_capacity(c_init)
-    , m_name(name)
-    , m_instantaneous(0.f)
-    , m_agent(aptr)
-    , m_reserved_capacity(0.f)
-{ }
-
-void CumulativeResource::setMaxCapacity(double c)
-{
-    if(c < m_capacity) {
-        Log::err << "[Agent " << m_agent->getId() << ":" << m_name << "] Changing maximum \'" << m_name << "\' capacity to " << c << " failed.\n";
-        throw std::runtime_error("Resource capacity error (1).");
-    }
-    m_max_capacity = c;
-}
-
-void CumulativeResource::setReservedCapacity(double c)
-{
-    if(c > m_capacity) {
-        Log::err << "[Agent " << m_agent->getId() << ":" << m_name << "] Changing reserved \'" << m_name << "\' capacity to " << c << " failed.\n";
-        throw std::runtime_error("Resource capacity error (2).");
-    }
-    m_reserved_capacity = c;
-}
-
-bool CumulativeResource::tryApplyOnce(double c) const
-{
-    double acc = 0.f;
-    for(auto& r : m_rates) {
-        acc += r.second;
-    }
-    acc += m_instantaneous;
-    return acc + c <= m_max_capacity - m_reserved_capacity;
-}
-
-void CumulativeResource::applyOnce(double c)
-{
-    m_instantaneous += c;
-}
-
-bool CumulativeResource::applyFor(double c, double t, bool verbose)
+    : BankedResource(std::make_shared<ResourceBank>(aptr), 0)
 {
-    if(t <= 0) {
-        return true;
-    }
-    double acc = c + m_instantaneous;
-    for(auto& r : m_rates) {
-        acc += r.second;
-    }
-    m_capacity -= acc * t;
-    if(m_capacity >= m_reserved_capacity) {
-        if(m_capacity > m_max_capacity) {
-            m_capacity = m_max_capacity;
-        }
-        return true;
-    } else {
-        if(verbose) {
-            Log::err << "Full depletion applying c = " << c << " for t = " << t << ". Resulting capacity would be " << m_capacity << "\n";
-        }
-        m_capacity = m_reserved_capacity;
-        return false;
-    }
-}
-
-void CumulativeResource::addRate(double dc, Activity* ptr)
-{
-    std::string rate_id;
-    if(ptr == nullptr) {
-        rate_id = "undefined";
-    } else {
-        rate_id = ptr->getAgentId() + ":" + std::to_string(ptr->getId());
-    }
-    m_rates[rate_id] = dc;
-}
-
-void CumulativeResource::removeRate(Activity* ptr)
-{
-    std::string rate_id;
-    if(ptr == nullptr) {
-        rate_id = "undefined";
-    } else {
-        rate_id = ptr->getAgentId() + ":" + std::to_string(ptr->getId());
-    }
-    auto it = m_rates.find(rate_id);
-    if(it != m_rates.end()) {
-        m_rates.erase(it);
-    } else {
-        Log::err << "Could not remove resource consumption rate for activity " << rate_id << " and resource \'" << m_name << "\'.\n";
-    }
-}
-
-void CumulativeResource::step(void)
-{
-    double acc = 0.f;
-    for(auto& r : m_rates) {
-        acc += r.second * Config::time_step;
-    }
-    acc += m_instantaneous * Config::time_step;
-    // Log::dbg << "================== Resource capacity at " << VirtualTime::toString(VirtualTime::now()) << " is "
-    //     << std::fixed << std::setprecision(12) << m_capacity << "\n";
-    if(acc > m_capacity - m_reserved_capacity) {
-        Log::err << "[Agent " << m_agent->getId() << ":" << m_name << "] Trying to consume ["
-            << m_capacity << "-]" << acc << " would result in negative capacity.\n";
-        throw std::runtime_error("Resource capacity exceeded.");
-    } else if(m_capacity - acc > m_max_capacity) {
-        m_capacity = m_max_capacity;
-    } else if(m_capacity - m_reserved_capacity == acc) {
-        Log::warn << "[Agent " << m_agent->getId() << ":" << m_name << "] Agent has depleted its resource completely (last consumption: "
-            << acc << ").\n";
-        m_capacity -= acc;
-    } else {
-        m_capacity -= acc;
-    }
-    m_instantaneous = 0.f;
+    m_index = m_bank->add(ResourceKind::CUMULATIVE, name, c, c_init);
 }
 
-void CumulativeResource::showStatus(void) const
+CumulativeResource::CumulativeResource(std::shared_ptr<ResourceBank> bank, std::size_t idx)
+    : BankedResource(bank, idx)
 {
-    Log::dbg << "Resource status [" << m_name << "]: capacity is " << m_capacity << "/" << m_max_capacity
-        << " (" << std::fixed << std::setprecision(0) << (100.f * m_capacity / m_max_capacity) << "%). Active rates: " << m_rates.size() << ".\n";
-    for(auto& r : m_rates) {
-        Log::dbg << " # " << r.first << " -> " << std::defaultfloat << r.second << ".\n";
+    if(bank->getKind(idx) != ResourceKind::CUMULATIVE) {
+        Log::err << "Resource \'" << bank->getName(idx) << "\' is not of the expected kind.\n";
+        throw std::runtime_error("Wrong resource kind.");
     }
-    Log::dbg << std::defaultfloat;
 }
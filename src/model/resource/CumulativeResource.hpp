@@ -12,47 +12,25 @@
 #define CUMULATIVE_RESOURCE_HPP
 
 #include "prot.hpp"
-#include "Resource.hpp"
+#include "BankedResource.hpp"
 #include "Random.hpp"
 
 class Activity;
 class Agent;
 
-class CumulativeResource : public Resource
+class CumulativeResource : public BankedResource
 {
 public:
     CumulativeResource(Agent* aptr, std::string name, double max_a, double max_b, double c_init_a, double c_init_b);
     CumulativeResource(Agent* aptr, std::string name, double c, double c_init);
     CumulativeResource(Agent* aptr, std::string name, double c);
 
-    double getCapacity(void) const override { return m_capacity; }
-    double getMaxCapacity(void) const override { return m_max_capacity; }
-    double getReservedCapacity(void) const override { return m_reserved_capacity; }
-    void setMaxCapacity(double c) override;
-    void setReservedCapacity(double c) override;
-    void applyOnce(double c) override;
-    bool applyFor(double c, double t, bool verbose = false);
-    bool isFull(void) const override { return m_capacity == m_max_capacity; }
-    bool isEmpty(void) const override { return m_capacity == 0.f; }
-    bool tryApplyOnce(double c) const override;
-    void addRate(double dc, Activity* ptr) override;
-    void removeRate(Activity* ptr) override;
-    void setName(std::string name) override { m_name = name; }
-    std::string getName(void) const override { return m_name; }
-    CumulativeResource* clone(void) const override { return new CumulativeResource(*this); }
-    void showStatus(void) const;
-
-    void step(void) override;
+    /*******************************************************************************************//**
+     *  Adapts the entry `idx` of `bank`, which has to be of kind ResourceKind::CUMULATIVE.
+     **********************************************************************************************/
+    CumulativeResource(std::shared_ptr<ResourceBank> bank, std::size_t idx);
 
-private:
-    double m_capacity;
-    double m_max_capacity;
-    double m_reserved_capacity;
-    Agent* m_agent;
-    std::string m_name;
-    double m_instantaneous;
-
-    std::map<std::string, double> m_rates;
+    CumulativeResource* clone(void) const override { return new CumulativeResource(*this); }
 };
 
 #endif /* CUMULATIVE_RESOURCE_HPP */
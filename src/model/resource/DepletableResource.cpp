@@ -9,7 +9,7 @@
  **************************************************************************************************/
 
 #include "DepletableResource.hpp"
-#include "Agent.hpp"
+#include "Activity.hpp"
 
 CREATE_LOGGER(DepletableResource)
 
@@ -20,116 +20,28 @@ DepletableResource::DepletableResource(Agent* aptr, std::string name, double max
 DepletableResource::DepletableResource(Agent* aptr, std::string name, double c)
     : DepletableResource(aptr, name, c, (c / 2.f))
 { }
-DepletableResource::DepletableResource(Agent* aptr, std::string name, double c, double c_init)
-    : m_max_capacity(c)
-    , m_capacity(c_init)
-    , m_name(name)
-    , m_instantaneous(0.f)
-    , m_agent(aptr)
-    , m_reserved_capacity(0.f)
-{ }
 
-void DepletableResource::setMaxCapacity(double c)
-{
-    if(c < m_capacity) {
-        Log::err << "[Agent " << m_agent->getId() << ":" << m_name << "] Changing maximum capacity failed.\n";
-        throw std::runtime_error("Resource capacity error.");
-    }
-    m_max_capacity = c;
-}
-
-bool DepletableResource::tryApplyOnce(double c) const
-{
-    double acc = 0.f;
-    for(auto& r : m_rates) {
-        acc += r.second;
-    }
-    acc += m_instantaneous + c;
-    return acc <= m_max_capacity - m_reserved_capacity;
-}
-
-void DepletableResource::applyOnce(double c)
+DepletableResource::DepletableResource(Agent* aptr, std::string name, double c, double c_init)
+    : BankedResource(std::make_shared<ResourceBank>(aptr), 0)
 {
-    m_instantaneous += c;
+    m_index = m_bank->add(ResourceKind::DEPLETABLE, name, c, c_init);
 }
 
-bool DepletableResource::applyFor(double c, double t, bool /* verbose */)
+DepletableResource::DepletableResource(std::shared_ptr<ResourceBank> bank, std::size_t idx)
+    : BankedResource(bank, idx)
 {
-    if(t <= 0) {
-        return true;
-    }
-
-    double acc = c + m_instantaneous;
-    for(auto& r : m_rates) {
-        acc += r.second;
-    }
-    if(m_max_capacity - acc - m_instantaneous >= m_reserved_capacity) {
-        m_capacity = m_max_capacity - acc - m_instantaneous;
-        return true;
-    } else {
-        m_capacity = m_reserved_capacity;
-        return false;
+    if(bank->getKind(idx) != ResourceKind::DEPLETABLE) {
+        Log::err << "Resource \'" << bank->getName(idx) << "\' is not of the expected kind.\n";
+        throw std::runtime_error("Wrong resource kind.");
     }
 }
 
 void DepletableResource::addRate(double dc, Activity* ptr)
 {
-    std::string rate_id;
-    if(ptr == nullptr) {
-        rate_id = "undefined";
-    } else {
-        rate_id = ptr->getAgentId() + ":" + std::to_string(ptr->getId());
-    }
     if(dc > 0.f) {
-        m_rates[rate_id] = dc;
+        BankedResource::addRate(dc, ptr);
     } else {
-        Log::warn << "Can't inflict a negative consumption rate (" << rate_id << ") for the depletable resource \'" << m_name << "\'\n";
-    }
-}
-
-void DepletableResource::removeRate(Activity* ptr)
-{
-    std::string rate_id;
-    if(ptr == nullptr) {
-        rate_id = "undefined";
-    } else {
-        rate_id = ptr->getAgentId() + ":" + std::to_string(ptr->getId());
-    }
-    auto it = m_rates.find(rate_id);
-    if(it != m_rates.end()) {
-        m_rates.erase(it);
-    } else {
-        Log::err << "Could not remove resource consumption rate for activity " << rate_id << " and resource \'" << m_name << "\'.\n";
-    }
-}
-
-void DepletableResource::step(void)
-{
-    double acc = 0.f;
-    for(auto& r : m_rates) {
-        acc += r.second;    /* These "rates" will only be positive for depletable resources. */
-    }
-    acc += m_instantaneous;
-    if(acc > m_max_capacity - m_reserved_capacity) {
-        Log::err << "[Agent " << m_agent->getId() << ":" << m_name << "] Trying to consume ["
-            << (m_max_capacity - m_reserved_capacity) << "-]" << acc << " would result in negative capacity.\n";
-        throw std::runtime_error("Resource capacity exceeded.");
-    } else if(m_max_capacity - m_reserved_capacity == acc) {
-        Log::warn << "[Agent " << m_agent->getId() << ":" << m_name << "] Agent has depleted its resource completely (last consumption: "
-            << acc << ").\n";
-        m_capacity = m_max_capacity - acc;
-    } else {
-        m_capacity = m_max_capacity - acc;
-    }
-    m_instantaneous = 0.f;
-}
-
-void DepletableResource::showStatus(void) const
-{
-    Log::dbg << "Resource status [" << m_name << "]: capacity is " << m_capacity << "/" << m_max_capacity
-        << " (" << std::fixed << std::setprecision(0) << (100.f * m_capacity / m_max_capacity) << "%). Active rates: " << m_rates.size() << ".\n";
-    for(auto& r : m_rates) {
-        Log::dbg << " # " << r.first << " -> " << std::defaultfloat << r.second << ".\n";
+        Log::warn << "Can't inflict a negative consumption rate (" << getRateName(ptr == nullptr ? undefined_rate : ptr->getHandle())
+            << ") for the depletable resource \'" << getName() << "\'\n";
     }
-    Log::dbg << std::defaultfloat;
 }
@@ -0,0 +1,185 @@
+/***********************************************************************************************//**
+ *  Flat storage of the resources of an agent.
+ *  @class      ResourceBank
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-27
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#include "ResourceBank.hpp"
+#include "Agent.hpp"
+
+CREATE_LOGGER(ResourceBank)
+
+ResourceBank::ResourceBank(Agent* aptr)
+    : m_agent(aptr)
+{ }
+
+std::size_t ResourceBank::add(ResourceKind kind, std::string name, double c, double c_init)
+{
+    m_name.push_back(name);
+    m_cumulative.push_back(kind == ResourceKind::CUMULATIVE ? 1.0 : 0.0);
+    m_capacity.push_back(c_init);
+    m_max_capacity.push_back(c);
+    m_reserved_capacity.push_back(0.0);
+    m_instantaneous.push_back(0.0);
+    m_rate_sum.push_back(0.0);
+    m_rate_count.push_back(0);
+    m_status.push_back((unsigned char)ResourceStatus::OK);
+    return m_name.size() - 1;
+}
+
+ResourceKind ResourceBank::getKind(std::size_t i) const
+{
+    return (m_cumulative[i] == 1.0 ? ResourceKind::CUMULATIVE : ResourceKind::DEPLETABLE);
+}
+
+void ResourceBank::setMaxCapacity(std::size_t i, double c)
+{
+    if(c < m_capacity[i]) {
+        Log::err << "[Agent " << getAgentId() << ":" << m_name[i] << "] Changing maximum \'" << m_name[i] << "\' capacity to " << c << " failed.\n";
+        throw std::runtime_error("Resource capacity error (1).");
+    }
+    m_max_capacity[i] = c;
+}
+
+void ResourceBank::setReservedCapacity(std::size_t i, double c)
+{
+    if(c > m_capacity[i]) {
+        Log::err << "[Agent " << getAgentId() << ":" << m_name[i] << "] Changing reserved \'" << m_name[i] << "\' capacity to " << c << " failed.\n";
+        throw std::runtime_error("Resource capacity error (2).");
+    }
+    m_reserved_capacity[i] = c;
+}
+
+bool ResourceBank::tryApplyOnce(std::size_t i, double c) const
+{
+    return m_rate_sum[i] + m_instantaneous[i] + c <= m_max_capacity[i] - m_reserved_capacity[i];
+}
+
+bool ResourceBank::applyFor(std::size_t i, double c, double t, bool verbose)
+{
+    if(t <= 0) {
+        return true;
+    }
+    double acc = c + m_instantaneous[i] + m_rate_sum[i];
+    if(getKind(i) == ResourceKind::CUMULATIVE) {
+        m_capacity[i] -= acc * t;
+        if(m_capacity[i] >= m_reserved_capacity[i]) {
+            m_capacity[i] = std::min(m_capacity[i], m_max_capacity[i]);
+            return true;
+        }
+        if(verbose) {
+            Log::err << "Full depletion applying c = " << c << " for t = " << t << ". Resulting capacity would be " << m_capacity[i] << "\n";
+        }
+    } else {
+        /* NOTE: The instantaneous consumption is accounted twice (as in DepletableResource). */
+        if(m_max_capacity[i] - acc - m_instantaneous[i] >= m_reserved_capacity[i]) {
+            m_capacity[i] = m_max_capacity[i] - acc - m_instantaneous[i];
+            return true;
+        }
+    }
+    m_capacity[i] = m_reserved_capacity[i];
+    return false;
+}
+
+ResourceBank::RateHandle ResourceBank::addRate(std::size_t i, double dc)
+{
+    RateHandle h;
+    if(m_rate_free.empty()) {
+        h = m_rate_value.size();
+        m_rate_value.push_back(dc);
+        m_rate_resource.push_back(i);
+    } else {
+        h = m_rate_free.back();
+        m_rate_free.pop_back();
+        m_rate_value[h] = dc;
+        m_rate_resource[h] = i;
+    }
+    m_rate_sum[i] += dc;
+    m_rate_count[i]++;
+    return h;
+}
+
+void ResourceBank::removeRate(RateHandle h)
+{
+    if(h >= m_rate_resource.size() || m_rate_resource[h] == std::string::npos) {
+        Log::err << "[Agent " << getAgentId() << "] Trying to remove an unknown resource rate (" << h << ").\n";
+        return;
+    }
+    std::size_t i = m_rate_resource[h];
+    m_rate_resource[h] = std::string::npos;
+    m_rate_free.push_back(h);
+    if(--m_rate_count[i] == 0) {
+        m_rate_sum[i] = 0.0;    /* Drops the rounding errors accumulated by add/remove. */
+    } else {
+        m_rate_sum[i] -= m_rate_value[h];
+    }
+}
+
+unsigned int ResourceBank::step(double dt)
+{
+    stepRange(0, size(), dt);
+    unsigned int violations = 0;
+    for(std::size_t i = 0; i < size(); i++) {
+        if(m_status[i] != (unsigned char)ResourceStatus::OK) {
+            logStatus(i, dt);
+            violations += (m_status[i] == (unsigned char)ResourceStatus::VIOLATED);
+        }
+    }
+    return violations;
+}
+
+ResourceStatus ResourceBank::step(std::size_t i, double dt)
+{
+    stepRange(i, i + 1, dt);
+    if(m_status[i] != (unsigned char)ResourceStatus::OK) {
+        logStatus(i, dt);
+    }
+    return (ResourceStatus)m_status[i];
+}
+
+void ResourceBank::stepRange(std::size_t i0, std::size_t i1, double dt)
+{
+    /*  Both kinds are computed for every resource and selected with the `m_cumulative` mask, whose
+     *  products by 0 and 1 are exact (i.e. results are the same as those of the branching code in
+     *  CumulativeResource::step and DepletableResource::step).
+     **/
+    const double* cum = m_cumulative.data();
+    const double* rsum = m_rate_sum.data();
+    const double* cmax = m_max_capacity.data();
+    const double* cres = m_reserved_capacity.data();
+    double* cap = m_capacity.data();
+    double* inst = m_instantaneous.data();
+    unsigned char* status = m_status.data();
+    #pragma omp simd
+    for(std::size_t i = i0; i < i1; i++) {
+        double acc   = (rsum[i] + inst[i]) * (cum[i] * dt + (1.0 - cum[i]));
+        double avail = cum[i] * cap[i] + (1.0 - cum[i]) * cmax[i] - cres[i];
+        double next  = cum[i] * std::min(cap[i] - acc, cmax[i]) + (1.0 - cum[i]) * (cmax[i] - acc);
+        bool ok = (acc <= avail);
+        cap[i]    = (ok ? next : cap[i]);
+        inst[i]   = (ok ? 0.0 : inst[i]);
+        status[i] = (unsigned char)((acc == avail) + 2 * (acc > avail));
+    }
+}
+
+void ResourceBank::logStatus(std::size_t i, double dt) const
+{
+    double acc = (m_rate_sum[i] + m_instantaneous[i]) * (getKind(i) == ResourceKind::CUMULATIVE ? dt : 1.0);
+    if(getStatus(i) == ResourceStatus::VIOLATED) {
+        double avail = (getKind(i) == ResourceKind::CUMULATIVE ? m_capacity[i] : m_max_capacity[i] - m_reserved_capacity[i]);
+        Log::err << "[Agent " << getAgentId() << ":" << m_name[i] << "] Trying to consume ["
+            << avail << "-]" << acc << " would result in negative capacity.\n";
+    } else if(getStatus(i) == ResourceStatus::DEPLETED) {
+        Log::warn << "[Agent " << getAgentId() << ":" << m_name[i] << "] Agent has depleted its resource completely (last consumption: "
+            << acc << ").\n";
+    }
+}
+
+std::string ResourceBank::getAgentId(void) const
+{
+    return (m_agent != nullptr ? m_agent->getId() : std::string("unknown"));
+}
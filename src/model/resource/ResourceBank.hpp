@@ -0,0 +1,119 @@
+/***********************************************************************************************//**
+ *  Flat storage of the resources of an agent.
+ *  @class      ResourceBank
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-27
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef RESOURCE_BANK_HPP
+#define RESOURCE_BANK_HPP
+
+#include "prot.hpp"
+
+class Agent;
+
+enum class ResourceKind {
+    CUMULATIVE,         /* Capacity integrates rates over time (e.g. energy). */
+    DEPLETABLE          /* Capacity is the maximum minus the sum of active rates (e.g. storage). */
+};
+
+enum class ResourceStatus : unsigned char {
+    OK          = 0,    /* Rates have been applied. */
+    DEPLETED    = 1,    /* Rates have been applied and the capacity left is exactly the reserved one. */
+    VIOLATED    = 2     /* Rates exceed the available capacity and have not been applied. */
+};
+
+/***********************************************************************************************//**
+ *  Stores the state of several resources (i.e. resource kinds of one agent) in contiguous arrays:
+ *  one entry per resource for its capacity, maximum and reserved capacities, instantaneous
+ *  consumption and sum of active rates. Rates are added and removed in O(1) through the handle
+ *  returned by ResourceBank::addRate, which also keeps the rate sums up to date. Stepping all the
+ *  resources is a loop without branches, the kind of each resource being a 0/1 mask.
+ *  CumulativeResource and DepletableResource are adapters to one entry of a bank (see Resource).
+ **************************************************************************************************/
+class ResourceBank
+{
+public:
+    typedef std::size_t RateHandle;
+
+    ResourceBank(Agent* aptr = nullptr);
+
+    /*******************************************************************************************//**
+     *  Adds a resource and returns its index in the bank.
+     **********************************************************************************************/
+    std::size_t add(ResourceKind kind, std::string name, double c, double c_init);
+
+    std::size_t size(void) const { return m_name.size(); }
+    const std::string& getName(std::size_t i) const { return m_name[i]; }
+    void setName(std::size_t i, std::string name) { m_name[i] = name; }
+    ResourceKind getKind(std::size_t i) const;
+    double getCapacity(std::size_t i) const { return m_capacity[i]; }
+    double getMaxCapacity(std::size_t i) const { return m_max_capacity[i]; }
+    double getReservedCapacity(std::size_t i) const { return m_reserved_capacity[i]; }
+    double getRateSum(std::size_t i) const { return m_rate_sum[i]; }
+    double getRate(RateHandle h) const { return m_rate_value[h]; }
+    std::size_t getRateCount(std::size_t i) const { return m_rate_count[i]; }
+
+    /*******************************************************************************************//**
+     *  Set the maximum or reserved capacity of resource `i`. Throw if it would be lower or higher,
+     *  respectively, than the current capacity.
+     **********************************************************************************************/
+    void setMaxCapacity(std::size_t i, double c);
+    void setReservedCapacity(std::size_t i, double c);
+
+    /*******************************************************************************************//**
+     *  Adds an instantaneous consumption to resource `i`, applied in its next step.
+     **********************************************************************************************/
+    void applyOnce(std::size_t i, double c) { m_instantaneous[i] += c; }
+    bool tryApplyOnce(std::size_t i, double c) const;
+
+    /*******************************************************************************************//**
+     *  Applies the active rates and an additional rate `c` to resource `i` during `t` seconds.
+     *  Returns false (and leaves the resource at its reserved capacity) if they can't be applied.
+     **********************************************************************************************/
+    bool applyFor(std::size_t i, double c, double t, bool verbose = false);
+
+    /*******************************************************************************************//**
+     *  Adds rate `dc` to resource `i`. The returned handle is needed to remove it.
+     **********************************************************************************************/
+    RateHandle addRate(std::size_t i, double dc);
+    void removeRate(RateHandle h);
+
+    /*******************************************************************************************//**
+     *  Steps all the resources of the bank by `dt` seconds. Violations and depletions are logged.
+     *  @return The number of resources whose rates could not be applied (ResourceStatus::VIOLATED).
+     **********************************************************************************************/
+    unsigned int step(double dt);
+
+    /*******************************************************************************************//**
+     *  Steps resource `i` only, and returns its status.
+     **********************************************************************************************/
+    ResourceStatus step(std::size_t i, double dt);
+
+    ResourceStatus getStatus(std::size_t i) const { return (ResourceStatus)m_status[i]; }
+
+private:
+    Agent* m_agent;
+    std::vector<std::string> m_name;
+    std::vector<double> m_cumulative;           /**< 1 for ResourceKind::CUMULATIVE, 0 otherwise. */
+    std::vector<double> m_capacity;
+    std::vector<double> m_max_capacity;
+    std::vector<double> m_reserved_capacity;
+    std::vector<double> m_instantaneous;        /**< Consumption to apply in the next step. */
+    std::vector<double> m_rate_sum;             /**< Sum of the active rates of each resource. */
+    std::vector<std::size_t> m_rate_count;      /**< Number of active rates of each resource. */
+    std::vector<unsigned char> m_status;        /**< ResourceStatus of the last step. */
+
+    std::vector<double> m_rate_value;           /**< Value of each rate (indexed by handle). */
+    std::vector<std::size_t> m_rate_resource;   /**< Resource of each rate (npos if the handle is free). */
+    std::vector<RateHandle> m_rate_free;        /**< Handles that can be reused. */
+
+    void stepRange(std::size_t i0, std::size_t i1, double dt);
+    void logStatus(std::size_t i, double dt) const;
+    std::string getAgentId(void) const;
+};
+
+#endif /* RESOURCE_BANK_HPP */
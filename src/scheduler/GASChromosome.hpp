@@ -33,6 +33,7 @@ public:
     void setFitness(float f) { m_fitness = f; }
     bool isValid(void) const { return m_valid; }
     void setValid(bool v = true) { m_valid = v; }
+    std::size_t getMemoryFootprint(void) const { return sizeof(GASChromosome) + (m_alleles.capacity() + m_protected_alleles.capacity()) / 8; }
 
     bool operator<(const GASChromosome& rhs) const;
     bool operator<=(const GASChromosome& rhs) const;
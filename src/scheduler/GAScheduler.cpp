@@ -9,6 +9,8 @@
  **************************************************************************************************/
 
 #include "GAScheduler.hpp"
+#include "TaskPool.hpp"
+#include "Profiler.hpp"
 
 CREATE_LOGGER(GAScheduler)
 
@@ -80,6 +82,7 @@ bool GAScheduler::iterate(unsigned int& g, GASChromosome best)
 
 GASchedErr GAScheduler::schedule(std::vector<std::shared_ptr<Activity> >& adis, GAScheduler::Solution& result, bool debug)
 {
+    PROFILE_ZONE("GAScheduler::schedule");
     bool insert_bl = false;
     if(m_population.size() == 0) {
         Log::err << "Cannot start scheduling before population has been spawned.\n";
@@ -149,10 +152,9 @@ GASchedErr GAScheduler::schedule(std::vector<std::shared_ptr<Activity> >& adis,
     m_init_individual = m_population[0];
 
     /* Initialize population fitness: */
-    #pragma omp parallel for
-    for(unsigned int i = 0; i < m_population.size(); i++) {
+    TaskPool::parallelFor(m_population.size(), 0, [this](std::size_t i) {
         computeFitness(m_population[i]);
-    }
+    }, "ga_fitness");
 
     /*  We have previously inserted the 3rd type of baseline solution, and its fitness has just been computed.
      *  Check that it's valid:
@@ -224,10 +226,9 @@ GASchedErr GAScheduler::schedule(std::vector<std::shared_ptr<Activity> >& adis,
             children.push_back(child2);
         }
 
-        #pragma omp parallel for
-        for(unsigned int i = 0; i < children.size(); i++) {
+        TaskPool::parallelFor(children.size(), 0, [&](std::size_t i) {
             computeFitness(children[i]);
-        }
+        }, "ga_fitness");
         if(g == 1) {
             repairPool(m_population);               /* Removes invalid parents. */
         }
@@ -781,6 +782,20 @@ GASChromosome GAScheduler::combine(std::vector<GASChromosome> parents, std::vect
     return best_individual;
 }
 
+std::size_t GAScheduler::getMemoryFootprint(void) const
+{
+    std::size_t b = sizeof(GAScheduler);
+    b += (m_population.capacity() - m_population.size()) * sizeof(GASChromosome);
+    for(auto& c : m_population) {
+        b += c.getMemoryFootprint();
+    }
+    b += m_best.getMemoryFootprint() + m_init_individual.getMemoryFootprint() - 2 * sizeof(GASChromosome);
+    b += MemoryUsage::bytes(m_iteration_profile) + MemoryUsage::bytes(m_individual_info);
+    b += MemoryUsage::bytes(m_previous_solutions) + MemoryUsage::bytes(m_max_cost) + MemoryUsage::bytes(m_costs);
+    b += MemoryUsage::bytes(m_resources_init);
+    return b;
+}
+
 void GAScheduler::debug(void) const
 {
     Log::dbg << "GA Scheduler, debug info: ======================================================\n";
@@ -106,6 +106,11 @@ public:
      **********************************************************************************************/
     void debug(void) const;
 
+    /*******************************************************************************************//**
+     *  Estimated memory footprint of the population and the chromosome information (bytes).
+     **********************************************************************************************/
+    std::size_t getMemoryFootprint(void) const;
+
 private:
     struct GASInfo {                            /**< Info for a single chromosome allele. */
         double t_start;                         /**< Start time of the allele. */
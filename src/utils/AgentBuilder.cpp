@@ -9,9 +9,54 @@
  **************************************************************************************************/
 
 #include "AgentBuilder.hpp"
+#include <unistd.h>
 
 CREATE_LOGGER(AgentBuilder)
 
+namespace
+{
+    /*  Binary agent set: header, one record per agent and the agent identifiers (concatenated, in
+     *  the same order). Values are stored as loaded from the YAML file, so both paths build
+     *  identical agents.
+     **/
+    const char agent_set_magic[8] = {'P', '3', 'A', 'G', 'S', 'E', 'T', '\0'};
+    const std::uint32_t agent_set_version = 1;
+
+    struct AgentSetHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t record_size;
+        std::uint64_t src_hash;         /* Hash of the YAML source contents. */
+        std::uint64_t count;            /* Number of agents. */
+    };
+
+    struct AgentSetRecord {
+        double sma;
+        double ecc;
+        double inc;
+        double argp;
+        double raan;
+        double mean_motion;
+        double mean_anomaly_init;
+        float link_range;
+        float link_datarate;
+        float instrument_aperture;
+        float instrument_energy_rate;
+        float instrument_storage_rate;
+        std::uint32_t id_length;
+    };
+
+    std::uint64_t contentHash(const std::string& s)
+    {
+        std::uint64_t h = 14695981039346656037ull;  /* FNV-1a. */
+        for(unsigned char c : s) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+}
+
 AgentBuilder::AgentBuilder(std::string aid)
     : m_agent_id(aid)
 {
@@ -95,13 +140,35 @@ std::vector<AgentBuilder> AgentBuilder::load(std::string src_path)
 {
     std::vector<AgentBuilder> retvec;
     try {
-        YAML::Node agent_conf = YAML::LoadFile(src_path);
+        std::ifstream src_file(src_path, std::ios::in | std::ios::binary);
+        if(!src_file.is_open()) {
+            throw std::runtime_error("Unable to open \'" + src_path + "\'.");
+        }
+        std::string src((std::istreambuf_iterator<char>(src_file)), std::istreambuf_iterator<char>());
+        std::uint64_t src_hash = contentHash(src);
         bool do_save = true;
         if(src_path == Config::data_path + "system.yml") {
             Log::warn << "Will not save \'system.yml\' file because system configuration source and the output paths are the same:\n";
             Log::warn << "--- \'" << src_path << "\'\n";
             do_save = false;
         }
+
+        std::string bin_path = src_path + ".bin";
+        if(Config::agent_cache != AgentCacheMode::YAML) {
+            if(loadBinary(bin_path, src_hash, Config::agent_cache == AgentCacheMode::AUTO, retvec)) {
+                Log::dbg << "Loaded " << retvec.size() << " agents from \'" << bin_path << "\'.\n";
+                if(do_save) {
+                    /* Same contents as saving every agent, without emitting YAML: */
+                    std::ofstream yaml_file(Config::data_path + "system.yml", std::ios_base::app);
+                    yaml_file << src;
+                }
+                return retvec;
+            } else if(Config::agent_cache == AgentCacheMode::BINARY) {
+                Log::warn << "Unable to load the binary agent set \'" << bin_path << "\'. Will parse \'" << src_path << "\'.\n";
+            }
+        }
+
+        YAML::Node agent_conf = YAML::Load(src);
         for(YAML::const_iterator it = agent_conf.begin(); it != agent_conf.end(); it++) {
             load(it->first.as<std::string>(), it->second);
             if(do_save) {
@@ -109,6 +176,7 @@ std::vector<AgentBuilder> AgentBuilder::load(std::string src_path)
             }
             retvec.push_back(*this);
         }
+        saveBinary(bin_path, src_hash, retvec);
     } catch(const std::exception& e) {
         Log::err << "Unable to parse all entries in \'" << src_path << "\' automatically.\n";
         Log::err << e.what() << "\n";
@@ -118,6 +186,107 @@ std::vector<AgentBuilder> AgentBuilder::load(std::string src_path)
     return retvec;
 }
 
+bool AgentBuilder::loadBinary(std::string path, std::uint64_t src_hash, bool check_hash, std::vector<AgentBuilder>& abs)
+{
+    std::ifstream f(path, std::ios::in | std::ios::binary);
+    if(!f.is_open()) {
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    AgentSetHeader h;
+    if(data.size() < sizeof(h)) {
+        return false;
+    }
+    std::memcpy(&h, data.data(), sizeof(h));
+    if(std::memcmp(h.magic, agent_set_magic, sizeof(h.magic)) != 0 || h.version != agent_set_version ||
+        h.record_size != sizeof(AgentSetRecord) || h.count > (data.size() - sizeof(h)) / sizeof(AgentSetRecord)) {
+        Log::warn << "Binary agent set \'" << path << "\' has an unknown format and will be regenerated.\n";
+        return false;
+    }
+    if(check_hash && h.src_hash != src_hash) {
+        Log::dbg << "Binary agent set \'" << path << "\' is out of date and will be regenerated.\n";
+        return false;
+    }
+
+    std::vector<AgentBuilder> retvec(h.count);
+    const char* rec_ptr = data.data() + sizeof(h);
+    std::size_t id_offset = sizeof(h) + h.count * sizeof(AgentSetRecord);
+    for(auto& ab : retvec) {
+        AgentSetRecord r;
+        std::memcpy(&r, rec_ptr, sizeof(r));
+        rec_ptr += sizeof(r);
+        if(id_offset + r.id_length > data.size()) {
+            Log::warn << "Binary agent set \'" << path << "\' is truncated and will be regenerated.\n";
+            return false;
+        }
+        ab.m_agent_id.assign(data.data() + id_offset, r.id_length);
+        id_offset += r.id_length;
+        ab.m_orbital_params.sma         = r.sma;
+        ab.m_orbital_params.ecc         = r.ecc;
+        ab.m_orbital_params.inc         = r.inc;
+        ab.m_orbital_params.argp        = r.argp;
+        ab.m_orbital_params.raan        = r.raan;
+        ab.m_orbital_params.mean_motion = r.mean_motion;
+        ab.m_mean_anomaly_init          = r.mean_anomaly_init;
+        ab.m_link_range                 = r.link_range;
+        ab.m_link_datarate              = r.link_datarate;
+        ab.m_instrument_aperture        = r.instrument_aperture;
+        ab.m_instrument_energy_rate     = r.instrument_energy_rate;
+        ab.m_instrument_storage_rate    = r.instrument_storage_rate;
+    }
+    abs.swap(retvec);
+    return true;
+}
+
+void AgentBuilder::saveBinary(std::string path, std::uint64_t src_hash, const std::vector<AgentBuilder>& abs)
+{
+    AgentSetHeader h;
+    std::memcpy(h.magic, agent_set_magic, sizeof(h.magic));
+    h.version = agent_set_version;
+    h.record_size = sizeof(AgentSetRecord);
+    h.src_hash = src_hash;
+    h.count = abs.size();
+
+    std::string data(reinterpret_cast<const char*>(&h), sizeof(h));
+    std::string ids;
+    for(auto& ab : abs) {
+        AgentSetRecord r;
+        std::memset(&r, 0, sizeof(r));  /* Padding bytes. */
+        r.sma                     = ab.m_orbital_params.sma;
+        r.ecc                     = ab.m_orbital_params.ecc;
+        r.inc                     = ab.m_orbital_params.inc;
+        r.argp                    = ab.m_orbital_params.argp;
+        r.raan                    = ab.m_orbital_params.raan;
+        r.mean_motion             = ab.m_orbital_params.mean_motion;
+        r.mean_anomaly_init       = ab.m_mean_anomaly_init;
+        r.link_range              = ab.m_link_range;
+        r.link_datarate           = ab.m_link_datarate;
+        r.instrument_aperture     = ab.m_instrument_aperture;
+        r.instrument_energy_rate  = ab.m_instrument_energy_rate;
+        r.instrument_storage_rate = ab.m_instrument_storage_rate;
+        r.id_length               = ab.m_agent_id.size();
+        data.append(reinterpret_cast<const char*>(&r), sizeof(r));
+        ids += ab.m_agent_id;
+    }
+    data += ids;
+
+    /* Concurrent runs (e.g. batches) may load the same set: replace it atomically. */
+    std::string tmp_path = path + ".tmp" + std::to_string(getpid());
+    std::ofstream f(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!f.is_open() || !f.write(data.data(), data.size())) {
+        Log::warn << "Unable to write the binary agent set \'" << path << "\'.\n";
+        std::remove(tmp_path.c_str());
+        return;
+    }
+    f.close();
+    if(std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        Log::warn << "Unable to write the binary agent set \'" << path << "\'.\n";
+        std::remove(tmp_path.c_str());
+        return;
+    }
+    Log::dbg << "Binary agent set written to \'" << path << "\'.\n";
+}
+
 void AgentBuilder::load(std::string aid, std::string src_path)
 {
     m_agent_id = aid;
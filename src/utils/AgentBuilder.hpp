@@ -30,6 +30,13 @@ public:
     void generateAndStore(std::string aid);
     void save(void);
     void load(std::string aid, std::string src_path);
+
+    /*******************************************************************************************//**
+     *  Loads all the agents in a system YAML file. A binary copy of the agent set is kept next to
+     *  it (<src_path>.bin) with a hash of the YAML contents: it is loaded instead of parsing the
+     *  YAML file as long as the hash matches, and it is regenerated otherwise (see
+     *  Config::agent_cache).
+     **********************************************************************************************/
     std::vector<AgentBuilder> load(std::string src_path);
 
     std::string getAgentId(void) const { return m_agent_id; }
@@ -53,6 +60,9 @@ private:
 
     void load(std::string aid, const YAML::Node& an);
     void randomize(void);
+
+    static bool loadBinary(std::string path, std::uint64_t src_hash, bool check_hash, std::vector<AgentBuilder>& abs);
+    static void saveBinary(std::string path, std::uint64_t src_hash, const std::vector<AgentBuilder>& abs);
 };
 
 #endif /* AGENT_BUILDER_HPP */
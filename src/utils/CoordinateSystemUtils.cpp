@@ -14,8 +14,75 @@
 
 CREATE_LOGGER(CoordinateSystemUtils)
 
+std::mutex CoordinateSystemUtils::m_rot_mtx;
+std::map<double, std::array<double, 9> > CoordinateSystemUtils::m_rot_cache;
+const std::size_t CoordinateSystemUtils::rot_cache_max_size = 8192;
+
 sf::Vector3f CoordinateSystemUtils::fromECIToECEF(sf::Vector3f coord, double jd)
 {
+    double m[9];
+    getECIToECEFMatrix(jd, m);
+    return sf::Vector3f(
+        m[0] * coord.x + m[1] * coord.y + m[2] * coord.z,
+        m[3] * coord.x + m[4] * coord.y + m[5] * coord.z,
+        m[6] * coord.x + m[7] * coord.y + m[8] * coord.z
+    );
+}
+
+void CoordinateSystemUtils::fromECIToECEF(const sf::Vector3f* coords, std::size_t n, double jd, Vec3Array<double>& ecef)
+{
+    double m[9];
+    getECIToECEFMatrix(jd, m);
+    ecef.resize(n);
+    #pragma omp simd
+    for(std::size_t i = 0; i < n; i++) {
+        ecef.x[i] = m[0] * coords[i].x + m[1] * coords[i].y + m[2] * coords[i].z;
+        ecef.y[i] = m[3] * coords[i].x + m[4] * coords[i].y + m[5] * coords[i].z;
+        ecef.z[i] = m[6] * coords[i].x + m[7] * coords[i].y + m[8] * coords[i].z;
+    }
+}
+
+void CoordinateSystemUtils::fromECIToECEF(const sf::Vector3f* coords, const double* jds, std::size_t n, Vec3Array<double>& ecef)
+{
+    double m[9];
+    ecef.resize(n);
+    for(std::size_t i = 0; i < n; i++) {
+        if(i == 0 || jds[i] != jds[i - 1]) {
+            getECIToECEFMatrix(jds[i], m);
+        }
+        ecef.x[i] = m[0] * coords[i].x + m[1] * coords[i].y + m[2] * coords[i].z;
+        ecef.y[i] = m[3] * coords[i].x + m[4] * coords[i].y + m[5] * coords[i].z;
+        ecef.z[i] = m[6] * coords[i].x + m[7] * coords[i].y + m[8] * coords[i].z;
+    }
+}
+
+void CoordinateSystemUtils::fromECIToGrid(const sf::Vector3f* coords, const double* jds, std::size_t n,
+    unsigned int w, unsigned int h, CoordinateBatch& out)
+{
+    fromECIToECEF(coords, jds, n, out.ecef);
+    fromECEFToGeographic(out.ecef, out.lat, out.lng, out.h);
+    out.gx.resize(n);
+    out.gy.resize(n);
+    for(std::size_t i = 0; i < n; i++) {
+        /* Same projection as AgentMotion::getProjection2D: */
+        int gx = std::floor(w * out.lng[i] / 360.0 + w / 2.0);
+        int gy = std::floor(h * (-out.lat[i]) / 180.0 + h / 2.0);
+        out.gx[i] = ((gx % (int)w) + (int)w) % (int)w;
+        out.gy[i] = std::min(std::max(gy, 0), (int)h - 1);
+    }
+}
+
+void CoordinateSystemUtils::getECIToECEFMatrix(double jd, double* m)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_rot_mtx);
+        auto it = m_rot_cache.find(jd);
+        if(it != m_rot_cache.end()) {
+            std::copy(it->second.begin(), it->second.end(), m);
+            return;
+        }
+    }
+
     gsl_error_handler_t* old_gsl_error_handler = gsl_set_error_handler(&CoordinateSystemUtils::GSLErrorHandler); /* Install new handler. */
     /*  This conversion is based upon "Appendix - Transformation of ECI (CIS, EPOCH J2000.0)
      *  coordinates to WGS84 (CTS, ECEF) coordinates", from the National Geospatial-Intelligence
@@ -31,8 +98,6 @@ sf::Vector3f CoordinateSystemUtils::fromECIToECEF(sf::Vector3f coord, double jd)
     /* ECI to ECEF transformation:
      *  ECEF <-- A·B·C·D·ECI
      **/
-    gsl_vector* ecef_vec = gsl_vector_alloc(3);
-    gsl_vector* eci_vec  = gsl_vector_alloc(3);
     gsl_matrix* ab_mat   = gsl_matrix_alloc(3, 3);
     gsl_matrix* abc_mat  = gsl_matrix_alloc(3, 3);
     gsl_matrix* abcd_mat = gsl_matrix_alloc(3, 3);
@@ -42,18 +107,14 @@ sf::Vector3f CoordinateSystemUtils::fromECIToECEF(sf::Vector3f coord, double jd)
     gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, ab_mat, nutation_mat, 0.0, abc_mat);
     gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, abc_mat, precession_mat, 0.0, abcd_mat);
 
-    gsl_vector_set_zero(ecef_vec);          /* Initialize ECEF vector.  */
-    gsl_vector_set(eci_vec, 0, coord.x);    /* Initialize ECI vector.   */
-    gsl_vector_set(eci_vec, 1, coord.y);    /* ...                      */
-    gsl_vector_set(eci_vec, 2, coord.z);    /* ...                      */
-    gsl_blas_dgemv(CblasNoTrans, 1.0, abcd_mat, eci_vec, 0.0, ecef_vec);     /* Computes ecef = (1 · abcd_mat · eci) */
-
-    double x = gsl_vector_get(ecef_vec, 0);
-    double y = gsl_vector_get(ecef_vec, 1);
-    double z = gsl_vector_get(ecef_vec, 2);
+    std::array<double, 9> abcd;
+    for(int i = 0; i < 3; i++) {
+        for(int j = 0; j < 3; j++) {
+            abcd[3 * i + j] = gsl_matrix_get(abcd_mat, i, j);
+        }
+    }
+    std::copy(abcd.begin(), abcd.end(), m);
 
-    gsl_vector_free(ecef_vec);
-    gsl_vector_free(eci_vec);
     gsl_matrix_free(precession_mat);
     gsl_matrix_free(nutation_mat);
     gsl_matrix_free(sideral_mat);
@@ -64,7 +125,14 @@ sf::Vector3f CoordinateSystemUtils::fromECIToECEF(sf::Vector3f coord, double jd)
 
     gsl_set_error_handler(old_gsl_error_handler); /* Restore the original handler. */
 
-    return sf::Vector3f(x, y, z);
+    std::lock_guard<std::mutex> lock(m_rot_mtx);
+    if(m_rot_cache.size() >= rot_cache_max_size) {
+        /* Epochs are mostly visited in increasing order: drop the oldest half. */
+        auto it = m_rot_cache.begin();
+        std::advance(it, m_rot_cache.size() / 2);
+        m_rot_cache.erase(m_rot_cache.begin(), it);
+    }
+    m_rot_cache[jd] = abcd;
 }
 
 sf::Vector3f CoordinateSystemUtils::fromECEFToECI(sf::Vector3f coord, double jd)
@@ -141,6 +209,25 @@ sf::Vector3f CoordinateSystemUtils::fromECIToGeographic(sf::Vector3f coord, doub
 }
 
 sf::Vector3f CoordinateSystemUtils::fromECEFToGeographic(sf::Vector3f coord)
+{
+    double lat, lng, h;
+    fromECEFToGeographic(coord.x, coord.y, coord.z, lat, lng, h);
+    return sf::Vector3f(lat, lng, h);
+}
+
+void CoordinateSystemUtils::fromECEFToGeographic(const Vec3Array<double>& ecef, std::vector<double>& lat,
+    std::vector<double>& lng, std::vector<double>& h)
+{
+    std::size_t n = ecef.size();
+    lat.resize(n);
+    lng.resize(n);
+    h.resize(n);
+    for(std::size_t i = 0; i < n; i++) {
+        fromECEFToGeographic(ecef.x[i], ecef.y[i], ecef.z[i], lat[i], lng[i], h[i]);
+    }
+}
+
+void CoordinateSystemUtils::fromECEFToGeographic(double x, double y, double z, double& lat, double& lng, double& h)
 {
     /* The conversion from ECEF to Geographic coordinates is performed using the Ferrari's
      * conversion. In particular, the following algorithm implement the five steps defined by
@@ -149,27 +236,25 @@ sf::Vector3f CoordinateSystemUtils::fromECEFToGeographic(sf::Vector3f coord)
     double a = Config::earth_wgs84_a;
     double e = Config::earth_wgs84_e;
     double b = Config::earth_wgs84_b;
-    double r = std::sqrt(coord.x * coord.x + coord.y * coord.y);
+    double r = std::sqrt(x * x + y * y);
     double e_ = std::sqrt((a * a - b * b) / (b * b));
     double E = std::sqrt(a * a - b * b);
-    double F = 54 * std::pow(b * coord.z, 2);
-    double G = std::pow(r, 2) + (1 - e * e) * std::pow(coord.z, 2) - std::pow(e * E, 2);
+    double F = 54 * std::pow(b * z, 2);
+    double G = std::pow(r, 2) + (1 - e * e) * std::pow(z, 2) - std::pow(e * E, 2);
     double C = std::pow(e, 4) * F * std::pow(r, 2) / std::pow(G, 3);
     double S = std::pow((1 + C + std::sqrt(C * (C + 2))), 1.0 / 3);
     double P = F / (3 * std::pow(G * (S + 1 / S + 1), 2));
     double Q = std::sqrt(1 + 2 * P * std::pow(e, 4));
     double ro = -P * r * r / 2;
-    ro -= P * (1 - e * e) * coord.z * coord.z / (Q * (1 + Q));
+    ro -= P * (1 - e * e) * z * z / (Q * (1 + Q));
     ro += std::pow(a, 2) * (1 + 1 / Q) * 0.5;
     ro = -(P * e * e * r) / (1 + Q) + std::sqrt(ro);
-    double U = std::sqrt(std::pow(r - e * e * ro, 2) + coord.z * coord.z);
-    double V = std::sqrt(std::pow(r - e * e * ro, 2) + (1 - e * e) * coord.z * coord.z);
-    double Zo = b * b * coord.z / (a * V);
-    double h = U * (1 - (b * b / (a * V)));
-    double lat = std::atan((coord.z + e_ * e_ * Zo) / r);
-    double lon = std::atan2(coord.y, coord.x);
-
-    return sf::Vector3f(MathUtils::radToDeg(lat), MathUtils::radToDeg(lon), h);
+    double U = std::sqrt(std::pow(r - e * e * ro, 2) + z * z);
+    double V = std::sqrt(std::pow(r - e * e * ro, 2) + (1 - e * e) * z * z);
+    double Zo = b * b * z / (a * V);
+    h = U * (1 - (b * b / (a * V)));
+    lat = MathUtils::radToDeg(std::atan((z + e_ * e_ * Zo) / r));
+    lng = MathUtils::radToDeg(std::atan2(y, x));
 }
 
 sf::Vector3f CoordinateSystemUtils::fromOrbitalToECI(
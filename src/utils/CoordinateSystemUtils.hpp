@@ -14,6 +14,8 @@
 #define COORDINATE_SYSTEM_UTILS_HPP
 
 #include "prot.hpp"
+#include <array>
+#include <map>
 
 /* External includes */
 #include <gsl/gsl_matrix.h>
@@ -25,9 +27,23 @@
 
 /* Internal includes */
 #include "MathUtils.hpp"
+#include "GeometryKernels.hpp"
 #include "CoordinateSystemUtilsCoeff.hpp"
 #include "VirtualTime.hpp"
 
+/***********************************************************************************************//**
+ *  Output buffers of CoordinateSystemUtils::fromECIToGrid (one element per input position).
+ **************************************************************************************************/
+struct CoordinateBatch
+{
+    Vec3Array<double> ecef;         /**< Positions in ECEF frame (in meters). */
+    std::vector<double> lat;        /**< Geodetic latitude (in degrees). */
+    std::vector<double> lng;        /**< Longitude (in degrees). */
+    std::vector<double> h;          /**< Height above the ellipsoid (in meters). */
+    std::vector<int> gx;            /**< Grid column. */
+    std::vector<int> gy;            /**< Grid row. */
+};
+
 /***********************************************************************************************//**
  * Provides frame transformation mechanisms. It is able to transform coordinates between
  * different frames:
@@ -54,6 +70,39 @@ public:
      **********************************************************************************************/
     static sf::Vector3f fromECIToECEF(sf::Vector3f coord, double jd);
 
+    /*******************************************************************************************//**
+     *  Batch transformation from ECI to ECEF of `n` positions that share the same epoch.
+     *  @param  coords  Coordinates in ECI frame to be transformed.
+     *  @param  n       Number of positions.
+     *  @param  jd      Julian Days of the transformation [days].
+     *  @param  ecef    Output: coordinates in ECEF frame.
+     **********************************************************************************************/
+    static void fromECIToECEF(const sf::Vector3f* coords, std::size_t n, double jd, Vec3Array<double>& ecef);
+
+    /*******************************************************************************************//**
+     *  Batch transformation from ECI to ECEF of `n` positions with their own epochs. The rotation
+     *  matrix is only looked up when the epoch changes.
+     *  @param  coords  Coordinates in ECI frame to be transformed.
+     *  @param  jds     Julian Days of each position [days].
+     *  @param  n       Number of positions.
+     *  @param  ecef    Output: coordinates in ECEF frame.
+     **********************************************************************************************/
+    static void fromECIToECEF(const sf::Vector3f* coords, const double* jds, std::size_t n, Vec3Array<double>& ecef);
+
+    /*******************************************************************************************//**
+     *  Batch transformation from ECI to ECEF, Geographic and grid indices in one pass. Grid indices
+     *  follow the equirectangular projection of AgentMotion::getProjection2D for a grid of `w` by
+     *  `h` cells; columns are wrapped and rows are clamped.
+     *  @param  coords  Coordinates in ECI frame to be transformed.
+     *  @param  jds     Julian Days of each position [days].
+     *  @param  n       Number of positions.
+     *  @param  w       Number of columns of the grid.
+     *  @param  h       Number of rows of the grid.
+     *  @param  out     Output buffers.
+     **********************************************************************************************/
+    static void fromECIToGrid(const sf::Vector3f* coords, const double* jds, std::size_t n,
+        unsigned int w, unsigned int h, CoordinateBatch& out);
+
     /*******************************************************************************************//**
      *  Transformation from ECEF to ECI. This conversion is based upon "Appendix - Transformation
      *  of ECI (CIS, EPOCH J2000.0) coordinates to WGS84 (CTS, ECEF) coordinates", from the
@@ -81,6 +130,16 @@ public:
      **********************************************************************************************/
     static sf::Vector3f fromECEFToGeographic(sf::Vector3f coord);
 
+    /*******************************************************************************************//**
+     *  Batch transformation from ECEF to Geographic (see the single-position version).
+     *  @param  ecef    Coordinates in ECEF frame to be transformed.
+     *  @param  lat     Output: latitudes [º].
+     *  @param  lng     Output: longitudes [º].
+     *  @param  h       Output: heights [m].
+     **********************************************************************************************/
+    static void fromECEFToGeographic(const Vec3Array<double>& ecef, std::vector<double>& lat,
+        std::vector<double>& lng, std::vector<double>& h);
+
     /*******************************************************************************************//**
      *  Transformation from Geographic to ECI. This conversion uses an intermediate transformation
      *  from Geographic to ECEF, and then from ECEF to ECI.
@@ -157,6 +216,24 @@ public:
     );
 
 private:
+    static std::mutex m_rot_mtx;                                    /**< Protects m_rot_cache. */
+    static std::map<double, std::array<double, 9> > m_rot_cache;    /**< ECI to ECEF matrices by epoch. */
+    static const std::size_t rot_cache_max_size;                    /**< Max. number of cached matrices. */
+
+    /*******************************************************************************************//**
+     *  Gets the ECI to ECEF rotation matrix (A·B·C·D, row-major) for a given epoch. Matrices are
+     *  cached, since the time grid of the simulation makes all agents (and every trajectory
+     *  position that is converted more than once) use the same epochs.
+     *  @param  jd      Julian Days of the transformation [days]
+     *  @param  m       Output: 3x3 matrix, row-major.
+     **********************************************************************************************/
+    static void getECIToECEFMatrix(double jd, double* m);
+
+    /*******************************************************************************************//**
+     *  Transformation from ECEF to Geographic in double precision. Implements fromECEFToGeographic.
+     **********************************************************************************************/
+    static void fromECEFToGeographic(double x, double y, double z, double& lat, double& lng, double& h);
+
     /*******************************************************************************************//**
      *  Computes the Julian Centuries from the Julian Days. This function is used in the ECEF/ECI
      *  conversion process.
@@ -0,0 +1,154 @@
+/***********************************************************************************************//**
+ *  Batch geometry kernels in single, double or extended precision.
+ *  @class      GeometryKernels
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-20
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef GEOMETRY_KERNELS_HPP
+#define GEOMETRY_KERNELS_HPP
+
+#include "prot.hpp"
+
+/***********************************************************************************************//**
+ *  Fixed-size 3D vectors stored as a structure of arrays (i.e. one contiguous buffer per axis), so
+ *  that batch kernels can process several vectors per instruction.
+ **************************************************************************************************/
+template <class T>
+struct Vec3Array
+{
+    std::vector<T> x;
+    std::vector<T> y;
+    std::vector<T> z;
+
+    void resize(std::size_t n) { x.resize(n); y.resize(n); z.resize(n); }
+    std::size_t size(void) const { return x.size(); }
+    void set(std::size_t i, const sf::Vector3<T>& v) { x[i] = v.x; y[i] = v.y; z[i] = v.z; }
+    sf::Vector3<T> at(std::size_t i) const { return sf::Vector3<T>(x[i], y[i], z[i]); }
+};
+
+/***********************************************************************************************//**
+ *  Geometry kernels templated on the floating-point type. Batch functions take plain pointers to
+ *  contiguous buffers and have no branches in their loop bodies, which lets the compiler vectorise
+ *  them (see `omp simd`). Scalar functions replicate the instrument geometry (with a spherical Earth
+ *  of radius `a`) and are used to select the precision at run time (see Config::instrument_precision).
+ **************************************************************************************************/
+class GeometryKernels
+{
+public:
+    /*******************************************************************************************//**
+     *  Computes the dot-product of `n` pairs of 3D vectors: out[i] = a[i] · b[i].
+     **********************************************************************************************/
+    template <class T>
+    static void dot(const T* ax, const T* ay, const T* az, const T* bx, const T* by, const T* bz,
+        std::size_t n, T* out);
+
+    /*******************************************************************************************//**
+     *  Computes the great-circle arc (in radians) between `n` pairs of unitary vectors.
+     **********************************************************************************************/
+    template <class T>
+    static void arc(const T* ax, const T* ay, const T* az, const T* bx, const T* by, const T* bz,
+        std::size_t n, T* out);
+
+    /*******************************************************************************************//**
+     *  Computes the great-circle arc (in radians) between the unitary vector `a` and `n` unitary
+     *  vectors in `b`.
+     **********************************************************************************************/
+    template <class T>
+    static void arc(const sf::Vector3<T>& a, const T* bx, const T* by, const T* bz, std::size_t n, T* out);
+
+    /*******************************************************************************************//**
+     *  Converts `n` pairs of geocentric latitude and longitude (in radians) to unitary vectors.
+     **********************************************************************************************/
+    template <class T>
+    static void latLonToUnit(const T* lat, const T* lng, std::size_t n, T* x, T* y, T* z);
+
+    /*******************************************************************************************//**
+     *  Central angle (in radians) between the sub-satellite point and the edge of the footprint of
+     *  an instrument with half-aperture `ang_rad` at distance `h` from the center of the Earth.
+     *  Returns NaN when the instrument does not intersect the Earth.
+     **********************************************************************************************/
+    template <class T>
+    static T footprintArc(T ang_rad, T h, T a);
+
+    /*******************************************************************************************//**
+     *  Slant range at off-nadir angle `ang_rad` for an instrument at distance `h` from the center
+     *  of the Earth. Returns NaN when the instrument does not intersect the Earth.
+     **********************************************************************************************/
+    template <class T>
+    static T slantRange(T ang_rad, T h, T a);
+};
+
+template <class T>
+void GeometryKernels::dot(const T* ax, const T* ay, const T* az, const T* bx, const T* by, const T* bz,
+    std::size_t n, T* out)
+{
+    #pragma omp simd
+    for(std::size_t i = 0; i < n; i++) {
+        out[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+    }
+}
+
+template <class T>
+void GeometryKernels::arc(const T* ax, const T* ay, const T* az, const T* bx, const T* by, const T* bz,
+    std::size_t n, T* out)
+{
+    /* Same formulation as MathUtils::arc (well-conditioned for small and large angles): */
+    #pragma omp simd
+    for(std::size_t i = 0; i < n; i++) {
+        T cx = ay[i] * bz[i] - az[i] * by[i];
+        T cy = az[i] * bx[i] - ax[i] * bz[i];
+        T cz = ax[i] * by[i] - ay[i] * bx[i];
+        T d  = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+        out[i] = std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), d);
+    }
+}
+
+template <class T>
+void GeometryKernels::arc(const sf::Vector3<T>& a, const T* bx, const T* by, const T* bz, std::size_t n, T* out)
+{
+    const T ax = a.x;
+    const T ay = a.y;
+    const T az = a.z;
+    #pragma omp simd
+    for(std::size_t i = 0; i < n; i++) {
+        T cx = ay * bz[i] - az * by[i];
+        T cy = az * bx[i] - ax * bz[i];
+        T cz = ax * by[i] - ay * bx[i];
+        T d  = ax * bx[i] + ay * by[i] + az * bz[i];
+        out[i] = std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), d);
+    }
+}
+
+template <class T>
+void GeometryKernels::latLonToUnit(const T* lat, const T* lng, std::size_t n, T* x, T* y, T* z)
+{
+    #pragma omp simd
+    for(std::size_t i = 0; i < n; i++) {
+        T cl = std::cos(lat[i]);
+        x[i] = cl * std::cos(lng[i]);
+        y[i] = cl * std::sin(lng[i]);
+        z[i] = std::sin(lat[i]);
+    }
+}
+
+template <class T>
+T GeometryKernels::footprintArc(T ang_rad, T h, T a)
+{
+    /*  Same triangle as BasicInstrument::getSlantRangeAt (α = π - λ - ẟ, with λ = π - asin(...)),
+     *  but without the intermediate subtraction from π, which loses most significant digits of α
+     *  in single precision.
+     **/
+    return std::asin((h / a) * std::sin(ang_rad)) - ang_rad;
+}
+
+template <class T>
+T GeometryKernels::slantRange(T ang_rad, T h, T a)
+{
+    return a * std::sin(footprintArc(ang_rad, h, a)) / std::sin(ang_rad);
+}
+
+#endif /* GEOMETRY_KERNELS_HPP */
@@ -0,0 +1,148 @@
+/***********************************************************************************************//**
+ *  Single-producer/single-consumer ring buffer.
+ *  @class      RingBuffer
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-25
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef RING_BUFFER_HPP
+#define RING_BUFFER_HPP
+
+#include "prot.hpp"
+#include <atomic>
+
+/***********************************************************************************************//**
+ *  FIFO queue where one thread pushes (the producer) and another thread reads and pops (the
+ *  consumer) without locks: the producer publishes new elements by releasing the tail index and
+ *  the consumer releases slots by advancing the head index. Elements are stored in a contiguous
+ *  buffer whose capacity is a power of two.
+ *  NOTE: The producer doubles the capacity when the buffer is full. Growing moves the elements
+ *  and, therefore, must not overlap with the consumer (e.g. agent links only push to their peers
+ *  in the sequential phase of Agent::stepTwoPhase).
+ **************************************************************************************************/
+template <class T>
+class RingBuffer
+{
+public:
+    RingBuffer(std::size_t capacity = 8);
+
+    /*******************************************************************************************//**
+     *  Copies the contents of another buffer. Not thread-safe (meant to set up containers).
+     **********************************************************************************************/
+    RingBuffer(const RingBuffer& other);
+    RingBuffer& operator=(const RingBuffer& other);
+
+    /*******************************************************************************************//**
+     *  Appends an element at the end of the queue (producer).
+     **********************************************************************************************/
+    void push(T v);
+
+    /*******************************************************************************************//**
+     *  Number of elements in the queue. Exact when called by the consumer or the producer (the
+     *  other side can only make it grow or shrink, respectively).
+     **********************************************************************************************/
+    std::size_t size(void) const { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+    bool empty(void) const { return size() == 0; }
+
+    /*******************************************************************************************//**
+     *  Access to the i-th element from the front of the queue (consumer).
+     **********************************************************************************************/
+    T& operator[](std::size_t i) { return m_buffer[(m_head.load(std::memory_order_relaxed) + i) & m_mask]; }
+    const T& operator[](std::size_t i) const { return m_buffer[(m_head.load(std::memory_order_relaxed) + i) & m_mask]; }
+    T& front(void) { return (*this)[0]; }
+
+    /*******************************************************************************************//**
+     *  Removes the element at the front of the queue (consumer).
+     **********************************************************************************************/
+    void pop(void);
+
+    /*******************************************************************************************//**
+     *  Removes all the elements (consumer).
+     **********************************************************************************************/
+    void clear(void);
+
+private:
+    std::vector<T> m_buffer;
+    std::size_t m_mask;
+    std::atomic<std::size_t> m_head;    /**< Index of the first element (written by the consumer). */
+    std::atomic<std::size_t> m_tail;    /**< Index past the last element (written by the producer). */
+
+    void grow(void);
+};
+
+template <class T>
+RingBuffer<T>::RingBuffer(std::size_t capacity)
+    : m_head(0)
+    , m_tail(0)
+{
+    std::size_t c = 1;
+    while(c < capacity) {
+        c <<= 1;
+    }
+    m_buffer.resize(c);
+    m_mask = c - 1;
+}
+
+template <class T>
+RingBuffer<T>::RingBuffer(const RingBuffer& other)
+    : m_buffer(other.m_buffer)
+    , m_mask(other.m_mask)
+    , m_head(other.m_head.load())
+    , m_tail(other.m_tail.load())
+{ }
+
+template <class T>
+RingBuffer<T>& RingBuffer<T>::operator=(const RingBuffer& other)
+{
+    m_buffer = other.m_buffer;
+    m_mask = other.m_mask;
+    m_head.store(other.m_head.load());
+    m_tail.store(other.m_tail.load());
+    return *this;
+}
+
+template <class T>
+void RingBuffer<T>::push(T v)
+{
+    std::size_t t = m_tail.load(std::memory_order_relaxed);
+    if(t - m_head.load(std::memory_order_acquire) == m_buffer.size()) {
+        grow();
+    }
+    m_buffer[t & m_mask] = std::move(v);
+    m_tail.store(t + 1, std::memory_order_release);
+}
+
+template <class T>
+void RingBuffer<T>::pop(void)
+{
+    std::size_t h = m_head.load(std::memory_order_relaxed);
+    m_buffer[h & m_mask] = T();     /* Releases the resources held by the element. */
+    m_head.store(h + 1, std::memory_order_release);
+}
+
+template <class T>
+void RingBuffer<T>::clear(void)
+{
+    while(!empty()) {
+        pop();
+    }
+}
+
+template <class T>
+void RingBuffer<T>::grow(void)
+{
+    std::size_t h = m_head.load(std::memory_order_acquire);
+    std::size_t t = m_tail.load(std::memory_order_relaxed);
+    std::vector<T> buffer(m_buffer.size() * 2);
+    std::size_t mask = buffer.size() - 1;
+    for(std::size_t i = h; i != t; i++) {
+        buffer[i & mask] = std::move(m_buffer[i & m_mask]);
+    }
+    m_buffer.swap(buffer);
+    m_mask = mask;
+}
+
+#endif /* RING_BUFFER_HPP */
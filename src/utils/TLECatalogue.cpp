@@ -0,0 +1,348 @@
+/***********************************************************************************************//**
+ *  Bulk loader of Two-Line Element catalogues.
+ *  @class      TLECatalogue
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#include "TLECatalogue.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+CREATE_LOGGER(TLECatalogue)
+
+namespace
+{
+    enum RecordStatus : unsigned char {
+        RECORD_OK = 0,
+        RECORD_BAD_FORMAT,
+        RECORD_BAD_CHECKSUM_1,
+        RECORD_BAD_CHECKSUM_2,
+        RECORD_BAD_NUMBER,
+        RECORD_OUT_OF_RANGE,
+    };
+
+    const char* const record_status_str[] = {
+        "ok",
+        "unexpected format",
+        "wrong checksum in line 1",
+        "wrong checksum in line 2",
+        "satellite numbers of lines 1 and 2 differ",
+        "elements out of range"
+    };
+
+    struct Line {
+        const char* p;
+        std::size_t len;
+        std::size_t number;     /* Line number in the file (1-based), for error reporting. */
+    };
+
+    struct RawRecord {
+        Line l0;                /* Name line (len = 0 in two-line sets). */
+        Line l1;
+        Line l2;
+    };
+
+    const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+        1e14, 1e15, 1e16, 1e17, 1e18 };
+
+    bool isElementLine(const Line& l, char n) { return l.len >= 69 && l.p[0] == n && l.p[1] == ' '; }
+
+    /*  Fixed-column parsers. Fields may be padded with blanks on either side. Decimals are built
+     *  from an integer mantissa and a single (exact) power of ten, so that results are correctly
+     *  rounded, i.e. equal to those of std::stod for the same text.
+     **/
+    bool parseInt(const char* p, int n, int& out)
+    {
+        int i = 0;
+        while(i < n && p[i] == ' ') i++;
+        bool neg = (i < n && (p[i] == '-' || p[i] == '+') ? p[i++] == '-' : false);
+        int v = 0;
+        for(; i < n && p[i] >= '0' && p[i] <= '9'; i++) {
+            v = v * 10 + (p[i] - '0');
+        }
+        while(i < n && p[i] == ' ') i++;
+        out = (neg ? -v : v);
+        return i == n;
+    }
+
+    bool parseDecimal(const char* p, int n, double& out)
+    {
+        int i = 0;
+        while(i < n && p[i] == ' ') i++;
+        bool neg = (i < n && (p[i] == '-' || p[i] == '+') ? p[i++] == '-' : false);
+        std::int64_t mant = 0;
+        int frac_digits = 0, digits = 0;
+        for(; i < n && p[i] >= '0' && p[i] <= '9'; i++, digits++) {
+            mant = mant * 10 + (p[i] - '0');
+        }
+        if(i < n && p[i] == '.') {
+            for(i++; i < n && p[i] >= '0' && p[i] <= '9'; i++, digits++, frac_digits++) {
+                mant = mant * 10 + (p[i] - '0');
+            }
+        }
+        while(i < n && p[i] == ' ') i++;
+        if(i != n || digits == 0 || digits > 18) {
+            return false;
+        }
+        out = (double)mant / pow10[frac_digits];
+        out = (neg ? -out : out);
+        return true;
+    }
+
+    /*  Decimal with an implied leading point and an exponent (e.g. " 12345-4" = 0.12345e-4). **/
+    bool parseExpDecimal(const char* p, int n, double& out)
+    {
+        int mant, exp;
+        if(!parseInt(p, n - 2, mant) || !parseInt(p + n - 2, 2, exp)) {
+            return false;
+        }
+        int e = exp - (n - 3);  /* Mantissa digits (sign excluded). */
+        out = (e < 0 ? mant / pow10[-e] : mant * pow10[e]);
+        return true;
+    }
+
+    bool checksum(const Line& l)
+    {
+        int sum = 0;
+        for(int i = 0; i < 68; i++) {
+            char c = l.p[i];
+            if(c >= '0' && c <= '9') {
+                sum += c - '0';
+            } else if(c == '-') {
+                sum++;
+            }
+        }
+        return (sum % 10) == (l.p[68] - '0');
+    }
+
+    RecordStatus parseRecord(const RawRecord& raw, TLERecord& r)
+    {
+        const char* l1 = raw.l1.p;
+        const char* l2 = raw.l2.p;
+        int sat_number_2;
+        double ecc;
+        if(!parseInt(l1 + 2, 5, r.sat_number) ||
+            !parseInt(l1 + 18, 2, r.epoch_year) ||
+            !parseDecimal(l1 + 20, 12, r.epoch_doy) ||
+            !parseExpDecimal(l1 + 53, 8, r.bstar) ||
+            !parseInt(l2 + 2, 5, sat_number_2) ||
+            !parseDecimal(l2 + 8, 8, r.orbit_params.inc) ||
+            !parseDecimal(l2 + 17, 8, r.orbit_params.raan) ||
+            !parseDecimal(l2 + 26, 7, ecc) ||
+            !parseDecimal(l2 + 34, 8, r.orbit_params.argp) ||
+            !parseDecimal(l2 + 43, 8, r.mean_anomaly) ||
+            !parseDecimal(l2 + 52, 11, r.mean_motion) ||
+            !parseInt(l2 + 63, 5, r.revolutions)) {
+            return RECORD_BAD_FORMAT;
+        }
+        if(!checksum(raw.l1)) {
+            return RECORD_BAD_CHECKSUM_1;
+        }
+        if(!checksum(raw.l2)) {
+            return RECORD_BAD_CHECKSUM_2;
+        }
+        if(r.sat_number != sat_number_2) {
+            return RECORD_BAD_NUMBER;
+        }
+        r.classification = l1[7];
+        r.orbit_params.ecc = ecc / 10000000.0;
+        r.orbit_params.mean_motion = r.mean_motion;
+
+        /* Semi-major axis (as in TLE::parseLine2): */
+        double period = 86400.0 / r.mean_motion;
+        double value = std::pow(period / (2 * Config::pi), 2);
+        r.orbit_params.sma = std::pow(Config::earth_mu * value, (1.0 / 3));
+        r.orbit_params.sma = floor(r.orbit_params.sma * 1000) / 1000;
+
+        if(r.orbit_params.inc < 0.0 || r.orbit_params.inc > 360.0 ||
+            r.orbit_params.raan < 0.0 || r.orbit_params.raan > 360.0 ||
+            r.orbit_params.ecc < 0.0 || r.orbit_params.ecc >= 1.0 ||
+            r.orbit_params.argp < 0.0 || r.orbit_params.argp > 360.0 ||
+            r.mean_anomaly < 0.0 || r.mean_anomaly > 360.0 ||
+            r.mean_motion == 0.0 || r.orbit_params.sma < Config::earth_radius) {
+            return RECORD_OUT_OF_RANGE;
+        }
+
+        /* Name: Space-Track prefixes it with "0 "; two-line sets are named after their number. */
+        const char* name = raw.l0.p;
+        std::size_t name_len = raw.l0.len;
+        if(name_len > 2 && name[0] == '0' && name[1] == ' ') {
+            name += 2;
+            name_len -= 2;
+        }
+        while(name_len > 0 && std::isspace((unsigned char)name[0])) {
+            name++;
+            name_len--;
+        }
+        r.sat_name = (name_len > 0 ? std::string(name, name_len) : std::to_string(r.sat_number));
+        return RECORD_OK;
+    }
+}
+
+double TLERecord::getEpochJD(void) const
+{
+    int y = (epoch_year < 57 ? 2000 + epoch_year : 1900 + epoch_year) - 1;
+    double jd_jan1 = 1721425.5 + 365.0 * y + (y / 4) - (y / 100) + (y / 400);
+    return jd_jan1 + epoch_doy - 1.0;
+}
+
+TLE TLERecord::toTLE(void) const
+{
+    TLE t;
+    t.sat_name = sat_name;
+    t.sat_number = sat_number;
+    t.classification = std::string(1, classification);
+    t.epoch_year = epoch_year;
+    t.epoch_doy = epoch_doy;
+    t.bstar = bstar;
+    t.orbit_params = orbit_params;
+    t.mean_anomaly = mean_anomaly;
+    t.mean_motion = mean_motion;
+    t.revolutions = revolutions;
+    return t;
+}
+
+TLECatalogue::TLECatalogue(std::string path)
+{
+    load(path);
+}
+
+std::size_t TLECatalogue::load(std::string path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        throw std::runtime_error("Unable to open TLE collection file: \'" + path + "\'.");
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Unable to read TLE collection file: \'" + path + "\'.");
+    }
+    std::size_t len = st.st_size;
+    if(len == 0) {
+        close(fd);
+        return 0;
+    }
+    void* data = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    std::size_t retval;
+    if(data != MAP_FAILED) {
+        madvise(data, len, MADV_SEQUENTIAL);
+        retval = parse((const char*)data, len);
+        munmap(data, len);
+    } else {
+        /* Not mappable (e.g. a pipe): */
+        std::ifstream f(path, std::ios::in | std::ios::binary);
+        std::string contents((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+        retval = parse(contents.data(), contents.size());
+    }
+    return retval;
+}
+
+std::size_t TLECatalogue::parse(const char* data, std::size_t len)
+{
+    /* Split in lines (trailing whitespace and CR removed, blank lines skipped): */
+    std::vector<Line> lines;
+    lines.reserve(len / 70 + 1);
+    const char* end = data + len;
+    std::size_t number = 1;
+    for(const char* p = data; p < end; number++) {
+        const char* eol = (const char*)std::memchr(p, '\n', end - p);
+        eol = (eol == nullptr ? end : eol);
+        std::size_t l = eol - p;
+        while(l > 0 && std::isspace((unsigned char)p[l - 1])) {
+            l--;
+        }
+        if(l > 0) {
+            lines.push_back({p, l, number});
+        }
+        p = eol + 1;
+    }
+
+    /* Group lines in records: */
+    std::vector<RawRecord> raws;
+    raws.reserve(lines.size() / 3 + 1);
+    std::vector<std::size_t> bad_lines;
+    for(std::size_t i = 0; i < lines.size(); ) {
+        if(i + 2 < lines.size() && isElementLine(lines[i + 1], '1') && isElementLine(lines[i + 2], '2')) {
+            raws.push_back({lines[i], lines[i + 1], lines[i + 2]});
+            i += 3;
+        } else if(i + 1 < lines.size() && isElementLine(lines[i], '1') && isElementLine(lines[i + 1], '2')) {
+            raws.push_back({{lines[i].p, 0, lines[i].number}, lines[i], lines[i + 1]});
+            i += 2;
+        } else {
+            bad_lines.push_back(lines[i].number);
+            i++;
+        }
+    }
+
+    /* Parse: */
+    std::vector<TLERecord> records(raws.size());
+    std::vector<unsigned char> status(raws.size());
+    #pragma omp parallel for schedule(static)
+    for(std::size_t i = 0; i < raws.size(); i++) {
+        status[i] = parseRecord(raws[i], records[i]);
+    }
+
+    std::size_t n_bad = 0;
+    m_records.reserve(m_records.size() + records.size());
+    for(std::size_t i = 0; i < records.size(); i++) {
+        if(status[i] == RECORD_OK) {
+            m_records.push_back(std::move(records[i]));
+        } else {
+            if(n_bad < 10) {
+                Log::warn << "TLE record at line " << raws[i].l1.number << " skipped: " << record_status_str[status[i]] << ".\n";
+            }
+            n_bad++;
+        }
+    }
+    if(!bad_lines.empty()) {
+        Log::warn << "Ignored " << bad_lines.size() << " lines not belonging to any TLE record (first: line " << bad_lines[0] << ").\n";
+    }
+    if(n_bad > 0) {
+        Log::warn << n_bad << " TLE records could not be parsed.\n";
+    }
+    return n_bad + bad_lines.size();
+}
+
+TLECatalogue TLECatalogue::filter(std::function<bool(const TLERecord&)> pred) const
+{
+    TLECatalogue retval;
+    std::copy_if(m_records.begin(), m_records.end(), std::back_inserter(retval.m_records), pred);
+    return retval;
+}
+
+TLECatalogue TLECatalogue::filterByName(std::string prefix) const
+{
+    return filter([&prefix](const TLERecord& r) { return r.sat_name.compare(0, prefix.size(), prefix) == 0; });
+}
+
+TLECatalogue TLECatalogue::filterByInclination(double inc_min, double inc_max) const
+{
+    return filter([=](const TLERecord& r) { return r.orbit_params.inc >= inc_min && r.orbit_params.inc <= inc_max; });
+}
+
+TLECatalogue TLECatalogue::filterByEpoch(double jd_min, double jd_max) const
+{
+    return filter([=](const TLERecord& r) {
+        double jd = r.getEpochJD();
+        return jd >= jd_min && jd <= jd_max;
+    });
+}
+
+std::vector<OrbitalParams> TLECatalogue::getOrbitalParams(void) const
+{
+    std::vector<OrbitalParams> retval(m_records.size());
+    #pragma omp parallel for schedule(static)
+    for(std::size_t i = 0; i < m_records.size(); i++) {
+        retval[i] = m_records[i].orbit_params;
+    }
+    return retval;
+}
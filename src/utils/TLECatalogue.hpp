@@ -0,0 +1,110 @@
+/***********************************************************************************************//**
+ *  Bulk loader of Two-Line Element catalogues.
+ *  @class      TLECatalogue
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef TLE_CATALOGUE_HPP
+#define TLE_CATALOGUE_HPP
+
+#include "prot.hpp"
+#include <functional>
+#include "TLE.hpp"
+#include "AgentMotion.hpp"  /* Provides OrbitalParams struct. */
+
+/***********************************************************************************************//**
+ *  Elements of a catalogue entry. Units follow the TLE class: angles in degrees, mean motion in
+ *  revolutions per day (also in orbit_params) and semi-major axis in meters.
+ **************************************************************************************************/
+struct TLERecord
+{
+    std::string sat_name;               /**< Satellite name (line 0, or the catalogue number). */
+    int sat_number;                     /**< Satellite catalogue number. */
+    char classification;                /**< U, C or S. */
+    int epoch_year;                     /**< Last two digits of the epoch year. */
+    double epoch_doy;                   /**< Day and fractional day of the epoch. */
+    double bstar;                       /**< BSTAR drag term (1/earth radii). */
+    double mean_anomaly;                /**< Mean anomaly at epoch [deg]. */
+    double mean_motion;                 /**< Mean motion [rev/day]. */
+    int revolutions;                    /**< Revolution number at epoch. */
+    OrbitalParams orbit_params;         /**< Orbital parameters (as parsed by TLE). */
+
+    /*******************************************************************************************//**
+     *  Epoch as a Julian date (two-digit years 57-99 are 19xx, 00-56 are 20xx).
+     **********************************************************************************************/
+    double getEpochJD(void) const;
+
+    /*******************************************************************************************//**
+     *  Builds the equivalent TLE object (public fields only, element lines are not regenerated).
+     **********************************************************************************************/
+    TLE toTLE(void) const;
+};
+
+/***********************************************************************************************//**
+ *  Parses TLE collection files (three-line sets with the satellite name, or plain two-line sets)
+ *  in bulk: the file is memory-mapped and split into records, and records are parsed in parallel
+ *  with fixed-column numeric parsers (no regular expressions, streams or intermediate strings).
+ *  Parsing follows TLE::setTLE: checksums and element ranges are validated and records that fail
+ *  are skipped (and reported once the file has been parsed).
+ *  Subsets of a catalogue are obtained with the filter methods, which can be chained:
+ *      TLECatalogue c("active.txt");
+ *      auto leo = c.filterByName("STARLINK").filterByInclination(50.0, 56.0);
+ **************************************************************************************************/
+class TLECatalogue
+{
+public:
+    TLECatalogue(void) = default;
+
+    /*******************************************************************************************//**
+     *  Loads a catalogue file.
+     *  @throws runtime_error If the file can not be opened.
+     **********************************************************************************************/
+    TLECatalogue(std::string path);
+
+    /*******************************************************************************************//**
+     *  Parses the catalogue file in path and appends its valid records.
+     *  @returns    Number of records (and stray lines) that could not be parsed.
+     *  @throws     runtime_error If the file can not be opened.
+     **********************************************************************************************/
+    std::size_t load(std::string path);
+
+    /*******************************************************************************************//**
+     *  Parses a catalogue in memory (same format as the files) and appends its valid records.
+     *  @returns    Number of records (and stray lines) that could not be parsed.
+     **********************************************************************************************/
+    std::size_t parse(const char* data, std::size_t len);
+
+    /*******************************************************************************************//**
+     *  Filters. Each of them returns a new catalogue with the records that satisfy the condition.
+     *  @param  prefix      Beginning of the satellite name (case sensitive).
+     *  @param  inc_min     Lower bound of the inclination [deg] (inclusive).
+     *  @param  inc_max     Upper bound of the inclination [deg] (inclusive).
+     *  @param  jd_min      Lower bound of the epoch as a Julian date (inclusive).
+     *  @param  jd_max      Upper bound of the epoch as a Julian date (inclusive).
+     **********************************************************************************************/
+    TLECatalogue filter(std::function<bool(const TLERecord&)> pred) const;
+    TLECatalogue filterByName(std::string prefix) const;
+    TLECatalogue filterByInclination(double inc_min, double inc_max) const;
+    TLECatalogue filterByEpoch(double jd_min, double jd_max) const;
+
+    std::size_t size(void) const { return m_records.size(); }
+    bool empty(void) const { return m_records.empty(); }
+    const TLERecord& operator[](std::size_t i) const { return m_records[i]; }
+    const std::vector<TLERecord>& getRecords(void) const { return m_records; }
+    std::vector<TLERecord>::const_iterator begin(void) const { return m_records.begin(); }
+    std::vector<TLERecord>::const_iterator end(void) const { return m_records.end(); }
+
+    /*******************************************************************************************//**
+     *  Orbital parameters of all the records (in catalogue order).
+     **********************************************************************************************/
+    std::vector<OrbitalParams> getOrbitalParams(void) const;
+
+private:
+    std::vector<TLERecord> m_records;
+};
+
+#endif /* TLE_CATALOGUE_HPP */
@@ -0,0 +1,91 @@
+/***********************************************************************************************//**
+ *  Timer wheel of integer handles, indexed by simulation step.
+ *  @class      TimerWheel
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-25
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include "prot.hpp"
+
+/***********************************************************************************************//**
+ *  Schedules handles to be collected at a given step. Timers are stored in the slot of their step
+ *  (modulo the number of slots), so that scheduling is O(1) and collecting a step only visits the
+ *  timers of one slot. Timers further than one lap away stay in their slot until their step.
+ *  Steps that are not collected (e.g. skipped steps) are caught up in the next call to collect.
+ **************************************************************************************************/
+class TimerWheel
+{
+public:
+    TimerWheel(std::size_t slots = 64)
+        : m_slots(slots)
+        , m_last(0)
+        , m_collected(false)
+    { }
+
+    /*******************************************************************************************//**
+     *  Schedules handle `h` for step `k`. Timers in the past are collected in the next call.
+     **********************************************************************************************/
+    void schedule(long k, unsigned int h)
+    {
+        if(m_collected && k <= m_last) {
+            k = m_last + 1;
+        }
+        m_slots[slotOf(k)].push_back({k, h});
+    }
+
+    /*******************************************************************************************//**
+     *  Moves the handles of all the timers scheduled up to step `k` (included) into `out`. The
+     *  same handle can be appended more than once.
+     **********************************************************************************************/
+    void collect(long k, std::vector<unsigned int>& out)
+    {
+        if(!m_collected || k - m_last >= (long)m_slots.size()) {
+            for(std::size_t s = 0; s < m_slots.size(); s++) {
+                collectSlot(s, k, out);
+            }
+        } else {
+            for(long kk = m_last + 1; kk <= k; kk++) {
+                collectSlot(slotOf(kk), k, out);
+            }
+        }
+        m_last = std::max(m_last, k);
+        m_collected = true;
+    }
+
+private:
+    struct Timer {
+        long k;
+        unsigned int h;
+    };
+    std::vector<std::vector<Timer> > m_slots;
+    long m_last;            /**< Last step collected. */
+    bool m_collected;       /**< Whether collect has ever been called. */
+
+    std::size_t slotOf(long k) const
+    {
+        long n = (long)m_slots.size();
+        return (std::size_t)(((k % n) + n) % n);
+    }
+
+    void collectSlot(std::size_t s, long k, std::vector<unsigned int>& out)
+    {
+        auto& slot = m_slots[s];
+        for(std::size_t i = 0; i < slot.size(); ) {
+            if(slot[i].k <= k) {
+                out.push_back(slot[i].h);
+                slot[i] = slot.back();
+                slot.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+};
+
+#endif /* TIMER_WHEEL_HPP */
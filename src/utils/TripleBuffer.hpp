@@ -0,0 +1,88 @@
+/***********************************************************************************************//**
+ *  Single-producer/single-consumer triple buffer.
+ *  @class      TripleBuffer
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include "prot.hpp"
+#include <atomic>
+
+/***********************************************************************************************//**
+ *  Latest-value exchange between two threads without locks. The producer fills a back slot and
+ *  publishes it, the consumer acquires the last published slot and reads it as its front slot. A
+ *  third slot sits in the middle: publishing swaps it with the back slot and acquiring swaps it with
+ *  the front slot, so neither side ever waits for the other nor sees a slot while it is being
+ *  written. Values published while the consumer is busy are overwritten (only the latest one is
+ *  kept).
+ *  NOTE: Slots are reused, hence the producer finds in the back slot the value it published two
+ *  publications ago (or an older one), which allows to reuse its allocated memory.
+ **************************************************************************************************/
+template <class T>
+class TripleBuffer
+{
+public:
+    TripleBuffer(void);
+
+    /*******************************************************************************************//**
+     *  Slot to be filled before calling TripleBuffer::publish (producer).
+     **********************************************************************************************/
+    T& back(void) { return m_slots[m_back]; }
+
+    /*******************************************************************************************//**
+     *  Makes the back slot available to the consumer (producer).
+     **********************************************************************************************/
+    void publish(void);
+
+    /*******************************************************************************************//**
+     *  Moves the last published value to the front slot, if any (consumer).
+     *  @return True if a value has been published since the last call.
+     **********************************************************************************************/
+    bool acquire(void);
+
+    /*******************************************************************************************//**
+     *  Last acquired value (consumer).
+     **********************************************************************************************/
+    const T& front(void) const { return m_slots[m_front]; }
+
+private:
+    static const unsigned int fresh = 4;    /**< Flag of m_middle: set when it has not been acquired. */
+
+    T m_slots[3];
+    unsigned int m_back;                    /**< Slot index owned by the producer. */
+    unsigned int m_front;                   /**< Slot index owned by the consumer. */
+    std::atomic<unsigned int> m_middle;     /**< Slot index in the middle and fresh flag. */
+};
+
+template <class T>
+TripleBuffer<T>::TripleBuffer(void)
+    : m_slots()
+    , m_back(0)
+    , m_front(1)
+    , m_middle(2)
+{ }
+
+template <class T>
+void TripleBuffer<T>::publish(void)
+{
+    /* Acquire the slot released by the consumer (it may be the front slot it has just left): */
+    m_back = m_middle.exchange(m_back | fresh, std::memory_order_acq_rel) & ~fresh;
+}
+
+template <class T>
+bool TripleBuffer<T>::acquire(void)
+{
+    if((m_middle.load(std::memory_order_relaxed) & fresh) == 0) {
+        return false;
+    }
+    m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & ~fresh;
+    return true;
+}
+
+#endif /* TRIPLE_BUFFER_HPP */
@@ -0,0 +1,550 @@
+/***********************************************************************************************//**
+ *  Parameter sweep driver (replaces the process fan-out of batch/batch.sh).
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#include "prot.hpp"
+
+#include <climits>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Agent.hpp"
+#include "AgentBuilder.hpp"
+#include "Init.hpp"
+#include "ReportSet.hpp"
+#include "TaskPool.hpp"
+#include "Profiler.hpp"
+#include "MemoryReport.hpp"
+#include "Utils.hpp"
+
+CREATE_LOGGER(sweep)
+
+/*  A sweep specification (YAML) is a base configuration plus a grid of parameter values. Every
+ *  combination of values is a run, e.g.:
+ *
+ *      name: memory                                    # Output directories are named after it.
+ *      base: ../batch/set/memory/memory_10a.yml        # Like `-f` (relative to conf/ or absolute).
+ *      load: ../batch/set/memory/constellation-10.yml  # Optional, like `-l`.
+ *      args: [--random]                                # Optional, extra prot-3 arguments.
+ *      seed: 1                                         # Optional, runs are seeded with seed + index.
+ *      memory_limit: 4096                              # Optional, MiB per run (see --memory).
+ *      grid:
+ *          environment.model_unity_size: [2, 5, 10, 20]
+ *          agent.knowledge_base_size: [50, 100, 500, 1000, 5000]
+ *
+ *  Grid keys are paths of the configuration file (separated by dots).
+ **/
+struct SweepParam {
+    std::string key;
+    std::vector<YAML::Node> values;
+};
+
+struct SweepRun {
+    unsigned int idx;
+    std::string name;
+    std::vector<std::string> values;    /**< Value of each SweepParam in this run (as in the spec). */
+    std::string conf;                   /**< Configuration of this run (absolute path). */
+    std::string dir;                    /**< Output directory. */
+    std::string log;                    /**< Output of the run (log and errors). */
+    unsigned int attempts;
+    int status;                         /**< Exit code of the last attempt (-1: not run, >128: signal). */
+    double wall_time;                   /**< Wall time of the last attempt (s). */
+    long peak_rss;                      /**< Peak resident set size of the last attempt (KiB). */
+    pid_t pid;
+    std::chrono::steady_clock::time_point t_start;
+};
+
+struct Options {
+    std::string spec;
+    std::string out;
+    std::string root;
+    unsigned int jobs = 4;
+    unsigned int threads = 0;           /**< OpenMP threads per run (0: cores / jobs). */
+    unsigned long memory_limit = 0;     /**< Address space limit per run (MiB, 0: none). */
+    unsigned int attempts = 2;
+    bool dry_run = false;
+};
+
+enum RunExit { RUN_OK = 0, RUN_FAILED = 1, RUN_OUT_OF_MEMORY = 4 };
+
+void usage(const char* bin)
+{
+    std::cerr << "Usage: " << bin << " <sweep.yml> [options]\n"
+        << "  -j, --jobs <n>          Concurrent runs (default: 4).\n"
+        << "  -t, --threads <n>       Threads per run (default: cores / jobs).\n"
+        << "  -m, --memory <MiB>      Address space limit per run (as `ulimit -Sv`, overrides memory_limit).\n"
+        << "  -a, --attempts <n>      Attempts per failed run (default: 2).\n"
+        << "  -o, --out <dir>         Output directory (default: data/<date>_sweep_<name>/).\n"
+        << "  --dbg-rootdir <dir>     Root path of the project (as in prot-3).\n"
+        << "  -d, --dry-run           Writes the configurations and the index without running them.\n";
+}
+
+void setParam(YAML::Node node, std::vector<std::string>::const_iterator k, std::vector<std::string>::const_iterator end,
+    const YAML::Node& value)
+{
+    if(std::next(k) == end) {
+        node[*k] = YAML::Clone(value);
+    } else {
+        setParam(node[*k], std::next(k), end, value);
+    }
+}
+
+bool hasParam(const YAML::Node& node, std::vector<std::string>::const_iterator k, std::vector<std::string>::const_iterator end)
+{
+    if(k == end) {
+        return true;
+    }
+    return node.IsMap() && node[*k].IsDefined() && hasParam(node[*k], std::next(k), end);
+}
+
+/*  Writes the configuration of every combination of the grid (in the order of the spec, the last
+ *  key changes faster).
+ **/
+std::vector<SweepRun> expand(const YAML::Node& base, const std::vector<SweepParam>& params, const std::string& name,
+    const std::string& out)
+{
+    std::vector<SweepRun> runs;
+    std::vector<std::size_t> pos(params.size(), 0);
+    std::size_t n = 1;
+    for(auto& p : params) {
+        n *= p.values.size();
+    }
+    for(std::size_t i = 0; i < n; i++) {
+        SweepRun r = {};
+        r.idx = i;
+        std::stringstream ss;
+        ss << name << "_" << std::setw(3) << std::setfill('0') << i;
+        r.name = ss.str();
+        r.conf = out + "configs/" + r.name + ".yml";
+        r.dir = out + r.name + "/";
+        r.log = out + "logs/" + r.name + ".log";
+        r.status = -1;
+
+        YAML::Node conf = YAML::Clone(base);
+        conf["system"]["name"] = r.name;
+        for(std::size_t k = 0; k < params.size(); k++) {
+            auto path = Utils::split(params[k].key, '.');
+            setParam(conf, path.begin(), path.end(), params[k].values[pos[k]]);
+            YAML::Emitter e;
+            e << YAML::Flow << params[k].values[pos[k]];
+            r.values.push_back(e.c_str());
+        }
+        std::ofstream f(r.conf, std::ios::out | std::ios::trunc);
+        f << conf << "\n";
+        runs.push_back(r);
+
+        for(std::size_t k = params.size(); k-- > 0; ) {
+            if(++pos[k] < params[k].values.size()) {
+                break;
+            }
+            pos[k] = 0;
+        }
+    }
+    return runs;
+}
+
+/*  Runs a simulation in the calling process. The step loop is that of `control_loop` in main.cpp,
+ *  without the draw thread.
+ **/
+int runSimulation(const SweepRun& run, const std::vector<std::string>& extra_args, const std::string& load)
+{
+    std::vector<std::string> args = {"prot-3-sweep", "--simple-log", "-g0", "-d", run.dir, "-f", run.conf};
+    if(!load.empty()) {
+        args.insert(args.end(), {"-l", load});
+    }
+    args.insert(args.end(), extra_args.begin(), extra_args.end());
+    std::vector<char*> argv;
+    for(auto& a : args) {
+        argv.push_back(&a[0]);
+    }
+    Config::loadCmdArgs(argv.size(), argv.data());
+    Init::createOutputDirectories();
+    Config::enable_graphics = false;
+    if(Config::profiler_enable) {
+        Profiler::enable(Config::profiler_buffer_size);
+    }
+
+    std::vector<std::shared_ptr<Agent> > agents;
+    if(Config::load_agents_from_yaml) {
+        AgentBuilder agent_builder;
+        auto abset = agent_builder.load(Config::system_yml);
+        for(auto ab : abset) {
+            if(agents.size() < Config::n_agents) {
+                agents.push_back(std::make_shared<Agent>(&ab));
+            }
+        }
+        if(agents.size() != Config::n_agents) {
+            Log::err << "Error loading agents from YAML file. " << Config::n_agents << " agents were expected, "
+                << agents.size() << " have been loaded.\n";
+            return RUN_FAILED;
+        }
+    } else {
+        for(unsigned int i = 0; i < Config::n_agents; i++) {
+            AgentBuilder ab;
+            ab.generateAndStore("A" + std::to_string(i));
+            agents.push_back(std::make_shared<Agent>(&ab));
+        }
+    }
+    for(auto& a : agents) {
+        a->getLink()->setAgents(agents);
+    }
+    auto world = std::make_shared<World>();
+    world->addAgent(agents);
+    ReportSet::getInstance().outputAllHeaders();
+
+    std::unique_ptr<MemoryReport> memory_report;
+    auto report_memory = [&]() {
+        for(auto& a : agents) {
+            MemoryUsage mu;
+            a->getMemoryUsage(mu);
+            memory_report->add(a->getId(), mu);
+        }
+        MemoryUsage mu;
+        world->getMemoryUsage(mu);
+        memory_report->add("world", mu);
+        memory_report->commit();
+    };
+    if(Config::memory_report_period > 0) {
+        memory_report.reset(new MemoryReport());
+        report_memory();
+    }
+
+    int update_world_metrics = 0;
+    int memory_report_step = 0;
+    while(!VirtualTime::finished()) {
+        if(Config::event_driven) {
+            /* Same as `skip_idle_steps` in main.cpp: */
+            double t = VirtualTime::now();
+            unsigned int k_max = (10 - update_world_metrics % 10) % 10;
+            double steps_left = std::ceil((Config::start_epoch + Config::duration - t) / Config::time_step - 1e-3);
+            k_max = (steps_left <= 1.0 ? 0 : std::min(k_max, (unsigned int)steps_left - 1));
+            if(k_max > 0) {
+                double t_event = t + (k_max + 1) * Config::time_step;
+                for(auto& a : agents) {
+                    a->propagatePosition(k_max + 2);
+                }
+                for(auto& a : agents) {
+                    t_event = std::min(t_event, a->getNextEventTime(k_max));
+                }
+                double steps = std::ceil((t_event - t) / Config::time_step - 1e-3);
+                unsigned int k = (steps <= 1.0 ? 0 : std::min((unsigned int)steps - 1, k_max));
+                if(k > 0) {
+                    world->beginSkip();
+                    for(unsigned int i = 0; i < k; i++) {
+                        VirtualTime::step();
+                        for(auto& a : agents) {
+                            a->skipStep();
+                        }
+                        world->skipStep();
+                    }
+                    world->endSkip();
+                    update_world_metrics += k;
+                }
+            }
+        }
+        VirtualTime::step();
+        for(auto& a : agents) {
+            a->updatePosition();
+        }
+        TaskPool::parallelFor(agents.size(), 1, [&agents](std::size_t i) {
+            agents[i]->plan();
+        }, "planner", Config::parallel_planners);
+        if(Config::parallel_agent_step) {
+            Agent::stepTwoPhase(agents, true);
+        } else {
+            for(auto& a : agents) {
+                a->step();
+            }
+        }
+        world->step();
+        if(update_world_metrics % 10 == 0) {
+            world->computeMetrics();
+            ReportSet::getInstance().outputAll();
+        }
+        if(memory_report && update_world_metrics - memory_report_step >= (int)Config::memory_report_period) {
+            report_memory();
+            memory_report_step = update_world_metrics;
+        }
+        update_world_metrics++;
+    }
+    world->computeMetrics(true);
+    ReportSet::getInstance().outputAll();
+    TaskPool::logCounters();
+    if(memory_report) {
+        report_memory();
+        memory_report->writeSummary(Config::data_path + "memory_summary.csv");
+    }
+    if(Profiler::isEnabled()) {
+        Profiler::writeChromeTrace(Config::data_path + "profile_trace.json");
+        Profiler::writeCSV(Config::data_path + "profile.csv");
+    }
+    Log::dbg << "Simulation reached end time.\n";
+    return RUN_OK;
+}
+
+/*  Starts a run in a child process. The child inherits the state of the driver (configuration,
+ *  fonts and look-up tables) copy-on-write, and discards its own state at exit.
+ **/
+pid_t startRun(SweepRun& run, const Options& opts, const std::vector<std::string>& extra_args, const std::string& load,
+    int seed)
+{
+    run.attempts++;
+    run.t_start = std::chrono::steady_clock::now();
+    pid_t cpid = fork();
+    if(cpid == 0) {
+        int fd = open(run.log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd >= 0) {
+            dup2(fd, 1);
+            dup2(fd, 2);
+            close(fd);
+        }
+        if(opts.memory_limit > 0) {
+            struct rlimit rl;
+            rl.rlim_cur = rl.rlim_max = (rlim_t)opts.memory_limit * 1024 * 1024;
+            setrlimit(RLIMIT_AS, &rl);
+        }
+        omp_set_num_threads(opts.threads);
+        if(seed >= 0) {
+            Random::getUniformEngine().seed(seed + run.idx);
+        } else {
+            Random::doInit();
+        }
+        int retval = RUN_FAILED;
+        try {
+            retval = runSimulation(run, extra_args, load);
+        } catch(const std::bad_alloc& e) {
+            Log::err << "Run \'" << run.name << "\' exceeded its memory limit.\n";
+            retval = RUN_OUT_OF_MEMORY;
+        } catch(const std::exception& e) {
+            Log::err << "Run \'" << run.name << "\' failed: " << e.what() << "\n";
+        }
+        std::clog << std::flush;
+        std::_Exit(retval);     /* Skips the destruction of the simulation state. */
+    } else if(cpid < 0) {
+        Log::err << "Unable to fork for run \'" << run.name << "\'.\n";
+    }
+    run.pid = cpid;
+    return cpid;
+}
+
+bool writeIndex(const std::string& path, const std::vector<SweepParam>& params, const std::vector<SweepRun>& runs)
+{
+    std::ofstream f(path, std::ios::out | std::ios::trunc);
+    if(!f.is_open()) {
+        Log::err << "Unable to write the sweep index to \'" << path << "\'.\n";
+        return false;
+    }
+    f << "run,dir";
+    for(auto& p : params) {
+        f << "," << p.key;
+    }
+    f << ",status,attempts,wall_s,peak_rss_mib\n";
+    f << std::fixed << std::setprecision(1);
+    for(auto& r : runs) {
+        f << r.name << "," << r.dir;
+        for(auto& v : r.values) {
+            f << ",\"" << v << "\"";
+        }
+        std::string status = "pending";
+        if(r.status == RUN_OK) {
+            status = "ok";
+        } else if(r.status == RUN_OUT_OF_MEMORY) {
+            status = "out_of_memory";
+        } else if(r.status > 128) {
+            status = "signal_" + std::to_string(r.status - 128);
+        } else if(r.status > 0) {
+            status = "failed";
+        }
+        f << "," << status << "," << r.attempts << "," << r.wall_time << "," << r.peak_rss / 1024.0 << "\n";
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    for(int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        bool has_value = (i + 1 < argc);
+        if((arg == "-j" || arg == "--jobs") && has_value) {
+            opts.jobs = std::max(1, std::stoi(argv[++i]));
+        } else if((arg == "-t" || arg == "--threads") && has_value) {
+            opts.threads = std::stoi(argv[++i]);
+        } else if((arg == "-m" || arg == "--memory") && has_value) {
+            opts.memory_limit = std::stoul(argv[++i]);
+        } else if((arg == "-a" || arg == "--attempts") && has_value) {
+            opts.attempts = std::max(1, std::stoi(argv[++i]));
+        } else if((arg == "-o" || arg == "--out") && has_value) {
+            opts.out = argv[++i];
+        } else if(arg == "--dbg-rootdir" && has_value) {
+            opts.root = argv[++i];
+        } else if(arg == "-d" || arg == "--dry-run") {
+            opts.dry_run = true;
+        } else if(arg[0] != '-' && opts.spec.empty()) {
+            opts.spec = arg;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if(opts.spec.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    /* Shared state (fonts, colour gradients), loaded once for all runs: */
+    Init::doInit();
+    if(!opts.root.empty()) {
+        Config::root_path = (opts.root.back() == '/' ? opts.root : opts.root + "/");
+    }
+
+    YAML::Node spec, base;
+    std::vector<SweepParam> params;
+    std::string name, base_file, load;
+    std::vector<std::string> extra_args;
+    int seed = -1;
+    try {
+        spec = YAML::LoadFile(opts.spec);
+        name = (spec["name"].IsDefined() ? spec["name"].as<std::string>() : std::string("sweep"));
+        base_file = spec["base"].as<std::string>();
+        base_file = (base_file[0] == '/' ? base_file : Config::root_path + "conf/" + base_file);
+        base = YAML::LoadFile(base_file);
+        if(spec["load"].IsDefined()) {
+            load = spec["load"].as<std::string>();
+            load = (load[0] == '/' ? load : Config::root_path + "conf/" + load);
+        }
+        if(spec["args"].IsDefined()) {
+            extra_args = spec["args"].as<std::vector<std::string> >();
+        }
+        if(spec["seed"].IsDefined()) {
+            seed = spec["seed"].as<int>();
+        }
+        if(spec["memory_limit"].IsDefined() && opts.memory_limit == 0) {
+            opts.memory_limit = spec["memory_limit"].as<unsigned long>();
+        }
+        for(auto p : spec["grid"]) {
+            SweepParam sp;
+            sp.key = p.first.as<std::string>();
+            if(p.second.IsSequence()) {
+                for(auto v : p.second) {
+                    sp.values.push_back(v);
+                }
+            } else {
+                sp.values.push_back(p.second);
+            }
+            auto path = Utils::split(sp.key, '.');
+            if(!hasParam(base, path.begin(), path.end())) {
+                Log::warn << "Parameter \'" << sp.key << "\' is not in the base configuration (it will be added).\n";
+            }
+            params.push_back(sp);
+        }
+    } catch(const std::exception& e) {
+        Log::err << "Unable to load the sweep specification \'" << opts.spec << "\': " << e.what() << "\n";
+        return 1;
+    }
+
+    if(opts.out.empty()) {
+        std::time_t t = std::time(nullptr);
+        char str[100];
+        std::strftime(str, sizeof(str), "%Y_%m_%d_%H%M%S", std::localtime(&t));
+        opts.out = Config::root_path + "data/" + str + "_sweep_" + name + "/";
+    } else if(opts.out.back() != '/') {
+        opts.out += "/";
+    }
+    if(opts.out[0] != '/') {
+        char cwd[PATH_MAX];
+        if(getcwd(cwd, sizeof(cwd)) != nullptr) {
+            opts.out = std::string(cwd) + "/" + opts.out;
+        }
+    }
+    std::string cmd = "mkdir -p " + opts.out + "configs " + opts.out + "logs";
+    if(std::system(cmd.c_str()) != 0) {
+        Log::err << "Unable to create the output directory: " << opts.out << ". Check permissions.\n";
+        return 1;
+    }
+    if(opts.threads == 0) {
+        opts.threads = std::max(1u, std::thread::hardware_concurrency() / opts.jobs);
+    }
+
+    std::vector<SweepRun> runs = expand(base, params, name, opts.out);
+    std::string index = opts.out + "index.csv";
+    writeIndex(index, params, runs);
+    Log::dbg << "Sweep \'" << name << "\': " << runs.size() << " runs, " << opts.jobs << " concurrent, "
+        << opts.threads << " threads each" << (opts.memory_limit > 0 ? ", limit of " + std::to_string(opts.memory_limit)
+        + " MiB each" : "") << ". Output in \'" << opts.out << "\'.\n";
+    if(opts.dry_run) {
+        return 0;
+    }
+
+    /*  Immutable data shared by all runs (copy-on-write): the configuration of the base file and the
+     *  ECEF coordinates of the world cells. Logs go to the log file of each run from now on.
+     **/
+    std::vector<std::string> base_args = {"prot-3-sweep", "--simple-log", "-g0", "-d", opts.out, "-f", base_file};
+    std::vector<char*> base_argv;
+    for(auto& a : base_args) {
+        base_argv.push_back(&a[0]);
+    }
+    LogStream::setLogLevel(LogStream::Level::ERROR);
+    Config::loadCmdArgs(base_argv.size(), base_argv.data());
+    if(Config::motion_model == AgentMotionType::ORBITAL) {
+        World::buildPositionLUT();
+    }
+    LogStream::setLogLevel(LogStream::Level::DEBUG);
+
+    std::size_t next = 0;
+    unsigned int running = 0, failed = 0;
+    std::vector<std::size_t> queue(runs.size());
+    std::iota(queue.begin(), queue.end(), 0);
+    while(next < queue.size() || running > 0) {
+        while(running < opts.jobs && next < queue.size()) {
+            SweepRun& r = runs[queue[next++]];
+            if(startRun(r, opts, extra_args, load, seed) > 0) {
+                running++;
+            } else {
+                r.status = RUN_FAILED;
+            }
+        }
+        if(running == 0) {
+            break;
+        }
+        int status;
+        struct rusage ru;
+        pid_t cpid = wait4(-1, &status, 0, &ru);
+        if(cpid < 0) {
+            break;
+        }
+        auto it = std::find_if(runs.begin(), runs.end(), [cpid](const SweepRun& r) { return r.pid == cpid; });
+        if(it == runs.end()) {
+            continue;
+        }
+        running--;
+        SweepRun& r = *it;
+        r.pid = 0;
+        r.status = (WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+        r.wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - r.t_start).count();
+        r.peak_rss = ru.ru_maxrss;
+        if(r.status == RUN_OK) {
+            Log::dbg << "[ OK ] " << r.name << " (" << std::fixed << std::setprecision(1) << r.wall_time << " s, "
+                << r.peak_rss / 1024.0 << " MiB).\n";
+        } else if(r.attempts < opts.attempts) {
+            Log::warn << "[FAIL] " << r.name << " (status " << r.status << ", attempt " << r.attempts << "). Retrying.\n";
+            queue.push_back(r.idx);
+        } else {
+            Log::err << "[FAIL] " << r.name << " (status " << r.status << ", attempt " << r.attempts << "). See \'"
+                << r.log << "\'.\n";
+            failed++;
+        }
+        writeIndex(index, params, runs);
+    }
+    writeIndex(index, params, runs);
+    Log::dbg << "Sweep finished: " << runs.size() - failed << " of " << runs.size() << " runs completed. Index: \'"
+        << index << "\'.\n";
+    return (failed > 0 ? 1 : 0);
+}
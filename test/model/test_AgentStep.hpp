@@ -0,0 +1,142 @@
+/***********************************************************************************************//**
+ *  Unit-test for the two-phase (parallel) agent step.
+ *  @class      AgentStepTest
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-24
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef TEST_AGENT_STEP_HPP
+#define TEST_AGENT_STEP_HPP
+
+#include "prot.hpp"
+#include "Agent.hpp"
+#include "AgentBuilder.hpp"
+#include "PayoffFunctions.hpp"
+
+namespace
+{
+    class AgentStepTest : public ::testing::Test
+    {
+    protected:
+        const unsigned int n_agents = 6;
+        const unsigned int n_steps = 300;
+
+        /* State of one agent after a simulation: */
+        struct AgentState {
+            double energy;
+            unsigned int own_activities;
+            unsigned int pending_activities;
+            unsigned int others_activities;
+            bool link_enabled;
+            sf::Vector3f position;
+        };
+
+        AgentMotionType motion_model;
+        PayoffModel payoff_model;
+        int interpos;
+        float range_min, range_max;
+        unsigned int planning_window, replanning_window, ga_generations;
+
+        virtual void SetUp(void) {
+            motion_model = Config::motion_model;
+            payoff_model = Config::payoff_model;
+            interpos = Config::interpos;
+            range_min = Config::agent_range_min;
+            range_max = Config::agent_range_max;
+            planning_window = Config::agent_planning_window;
+            replanning_window = Config::agent_replanning_window;
+            ga_generations = Config::ga_generations;
+
+            Config::motion_model = AgentMotionType::ORBITAL;
+            Config::payoff_model = PayoffModel::LINEAR;
+            Config::interpos = 2;
+            Config::agent_range_min = 6000e3f;  /* Long ranges so that agents exchange activities. */
+            Config::agent_range_max = 8000e3f;
+            Config::agent_planning_window = 360;
+            Config::agent_replanning_window = 60;
+            Config::ga_generations = 50;
+            PayoffFunctions::bindPayoffFunctions();
+        }
+
+        virtual void TearDown(void) {
+            Config::motion_model = motion_model;
+            Config::payoff_model = payoff_model;
+            Config::interpos = interpos;
+            Config::agent_range_min = range_min;
+            Config::agent_range_max = range_max;
+            Config::agent_planning_window = planning_window;
+            Config::agent_replanning_window = replanning_window;
+            Config::ga_generations = ga_generations;
+            PayoffFunctions::bindPayoffFunctions();
+        }
+
+        /*  Creates a new set of agents (always the same) and runs it. Returns the final state of
+         *  every agent, followed by the next value of Random (to check that both runs have drawn
+         *  the same random numbers).
+         **/
+        std::pair<std::vector<AgentState>, float> run(bool parallel) {
+            Random::getUniformEngine().seed(1234);
+            VirtualTime::doInit(Config::start_epoch);
+            std::vector<std::shared_ptr<Agent> > agents;
+            for(unsigned int i = 0; i < n_agents; i++) {
+                AgentBuilder ab;
+                ab.generateAndStore("A" + std::to_string(i));
+                agents.push_back(std::make_shared<Agent>(&ab));
+            }
+            for(auto& a : agents) {
+                a->getLink()->setAgents(agents);
+                a->getLink()->enable();   /* Otherwise, links are enabled after the first plan. */
+            }
+            for(unsigned int s = 0; s < n_steps; s++) {
+                VirtualTime::step();
+                for(auto& a : agents) {
+                    a->updatePosition();
+                }
+                for(auto& a : agents) {
+                    a->plan();
+                }
+                Agent::stepTwoPhase(agents, parallel);
+            }
+            std::vector<AgentState> retval;
+            for(auto& a : agents) {
+                unsigned int others = 0;
+                for(auto& b : agents) {
+                    if(b != a) {
+                        others += a->getActivityHandler()->count(b->getId());
+                    }
+                }
+                retval.push_back({
+                    a->getResource("energy")->getCapacity(),
+                    a->getActivityHandler()->count(a->getId()),
+                    a->getActivityHandler()->pending(),
+                    others,
+                    a->getLink()->isEnabled(),
+                    a->getMotion().getPosition()
+                });
+            }
+            return std::make_pair(retval, Random::getUf());
+        }
+    };
+
+    TEST_F(AgentStepTest, ParallelEqualsSequential)
+    {
+        auto seq = run(false);
+        auto par = run(true);
+        ASSERT_EQ(seq.first.size(), par.first.size());
+        for(unsigned int i = 0; i < seq.first.size(); i++) {
+            /* Bitwise equality: */
+            EXPECT_EQ(seq.first[i].energy, par.first[i].energy);
+            EXPECT_EQ(seq.first[i].own_activities, par.first[i].own_activities);
+            EXPECT_EQ(seq.first[i].pending_activities, par.first[i].pending_activities);
+            EXPECT_EQ(seq.first[i].others_activities, par.first[i].others_activities);
+            EXPECT_EQ(seq.first[i].link_enabled, par.first[i].link_enabled);
+            EXPECT_EQ(seq.first[i].position, par.first[i].position);
+        }
+        EXPECT_EQ(seq.second, par.second);
+    }
+}
+
+#endif /* TEST_AGENT_STEP_HPP */
@@ -0,0 +1,193 @@
+/***********************************************************************************************//**
+ *  Unit-test for EnvModel class.
+ *  @class      EnvModelTest
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-14
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef TEST_ENV_MODEL_HPP
+#define TEST_ENV_MODEL_HPP
+
+#include "prot.hpp"
+#include "EnvModel.hpp"
+#include "Activity.hpp"
+#include "PayoffFunctions.hpp"
+
+namespace
+{
+    class EnvModelTest : public ::testing::Test
+    {
+    protected:
+        const unsigned int model_w = 24;
+        const unsigned int model_h = 12;
+        std::shared_ptr<EnvModel> env;
+        std::shared_ptr<Activity> tmp_act;
+        std::vector<std::shared_ptr<Activity> > acts;   /* Keeps activities alive. */
+        std::mt19937 rng;
+
+        virtual void SetUp(void) {
+            Config::motion_model = AgentMotionType::LINEAR_BOUNCE;
+            Config::payoff_model = PayoffModel::LINEAR;
+            Config::goal_min = 0.0;
+            Config::goal_target = 1.0;
+            Config::goal_max = 2.0;
+            Config::payoff_mid = 0.5f;
+            PayoffFunctions::bindPayoffFunctions();
+            rng.seed(12345);
+            env = std::make_shared<EnvModel>(nullptr, model_w, model_h);
+
+            /* Temporal activity that covers all cells with one to three sorted intervals: */
+            std::vector<ActivityCell> tmp_cells;
+            for(unsigned int x = 0; x < model_w; x++) {
+                for(unsigned int y = 0; y < model_h; y++) {
+                    tmp_cells.push_back(randomCell(x, y, 0.0, 10.0, 1 + rng() % 3));
+                }
+            }
+            tmp_act = makeActivity("tmp", 0, tmp_cells);
+
+            /* Activities from other agents, in random cells and with random states: */
+            std::uniform_real_distribution<double> ud(0.0, 1.0);
+            for(int k = 0; k < 200; k++) {
+                std::vector<ActivityCell> a_cells;
+                unsigned int x0 = rng() % model_w;
+                unsigned int y0 = rng() % model_h;
+                double t0 = 10.0 * ud(rng);
+                for(unsigned int x = x0; x < std::min(x0 + 4, model_w); x++) {
+                    for(unsigned int y = y0; y < std::min(y0 + 3, model_h); y++) {
+                        a_cells.push_back(randomCell(x, y, t0, t0 + 1.0, 1 + rng() % 2));
+                    }
+                }
+                auto act = makeActivity("agent" + std::to_string(k % 7), k, a_cells);
+                double r = ud(rng);
+                if(r < 0.3) {
+                    act->setConfirmed();
+                } else if(r < 0.4) {
+                    act->setDiscarded();
+                } else {
+                    act->setConfidenceBaseline(ud(rng));
+                }
+                env->addActivity(act);
+                acts.push_back(act);
+            }
+        }
+
+        ActivityCell randomCell(unsigned int x, unsigned int y, double t0, double t1, unsigned int n) {
+            ActivityCell c;
+            c.x = x;
+            c.y = y;
+            c.nts = n;
+            c.t0s = new double[n];
+            c.t1s = new double[n];
+            c.ready = true;
+            c.aux = 0;
+            double dt = (t1 - t0) / n;
+            for(unsigned int i = 0; i < n; i++) {
+                c.t0s[i] = t0 + i * dt;
+                c.t1s[i] = t0 + i * dt + dt * 0.5;
+            }
+            return c;
+        }
+
+        std::shared_ptr<Activity> makeActivity(std::string aid, int id, const std::vector<ActivityCell>& cells) {
+            double t0 = cells.front().t0s[0];
+            double t1 = t0;
+            for(auto& c : cells) {
+                t0 = std::min(t0, c.t0s[0]);
+                t1 = std::max(t1, c.t1s[c.nts - 1]);
+            }
+            Trajectory traj(t0, (t1 - t0) / 4.0);
+            for(int i = 0; i < 5; i++) {
+                traj.addPosition(sf::Vector3f(i, 0.f, 0.f));
+            }
+            auto act = std::make_shared<Activity>(aid, id);
+            act->setTrajectory(traj, cells);
+            return act;
+        }
+
+        void expectEqual(const std::vector<std::vector<EnvCellPayoff> >& a, const std::vector<std::vector<EnvCellPayoff> >& b) {
+            ASSERT_EQ(a.size(), b.size());
+            for(std::size_t c = 0; c < a.size(); c++) {
+                ASSERT_EQ(a[c].size(), b[c].size());
+                for(std::size_t i = 0; i < a[c].size(); i++) {
+                    EXPECT_EQ(a[c][i].t, b[c][i].t);
+                    EXPECT_EQ(a[c][i].payoff, b[c][i].payoff);
+                    EXPECT_EQ(a[c][i].utility, b[c][i].utility);
+                }
+            }
+        }
+
+        std::vector<std::vector<EnvCellPayoff> > snapshot(void) const {
+            std::vector<std::vector<EnvCellPayoff> > retval;
+            for(unsigned int x = 0; x < model_w; x++) {
+                for(unsigned int y = 0; y < model_h; y++) {
+                    auto series = env->getCell(x, y).getPayoffSeries();
+                    retval.push_back(std::vector<EnvCellPayoff>(series.begin(), series.end()));
+                }
+            }
+            return retval;
+        }
+    };
+
+    TEST_F(EnvModelTest, ParallelPayoffEqualsSequential)
+    {
+        Config::parallel_payoff = false;
+        env->computePayoff(tmp_act);
+        auto po_seq = snapshot();
+
+        Config::parallel_payoff = true;
+        Config::parallel_nested = true;
+        omp_set_num_threads(4);
+        for(int rep = 0; rep < 3; rep++) {
+            env->computePayoff(tmp_act);
+            expectEqual(po_seq, snapshot());
+        }
+    }
+
+    TEST_F(EnvModelTest, IncrementalPayoffEqualsFull)
+    {
+        Config::parallel_payoff = false;
+        Config::payoff_incremental = true;
+        std::vector<ActivityCell> tmp_cells;
+        for(unsigned int x = 0; x < model_w; x++) {
+            for(unsigned int y = 0; y < model_h; y++) {
+                tmp_cells.push_back(randomCell(x, y, 0.0, 10.0, 5));
+            }
+        }
+        env->computePayoff(makeActivity("tmp", 1, tmp_cells));
+
+        /* Churn: remove, discard in place and add some activities. */
+        for(int k = 0; k < 10; k++) {
+            env->removeActivity(acts[k]);
+        }
+        for(int k = 10; k < 20; k++) {
+            if(!acts[k]->isFact()) {
+                acts[k]->setDiscarded(true);
+                env->touchActivity(acts[k]);
+            }
+        }
+        for(int k = 0; k < 5; k++) {
+            env->addActivity(acts[k]);
+        }
+
+        /* Shifted window: same grid of intervals, but starting one interval later. */
+        tmp_cells.clear();
+        for(unsigned int x = 0; x < model_w; x++) {
+            for(unsigned int y = 0; y < model_h; y++) {
+                tmp_cells.push_back(randomCell(x, y, 2.0, 12.0, 5));
+            }
+        }
+        auto tmp_act2 = makeActivity("tmp", 2, tmp_cells);
+        env->computePayoff(tmp_act2);
+        auto po_inc = snapshot();
+
+        Config::payoff_incremental = false;
+        env->computePayoff(tmp_act2);
+        Config::payoff_incremental = true;
+        expectEqual(snapshot(), po_inc);
+    }
+}
+
+#endif /* TEST_ENV_MODEL_HPP */
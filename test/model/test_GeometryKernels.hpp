@@ -0,0 +1,152 @@
+/***********************************************************************************************//**
+ *  Accuracy tests for the single and double precision geometry kernels (against long double).
+ *  @class      GeometryKernelsTest
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-20
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef TEST_GEOMETRY_KERNELS_HPP
+#define TEST_GEOMETRY_KERNELS_HPP
+
+#include "prot.hpp"
+#include "GeometryKernels.hpp"
+#include "MathUtils.hpp"
+
+namespace
+{
+    class GeometryKernelsTest : public ::testing::Test
+    {
+    protected:
+        const std::size_t n = 4096;
+        Vec3Array<long double> a_ld;
+        Vec3Array<long double> b_ld;
+        std::mt19937 rng;
+
+        virtual void SetUp(void) {
+            rng.seed(12345);
+            std::normal_distribution<double> nd(0.0, 1.0);
+            a_ld.resize(n);
+            b_ld.resize(n);
+            for(std::size_t i = 0; i < n; i++) {
+                sf::Vector3<long double> a(nd(rng), nd(rng), nd(rng));
+                sf::Vector3<long double> b(nd(rng), nd(rng), nd(rng));
+                if(i % 4 == 0) {
+                    /* Nearby points (i.e. within a footprint) are the common case: */
+                    b = a + b * 1e-3L;
+                }
+                a_ld.set(i, MathUtils::makeUnitary(a));
+                b_ld.set(i, MathUtils::makeUnitary(b));
+            }
+        }
+
+        template <class T>
+        Vec3Array<T> cast(const Vec3Array<long double>& v) const {
+            Vec3Array<T> retval;
+            retval.x.assign(v.x.begin(), v.x.end());
+            retval.y.assign(v.y.begin(), v.y.end());
+            retval.z.assign(v.z.begin(), v.z.end());
+            return retval;
+        }
+
+        template <class T>
+        long double maxArcError(void) const {
+            Vec3Array<T> a = cast<T>(a_ld);
+            Vec3Array<T> b = cast<T>(b_ld);
+            std::vector<T> out(n);
+            GeometryKernels::arc(a.x.data(), a.y.data(), a.z.data(), b.x.data(), b.y.data(), b.z.data(), n, out.data());
+            long double err = 0.L;
+            for(std::size_t i = 0; i < n; i++) {
+                err = std::max(err, std::abs(out[i] - MathUtils::arc(a_ld.at(i), b_ld.at(i))));
+            }
+            return err;
+        }
+    };
+
+    TEST_F(GeometryKernelsTest, ArcErrorIsBounded)
+    {
+        EXPECT_LT(maxArcError<double>(), 1e-12L);
+        EXPECT_LT(maxArcError<float>(), 1e-6L);     /* ~6 m on the surface of the Earth. */
+    }
+
+    TEST_F(GeometryKernelsTest, ArcFromOneEqualsPairwise)
+    {
+        Vec3Array<double> b = cast<double>(b_ld);
+        std::vector<double> a_x(n, a_ld.x[0]), a_y(n, a_ld.y[0]), a_z(n, a_ld.z[0]);
+        std::vector<double> pairwise(n), from_one(n);
+        GeometryKernels::arc(a_x.data(), a_y.data(), a_z.data(), b.x.data(), b.y.data(), b.z.data(), n, pairwise.data());
+        sf::Vector3<double> a(a_ld.x[0], a_ld.y[0], a_ld.z[0]);
+        GeometryKernels::arc(a, b.x.data(), b.y.data(), b.z.data(), n, from_one.data());
+        for(std::size_t i = 0; i < n; i++) {
+            EXPECT_DOUBLE_EQ(pairwise[i], from_one[i]);
+        }
+    }
+
+    TEST_F(GeometryKernelsTest, DotErrorIsBounded)
+    {
+        Vec3Array<double> a = cast<double>(a_ld);
+        Vec3Array<double> b = cast<double>(b_ld);
+        std::vector<double> out(n);
+        GeometryKernels::dot(a.x.data(), a.y.data(), a.z.data(), b.x.data(), b.y.data(), b.z.data(), n, out.data());
+        for(std::size_t i = 0; i < n; i++) {
+            EXPECT_NEAR(out[i], (double)MathUtils::dot(a_ld.at(i), b_ld.at(i)), 1e-15);
+        }
+    }
+
+    TEST_F(GeometryKernelsTest, LatLonToUnitErrorIsBounded)
+    {
+        std::uniform_real_distribution<double> lat_d(-Config::pi / 2.0, Config::pi / 2.0);
+        std::uniform_real_distribution<double> lng_d(-Config::pi, Config::pi);
+        std::vector<double> lat(n), lng(n), x(n), y(n), z(n);
+        std::vector<float> latf(n), lngf(n), xf(n), yf(n), zf(n);
+        for(std::size_t i = 0; i < n; i++) {
+            lat[i] = latf[i] = lat_d(rng);
+            lng[i] = lngf[i] = lng_d(rng);
+        }
+        GeometryKernels::latLonToUnit(lat.data(), lng.data(), n, x.data(), y.data(), z.data());
+        GeometryKernels::latLonToUnit(latf.data(), lngf.data(), n, xf.data(), yf.data(), zf.data());
+        for(std::size_t i = 0; i < n; i++) {
+            /* Reference computed from the (float) inputs given to both kernels: */
+            long double cl = std::cos((long double)latf[i]);
+            sf::Vector3<long double> u(cl * std::cos((long double)lngf[i]), cl * std::sin((long double)lngf[i]),
+                std::sin((long double)latf[i]));
+            EXPECT_NEAR(xf[i], (double)u.x, 1e-6);
+            EXPECT_NEAR(yf[i], (double)u.y, 1e-6);
+            EXPECT_NEAR(zf[i], (double)u.z, 1e-6);
+            EXPECT_NEAR(x[i] * x[i] + y[i] * y[i] + z[i] * z[i], 1.0, 1e-15);
+        }
+    }
+
+    TEST_F(GeometryKernelsTest, InstrumentGeometryErrorIsBounded)
+    {
+        /* Swath and slant range errors in meters, for LEO altitudes and apertures up to 120º: */
+        long double err_swath_d = 0.L, err_swath_f = 0.L;
+        long double err_sr_d = 0.L, err_sr_f = 0.L;
+        for(long double alt = 300e3L; alt <= 1200e3L; alt += 50e3L) {
+            long double h = Config::earth_wgs84_a + alt;
+            for(long double deg = 1.L; deg <= 60.L; deg += 0.5L) {
+                long double ang = MathUtils::degToRad(deg);
+                if((h / Config::earth_wgs84_a) * std::sin(ang) >= 0.99L) {
+                    break;  /* Beyond (or too close to) the horizon. */
+                }
+                long double swath = GeometryKernels::footprintArc<long double>(ang, h, Config::earth_wgs84_a);
+                long double sr = GeometryKernels::slantRange<long double>(ang, h, Config::earth_wgs84_a);
+                ASSERT_FALSE(std::isnan(sr));
+                err_swath_d = std::max(err_swath_d, std::abs(GeometryKernels::footprintArc<double>(ang, h, Config::earth_wgs84_a) - swath));
+                err_swath_f = std::max(err_swath_f, std::abs(GeometryKernels::footprintArc<float>(ang, h, Config::earth_wgs84_a) - swath));
+                err_sr_d = std::max(err_sr_d, std::abs(GeometryKernels::slantRange<double>(ang, h, Config::earth_wgs84_a) - sr));
+                err_sr_f = std::max(err_sr_f, std::abs(GeometryKernels::slantRange<float>(ang, h, Config::earth_wgs84_a) - sr));
+            }
+        }
+        err_swath_d *= 2.L * Config::earth_wgs84_a;
+        err_swath_f *= 2.L * Config::earth_wgs84_a;
+        EXPECT_LT(err_swath_d, 1e-6L);
+        EXPECT_LT(err_sr_d, 1e-6L);
+        EXPECT_LT(err_swath_f, 10.L);
+        EXPECT_LT(err_sr_f, 10.L);
+    }
+}
+
+#endif /* TEST_GEOMETRY_KERNELS_HPP */
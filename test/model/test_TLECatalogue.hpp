@@ -0,0 +1,117 @@
+/***********************************************************************************************//**
+ *  Tests of the bulk TLE catalogue parser (against the TLE class).
+ *  @class      TLECatalogueTest
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef TEST_TLE_CATALOGUE_HPP
+#define TEST_TLE_CATALOGUE_HPP
+
+#include "prot.hpp"
+#include "TLECatalogue.hpp"
+
+namespace
+{
+    class TLECatalogueTest : public ::testing::Test
+    {
+    protected:
+        const std::vector<std::string> lines = {
+            "ISS (ZARYA)",
+            "1 25544U 98067A   08264.51782528 -.00002182  00000-0 -11606-4 0  2927",
+            "2 25544  51.6416 247.4627 0006703 130.5360 325.0288 15.72125391563537",
+            "SAT-0",
+            "1 10000U 19001A   19208.19021044 -.00002182  00000-0 -11606-4 0  9996",
+            "2 10000  97.4077  22.7185 0015455 178.3566 161.8168 14.25796486275195",
+            "SAT-1",
+            "1 10001U 19001A   19178.57982297 -.00002182  00000-0 -11606-4 0  9991",
+            "2 10001  98.7971 140.3312 0079618 274.4208   0.7582 13.22693597945734",
+            "SAT-2",
+            "1 10002U 19001A   19216.17985034 -.00002182  00000-0 -11606-4 0  9993",
+            "2 10002  18.4009 114.2747 0002925   9.1605 194.9085 15.69574581499652"
+        };
+
+        std::string join(const std::vector<std::string>& ls, std::string eol = "\n") const {
+            std::string retval;
+            for(auto& l : ls) {
+                retval += l + eol;
+            }
+            return retval;
+        }
+    };
+
+    TEST_F(TLECatalogueTest, ParsesLikeTLE)
+    {
+        TLECatalogue c;
+        std::string text = join(lines);
+        ASSERT_EQ(c.parse(text.data(), text.size()), 0u);
+        ASSERT_EQ(c.size(), lines.size() / 3);
+        for(std::size_t i = 0; i < c.size(); i++) {
+            TLE tle(lines[3 * i], lines[3 * i + 1], lines[3 * i + 2]);
+            const TLERecord& r = c[i];
+            EXPECT_EQ(r.sat_name, tle.sat_name);
+            EXPECT_EQ(r.sat_number, tle.sat_number);
+            EXPECT_EQ(r.epoch_year, tle.epoch_year);
+            EXPECT_EQ(r.epoch_doy, tle.epoch_doy);
+            EXPECT_EQ(r.mean_anomaly, tle.mean_anomaly);
+            EXPECT_EQ(r.mean_motion, tle.mean_motion);
+            EXPECT_EQ(r.revolutions, tle.revolutions);
+            EXPECT_EQ(r.orbit_params.sma, tle.orbit_params.sma);
+            EXPECT_EQ(r.orbit_params.ecc, tle.orbit_params.ecc);
+            EXPECT_EQ(r.orbit_params.inc, tle.orbit_params.inc);
+            EXPECT_EQ(r.orbit_params.raan, tle.orbit_params.raan);
+            EXPECT_EQ(r.orbit_params.argp, tle.orbit_params.argp);
+            EXPECT_EQ(r.orbit_params.mean_motion, tle.orbit_params.mean_motion);
+        }
+        EXPECT_DOUBLE_EQ(c[0].bstar, -0.11606e-4);
+        EXPECT_DOUBLE_EQ(c[0].getEpochJD(), 2454730.01782528);     /* 2008-09-20 12:25:40 UTC. */
+    }
+
+    TEST_F(TLECatalogueTest, TwoLineSetsAndCRLF)
+    {
+        std::vector<std::string> two_lines;
+        for(std::size_t i = 0; i < lines.size(); i++) {
+            if(i % 3 != 0) {
+                two_lines.push_back(lines[i]);
+            }
+        }
+        TLECatalogue c;
+        std::string text = join(two_lines, "\r\n");
+        ASSERT_EQ(c.parse(text.data(), text.size()), 0u);
+        ASSERT_EQ(c.size(), 4u);
+        EXPECT_EQ(c[0].sat_name, "25544");
+        EXPECT_EQ(c[3].orbit_params.inc, 18.4009);
+    }
+
+    TEST_F(TLECatalogueTest, SkipsInvalidRecords)
+    {
+        std::vector<std::string> bad = lines;
+        bad[2][21] = '7';           /* Wrong checksum. */
+        bad[4][2] = 'X';            /* Bad format. */
+        TLECatalogue c;
+        std::string text = join(bad);
+        EXPECT_EQ(c.parse(text.data(), text.size()), 2u);
+        ASSERT_EQ(c.size(), 2u);
+        EXPECT_EQ(c[0].sat_name, "SAT-1");
+        EXPECT_EQ(c[1].sat_name, "SAT-2");
+    }
+
+    TEST_F(TLECatalogueTest, Filters)
+    {
+        TLECatalogue c;
+        std::string text = join(lines);
+        c.parse(text.data(), text.size());
+        EXPECT_EQ(c.filterByName("SAT-").size(), 3u);
+        EXPECT_EQ(c.filterByName("ISS").size(), 1u);
+        EXPECT_EQ(c.filterByInclination(0.0, 90.0).size(), 2u);
+        EXPECT_EQ(c.filterByName("SAT-").filterByInclination(90.0, 180.0).size(), 2u);
+        double jd = c[1].getEpochJD();
+        EXPECT_EQ(c.filterByEpoch(jd - 10.0, jd + 10.0).size(), 2u);   /* SAT-0 and SAT-2. */
+        EXPECT_EQ(c.getOrbitalParams().size(), c.size());
+    }
+}
+
+#endif /* TEST_TLE_CATALOGUE_HPP */
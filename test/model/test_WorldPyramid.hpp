@@ -0,0 +1,167 @@
+/***********************************************************************************************//**
+ *  Tests of the world level-of-detail pyramid (against a full-resolution reference).
+ *  @class      WorldPyramidTest
+ *  @authors    Carles Araguz (CA), carles.araguz@upc.edu
+ *  @date       2019-jun-28
+ *  @version    0.1
+ *  @copyright  This file is part of a project developed by Nano-Satellite and Payload Laboratory
+ *              (NanoSat Lab) at Technical University of Catalonia - UPC BarcelonaTech.
+ **************************************************************************************************/
+
+#ifndef TEST_WORLD_PYRAMID_HPP
+#define TEST_WORLD_PYRAMID_HPP
+
+#include "prot.hpp"
+#include "WorldPyramid.hpp"
+
+namespace
+{
+    class WorldPyramidTest : public ::testing::Test
+    {
+    protected:
+        const unsigned int w = 37;      /* Odd sizes, to have partial entries at the borders. */
+        const unsigned int h = 23;
+        std::vector<int> utop;          /* Reference ages (in steps), -1 if unseen. */
+        std::vector<int> curr;
+        std::mt19937 rng;
+
+        virtual void SetUp(void) {
+            rng.seed(12345);
+            utop.assign(w * h, -1);
+            curr.assign(w * h, 0);
+        }
+
+        /* Steps the pyramid and the reference, and visits a few random rectangles (like footprints): */
+        void step(WorldPyramid& p, unsigned int n_visits) {
+            p.step();
+            for(unsigned int i = 0; i < w * h; i++) {
+                utop[i] += (utop[i] >= 0 ? 1 : 0);
+                curr[i]++;
+            }
+            for(unsigned int v = 0; v < n_visits; v++) {
+                unsigned int x0 = rng() % w;
+                unsigned int y0 = rng() % h;
+                bool capturing = (rng() % 3 != 0);
+                for(unsigned int x = x0; x < std::min(x0 + 3, w); x++) {
+                    for(unsigned int y = y0; y < std::min(y0 + 2, h); y++) {
+                        p.visit(x, y, capturing);
+                        utop[x * h + y] = 0;
+                        if(capturing) {
+                            curr[x * h + y] = 0;
+                        } else {
+                            curr[x * h + y]++;      /* As World::updateLayer. */
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    TEST_F(WorldPyramidTest, LevelsMatchReference)
+    {
+        WorldPyramid p(w, h);
+        ASSERT_EQ(p.getLevels(), 7u);   /* 37x23, 19x12, 10x6, 5x3, 3x2, 2x1, 1x1. */
+        for(unsigned int s = 0; s < 30; s++) {
+            step(p, 4);
+        }
+        p.refresh();
+        for(unsigned int k = 0; k < p.getLevels(); k++) {
+            for(unsigned int x = 0; x < p.getWidth(k); x++) {
+                for(unsigned int y = 0; y < p.getHeight(k); y++) {
+                    int u_min = -1, u_max = -1, c_min = -1, c_max = -1;
+                    double u_sum = 0.0, c_sum = 0.0;
+                    unsigned int u_count = 0, c_count = 0;
+                    for(unsigned int cx = (x << k); cx < std::min((x + 1) << k, w); cx++) {
+                        for(unsigned int cy = (y << k); cy < std::min((y + 1) << k, h); cy++) {
+                            int u = utop[cx * h + cy];
+                            int c = curr[cx * h + cy];
+                            if(u >= 0) {
+                                u_min = (u_min < 0 ? u : std::min(u_min, u));
+                                u_max = std::max(u_max, u);
+                                u_sum += u;
+                                u_count++;
+                            }
+                            c_min = (c_min < 0 ? c : std::min(c_min, c));
+                            c_max = std::max(c_max, c);
+                            c_sum += c;
+                            c_count++;
+                        }
+                    }
+                    if(u_count == 0) {
+                        EXPECT_EQ(p.getAge(0, k, x, y, Aggregate::MEAN_VALUE), -1.0);
+                    } else {
+                        EXPECT_EQ(p.getAge(0, k, x, y, Aggregate::MIN_VALUE), u_min);
+                        EXPECT_EQ(p.getAge(0, k, x, y, Aggregate::MAX_VALUE), u_max);
+                        EXPECT_DOUBLE_EQ(p.getAge(0, k, x, y, Aggregate::MEAN_VALUE), u_sum / u_count);
+                    }
+                    EXPECT_EQ(p.getAge(1, k, x, y, Aggregate::MIN_VALUE), c_min);
+                    EXPECT_EQ(p.getAge(1, k, x, y, Aggregate::MAX_VALUE), c_max);
+                    EXPECT_DOUBLE_EQ(p.getAge(1, k, x, y, Aggregate::MEAN_VALUE), c_sum / c_count);
+                }
+            }
+        }
+    }
+
+    TEST_F(WorldPyramidTest, RegionStatsMatchReference)
+    {
+        WorldPyramid p(w, h);
+        const std::uint32_t unmet_age = 12;
+        for(unsigned int s = 0; s < 40; s++) {
+            step(p, 3);
+            if(s % 10 != 9) {
+                continue;
+            }
+            p.refresh();
+            for(unsigned int r = 0; r < 20; r++) {
+                unsigned int x0 = rng() % w;
+                unsigned int y0 = rng() % h;
+                unsigned int x1 = x0 + 1 + rng() % (w - x0);
+                unsigned int y1 = y0 + 1 + rng() % (h - y0);
+                if(r == 0) {
+                    x0 = y0 = 0;
+                    x1 = w;
+                    y1 = h;
+                }
+                WorldPyramid::RegionStats ref = WorldPyramid::RegionStats();
+                for(unsigned int x = x0; x < x1; x++) {
+                    for(unsigned int y = y0; y < y1; y++) {
+                        int u = utop[x * h + y];
+                        int c = curr[x * h + y];
+                        if(u < 0) {
+                            continue;
+                        }
+                        ref.count++;
+                        ref.utop_sum += u;
+                        ref.curr_sum += c;
+                        ref.diff_sum += c - u;
+                        ref.utop_max = std::max(ref.utop_max, (std::uint32_t)u);
+                        ref.curr_max = std::max(ref.curr_max, (std::uint32_t)c);
+                        ref.diff_max = std::max(ref.diff_max, (std::uint32_t)(c - u));
+                        if((std::uint32_t)u >= unmet_age) {
+                            ref.utop_unmet_count++;
+                            ref.utop_unmet_sum += u;
+                        }
+                        if((std::uint32_t)c >= unmet_age) {
+                            ref.curr_unmet_count++;
+                            ref.curr_unmet_sum += c;
+                        }
+                    }
+                }
+                WorldPyramid::RegionStats rs = p.getRegionStats(x0, x1, y0, y1, unmet_age);
+                EXPECT_EQ(rs.count, ref.count);
+                EXPECT_EQ(rs.utop_sum, ref.utop_sum);
+                EXPECT_EQ(rs.curr_sum, ref.curr_sum);
+                EXPECT_EQ(rs.diff_sum, ref.diff_sum);
+                EXPECT_EQ(rs.utop_max, ref.utop_max);
+                EXPECT_EQ(rs.curr_max, ref.curr_max);
+                EXPECT_EQ(rs.diff_max, ref.diff_max);
+                EXPECT_EQ(rs.utop_unmet_count, ref.utop_unmet_count);
+                EXPECT_EQ(rs.utop_unmet_sum, ref.utop_unmet_sum);
+                EXPECT_EQ(rs.curr_unmet_count, ref.curr_unmet_count);
+                EXPECT_EQ(rs.curr_unmet_sum, ref.curr_unmet_sum);
+            }
+        }
+    }
+}
+
+#endif /* TEST_WORLD_PYRAMID_HPP */